@@ -0,0 +1,25 @@
+#version 430
+#extension GL_ARB_shading_language_include : require
+#extension GL_ARB_bindless_texture : require
+#include "/model-globals.glsl"
+
+flat in uint drawMaterial;
+
+// the handles of all materials, five per material in the order of RenderQueue, zero where a material has no texture
+layout(std430, binding = 3) readonly buffer textureHandleBuffer
+{
+	uvec2 textureHandles[];
+};
+
+vec4 materialTexture(int unit, vec2 texCoord)
+{
+	uvec2 handle = textureHandles[drawMaterial * 5u + uint(unit)];
+
+	// like sampling an unbound unit
+	if (handle == uvec2(0u))
+		return vec4(0.0, 0.0, 0.0, 1.0);
+
+	return texture(sampler2D(handle), texCoord);
+}
+
+#include "/model-shading.glsl"
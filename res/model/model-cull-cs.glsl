@@ -0,0 +1,200 @@
+#version 430
+#extension GL_ARB_shading_language_include : require
+#include "/model-globals.glsl"
+
+layout(local_size_x = 64) in;
+
+struct Meshlet
+{
+	vec4 sphere;
+	uint firstIndex;
+	uint indexCount;
+	int baseVertex;
+	uint draw;
+	uint run;
+	uint firstSlot;
+	uint padding0;
+	uint padding1;
+};
+
+struct Draw
+{
+	vec3 offsetVector;
+	uint material;
+};
+
+layout(std430, binding = 0) readonly buffer meshletBuffer
+{
+	Meshlet meshlets[];
+};
+
+// the compacted commands of both phases, five words each: count, instance count, first index, base vertex and base instance
+layout(std430, binding = 1) writeonly buffer commandBuffer
+{
+	uint commands[];
+};
+
+layout(std430, binding = 2) readonly buffer drawBuffer
+{
+	Draw draws[];
+};
+
+// the number of commands of every run in both phases
+layout(std430, binding = 3) buffer countBuffer
+{
+	uint counts[];
+};
+
+// whether the early phase found a meshlet occluded, only those are tested again in the late phase
+layout(std430, binding = 4) buffer stateBuffer
+{
+	uint occludedEarly[];
+};
+
+// meshlets and triangles outside of the frustum, drawn early, drawn late and occluded
+layout(std430, binding = 5) buffer statisticsBuffer
+{
+	uint statistics[];
+};
+
+// the commands of the groups, a group without instances is disabled or outside of the frustum as a whole
+layout(std430, binding = 6) readonly buffer groupCommandBuffer
+{
+	uint groupCommands[];
+};
+
+uniform mat4 modelViewProjectionMatrix;
+// the matrix the depth of the pyramid was drawn with
+uniform mat4 pyramidMatrix;
+uniform float explosion;
+uniform int phase;
+uniform bool occlusionCulling;
+
+// the farthest depth of blocks of pixels, level 0 is the size of the viewport padded to powers of two, no levels without a pyramid
+uniform sampler2D depthPyramid;
+uniform ivec2 viewportSize;
+uniform int pyramidLevels;
+
+uniform uint meshletCount;
+uniform uint runCount;
+
+bool insideFrustum(vec3 center, float radius)
+{
+	mat4 rows = transpose(modelViewProjectionMatrix);
+	vec4 planes[6] = vec4[6](rows[3] + rows[0], rows[3] - rows[0], rows[3] + rows[1], rows[3] - rows[1], rows[3] + rows[2], rows[3] - rows[2]);
+
+	for (int p = 0; p < 6; p++)
+	{
+		if (dot(planes[p].xyz, center) + planes[p].w < -radius * length(planes[p].xyz))
+			return false;
+	}
+
+	return true;
+}
+
+// compares the nearest depth of the box around the sphere with the farthest depth of the pyramid texels it covers,
+// at the level where those are at most two in each direction
+bool occluded(vec3 center, float radius)
+{
+	vec2 minimum = vec2(1.0e30);
+	vec2 maximum = vec2(-1.0e30);
+	float nearest = 1.0e30;
+
+	for (int i = 0; i < 8; i++)
+	{
+		vec3 corner = center + radius * vec3((i & 1) != 0 ? 1.0 : -1.0, (i & 2) != 0 ? 1.0 : -1.0, (i & 4) != 0 ? 1.0 : -1.0);
+		vec4 clip = pyramidMatrix * vec4(corner, 1.0);
+
+		// boxes reaching behind the camera are always visible
+		if (clip.w <= 1.0e-5)
+			return false;
+
+		vec3 ndc = clip.xyz / clip.w;
+		minimum = min(minimum, ndc.xy);
+		maximum = max(maximum, ndc.xy);
+		nearest = min(nearest, ndc.z);
+	}
+
+	ivec2 pixelMinimum = clamp(ivec2((minimum * 0.5 + 0.5) * vec2(viewportSize)), ivec2(0), viewportSize - 1);
+	ivec2 pixelMaximum = clamp(ivec2((maximum * 0.5 + 0.5) * vec2(viewportSize)), ivec2(0), viewportSize - 1);
+
+	int level = 0;
+
+	while (level + 1 < pyramidLevels && any(greaterThan((pixelMaximum >> level) - (pixelMinimum >> level), ivec2(1))))
+		level++;
+
+	ivec2 texelMinimum = pixelMinimum >> level;
+	ivec2 texelMaximum = pixelMaximum >> level;
+
+	float farthest = max(max(texelFetch(depthPyramid, texelMinimum, level).r, texelFetch(depthPyramid, ivec2(texelMaximum.x, texelMinimum.y), level).r),
+		max(texelFetch(depthPyramid, ivec2(texelMinimum.x, texelMaximum.y), level).r, texelFetch(depthPyramid, texelMaximum, level).r));
+
+	return nearest * 0.5 + 0.5 > farthest;
+}
+
+void emitCommand(Meshlet meshlet, uint commandPhase)
+{
+	uint slot = meshlet.firstSlot + atomicAdd(counts[commandPhase * runCount + meshlet.run], 1u);
+	uint command = (commandPhase * meshletCount + slot) * 5u;
+
+	commands[command + 0u] = meshlet.indexCount;
+	commands[command + 1u] = 1u;
+	commands[command + 2u] = meshlet.firstIndex;
+	commands[command + 3u] = uint(meshlet.baseVertex);
+	// selects the draw of the group in the instanced attribute
+	commands[command + 4u] = meshlet.draw;
+}
+
+void main()
+{
+	uint m = gl_GlobalInvocationID.x;
+
+	if (m >= meshletCount)
+		return;
+
+	Meshlet meshlet = meshlets[m];
+	uint triangles = meshlet.indexCount / 3u;
+	vec3 center = meshlet.sphere.xyz + draws[meshlet.draw].offsetVector * explosion;
+	float radius = meshlet.sphere.w;
+
+	if (phase == 0)
+	{
+		occludedEarly[m] = 0u;
+
+		if (groupCommands[meshlet.draw * 5u + 1u] == 0u)
+			return;
+
+		if (!insideFrustum(center, radius))
+		{
+			atomicAdd(statistics[0], 1u);
+			atomicAdd(statistics[1], triangles);
+			return;
+		}
+
+		if (occlusionCulling && pyramidLevels > 0 && occluded(center, radius))
+		{
+			occludedEarly[m] = 1u;
+			return;
+		}
+
+		emitCommand(meshlet, 0u);
+		atomicAdd(statistics[2], 1u);
+		atomicAdd(statistics[3], triangles);
+	}
+	else
+	{
+		if (occludedEarly[m] == 0u)
+			return;
+
+		if (occluded(center, radius))
+		{
+			atomicAdd(statistics[6], 1u);
+			atomicAdd(statistics[7], triangles);
+			return;
+		}
+
+		emitCommand(meshlet, 1u);
+		atomicAdd(statistics[4], 1u);
+		atomicAdd(statistics[5], triangles);
+	}
+}
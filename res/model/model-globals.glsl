@@ -0,0 +1,10 @@
+// inverse of VertexQuantizer::octahedralEncode, the octahedron unfolded into the square [-1,1] x [-1,1] back to a unit vector
+vec3 octahedralDecode(vec2 encoded)
+{
+	vec3 v = vec3(encoded, 1.0 - abs(encoded.x) - abs(encoded.y));
+
+	if (v.z < 0.0)
+		v.xy = (1.0 - abs(v.yx)) * vec2(v.x < 0.0 ? -1.0 : 1.0, v.y < 0.0 ? -1.0 : 1.0);
+
+	return normalize(v);
+}
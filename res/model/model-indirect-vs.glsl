@@ -0,0 +1,29 @@
+#version 430
+#extension GL_ARB_shading_language_include : require
+#include "/model-globals.glsl"
+
+uniform float explosion;
+
+// the index of the draw comes from an instanced attribute, the base instance of each indirect command selects it
+layout(location = 4) in uint drawIndex;
+
+struct Draw
+{
+	vec3 offsetVector;
+	uint material;
+};
+
+layout(std430, binding = 2) readonly buffer drawBuffer
+{
+	Draw draws[];
+};
+
+flat out uint drawMaterial;
+
+#include "/model-vertex.glsl"
+
+void main()
+{
+	drawMaterial = draws[drawIndex].material;
+	emitVertex(draws[drawIndex].offsetVector * explosion);
+}
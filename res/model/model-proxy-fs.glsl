@@ -0,0 +1,11 @@
+#version 400
+#extension GL_ARB_shading_language_include : require
+#include "/model-globals.glsl"
+
+// only the depth test counts for the occlusion queries, the color is masked
+out vec4 fragColor;
+
+void main()
+{
+	fragColor = vec4(1.0);
+}
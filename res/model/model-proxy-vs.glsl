@@ -0,0 +1,16 @@
+#version 400
+#extension GL_ARB_shading_language_include : require
+#include "/model-globals.glsl"
+
+uniform mat4 modelViewProjectionMatrix;
+
+// the bounding box of a group moved by its explosion offset, the positions are the corners from -1 to 1
+uniform vec3 boxCenter;
+uniform vec3 boxExtent;
+
+layout(location = 0) in vec3 position;
+
+void main()
+{
+	gl_Position = modelViewProjectionMatrix * vec4(boxCenter + position * boxExtent, 1.0);
+}
@@ -0,0 +1,40 @@
+#version 430
+#extension GL_ARB_shading_language_include : require
+#include "/model-globals.glsl"
+
+layout(local_size_x = 8, local_size_y = 8) in;
+
+// level 0 copies the depth, padded with the nearest depth, which never raises the farthest one of a block,
+// every other level keeps the farthest depth of the 2x2 texels below it
+uniform int level;
+uniform ivec2 viewportSize;
+uniform sampler2D depthTexture;
+
+layout(r32f, binding = 0) readonly uniform image2D previousLevel;
+layout(r32f, binding = 1) writeonly uniform image2D currentLevel;
+
+void main()
+{
+	ivec2 texel = ivec2(gl_GlobalInvocationID.xy);
+
+	if (any(greaterThanEqual(texel, imageSize(currentLevel))))
+		return;
+
+	float depth = 0.0;
+
+	if (level == 0)
+	{
+		if (all(lessThan(texel, viewportSize)))
+			depth = texelFetch(depthTexture, texel, 0).r;
+	}
+	else
+	{
+		ivec2 last = imageSize(previousLevel) - 1;
+		ivec2 below = texel * 2;
+
+		depth = max(max(imageLoad(previousLevel, min(below, last)).r, imageLoad(previousLevel, min(below + ivec2(1, 0), last)).r),
+			max(imageLoad(previousLevel, min(below + ivec2(0, 1), last)).r, imageLoad(previousLevel, min(below + ivec2(1, 1), last)).r));
+	}
+
+	imageStore(currentLevel, texel, vec4(depth));
+}
@@ -0,0 +1,95 @@
+uniform vec3 worldCameraPosition;
+uniform vec3 worldLightPosition;
+
+uniform vec3 diffuseColor, ambientColor, specularColor;
+
+uniform float shininess;
+
+uniform vec3 light_A, light_S, light_D;
+
+uniform bool diff_txt, ambn_txt, spec_txt;
+
+uniform bool objSpace, tangSpace, bumpMapping;
+
+uniform float amp,freq;
+
+uniform bool wireframeEnabled;
+uniform vec4 wireframeLineColor;
+
+in fragmentData
+{
+	vec3 position;
+	vec3 normal;
+	vec2 texCoord;
+	noperspective vec3 barycentric;
+	mat3 TBN;
+} fragment;
+
+float bump_func(vec2 txCoord)
+{
+	return amp*pow(sin(freq*txCoord.x),2)*pow(sin(freq*txCoord.y),2);
+	//return amp*exp(pow(sin(freq*txCoord.x),2)*pow(cos(freq*txCoord.x),2))*(pow(sin(freq*txCoord.y),2)*pow(cos(freq*txCoord.y),2));
+}
+
+out vec4 fragColor;
+
+void main()
+{
+	vec3 normal= fragment.normal;
+
+	if(objSpace)
+	{
+		normal = materialTexture(3, fragment.texCoord).xyz;
+		normal = normalize(normal * 2.0 - 1.0);
+	}else if(tangSpace)
+	{
+		// only x and y are stored when the map is compressed to two channels, z is always positive in tangent space
+		vec2 tangentNormal = materialTexture(4, fragment.texCoord).xy * 2.0 - 1.0;
+		normal = vec3(tangentNormal, sqrt(max(1.0 - dot(tangentNormal, tangentNormal), 0.0)));
+
+		if(bumpMapping)
+		{
+			//Pu = tangent; Pv=bitangent
+			//N' = N + dy(Pu x n) + dx(n x Pv)
+			normal = normal + dFdy(bump_func(fragment.texCoord))*(cross(fragment.TBN[0],normalize(normal))) + dFdx(bump_func(fragment.texCoord))*(cross(normalize(normal),fragment.TBN[1]));
+		}
+		
+		normal = normalize(fragment.TBN * normal);
+	}
+
+	
+
+	vec3 viewer =  normalize(worldCameraPosition - fragment.position);
+	vec3 light =  normalize(worldLightPosition - fragment.position);
+	vec3 reflected = normalize(2*dot(light,normal)*normal-light);
+	vec3 total = ambientColor*light_A + diffuseColor*max(dot(light, normalize(normal)),0.0)*light_D + specularColor*(pow(max(dot(reflected,viewer),0.0), shininess))*light_S;
+	vec4 result = vec4(total,1.0);
+
+	if(diff_txt)
+	{
+		result = result*materialTexture(0,fragment.texCoord);
+	}
+
+	if(ambn_txt)
+	{
+		result = result*materialTexture(1,fragment.texCoord);
+	}
+
+	if(spec_txt)
+	{
+		result = result*materialTexture(2,fragment.texCoord);
+	}
+
+	if (wireframeEnabled)
+	{
+		// distances to the edges in pixels, from how fast the barycentric coordinates change across the screen
+		vec3 dx = dFdx(fragment.barycentric);
+		vec3 dy = dFdy(fragment.barycentric);
+		vec3 edgeDistance = fragment.barycentric / max(sqrt(dx*dx + dy*dy), vec3(1e-6));
+		float smallestDistance = min(min(edgeDistance[0],edgeDistance[1]),edgeDistance[2]);
+		float edgeIntensity = exp2(-1.0*smallestDistance*smallestDistance);
+		result.rgb = mix(result.rgb,wireframeLineColor.rgb,edgeIntensity*wireframeLineColor.a);
+	}
+
+	fragColor = result;
+}
\ No newline at end of file
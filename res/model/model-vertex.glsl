@@ -0,0 +1,50 @@
+uniform mat4 modelViewProjectionMatrix;
+
+// compact vertices have positions normalized within the bounds, octahedral normals and tangents and the handedness in position.w
+uniform bool compactVertices;
+uniform vec3 positionOffset;
+uniform vec3 positionScale;
+
+layout(location = 0) in vec4 vertexPosition;
+layout(location = 1) in vec3 vertexNormal;
+layout(location = 2) in vec2 texCoord;
+layout(location = 3) in vec4 vertexTangent;
+
+out fragmentData
+{
+	vec3 position;
+	vec3 normal;
+	vec2 texCoord;
+	noperspective vec3 barycentric;
+	mat3 TBN;
+} fragment;
+
+// decodes the vertex attributes and moves the vertex by the offset of its group
+void emitVertex(vec3 offset)
+{
+	vec3 position = vertexPosition.xyz;
+	vec3 normal = vertexNormal;
+	vec4 tangent = vertexTangent;
+
+	if (compactVertices)
+	{
+		position = positionOffset + vertexPosition.xyz * positionScale;
+		normal = octahedralDecode(vertexNormal.xy);
+		tangent = vec4(octahedralDecode(vertexTangent.xy), vertexPosition.w * 2.0 - 1.0);
+	}
+
+	vec4 pos = modelViewProjectionMatrix*vec4(position + offset,1.0);
+
+	fragment.position = position + offset; 
+	fragment.normal = normal;
+	fragment.texCoord = texCoord;
+
+	// the tangent frame is precomputed per vertex, the bitangent follows from its handedness
+	vec3 n = normalize(normal);
+	fragment.TBN = mat3(tangent.xyz, cross(n, tangent.xyz) * tangent.w, n);
+
+	// no edges are drawn without the wireframe
+	fragment.barycentric = vec3(1.0);
+	
+	gl_Position = pos;
+}
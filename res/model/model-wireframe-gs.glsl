@@ -0,0 +1,46 @@
+#version 400
+#extension GL_ARB_shading_language_include : require
+#include "/model-globals.glsl"
+
+// the wireframe for contexts without storage buffers, the corners of the triangles drawn from the element buffer
+// only get their barycentric coordinates here
+layout(triangles) in;
+layout(triangle_strip, max_vertices = 3) out;
+
+in fragmentData
+{
+	vec3 position;
+	vec3 normal;
+	vec2 texCoord;
+	noperspective vec3 barycentric;
+	mat3 TBN;
+} vertices[];
+
+out fragmentData
+{
+	vec3 position;
+	vec3 normal;
+	vec2 texCoord;
+	noperspective vec3 barycentric;
+	mat3 TBN;
+} fragment;
+
+void main(void)
+{
+	for (int i=0;i<3;i++)
+	{
+		gl_Position = gl_in[i].gl_Position;
+		fragment.position = vertices[i].position;
+		fragment.normal = vertices[i].normal;
+		fragment.texCoord = vertices[i].texCoord;
+		fragment.TBN = vertices[i].TBN;
+
+		vec3 barycentric = vec3(0.0);
+		barycentric[i] = 1.0;
+		fragment.barycentric = barycentric;
+
+		EmitVertex();
+	}
+
+	EndPrimitive();
+}
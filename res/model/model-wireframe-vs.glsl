@@ -0,0 +1,90 @@
+#version 430
+#extension GL_ARB_shading_language_include : require
+#include "/model-globals.glsl"
+
+uniform mat4 modelViewProjectionMatrix;
+
+uniform vec3 explosionVector;
+
+// the triangles are drawn without an element buffer, the vertices are fetched by index from the buffers
+// of the model, so that each corner of a triangle knows its place and can output its own barycentric coordinate
+layout(std430, binding = 0) readonly buffer vertexBuffer
+{
+	uint vertexData[];
+};
+
+layout(std430, binding = 1) readonly buffer indexBuffer
+{
+	uint indexData[];
+};
+
+// number of words in a Vertex: position, normal, texcoord and tangent
+const int vertexStride = 12;
+// number of words in a CompactVertex: position, normal, tangent and texcoord
+const int compactVertexStride = 5;
+
+uniform bool compactVertices;
+uniform vec3 positionOffset;
+uniform vec3 positionScale;
+
+// the index buffer holds the indices of each group relative to its base vertex, packed in pairs into words for 16-bit groups,
+// the first index of the draw is where the corners of its triangles start counting
+uniform int firstIndex;
+uniform bool shortIndices;
+uniform int baseVertex;
+
+int vertexIndex()
+{
+	uint index = shortIndices ? (indexData[gl_VertexID >> 1] >> ((gl_VertexID & 1) * 16)) & 0xffffu : indexData[gl_VertexID];
+	return int(index) + baseVertex;
+}
+
+out fragmentData
+{
+	vec3 position;
+	vec3 normal;
+	vec2 texCoord;
+	noperspective vec3 barycentric;
+	mat3 TBN;
+} fragment;
+
+void main()
+{
+	vec3 position;
+	vec3 normal;
+	vec2 texCoord;
+	vec4 tangent;
+
+	if (compactVertices)
+	{
+		int base = vertexIndex() * compactVertexStride;
+
+		vec4 quantized = vec4(unpackUnorm2x16(vertexData[base + 0]), unpackUnorm2x16(vertexData[base + 1]));
+		position = positionOffset + quantized.xyz * positionScale;
+		normal = octahedralDecode(unpackSnorm2x16(vertexData[base + 2]));
+		tangent = vec4(octahedralDecode(unpackSnorm2x16(vertexData[base + 3])), quantized.w * 2.0 - 1.0);
+		texCoord = unpackHalf2x16(vertexData[base + 4]);
+	}
+	else
+	{
+		int base = vertexIndex() * vertexStride;
+
+		position = uintBitsToFloat(uvec3(vertexData[base + 0], vertexData[base + 1], vertexData[base + 2]));
+		normal = uintBitsToFloat(uvec3(vertexData[base + 3], vertexData[base + 4], vertexData[base + 5]));
+		texCoord = uintBitsToFloat(uvec2(vertexData[base + 6], vertexData[base + 7]));
+		tangent = uintBitsToFloat(uvec4(vertexData[base + 8], vertexData[base + 9], vertexData[base + 10], vertexData[base + 11]));
+	}
+
+	fragment.position = position + explosionVector;
+	fragment.normal = normal;
+	fragment.texCoord = texCoord;
+
+	vec3 n = normalize(normal);
+	fragment.TBN = mat3(tangent.xyz, cross(n, tangent.xyz) * tangent.w, n);
+
+	vec3 barycentric = vec3(0.0);
+	barycentric[(gl_VertexID - firstIndex) % 3] = 1.0;
+	fragment.barycentric = barycentric;
+
+	gl_Position = modelViewProjectionMatrix*vec4(position + explosionVector,1.0);
+}
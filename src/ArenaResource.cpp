@@ -0,0 +1,123 @@
+#include "ArenaResource.h"
+
+#include <algorithm>
+
+using namespace minity;
+
+ArenaResource::ArenaResource(std::size_t blockSize, std::pmr::memory_resource * upstream) : m_upstream(upstream), m_blockSize(blockSize), m_largeThreshold(blockSize / 4)
+{
+
+}
+
+ArenaResource::~ArenaResource()
+{
+	release();
+}
+
+void ArenaResource::release()
+{
+	while (m_blocks)
+	{
+		Block * next = m_blocks->next;
+		m_upstream->deallocate(m_blocks, m_blocks->size, alignof(std::max_align_t));
+		m_blocks = next;
+	}
+
+	while (m_largeAllocations)
+	{
+		LargeAllocation * next = m_largeAllocations->next;
+		m_upstream->deallocate(m_largeAllocations, m_largeAllocations->size, m_largeAllocations->alignment);
+		m_largeAllocations = next;
+	}
+
+	m_current = nullptr;
+	m_end = nullptr;
+}
+
+const ArenaResource::Statistics & ArenaResource::statistics() const
+{
+	return m_statistics;
+}
+
+void * ArenaResource::do_allocate(std::size_t bytes, std::size_t alignment)
+{
+	m_statistics.allocations++;
+
+	if (bytes > m_largeThreshold || alignment > alignof(std::max_align_t))
+	{
+		// large allocations are linked into a list, so they can be returned individually or all at once
+		const std::size_t headerSize = largeHeaderSize(alignment);
+		const std::size_t upstreamAlignment = std::max(alignment, alignof(LargeAllocation));
+		char * memory = static_cast<char*>(m_upstream->allocate(headerSize + bytes, upstreamAlignment));
+
+		LargeAllocation * allocation = reinterpret_cast<LargeAllocation*>(memory + headerSize - sizeof(LargeAllocation));
+		allocation->previous = nullptr;
+		allocation->next = m_largeAllocations;
+		allocation->size = headerSize + bytes;
+		allocation->alignment = upstreamAlignment;
+
+		if (m_largeAllocations)
+			m_largeAllocations->previous = allocation;
+
+		m_largeAllocations = allocation;
+
+		m_statistics.largeAllocations++;
+		m_statistics.largeBytes += bytes;
+
+		return memory + headerSize;
+	}
+
+	std::uintptr_t address = (reinterpret_cast<std::uintptr_t>(m_current) + alignment - 1) & ~std::uintptr_t(alignment - 1);
+
+	if (m_current == nullptr || address + bytes > reinterpret_cast<std::uintptr_t>(m_end))
+	{
+		const std::size_t blockSize = m_blockSize;
+		Block * block = static_cast<Block*>(m_upstream->allocate(blockSize, alignof(std::max_align_t)));
+		block->next = m_blocks;
+		block->size = blockSize;
+		m_blocks = block;
+
+		m_current = reinterpret_cast<char*>(block) + sizeof(Block);
+		m_end = reinterpret_cast<char*>(block) + blockSize;
+
+		m_statistics.blocks++;
+		m_statistics.blockBytes += blockSize;
+
+		address = (reinterpret_cast<std::uintptr_t>(m_current) + alignment - 1) & ~std::uintptr_t(alignment - 1);
+	}
+
+	m_current = reinterpret_cast<char*>(address + bytes);
+	return reinterpret_cast<void*>(address);
+}
+
+void ArenaResource::do_deallocate(void * pointer, std::size_t bytes, std::size_t alignment)
+{
+	// small allocations are only returned with their block
+	if (bytes <= m_largeThreshold && alignment <= alignof(std::max_align_t))
+		return;
+
+	const std::size_t headerSize = largeHeaderSize(alignment);
+	LargeAllocation * allocation = reinterpret_cast<LargeAllocation*>(static_cast<char*>(pointer) - sizeof(LargeAllocation));
+
+	if (allocation->previous)
+		allocation->previous->next = allocation->next;
+	else
+		m_largeAllocations = allocation->next;
+
+	if (allocation->next)
+		allocation->next->previous = allocation->previous;
+
+	m_upstream->deallocate(static_cast<char*>(pointer) - headerSize, allocation->size, allocation->alignment);
+}
+
+bool ArenaResource::do_is_equal(const std::pmr::memory_resource & other) const noexcept
+{
+	return this == &other;
+}
+
+std::size_t ArenaResource::largeHeaderSize(std::size_t alignment)
+{
+	// the header is placed directly in front of the returned memory, which keeps its alignment
+	const std::size_t align = std::max(alignment, alignof(LargeAllocation));
+	return (sizeof(LargeAllocation) + align - 1) / align * align;
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+
+namespace minity
+{
+	// memory resource which serves small requests from larger blocks without freeing them individually,
+	// while large requests (like growing arrays) are passed on to the upstream resource and can be returned
+	// -- everything that is still allocated is released at once when the arena is destroyed, not thread-safe
+	class ArenaResource : public std::pmr::memory_resource
+	{
+	public:
+
+		struct Statistics
+		{
+			std::uint64_t allocations = 0;
+			std::uint64_t blocks = 0;
+			std::uint64_t blockBytes = 0;
+			std::uint64_t largeAllocations = 0;
+			std::uint64_t largeBytes = 0;
+		};
+
+		ArenaResource(std::size_t blockSize = 64 * 1024, std::pmr::memory_resource * upstream = std::pmr::new_delete_resource());
+		~ArenaResource();
+
+		ArenaResource(const ArenaResource &) = delete;
+		ArenaResource & operator=(const ArenaResource &) = delete;
+
+		void release();
+		const Statistics & statistics() const;
+
+	protected:
+		void * do_allocate(std::size_t bytes, std::size_t alignment) override;
+		void do_deallocate(void * pointer, std::size_t bytes, std::size_t alignment) override;
+		bool do_is_equal(const std::pmr::memory_resource & other) const noexcept override;
+
+	private:
+
+		struct Block
+		{
+			Block * next;
+			std::size_t size;
+		};
+
+		struct LargeAllocation
+		{
+			LargeAllocation * previous;
+			LargeAllocation * next;
+			std::size_t size;
+			std::size_t alignment;
+		};
+
+		static std::size_t largeHeaderSize(std::size_t alignment);
+
+		std::pmr::memory_resource * m_upstream;
+		std::size_t m_blockSize;
+		std::size_t m_largeThreshold;
+
+		Block * m_blocks = nullptr;
+		char * m_current = nullptr;
+		char * m_end = nullptr;
+
+		LargeAllocation * m_largeAllocations = nullptr;
+		Statistics m_statistics;
+	};
+}
@@ -0,0 +1,653 @@
+#include "Benchmark.h"
+#include "ObjLoader.h"
+#include "ThreadPool.h"
+#include "MeshCache.h"
+#include "MemoryStatistics.h"
+#include "TextureLoader.h"
+#include "MeshAnalyzer.h"
+#include "OutOfCoreLoader.h"
+#include "LoadStatistics.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <iostream>
+#include <iomanip>
+#include <vector>
+
+using namespace minity;
+
+bool Benchmark::run(const std::string & name, const std::string & filename, const LoadOptions & options)
+{
+	if (name == "parser")
+		return parser(filename);
+
+	if (name == "cache")
+		return cache(filename, options);
+
+	if (name == "memory")
+		return memory(filename, options);
+
+	if (name == "normals")
+		return normals(filename, options);
+
+	if (name == "textures")
+		return textures(filename, options);
+
+	if (name == "phases")
+		return phases(filename, options);
+
+	if (name == "outofcore")
+		return outOfCore(options);
+
+	std::cerr << "Unknown benchmark '" << name << "'" << std::endl;
+	return false;
+}
+
+bool Benchmark::parser(const std::string & filename)
+{
+	// returns the fastest of a few runs, the first run also warms up the page cache
+	const int repetitions = 3;
+
+	auto measure = [&](const LoadOptions & options, std::uint64_t & checksum) {
+		double best = -1.0;
+
+		for (int i = 0; i < repetitions; i++)
+		{
+			ObjLoader loader(options);
+
+			auto start = std::chrono::steady_clock::now();
+
+			if (!loader.parseObjFile(filename))
+				return -1.0;
+
+			auto end = std::chrono::steady_clock::now();
+			double seconds = std::chrono::duration<double>(end - start).count();
+
+			if (best < 0.0 || seconds < best)
+				best = seconds;
+
+			checksum = loader.parseChecksum();
+		}
+
+		return best;
+	};
+
+	struct Result
+	{
+		std::string name;
+		unsigned int threads;
+		double seconds;
+		std::uint64_t checksum;
+	};
+
+	std::vector<Result> results;
+
+	LoadOptions options;
+	options.parser = LoadOptions::Parser::Stream;
+
+	std::uint64_t checksum = 0;
+	double seconds = measure(options, checksum);
+
+	if (seconds < 0.0)
+	{
+		std::cerr << "Could not open '" << filename << "'" << std::endl;
+		return false;
+	}
+
+	results.push_back({ "stream", 1, seconds, checksum });
+
+	options.parser = LoadOptions::Parser::Mapped;
+	seconds = measure(options, checksum);
+	results.push_back({ "mapped", 1, seconds, checksum });
+
+	const unsigned int hardwareThreads = ThreadPool::hardwareThreads();
+	options.parser = LoadOptions::Parser::Parallel;
+
+	for (unsigned int threads = 1; ; threads *= 2)
+	{
+		threads = std::min(threads, hardwareThreads);
+		options.threadCount = threads;
+		seconds = measure(options, checksum);
+		results.push_back({ "parallel", threads, seconds, checksum });
+
+		if (threads == hardwareThreads)
+			break;
+	}
+
+	// speedups are relative to the parallel parser on a single thread
+	double baseline = results[2].seconds;
+	bool identical = true;
+
+	std::cout << std::left << std::setw(10) << "parser" << std::right << std::setw(8) << "threads" << std::setw(12) << "time [ms]" << std::setw(10) << "speedup" << std::setw(20) << "checksum" << std::endl;
+
+	for (const auto & r : results)
+	{
+		const bool matches = r.checksum == results.front().checksum;
+		identical = identical && matches;
+
+		std::cout << std::left << std::setw(10) << r.name << std::right << std::setw(8) << r.threads
+			<< std::setw(12) << std::fixed << std::setprecision(2) << r.seconds * 1000.0
+			<< std::setw(9) << std::setprecision(2) << (r.seconds > 0.0 ? baseline / r.seconds : 0.0) << "x"
+			<< std::setw(20) << std::hex << r.checksum << std::dec << (matches ? "" : " MISMATCH") << std::endl;
+	}
+
+	if (!identical)
+		std::cerr << "Parsers produced different results" << std::endl;
+
+	return identical;
+}
+
+bool Benchmark::cache(const std::string & filename, const LoadOptions & options)
+{
+	LoadOptions cacheOptions = options;
+	cacheOptions.loadTextures = false;
+
+	// cold: parsing and building the vertices, as done without a valid cache
+	auto coldStart = std::chrono::steady_clock::now();
+
+	ObjLoader loader(cacheOptions);
+
+	if (!loader.loadObjFile(filename))
+	{
+		std::cerr << "Could not open '" << filename << "'" << std::endl;
+		return false;
+	}
+
+	auto coldEnd = std::chrono::steady_clock::now();
+
+	glm::vec3 minimumBounds(std::numeric_limits<float>::max());
+	glm::vec3 maximumBounds(-std::numeric_limits<float>::max());
+
+	for (auto i : loader.indices())
+	{
+		minimumBounds = glm::min(minimumBounds, loader.vertices()[i].position);
+		maximumBounds = glm::max(maximumBounds, loader.vertices()[i].position);
+	}
+
+	MeshCache writeCache(filename, cacheOptions);
+
+	auto writeStart = std::chrono::steady_clock::now();
+
+	if (!writeCache.write(loader, minimumBounds, maximumBounds))
+	{
+		std::cerr << "Could not write '" << writeCache.cacheFilename() << "'" << std::endl;
+		return false;
+	}
+
+	auto writeEnd = std::chrono::steady_clock::now();
+
+	// warm: mapping and validating the cache and copying the geometry, touching every page like the upload would
+	auto warmStart = std::chrono::steady_clock::now();
+
+	MeshCache readCache(filename, cacheOptions);
+
+	if (!readCache.read())
+	{
+		std::cerr << "Could not read '" << readCache.cacheFilename() << "'" << std::endl;
+		return false;
+	}
+
+	auto mapEnd = std::chrono::steady_clock::now();
+
+	std::vector<Vertex> vertices(readCache.vertexData(), readCache.vertexData() + readCache.vertexCount());
+	std::vector<glm::uint> indices(readCache.indexData(), readCache.indexData() + readCache.indexCount());
+
+	auto warmEnd = std::chrono::steady_clock::now();
+
+	const bool identical = vertices.size() == loader.vertices().size() && indices == loader.indices() && readCache.groups().size() == loader.groups().size() &&
+		std::memcmp(vertices.data(), loader.vertices().data(), vertices.size() * sizeof(Vertex)) == 0;
+
+	const double cacheMegabytes = double(std::filesystem::file_size(readCache.cacheFilename())) / (1024.0 * 1024.0);
+	const double coldSeconds = std::chrono::duration<double>(coldEnd - coldStart).count();
+	const double writeSeconds = std::chrono::duration<double>(writeEnd - writeStart).count();
+	const double mapSeconds = std::chrono::duration<double>(mapEnd - warmStart).count();
+	const double warmSeconds = std::chrono::duration<double>(warmEnd - warmStart).count();
+
+	std::cout << std::fixed << std::setprecision(2);
+	std::cout << "cache file       " << readCache.cacheFilename() << " (" << cacheMegabytes << " MB)" << std::endl;
+	std::cout << "cold load        " << coldSeconds * 1000.0 << " ms" << std::endl;
+	std::cout << "cache write      " << writeSeconds * 1000.0 << " ms" << std::endl;
+	std::cout << "warm load        " << warmSeconds * 1000.0 << " ms (" << mapSeconds * 1000.0 << " ms validation, " << (warmSeconds > 0.0 ? cacheMegabytes / warmSeconds : 0.0) << " MB/s)" << std::endl;
+	std::cout << "speedup          " << (warmSeconds > 0.0 ? coldSeconds / warmSeconds : 0.0) << "x" << std::endl;
+
+	if (!identical)
+		std::cerr << "Cached geometry differs from the source" << std::endl;
+
+	return identical;
+}
+
+bool Benchmark::memory(const std::string & filename, const LoadOptions & options)
+{
+	LoadOptions memoryOptions = options;
+	memoryOptions.loadTextures = false;
+	memoryOptions.meshCache = false;
+
+	MemoryStatistics::resetPeak();
+	const MemoryStatistics::Counters before = MemoryStatistics::counters();
+
+	auto start = std::chrono::steady_clock::now();
+
+	ObjLoader loader(memoryOptions);
+
+	if (!loader.loadObjFile(filename))
+	{
+		std::cerr << "Could not open '" << filename << "'" << std::endl;
+		return false;
+	}
+
+	auto end = std::chrono::steady_clock::now();
+
+	const MemoryStatistics::Counters after = MemoryStatistics::counters();
+	const double megabyte = 1024.0 * 1024.0;
+
+	std::cout << std::fixed << std::setprecision(2);
+	std::cout << "load time        " << std::chrono::duration<double>(end - start).count() * 1000.0 << " ms" << std::endl;
+	std::cout << "groups           " << loader.groups().size() << std::endl;
+	std::cout << "vertices         " << loader.vertices().size() << std::endl;
+	const ArenaResource::Statistics arena = loader.arenaStatistics();
+
+	if (MemoryStatistics::counting())
+		std::cout << "allocations      " << after.allocations - before.allocations << std::endl;
+	else
+		std::cout << "allocations      not counted, configure with -DMINITY_COUNT_ALLOCATIONS=ON" << std::endl;
+
+	std::cout << "arena requests   " << arena.allocations << std::endl;
+	std::cout << "arena blocks     " << arena.blocks << " (" << double(arena.blockBytes) / megabyte << " MB)" << std::endl;
+	std::cout << "arena large      " << arena.largeAllocations << " (" << double(arena.largeBytes) / megabyte << " MB)" << std::endl;
+
+	if (MemoryStatistics::counting())
+	{
+		std::cout << "allocated        " << double(after.allocatedBytes - before.allocatedBytes) / megabyte << " MB" << std::endl;
+		std::cout << "peak heap        " << double(after.peakBytes - before.currentBytes) / megabyte << " MB" << std::endl;
+	}
+
+	std::cout << "peak resident    " << double(MemoryStatistics::peakResidentBytes()) / megabyte << " MB" << std::endl;
+
+	return true;
+}
+
+bool Benchmark::normals(const std::string & filename, const LoadOptions & options)
+{
+	const int repetitions = 3;
+	const unsigned int hardwareThreads = ThreadPool::hardwareThreads();
+
+	struct Result
+	{
+		unsigned int threads;
+		double seconds;
+		std::uint64_t checksum;
+	};
+
+	std::vector<Result> results;
+
+	for (unsigned int threads = 1; ; threads *= 2)
+	{
+		threads = std::min(threads, hardwareThreads);
+
+		LoadOptions normalOptions = options;
+		normalOptions.threadCount = threads;
+
+		Result result = { threads, -1.0, 0 };
+
+		for (int i = 0; i < repetitions; i++)
+		{
+			// the generation replaces the parsed normals, so every run starts from a freshly parsed file
+			ObjLoader loader(normalOptions);
+
+			if (!loader.parseObjFile(filename))
+			{
+				std::cerr << "Could not open '" << filename << "'" << std::endl;
+				return false;
+			}
+
+			auto start = std::chrono::steady_clock::now();
+
+			if (!loader.generateNormals())
+			{
+				std::cerr << "'" << filename << "' already has normals" << std::endl;
+				return false;
+			}
+
+			auto end = std::chrono::steady_clock::now();
+			double seconds = std::chrono::duration<double>(end - start).count();
+
+			if (result.seconds < 0.0 || seconds < result.seconds)
+				result.seconds = seconds;
+
+			result.checksum = loader.parseChecksum();
+		}
+
+		results.push_back(result);
+
+		if (threads == hardwareThreads)
+			break;
+	}
+
+	bool identical = true;
+
+	std::cout << std::right << std::setw(8) << "threads" << std::setw(12) << "time [ms]" << std::setw(10) << "speedup" << std::setw(20) << "checksum" << std::endl;
+
+	for (const auto & r : results)
+	{
+		const bool matches = r.checksum == results.front().checksum;
+		identical = identical && matches;
+
+		std::cout << std::setw(8) << r.threads << std::setw(12) << std::fixed << std::setprecision(2) << r.seconds * 1000.0
+			<< std::setw(9) << std::setprecision(2) << (r.seconds > 0.0 ? results.front().seconds / r.seconds : 0.0) << "x"
+			<< std::setw(20) << std::hex << r.checksum << std::dec << (matches ? "" : " MISMATCH") << std::endl;
+	}
+
+	if (!identical)
+		std::cerr << "Thread counts produced different normals" << std::endl;
+
+	return identical;
+}
+
+bool Benchmark::textures(const std::string & filename, const LoadOptions & options)
+{
+	LoadOptions textureOptions = options;
+	textureOptions.loadTextures = false;
+	textureOptions.textureCache = true;
+
+	ObjLoader loader(textureOptions);
+
+	if (!loader.loadObjFile(filename))
+	{
+		std::cerr << "Could not open '" << filename << "'" << std::endl;
+		return false;
+	}
+
+	// maps shared by several materials are encoded once
+	auto maps = loader.textureMaps(loader.objMaterials());
+	std::sort(maps.begin(), maps.end());
+	maps.erase(std::unique(maps.begin(), maps.end(), [](const auto & a, const auto & b) { return a.first == b.first; }), maps.end());
+
+	struct Result
+	{
+		BlockCompressor::Format format = BlockCompressor::Format::None;
+		std::size_t uncompressedBytes = 0;
+		std::size_t compressedBytes = 0;
+		double encodeSeconds = 0.0;
+		bool loaded = false;
+	};
+
+	std::vector<Result> results(maps.size());
+	ThreadPool pool(options.threadCount);
+
+	auto start = std::chrono::steady_clock::now();
+
+	// without a context every format counts as supported, a viewer without BC7 support encodes RGBA images to BC3 again
+	pool.parallelFor(maps.size(), [&](std::size_t i) {
+		const TextureLoader::Image image = TextureLoader::decode(maps[i].first, maps[i].second, textureOptions, BlockCompressor::allFormats());
+
+		results[i].loaded = image.data != nullptr;
+		results[i].format = image.format;
+		results[i].uncompressedBytes = TextureLoader::uncompressedByteSize(image);
+		results[i].compressedBytes = TextureLoader::byteSize(image);
+		results[i].encodeSeconds = image.encodeSeconds;
+	});
+
+	auto end = std::chrono::steady_clock::now();
+
+	const double megabyte = 1024.0 * 1024.0;
+	std::size_t uncompressedBytes = 0;
+	std::size_t compressedBytes = 0;
+	double encodeSeconds = 0.0;
+	bool loaded = true;
+
+	std::cout << std::fixed << std::setprecision(2);
+	std::cout << std::left << std::setw(48) << "texture" << std::right << std::setw(8) << "format" << std::setw(12) << "raw [MB]" << std::setw(12) << "size [MB]" << std::setw(12) << "MB/s" << std::endl;
+
+	for (std::size_t i = 0; i < maps.size(); i++)
+	{
+		const Result & r = results[i];
+
+		if (!r.loaded)
+		{
+			std::cerr << "Could not load '" << maps[i].first << "'" << std::endl;
+			loaded = false;
+			continue;
+		}
+
+		uncompressedBytes += r.uncompressedBytes;
+		compressedBytes += r.compressedBytes;
+		encodeSeconds += r.encodeSeconds;
+
+		// cached images were not encoded again, so there is no throughput to report
+		std::cout << std::left << std::setw(48) << std::filesystem::path(maps[i].first).filename().string() << std::right << std::setw(8) << BlockCompressor::name(r.format)
+			<< std::setw(12) << double(r.uncompressedBytes) / megabyte << std::setw(12) << double(r.compressedBytes) / megabyte
+			<< std::setw(12) << (r.encodeSeconds > 0.0 ? double(r.uncompressedBytes) / megabyte / r.encodeSeconds : 0.0) << std::endl;
+	}
+
+	std::cout << "textures         " << maps.size() << std::endl;
+	std::cout << "total time       " << std::chrono::duration<double>(end - start).count() * 1000.0 << " ms" << std::endl;
+	std::cout << "encode time      " << encodeSeconds * 1000.0 << " ms summed over all threads" << std::endl;
+	std::cout << "uncompressed     " << double(uncompressedBytes) / megabyte << " MB" << std::endl;
+	std::cout << "compressed       " << double(compressedBytes) / megabyte << " MB (" << (compressedBytes > 0 ? double(uncompressedBytes) / double(compressedBytes) : 0.0) << ":1)" << std::endl;
+
+	return loaded;
+}
+
+bool Benchmark::analyze(const std::string & filename, const LoadOptions & options, const std::string & reportFilename)
+{
+	LoadOptions analyzeOptions = options;
+	analyzeOptions.loadTextures = false;
+
+	ObjLoader loader(analyzeOptions);
+
+	if (!loader.loadObjFile(filename))
+	{
+		std::cerr << "Could not open '" << filename << "'" << std::endl;
+		return false;
+	}
+
+	auto start = std::chrono::steady_clock::now();
+
+	MeshAnalyzer::Report report = MeshAnalyzer::analyze(loader.vertices(), loader.indices(), loader.groups(), options.threadCount);
+	report.filename = filename;
+
+	auto end = std::chrono::steady_clock::now();
+
+	if (reportFilename == "-")
+	{
+		std::cout << MeshAnalyzer::json(report);
+		return true;
+	}
+
+	if (!MeshAnalyzer::write(report, reportFilename))
+	{
+		std::cerr << "Could not write '" << reportFilename << "'" << std::endl;
+		return false;
+	}
+
+	std::cout << std::fixed << std::setprecision(3);
+	std::cout << "analysis time    " << std::chrono::duration<double>(end - start).count() * 1000.0 << " ms" << std::endl;
+	std::cout << "groups           " << report.groups.size() << std::endl;
+
+	for (const auto & c : report.total.caches)
+		std::cout << (c.policy == MeshAnalyzer::CachePolicy::FIFO ? "fifo " : "lru  ") << std::setw(2) << c.size << "          acmr " << c.averageCacheMissRatio << ", atvr " << c.averageTransformedVertexRatio << std::endl;
+
+	std::cout << "fetch overread   " << report.total.fetchOverread << std::endl;
+	std::cout << "overdraw         " << report.total.overdraw << std::endl;
+	std::cout << "report           " << reportFilename << std::endl;
+
+	return true;
+}
+
+bool Benchmark::phases(const std::string & filename, const LoadOptions & options)
+{
+	LoadOptions phaseOptions = options;
+	phaseOptions.loadTextures = false;
+	phaseOptions.meshCache = false;
+
+	LoadStatistics statistics;
+	statistics.setFilename(filename);
+
+	{
+		ObjLoader loader(phaseOptions, nullptr, &statistics);
+
+		if (!loader.loadObjFile(filename))
+		{
+			std::cerr << "Could not open '" << filename << "'" << std::endl;
+			return false;
+		}
+	}
+
+	std::cout << statistics.table();
+
+	if (!options.statisticsFilename.empty() && !statistics.write(options.statisticsFilename))
+	{
+		std::cerr << "Could not write '" << options.statisticsFilename << "'" << std::endl;
+		return false;
+	}
+
+	return true;
+}
+
+bool Benchmark::outOfCore(const LoadOptions & options)
+{
+	LoadOptions outOfCoreOptions = options;
+	outOfCoreOptions.loadTextures = false;
+	outOfCoreOptions.meshCache = false;
+
+	if (outOfCoreOptions.memoryLimit == 0)
+		outOfCoreOptions.memoryLimit = std::size_t(64) << 20;
+
+	const std::size_t limit = outOfCoreOptions.memoryLimit;
+	const double megabyte = 1024.0 * 1024.0;
+
+	std::error_code error;
+	std::filesystem::path directory = options.cacheDirectory.empty() ? std::filesystem::temp_directory_path(error) : std::filesystem::path(options.cacheDirectory);
+
+	if (error)
+		directory = ".";
+
+	bool passed = true;
+
+	for (const bool withNormals : { true, false })
+	{
+		// a flat grid in the xy plane facing +z, every row of faces is a group, which makes for many groups spanning windows
+		const std::string filename = (directory / (withNormals ? "minity-outofcore-normals.obj" : "minity-outofcore.obj")).string();
+		const std::size_t columns = 1024;
+		std::size_t rows = 0;
+
+		{
+			std::ofstream os(filename, std::ios::binary | std::ios::trunc);
+
+			if (!os.is_open())
+			{
+				std::cerr << "Could not write '" << filename << "'" << std::endl;
+				return false;
+			}
+
+			char line[256];
+
+			while (std::uint64_t(os.tellp()) < 4 * std::uint64_t(limit) && os.good())
+			{
+				for (std::size_t x = 0; x < columns; x++)
+				{
+					os.write(line, std::snprintf(line, sizeof(line), "v %zu %zu 0\nvt %g %g\n", x, rows, double(x) / double(columns - 1), double(rows % 1024) / 1023.0));
+
+					if (withNormals)
+						os.write("vn 0 0 1\n", 9);
+				}
+
+				if (rows > 0)
+				{
+					os << "g row" << rows << "\n";
+
+					for (std::size_t x = 0; x + 1 < columns; x++)
+					{
+						const std::size_t a = (rows - 1) * columns + x + 1;
+						const std::size_t b = a + 1;
+						const std::size_t c = b + columns;
+						const std::size_t d = a + columns;
+
+						if (withNormals)
+							os.write(line, std::snprintf(line, sizeof(line), "f %zu/%zu/%zu %zu/%zu/%zu %zu/%zu/%zu\nf %zu/%zu/%zu %zu/%zu/%zu %zu/%zu/%zu\n", a, a, a, b, b, b, c, c, c, a, a, a, c, c, c, d, d, d));
+						else
+							os.write(line, std::snprintf(line, sizeof(line), "f %zu/%zu %zu/%zu %zu/%zu\nf %zu/%zu %zu/%zu %zu/%zu\n", a, a, b, b, c, c, a, a, c, c, d, d));
+					}
+				}
+
+				rows++;
+			}
+
+			if (!os.good())
+			{
+				std::cerr << "Could not write '" << filename << "'" << std::endl;
+				os.close();
+				std::filesystem::remove(filename, error);
+				return false;
+			}
+		}
+
+		const std::uintmax_t fileSize = std::filesystem::file_size(filename, error);
+		const std::size_t expectedTriangles = (rows - 1) * (columns - 1) * 2;
+
+		MemoryStatistics::resetPeak();
+		const MemoryStatistics::Counters before = MemoryStatistics::counters();
+
+		auto start = std::chrono::steady_clock::now();
+
+		bool loaded = false;
+		bool valid = true;
+		std::size_t peakBytes = 0;
+
+		{
+			OutOfCoreLoader loader(outOfCoreOptions);
+			loaded = loader.load(filename);
+			peakBytes = std::size_t(MemoryStatistics::counters().peakBytes - before.currentBytes);
+
+			if (loaded)
+			{
+				std::size_t triangles = 0;
+
+				for (const auto & g : loader.groups())
+					triangles += g.count() / 3;
+
+				valid = valid && loader.groups().size() == rows - 1 && triangles == expectedTriangles && loader.indexCount() == expectedTriangles * 3;
+				valid = valid && loader.minimumBounds() == glm::vec3(0.0f) && loader.maximumBounds() == glm::vec3(float(columns - 1), float(rows - 1), 0.0f);
+
+				for (std::size_t i = 0; i < loader.indexCount() && valid; i++)
+					valid = loader.indexData()[i] < loader.vertexCount();
+
+				// generated normals of the flat grid have to match the ones written
+				for (std::size_t i = 0; i < loader.vertexCount() && valid; i++)
+					valid = loader.vertexData()[i].normal.z > 0.999f;
+			}
+		}
+
+		auto end = std::chrono::steady_clock::now();
+
+		std::filesystem::remove(filename, error);
+
+		const bool bounded = peakBytes <= limit;
+
+		std::cout << std::fixed << std::setprecision(2);
+		std::cout << (withNormals ? "with normals" : "without normals") << std::endl;
+		std::cout << "file size        " << double(fileSize) / megabyte << " MB (" << double(fileSize) / double(limit) << "x the limit)" << std::endl;
+		std::cout << "triangles        " << expectedTriangles << std::endl;
+		std::cout << "load time        " << std::chrono::duration<double>(end - start).count() * 1000.0 << " ms" << std::endl;
+
+		// without counting only the peak resident set of the whole process is known, which is not compared with the limit
+		if (MemoryStatistics::counting())
+			std::cout << "peak heap        " << double(peakBytes) / megabyte << " MB of " << double(limit) / megabyte << " MB" << (bounded ? "" : " EXCEEDED") << std::endl;
+		else
+			std::cout << "peak heap        not counted, configure with -DMINITY_COUNT_ALLOCATIONS=ON" << std::endl;
+
+		std::cout << "geometry         " << (!loaded ? "NOT LOADED" : valid ? "valid" : "INVALID") << std::endl;
+
+		passed = passed && loaded && valid && bounded;
+	}
+
+	if (!passed)
+		std::cerr << "Out of core loading failed" << std::endl;
+
+	return passed;
+}
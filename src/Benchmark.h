@@ -0,0 +1,46 @@
+#pragma once
+
+#include "Model.h"
+
+#include <string>
+
+namespace minity
+{
+	// command line benchmarks which run without creating a window or an OpenGL context
+	class Benchmark
+	{
+	public:
+		// runs the benchmark with the given name on a model file, returns false for unknown names or failures
+		static bool run(const std::string & name, const std::string & filename, const LoadOptions & options = LoadOptions());
+
+		// times parsing with the stream and mapped parsers and the parallel parser on 1, 2, 4, ... threads
+		static bool parser(const std::string & filename);
+
+		// compares a cold load from the source file with a warm load from the mesh cache
+		static bool cache(const std::string & filename, const LoadOptions & options);
+
+		// counts heap allocations and peak memory of loading a model once, peak resident memory
+		// is only meaningful as long as nothing else was loaded in the same process before
+		static bool memory(const std::string & filename, const LoadOptions & options);
+
+		// times the normal generation on 1, 2, 4, ... threads with the weighting and crease angle of the options
+		// and checks that all thread counts produce the same normals
+		static bool normals(const std::string & filename, const LoadOptions & options);
+
+		// encodes all textures of a model to block compressed mipmap chains in the texture cache, in all formats
+		// a context may support, so the viewer finds them ready, and reports sizes and encoder throughput
+		static bool textures(const std::string & filename, const LoadOptions & options);
+
+		// loads a model from the source without textures, prints the phases of loading and writes them as JSON
+		// to the statistics file of the options if there is one
+		static bool phases(const std::string & filename, const LoadOptions & options);
+
+		// writes a synthetic model four times the memory limit of the options, 64 MB without one, with and without normals,
+		// loads it out of core and checks the peak heap against the limit and the geometry against the expected grid
+		static bool outOfCore(const LoadOptions & options);
+
+		// loads a model without textures and writes the vertex cache, vertex fetch and overdraw analysis
+		// of its groups as JSON to the report file, or to the standard output for "-"
+		static bool analyze(const std::string & filename, const LoadOptions & options, const std::string & reportFilename);
+	};
+}
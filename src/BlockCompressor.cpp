@@ -0,0 +1,494 @@
+#include "BlockCompressor.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <globjects/globjects.h>
+
+using namespace minity;
+using namespace gl;
+
+namespace
+{
+	// texels of one block, expanded to four channels
+	typedef unsigned char Block[16][4];
+
+	void fetchBlock(const unsigned char * pixels, int width, int height, int channels, int blockX, int blockY, Block & block)
+	{
+		for (int y = 0; y < 4; y++)
+		{
+			const int py = std::min(blockY * 4 + y, height - 1);
+
+			for (int x = 0; x < 4; x++)
+			{
+				const int px = std::min(blockX * 4 + x, width - 1);
+				const unsigned char * texel = pixels + (std::size_t(py) * std::size_t(width) + std::size_t(px)) * std::size_t(channels);
+				unsigned char * target = block[y * 4 + x];
+
+				target[0] = texel[0];
+				target[1] = channels > 1 ? texel[1] : 0;
+				target[2] = channels > 2 ? texel[2] : 0;
+				target[3] = channels > 3 ? texel[3] : 255;
+			}
+		}
+	}
+
+	// principal axis of the texels in the first n channels by power iteration, returns false if all texels are equal
+	template <int n> bool principalAxis(const Block & block, float mean[n], float axis[n])
+	{
+		for (int c = 0; c < n; c++)
+		{
+			mean[c] = 0.0f;
+
+			for (int i = 0; i < 16; i++)
+				mean[c] += float(block[i][c]);
+
+			mean[c] /= 16.0f;
+		}
+
+		float covariance[n][n] = {};
+
+		for (int i = 0; i < 16; i++)
+		{
+			for (int a = 0; a < n; a++)
+			{
+				for (int b = 0; b < n; b++)
+					covariance[a][b] += (float(block[i][a]) - mean[a]) * (float(block[i][b]) - mean[b]);
+			}
+		}
+
+		// starting with the channel of the largest variance avoids starting orthogonal to the axis
+		int largest = 0;
+
+		for (int c = 1; c < n; c++)
+		{
+			if (covariance[c][c] > covariance[largest][largest])
+				largest = c;
+		}
+
+		if (covariance[largest][largest] <= 0.0f)
+			return false;
+
+		for (int c = 0; c < n; c++)
+			axis[c] = covariance[largest][c];
+
+		for (int iteration = 0; iteration < 8; iteration++)
+		{
+			float next[n] = {};
+			float length = 0.0f;
+
+			for (int a = 0; a < n; a++)
+			{
+				for (int b = 0; b < n; b++)
+					next[a] += covariance[a][b] * axis[b];
+
+				length += next[a] * next[a];
+			}
+
+			if (length <= 0.0f)
+				return false;
+
+			length = std::sqrt(length);
+
+			for (int c = 0; c < n; c++)
+				axis[c] = next[c] / length;
+		}
+
+		return true;
+	}
+
+	// the two texels spanning the block along its principal axis
+	template <int n> void endpoints(const Block & block, float first[n], float second[n])
+	{
+		float mean[n];
+		float axis[n];
+
+		if (!principalAxis<n>(block, mean, axis))
+		{
+			for (int c = 0; c < n; c++)
+				first[c] = second[c] = float(block[0][c]);
+
+			return;
+		}
+
+		float minimum = 0.0f;
+		float maximum = 0.0f;
+
+		for (int i = 0; i < 16; i++)
+		{
+			float t = 0.0f;
+
+			for (int c = 0; c < n; c++)
+				t += (float(block[i][c]) - mean[c]) * axis[c];
+
+			minimum = std::min(minimum, t);
+			maximum = std::max(maximum, t);
+		}
+
+		for (int c = 0; c < n; c++)
+		{
+			first[c] = std::min(255.0f, std::max(0.0f, mean[c] + axis[c] * maximum));
+			second[c] = std::min(255.0f, std::max(0.0f, mean[c] + axis[c] * minimum));
+		}
+	}
+
+	template <int n> int nearest(const unsigned char texel[4], const int palette[][4], int paletteSize)
+	{
+		int best = 0;
+		int bestError = std::numeric_limits<int>::max();
+
+		for (int p = 0; p < paletteSize; p++)
+		{
+			int error = 0;
+
+			for (int c = 0; c < n; c++)
+			{
+				const int d = int(texel[c]) - palette[p][c];
+				error += d * d;
+			}
+
+			if (error < bestError)
+			{
+				best = p;
+				bestError = error;
+			}
+		}
+
+		return best;
+	}
+
+	std::uint16_t packColor(const float color[3])
+	{
+		const int r = int(color[0] * 31.0f / 255.0f + 0.5f);
+		const int g = int(color[1] * 63.0f / 255.0f + 0.5f);
+		const int b = int(color[2] * 31.0f / 255.0f + 0.5f);
+		return std::uint16_t((r << 11) | (g << 5) | b);
+	}
+
+	void unpackColor(std::uint16_t color, int rgb[4])
+	{
+		const int r = (color >> 11) & 31;
+		const int g = (color >> 5) & 63;
+		const int b = color & 31;
+		rgb[0] = (r << 3) | (r >> 2);
+		rgb[1] = (g << 2) | (g >> 4);
+		rgb[2] = (b << 3) | (b >> 2);
+		rgb[3] = 255;
+	}
+
+	// 8 bytes: two RGB565 endpoints and 2 bit indices, always in the four color mode
+	void encodeColorBlock(const Block & block, unsigned char * target)
+	{
+		float first[3];
+		float second[3];
+		endpoints<3>(block, first, second);
+
+		std::uint16_t color0 = packColor(first);
+		std::uint16_t color1 = packColor(second);
+		std::uint32_t indices = 0;
+
+		if (color0 < color1)
+			std::swap(color0, color1);
+
+		// equal endpoints would select the three color mode with transparent black, index 0 is used for all texels instead
+		if (color0 != color1)
+		{
+			int palette[4][4];
+			unpackColor(color0, palette[0]);
+			unpackColor(color1, palette[1]);
+
+			for (int c = 0; c < 3; c++)
+			{
+				palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+				palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+			}
+
+			for (int i = 0; i < 16; i++)
+				indices |= std::uint32_t(nearest<3>(block[i], palette, 4)) << (2 * i);
+		}
+
+		std::memcpy(target, &color0, 2);
+		std::memcpy(target + 2, &color1, 2);
+		std::memcpy(target + 4, &indices, 4);
+	}
+
+	// 8 bytes: two 8 bit endpoints and 3 bit indices into the eight value mode
+	void encodeChannelBlock(const Block & block, int channel, unsigned char * target)
+	{
+		int maximum = 0;
+		int minimum = 255;
+
+		for (int i = 0; i < 16; i++)
+		{
+			maximum = std::max(maximum, int(block[i][channel]));
+			minimum = std::min(minimum, int(block[i][channel]));
+		}
+
+		std::uint64_t bits = std::uint64_t(maximum) | (std::uint64_t(minimum) << 8);
+
+		if (maximum != minimum)
+		{
+			int palette[8];
+			palette[0] = maximum;
+			palette[1] = minimum;
+
+			for (int p = 2; p < 8; p++)
+				palette[p] = ((8 - p) * maximum + (p - 1) * minimum + 3) / 7;
+
+			for (int i = 0; i < 16; i++)
+			{
+				int best = 0;
+				int bestError = 256;
+
+				for (int p = 0; p < 8; p++)
+				{
+					const int error = std::abs(int(block[i][channel]) - palette[p]);
+
+					if (error < bestError)
+					{
+						best = p;
+						bestError = error;
+					}
+				}
+
+				bits |= std::uint64_t(best) << (16 + 3 * i);
+			}
+		}
+
+		std::memcpy(target, &bits, 8);
+	}
+
+	class BitWriter
+	{
+	public:
+		BitWriter(unsigned char * target) : m_target(target)
+		{
+			std::memset(m_target, 0, 16);
+		}
+
+		void write(unsigned int value, int count)
+		{
+			for (int i = 0; i < count; i++, m_position++)
+			{
+				if (value & (1u << i))
+					m_target[m_position / 8] |= (unsigned char)(1u << (m_position % 8));
+			}
+		}
+
+	private:
+		unsigned char * m_target;
+		int m_position = 0;
+	};
+
+	// 16 bytes in mode 6: one subset with RGBA 7.7.7.7 endpoints, one p-bit per endpoint and 4 bit indices
+	void encodeBptcBlock(const Block & block, unsigned char * target)
+	{
+		static const int weights[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+		float first[4];
+		float second[4];
+		endpoints<4>(block, first, second);
+
+		// the p-bit is shared by all channels of an endpoint, so the one with the smaller error is chosen
+		int quantized[2][4];
+		int pbits[2];
+		int palette[16][4];
+		const float * endpoint[2] = { first, second };
+
+		for (int e = 0; e < 2; e++)
+		{
+			float bestError = std::numeric_limits<float>::max();
+
+			for (int p = 0; p < 2; p++)
+			{
+				int q[4];
+				float error = 0.0f;
+
+				for (int c = 0; c < 4; c++)
+				{
+					q[c] = std::min(127, std::max(0, int(std::floor((endpoint[e][c] - float(p)) * 0.5f + 0.5f))));
+					const float d = float((q[c] << 1) | p) - endpoint[e][c];
+					error += d * d;
+				}
+
+				if (error < bestError)
+				{
+					bestError = error;
+					pbits[e] = p;
+					std::copy(q, q + 4, quantized[e]);
+				}
+			}
+		}
+
+		for (int i = 0; i < 16; i++)
+		{
+			for (int c = 0; c < 4; c++)
+			{
+				const int v0 = (quantized[0][c] << 1) | pbits[0];
+				const int v1 = (quantized[1][c] << 1) | pbits[1];
+				palette[i][c] = ((64 - weights[i]) * v0 + weights[i] * v1 + 32) >> 6;
+			}
+		}
+
+		int indices[16];
+
+		for (int i = 0; i < 16; i++)
+			indices[i] = nearest<4>(block[i], palette, 16);
+
+		// the most significant index bit of the first texel is implicitly zero
+		if (indices[0] >= 8)
+		{
+			std::swap(quantized[0], quantized[1]);
+			std::swap(pbits[0], pbits[1]);
+
+			for (int i = 0; i < 16; i++)
+				indices[i] = 15 - indices[i];
+		}
+
+		BitWriter writer(target);
+		writer.write(1u << 6, 7);
+
+		for (int c = 0; c < 4; c++)
+		{
+			writer.write(unsigned(quantized[0][c]), 7);
+			writer.write(unsigned(quantized[1][c]), 7);
+		}
+
+		writer.write(unsigned(pbits[0]), 1);
+		writer.write(unsigned(pbits[1]), 1);
+		writer.write(unsigned(indices[0]), 3);
+
+		for (int i = 1; i < 16; i++)
+			writer.write(unsigned(indices[i]), 4);
+	}
+}
+
+unsigned int BlockCompressor::formatBit(Format format)
+{
+	return 1u << unsigned(format);
+}
+
+unsigned int BlockCompressor::allFormats()
+{
+	return formatBit(Format::BC1) | formatBit(Format::BC3) | formatBit(Format::BC4) | formatBit(Format::BC5) | formatBit(Format::BC7);
+}
+
+unsigned int BlockCompressor::supportedFormats()
+{
+	// RGTC is core since OpenGL 3.0, S3TC and BPTC (core in 4.2) are extensions for our 4.0 context
+	unsigned int formats = formatBit(Format::BC4) | formatBit(Format::BC5);
+
+	if (globjects::hasExtension(GLextension::GL_EXT_texture_compression_s3tc))
+		formats |= formatBit(Format::BC1) | formatBit(Format::BC3);
+
+	if (globjects::hasExtension(GLextension::GL_ARB_texture_compression_bptc))
+		formats |= formatBit(Format::BC7);
+
+	return formats;
+}
+
+const char * BlockCompressor::name(Format format)
+{
+	switch (format)
+	{
+	case Format::BC1:
+		return "BC1";
+	case Format::BC3:
+		return "BC3";
+	case Format::BC4:
+		return "BC4";
+	case Format::BC5:
+		return "BC5";
+	case Format::BC7:
+		return "BC7";
+	default:
+		return "uncompressed";
+	}
+}
+
+GLenum BlockCompressor::internalFormat(Format format)
+{
+	switch (format)
+	{
+	case Format::BC1:
+		return GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+	case Format::BC3:
+		return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+	case Format::BC4:
+		return GL_COMPRESSED_RED_RGTC1;
+	case Format::BC5:
+		return GL_COMPRESSED_RG_RGTC2;
+	case Format::BC7:
+		return GL_COMPRESSED_RGBA_BPTC_UNORM;
+	default:
+		return GL_NONE;
+	}
+}
+
+std::size_t BlockCompressor::blockSize(Format format)
+{
+	switch (format)
+	{
+	case Format::BC1:
+	case Format::BC4:
+		return 8;
+	case Format::BC3:
+	case Format::BC5:
+	case Format::BC7:
+		return 16;
+	default:
+		return 0;
+	}
+}
+
+std::size_t BlockCompressor::compressedSize(Format format, int width, int height)
+{
+	return std::size_t((width + 3) / 4) * std::size_t((height + 3) / 4) * blockSize(format);
+}
+
+void BlockCompressor::compress(Format format, const unsigned char * pixels, int width, int height, int channels, unsigned char * blocks)
+{
+	const int blockWidth = (width + 3) / 4;
+	const int blockHeight = (height + 3) / 4;
+	const std::size_t size = blockSize(format);
+
+	Block block;
+
+	for (int by = 0; by < blockHeight; by++)
+	{
+		for (int bx = 0; bx < blockWidth; bx++)
+		{
+			fetchBlock(pixels, width, height, channels, bx, by, block);
+			unsigned char * target = blocks + (std::size_t(by) * std::size_t(blockWidth) + std::size_t(bx)) * size;
+
+			switch (format)
+			{
+			case Format::BC1:
+				encodeColorBlock(block, target);
+				break;
+
+			case Format::BC3:
+				encodeChannelBlock(block, 3, target);
+				encodeColorBlock(block, target + 8);
+				break;
+
+			case Format::BC4:
+				encodeChannelBlock(block, 0, target);
+				break;
+
+			case Format::BC5:
+				encodeChannelBlock(block, 0, target);
+				encodeChannelBlock(block, 1, target + 8);
+				break;
+
+			case Format::BC7:
+				encodeBptcBlock(block, target);
+				break;
+
+			default:
+				break;
+			}
+		}
+	}
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <glbinding/gl/gl.h>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace minity
+{
+	// CPU encoders for the block compressed texture formats, which store 4x4 texel blocks of 8 bit channels
+	class BlockCompressor
+	{
+	public:
+
+		enum class Format : std::uint32_t
+		{
+			None = 0,
+			// RGB, 4 bits per texel
+			BC1 = 1,
+			// RGBA with separately encoded alpha, 8 bits per texel
+			BC3 = 3,
+			// single channel, 4 bits per texel
+			BC4 = 4,
+			// two independent channels, 8 bits per texel
+			BC5 = 5,
+			// RGBA, 8 bits per texel, only mode 6 is used by the encoder
+			BC7 = 7
+		};
+
+		// a set of formats has bit n set for format n
+		static unsigned int formatBit(Format format);
+		static unsigned int allFormats();
+		// the formats the current OpenGL context can sample from
+		static unsigned int supportedFormats();
+
+		static const char * name(Format format);
+		static gl::GLenum internalFormat(Format format);
+		static std::size_t blockSize(Format format);
+		static std::size_t compressedSize(Format format, int width, int height);
+
+		// encodes an image with tightly packed rows of the given channel count,
+		// partial blocks at the border repeat the last column and row
+		static void compress(Format format, const unsigned char * pixels, int width, int height, int channels, unsigned char * blocks);
+	};
+}
@@ -19,9 +19,9 @@ using namespace gl;
 using namespace glm;
 using namespace globjects;
 
-BoundingBoxRenderer::BoundingBoxRenderer(Viewer* viewer) : Renderer(viewer)
+const std::array<vec3, 8> & BoundingBoxRenderer::boxVertices()
 {
-	static std::array<vec3, 8> vertices {{
+	static const std::array<vec3, 8> vertices {{
 		// front
 		{-1.0, -1.0, 1.0 },
 		{ 1.0, -1.0, 1.0 },
@@ -34,8 +34,12 @@ BoundingBoxRenderer::BoundingBoxRenderer(Viewer* viewer) : Renderer(viewer)
 		{ -1.0, 1.0, -1.0 }
 	}};
 
-	
-	static std::array< std::array<GLushort, 4>, 6> indices{ {
+	return vertices;
+}
+
+const std::array<std::array<GLushort, 4>, 6> & BoundingBoxRenderer::boxFaces()
+{
+	static const std::array< std::array<GLushort, 4>, 6> indices{ {
 		// front
 		{0,1,2,3},
 		// top
@@ -50,6 +54,14 @@ BoundingBoxRenderer::BoundingBoxRenderer(Viewer* viewer) : Renderer(viewer)
 		{3,2,6,7}
 	}};
 
+	return indices;
+}
+
+BoundingBoxRenderer::BoundingBoxRenderer(Viewer* viewer) : Renderer(viewer)
+{
+	const auto & vertices = boxVertices();
+	const auto & indices = boxFaces();
+
 	m_indices->setData(indices, GL_STATIC_DRAW);
 	m_vertices->setData(vertices, GL_STATIC_DRAW);
 
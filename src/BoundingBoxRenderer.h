@@ -1,5 +1,6 @@
 #pragma once
 #include "Renderer.h"
+#include <array>
 #include <memory>
 
 #include <glm/glm.hpp>
@@ -26,6 +27,10 @@ namespace minity
 		BoundingBoxRenderer(Viewer *viewer);
 		virtual void display();
 
+		// the corners of the box from -1 to 1 and its faces as quads, also used as proxies for the occlusion queries of the model
+		static const std::array<glm::vec3, 8> & boxVertices();
+		static const std::array<std::array<gl::GLushort, 4>, 6> & boxFaces();
+
 	private:
 		
 		std::unique_ptr<globjects::VertexArray> m_vao = std::make_unique<globjects::VertexArray>();
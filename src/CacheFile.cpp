@@ -0,0 +1,145 @@
+#include "CacheFile.h"
+#include "MappedFile.h"
+
+#include <filesystem>
+#include <iomanip>
+#include <sstream>
+#include <system_error>
+
+using namespace minity;
+
+CacheFileKey CacheFileKey::create(const std::string & filename, bool computeHash)
+{
+	std::error_code error;
+	CacheFileKey key;
+	key.filename = std::filesystem::absolute(filename, error).string();
+
+	if (error)
+		key.filename = filename;
+
+	key.size = std::filesystem::file_size(filename, error);
+
+	if (error)
+	{
+		key.size = 0;
+		return key;
+	}
+
+	key.modificationTime = std::int64_t(std::filesystem::last_write_time(filename, error).time_since_epoch().count());
+	key.exists = true;
+
+	if (computeHash)
+		key.contentHash = hashFile(filename);
+
+	return key;
+}
+
+bool CacheFileKey::matches() const
+{
+	CacheFileKey current = create(filename, false);
+
+	if (current.exists != exists)
+		return false;
+
+	if (!current.exists)
+		return true;
+
+	if (current.size != size)
+		return false;
+
+	if (current.modificationTime != modificationTime)
+		return hashFile(filename) == contentHash;
+
+	return true;
+}
+
+void CacheFileKey::write(CacheWriter & writer) const
+{
+	writer.writeString(filename);
+	writer.write(std::uint8_t(exists ? 1 : 0));
+	writer.write(size);
+	writer.write(modificationTime);
+	writer.write(contentHash);
+}
+
+CacheFileKey CacheFileKey::read(CacheReader & reader)
+{
+	CacheFileKey key;
+	key.filename = reader.readString();
+	key.exists = reader.read<std::uint8_t>() != 0;
+	key.size = reader.read<std::uint64_t>();
+	key.modificationTime = reader.read<std::int64_t>();
+	key.contentHash = reader.read<std::uint64_t>();
+	return key;
+}
+
+std::string minity::cacheFilename(const std::string & filename, const std::string & cacheDirectory, const std::string & extension)
+{
+	std::error_code error;
+	std::filesystem::path sourcePath = std::filesystem::absolute(filename, error);
+
+	if (error)
+		sourcePath = filename;
+
+	if (cacheDirectory.empty())
+		return sourcePath.string() + extension;
+
+	// different source files with the same name must not share the same cache file
+	std::stringstream ss;
+	ss << sourcePath.filename().string() << "." << std::hex << std::setw(16) << std::setfill('0') << hashBytes(sourcePath.string().data(), sourcePath.string().size()) << extension;
+
+	std::filesystem::path cachePath = cacheDirectory;
+	cachePath.append(ss.str());
+	return cachePath.string();
+}
+
+bool minity::commitCacheFile(const std::string & temporaryFilename, const std::string & cacheFilename)
+{
+	std::error_code error;
+	std::filesystem::rename(temporaryFilename, cacheFilename, error);
+
+	if (error)
+	{
+		std::filesystem::remove(temporaryFilename, error);
+		return false;
+	}
+
+	return true;
+}
+
+std::uint64_t minity::hashBytes(const void * data, std::size_t size, std::uint64_t seed)
+{
+	// FNV-1a on 64 bit words with an additional multiply-xorshift mix, fast enough to keep up with reading the file
+	const std::uint64_t prime = 1099511628211ull;
+	std::uint64_t h = 14695981039346656037ull ^ seed;
+
+	const unsigned char * bytes = static_cast<const unsigned char*>(data);
+	std::size_t i = 0;
+
+	for (; i + sizeof(std::uint64_t) <= size; i += sizeof(std::uint64_t))
+	{
+		std::uint64_t word;
+		std::memcpy(&word, bytes + i, sizeof(word));
+		h = (h ^ word) * prime;
+		h ^= h >> 32;
+	}
+
+	for (; i < size; i++)
+		h = (h ^ bytes[i]) * prime;
+
+	h ^= std::uint64_t(size);
+	h *= 0xff51afd7ed558ccdull;
+	h ^= h >> 33;
+
+	return h;
+}
+
+std::uint64_t minity::hashFile(const std::string & filename)
+{
+	MappedFile file;
+
+	if (!file.open(filename))
+		return 0;
+
+	return hashBytes(file.data(), file.size());
+}
@@ -0,0 +1,142 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <ostream>
+#include <string>
+
+namespace minity
+{
+	// building blocks shared by the binary cache files (MeshCache, MipmapCache)
+
+	// arrays are aligned within the file, so they can be used in place from the mapping
+	const std::size_t cacheArrayAlignment = 16;
+
+	class CacheWriter
+	{
+	public:
+		CacheWriter(std::ostream & os) : m_os(os)
+		{
+		}
+
+		template <typename T> void write(const T & value)
+		{
+			writeBytes(&value, sizeof(T));
+		}
+
+		void writeString(const std::string & s)
+		{
+			write(std::uint64_t(s.size()));
+			writeBytes(s.data(), s.size());
+		}
+
+		template <typename T> void writeArray(const T * data, std::size_t count)
+		{
+			write(std::uint64_t(count));
+
+			const char padding[cacheArrayAlignment] = {};
+			writeBytes(padding, (cacheArrayAlignment - m_offset % cacheArrayAlignment) % cacheArrayAlignment);
+			writeBytes(data, count * sizeof(T));
+		}
+
+		void writeBytes(const void * data, std::size_t size)
+		{
+			m_os.write(static_cast<const char*>(data), std::streamsize(size));
+			m_offset += size;
+		}
+
+	private:
+		std::ostream & m_os;
+		std::size_t m_offset = 0;
+	};
+
+	class CacheReader
+	{
+	public:
+		CacheReader(const char * data, std::size_t size) : m_data(data), m_size(size)
+		{
+		}
+
+		bool good() const
+		{
+			return m_good;
+		}
+
+		template <typename T> T read()
+		{
+			T value = T();
+
+			if (const char * p = readBytes(sizeof(T)))
+				std::memcpy(&value, p, sizeof(T));
+
+			return value;
+		}
+
+		std::string readString()
+		{
+			const std::uint64_t size = read<std::uint64_t>();
+			const char * p = readBytes(size);
+			return p ? std::string(p, std::size_t(size)) : std::string();
+		}
+
+		template <typename T> const T * readArray(std::size_t & count)
+		{
+			const std::uint64_t size = read<std::uint64_t>();
+			readBytes((cacheArrayAlignment - m_offset % cacheArrayAlignment) % cacheArrayAlignment);
+
+			count = m_good && size <= (m_size - m_offset) / sizeof(T) ? std::size_t(size) : 0;
+			const char * p = readBytes(count * sizeof(T));
+
+			if (size != count)
+				m_good = false;
+
+			return reinterpret_cast<const T*>(p);
+		}
+
+		const char * readBytes(std::uint64_t size)
+		{
+			if (!m_good || size > m_size - m_offset)
+			{
+				m_good = false;
+				return nullptr;
+			}
+
+			const char * p = m_data + m_offset;
+			m_offset += std::size_t(size);
+			return p;
+		}
+
+	private:
+		const char * m_data;
+		std::size_t m_size;
+		std::size_t m_offset = 0;
+		bool m_good = true;
+	};
+
+	// identifies the state of a file the cached data was created from
+	struct CacheFileKey
+	{
+		std::string filename;
+		std::uint64_t size = 0;
+		std::int64_t modificationTime = 0;
+		std::uint64_t contentHash = 0;
+		bool exists = false;
+
+		static CacheFileKey create(const std::string & filename, bool computeHash);
+
+		// touched or copied files still match if their content did not change
+		bool matches() const;
+
+		void write(CacheWriter & writer) const;
+		static CacheFileKey read(CacheReader & reader);
+	};
+
+	// the cache file for a source file, placed next to it or, if a directory is given, in there
+	std::string cacheFilename(const std::string & filename, const std::string & cacheDirectory, const std::string & extension);
+
+	// renames a completely written temporary file to the cache file, so that concurrent readers never see a partial cache
+	bool commitCacheFile(const std::string & temporaryFilename, const std::string & cacheFilename);
+
+	std::uint64_t hashBytes(const void * data, std::size_t size, std::uint64_t seed = 0);
+	std::uint64_t hashFile(const std::string & filename);
+}
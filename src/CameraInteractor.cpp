@@ -1,4 +1,6 @@
 #include "CameraInteractor.h"
+#include "Scene.h"
+#include "Model.h"
 
 #include <iostream>
 #include <algorithm>
@@ -117,6 +119,7 @@ void CameraInteractor::keyEvent(int key, int scancode, int action, int mods)
 		m_benchmark = true;
 		m_startTime = glfwGetTime();
 		m_frameCount = 0;
+		m_triangleCount = 0.0;
 	}
 	else if (key == GLFW_KEY_H && action == GLFW_RELEASE)
 	{
@@ -272,6 +275,7 @@ void CameraInteractor::display()
 	if (m_benchmark)
 	{
 		m_frameCount++;
+		m_triangleCount += double(viewer()->drawnTriangles());
 
 		mat4 viewTransform = viewer()->viewTransform();
 		mat4 inverseViewTransform = inverse(viewTransform);
@@ -287,6 +291,8 @@ void CameraInteractor::display()
 			std::cout << "Benchmark finished." << std::endl;
 			std::cout << "Rendered " << m_frameCount << " frames in " << (currentTime - m_startTime) << " seconds." << std::endl;
 			std::cout << "Average frames/second: " << double(m_frameCount) / (currentTime - m_startTime) << std::endl;
+			std::cout << "Average triangles/frame: " << m_triangleCount / double(m_frameCount) << std::endl;
+			std::cout << "Average triangles/second: " << m_triangleCount / (currentTime - m_startTime) << std::endl;
 
 			m_benchmark = false;
 		}
@@ -38,6 +38,8 @@ namespace minity
 		bool m_benchmark = false;
 		double m_startTime = 0.0;
 		glm::uint m_frameCount = 0;
+		// triangles drawn in the frames of the benchmark
+		double m_triangleCount = 0.0;
 		double m_xPrevious = 0.0, m_yPrevious = 0.0;
 		double m_xCurrent = 0.0, m_yCurrent = 0.0;
 
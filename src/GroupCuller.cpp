@@ -0,0 +1,158 @@
+#include "GroupCuller.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+
+using namespace glm;
+using namespace minity;
+
+GroupCuller::GroupCuller(const std::vector<Group> & groups, unsigned int threadCount) : m_pool(threadCount)
+{
+	const std::size_t count = groups.size();
+
+	for (auto array : { &m_centerX, &m_centerY, &m_centerZ, &m_extentX, &m_extentY, &m_extentZ, &m_offsetX, &m_offsetY, &m_offsetZ })
+		array->resize(count);
+
+	m_visible.assign(count, 1);
+
+	for (std::size_t i = 0; i < count; i++)
+	{
+		const Group & g = groups[i];
+		const vec3 center = (g.minimum_group + g.maximum_group) * 0.5f;
+		const vec3 extent = (g.maximum_group - g.minimum_group) * 0.5f;
+
+		m_centerX[i] = center.x;
+		m_centerY[i] = center.y;
+		m_centerZ[i] = center.z;
+		m_extentX[i] = extent.x;
+		m_extentY[i] = extent.y;
+		m_extentZ[i] = extent.z;
+		m_offsetX[i] = g.offsetVector.x;
+		m_offsetY[i] = g.offsetVector.y;
+		m_offsetZ[i] = g.offsetVector.z;
+	}
+
+	m_statistics.groups = count;
+	m_statistics.visibleGroups = count;
+}
+
+void GroupCuller::cull(const mat4 & modelViewProjectionMatrix, float explosion, bool frustumCulling)
+{
+	auto start = std::chrono::steady_clock::now();
+
+	const std::size_t count = m_visible.size();
+
+	if (!frustumCulling)
+	{
+		std::fill(m_visible.begin(), m_visible.end(), std::uint8_t(1));
+		m_statistics.visibleGroups = count;
+		m_statistics.culledGroups = 0;
+		m_statistics.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		return;
+	}
+
+	// the planes of the frustum from the rows of the matrix, pointing inwards
+	vec4 planes[6];
+	const vec4 row0(modelViewProjectionMatrix[0][0], modelViewProjectionMatrix[1][0], modelViewProjectionMatrix[2][0], modelViewProjectionMatrix[3][0]);
+	const vec4 row1(modelViewProjectionMatrix[0][1], modelViewProjectionMatrix[1][1], modelViewProjectionMatrix[2][1], modelViewProjectionMatrix[3][1]);
+	const vec4 row2(modelViewProjectionMatrix[0][2], modelViewProjectionMatrix[1][2], modelViewProjectionMatrix[2][2], modelViewProjectionMatrix[3][2]);
+	const vec4 row3(modelViewProjectionMatrix[0][3], modelViewProjectionMatrix[1][3], modelViewProjectionMatrix[2][3], modelViewProjectionMatrix[3][3]);
+
+	planes[0] = row3 + row0;
+	planes[1] = row3 - row0;
+	planes[2] = row3 + row1;
+	planes[3] = row3 - row1;
+	planes[4] = row3 + row2;
+	planes[5] = row3 - row2;
+
+	const std::size_t taskCount = std::max<std::size_t>(1, std::min<std::size_t>(m_pool.threadCount(), count / minimumTaskSize));
+	std::vector<std::size_t> taskVisible(taskCount, 0);
+
+	auto task = [&](std::size_t t) {
+		taskVisible[t] = cullRange(count * t / taskCount, count * (t + 1) / taskCount, planes, explosion);
+	};
+
+	if (taskCount == 1)
+		task(0);
+	else
+		m_pool.parallelFor(taskCount, task);
+
+	m_statistics.visibleGroups = 0;
+
+	for (auto v : taskVisible)
+		m_statistics.visibleGroups += v;
+
+	m_statistics.culledGroups = count - m_statistics.visibleGroups;
+
+	auto end = std::chrono::steady_clock::now();
+	m_statistics.seconds = std::chrono::duration<double>(end - start).count();
+}
+
+std::size_t GroupCuller::cullRange(std::size_t begin, std::size_t end, const vec4 * planes, float explosion)
+{
+	const float * centerX = m_centerX.data();
+	const float * centerY = m_centerY.data();
+	const float * centerZ = m_centerZ.data();
+	const float * extentX = m_extentX.data();
+	const float * extentY = m_extentY.data();
+	const float * extentZ = m_extentZ.data();
+	const float * offsetX = m_offsetX.data();
+	const float * offsetY = m_offsetY.data();
+	const float * offsetZ = m_offsetZ.data();
+	std::uint8_t * visible = m_visible.data();
+
+	// the box is outside of a plane if even its corner furthest along the normal is behind it,
+	// the projection of the half extents onto the normal uses the absolute normal components
+	float plane[6][4];
+	float absolute[6][3];
+
+	for (int p = 0; p < 6; p++)
+	{
+		plane[p][0] = planes[p].x;
+		plane[p][1] = planes[p].y;
+		plane[p][2] = planes[p].z;
+		plane[p][3] = planes[p].w;
+		absolute[p][0] = std::abs(planes[p].x);
+		absolute[p][1] = std::abs(planes[p].y);
+		absolute[p][2] = std::abs(planes[p].z);
+	}
+
+	// branch free with the smallest distance of the boxes from the planes, the counting is separate,
+	// so that both loops vectorize
+	for (std::size_t i = begin; i < end; i++)
+	{
+		const float x = centerX[i] + offsetX[i] * explosion;
+		const float y = centerY[i] + offsetY[i] * explosion;
+		const float z = centerZ[i] + offsetZ[i] * explosion;
+
+		float distance = std::numeric_limits<float>::infinity();
+
+		for (int p = 0; p < 6; p++)
+		{
+			const float d = plane[p][0] * x + plane[p][1] * y + plane[p][2] * z + plane[p][3] + absolute[p][0] * extentX[i] + absolute[p][1] * extentY[i] + absolute[p][2] * extentZ[i];
+			distance = distance < d ? distance : d;
+		}
+
+		// written so that a NaN distance keeps the group visible
+		visible[i] = distance < 0.0f ? 0 : 1;
+	}
+
+	std::size_t visibleGroups = 0;
+
+	for (std::size_t i = begin; i < end; i++)
+		visibleGroups += visible[i];
+
+	return visibleGroups;
+}
+
+const std::vector<std::uint8_t> & GroupCuller::visible() const
+{
+	return m_visible;
+}
+
+const GroupCuller::Statistics & GroupCuller::statistics() const
+{
+	return m_statistics;
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "Model.h"
+#include "ThreadPool.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace minity
+{
+	// tests the bounding boxes of all groups against the view frustum every frame, before any of their meshlets,
+	// the boxes are kept as structure of arrays of centers and half extents so that the tests vectorize
+	class GroupCuller
+	{
+	public:
+
+		struct Statistics
+		{
+			std::size_t groups = 0;
+			std::size_t visibleGroups = 0;
+			std::size_t culledGroups = 0;
+			double seconds = 0.0;
+		};
+
+		// a thread count of zero uses all hardware threads
+		GroupCuller(const std::vector<Group> & groups, unsigned int threadCount = 0);
+
+		// the matrix is in model space, every group is moved by its offset vector times the explosion like in the vertex shader,
+		// all groups are visible if frustum culling is disabled
+		void cull(const glm::mat4 & modelViewProjectionMatrix, float explosion, bool frustumCulling);
+
+		// one entry per group, non-zero if it is at least partially inside the frustum
+		const std::vector<std::uint8_t> & visible() const;
+		const Statistics & statistics() const;
+
+	private:
+
+		std::size_t cullRange(std::size_t begin, std::size_t end, const glm::vec4 * planes, float explosion);
+
+		// below this many groups per task the threads cost more than they save
+		static constexpr std::size_t minimumTaskSize = 16384;
+
+		std::vector<float> m_centerX, m_centerY, m_centerZ;
+		std::vector<float> m_extentX, m_extentY, m_extentZ;
+		std::vector<float> m_offsetX, m_offsetY, m_offsetZ;
+
+		std::vector<std::uint8_t> m_visible;
+		Statistics m_statistics;
+		ThreadPool m_pool;
+	};
+}
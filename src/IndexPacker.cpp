@@ -0,0 +1,75 @@
+#include "IndexPacker.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+using namespace glm;
+using namespace minity;
+
+namespace
+{
+	void packRange(const std::vector<uint> & indices, IndexRange & range, std::vector<std::uint8_t> & data)
+	{
+		const std::size_t begin = std::min(std::size_t(range.startIndex), indices.size());
+		const std::size_t end = std::min(std::size_t(range.endIndex), indices.size());
+
+		uint minimum = std::numeric_limits<uint>::max();
+		uint maximum = 0;
+
+		for (std::size_t i = begin; i < end; i++)
+		{
+			minimum = std::min(minimum, indices[i]);
+			maximum = std::max(maximum, indices[i]);
+		}
+
+		if (end <= begin)
+			minimum = maximum = 0;
+
+		range.baseVertex = minimum;
+		range.shortIndices = maximum - minimum <= std::numeric_limits<std::uint16_t>::max();
+
+		// offsets have to be a multiple of the index size
+		const std::size_t indexSize = range.indexSize();
+		data.resize((data.size() + indexSize - 1) / indexSize * indexSize);
+		range.indexOffset = data.size();
+		data.resize(data.size() + (end - begin) * indexSize);
+
+		std::uint8_t * output = data.data() + range.indexOffset;
+
+		for (std::size_t i = begin; i < end; i++)
+		{
+			if (range.shortIndices)
+			{
+				const std::uint16_t index = std::uint16_t(indices[i] - minimum);
+				std::memcpy(output + (i - begin) * sizeof(index), &index, sizeof(index));
+			}
+			else
+			{
+				const uint index = indices[i] - minimum;
+				std::memcpy(output + (i - begin) * sizeof(index), &index, sizeof(index));
+			}
+		}
+	}
+}
+
+std::vector<std::uint8_t> IndexPacker::pack(const std::vector<uint> & indices, std::vector<Group> & groups)
+{
+	std::vector<std::uint8_t> data;
+	data.reserve(indices.size() * sizeof(std::uint16_t));
+
+	for (auto & g : groups)
+		packRange(indices, g, data);
+
+	// the levels of detail after all groups, so that the ranges drawn most often stay together
+	for (auto & g : groups)
+	{
+		for (auto & lod : g.levelsOfDetail)
+			packRange(indices, lod, data);
+	}
+
+	// whole words, since the wireframe shader reads the buffer as an array of them
+	data.resize((data.size() + sizeof(uint) - 1) / sizeof(uint) * sizeof(uint));
+
+	return data;
+}
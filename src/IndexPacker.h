@@ -0,0 +1,19 @@
+#pragma once
+
+#include "Model.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace minity
+{
+	// packs the indices of each group into 16 bits relative to a base vertex where the range of vertices it uses allows it
+	class IndexPacker
+	{
+	public:
+
+		// returns the contents of the index buffer and sets the base vertex, index size and offset of the groups and their levels of detail,
+		// groups which use more than 65536 consecutive vertices keep 32-bit indices
+		static std::vector<std::uint8_t> pack(const std::vector<glm::uint> & indices, std::vector<Group> & groups);
+	};
+}
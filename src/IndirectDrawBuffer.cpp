@@ -0,0 +1,349 @@
+#include "IndirectDrawBuffer.h"
+
+#include <globjects/globjects.h>
+
+#include <algorithm>
+#include <array>
+#include <map>
+#include <numeric>
+#include <tuple>
+
+using namespace minity;
+using namespace gl;
+using namespace glm;
+using namespace globjects;
+
+IndirectDrawBuffer::IndirectDrawBuffer(const std::vector<Group> & groups, const std::vector<Material> & materials)
+{
+	// materials with identical textures share a texture set, like in the RenderQueue
+	std::map<std::array<const Texture*, RenderQueue::textureUnitCount>, uint> textureSets;
+	std::vector<uint> materialTextureSets(materials.size(), 0);
+
+	for (std::size_t m = 0; m < materials.size(); m++)
+	{
+		std::array<const Texture*, RenderQueue::textureUnitCount> textures;
+
+		for (std::size_t unit = 0; unit < RenderQueue::textureUnitCount; unit++)
+			textures[unit] = RenderQueue::texture(materials[m], unit);
+
+		materialTextureSets[m] = textureSets.emplace(textures, uint(textureSets.size())).first->second;
+	}
+
+	std::vector<std::size_t> order(groups.size());
+	std::iota(order.begin(), order.end(), std::size_t(0));
+
+	std::stable_sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) {
+		return std::make_tuple(groups[a].shortIndices, materialTextureSets.at(groups[a].materialIndex)) < std::make_tuple(groups[b].shortIndices, materialTextureSets.at(groups[b].materialIndex));
+	});
+
+	m_commands.resize(groups.size());
+	m_groupCommands.resize(groups.size());
+	m_commandRuns.resize(groups.size());
+
+	std::vector<DrawData> draws(groups.size());
+	std::vector<uint> drawIndices(groups.size());
+
+	for (std::size_t c = 0; c < order.size(); c++)
+	{
+		const Group & g = groups[order[c]];
+		const uint textureSet = materialTextureSets.at(g.materialIndex);
+
+		DrawElementsIndirectCommand & command = m_commands[c];
+		command.count = g.count();
+		command.instanceCount = 1;
+		command.firstIndex = uint(g.indexOffset / g.indexSize());
+		command.baseVertex = GLint(g.baseVertex);
+		// selects the draw index of the command from the instanced attribute
+		command.baseInstance = uint(c);
+
+		draws[c].offsetVector = g.offsetVector;
+		draws[c].material = g.materialIndex;
+		drawIndices[c] = uint(c);
+
+		m_groupCommands[order[c]] = c;
+
+		if (m_runs.empty() || m_runs.back().type != g.indexType() || m_runs.back().textureSet != textureSet)
+		{
+			Run run;
+			run.firstCommand = c;
+			run.type = g.indexType();
+			run.textureSet = textureSet;
+			run.material = g.materialIndex;
+			m_runs.push_back(run);
+		}
+
+		m_runs.back().commandCount++;
+		m_commandRuns[c] = m_runs.size() - 1;
+	}
+
+	m_runEnabled.resize(m_runs.size());
+
+	for (std::size_t r = 0; r < m_runs.size(); r++)
+		m_runEnabled[r] = m_runs[r].commandCount;
+
+	// empty storage is not allowed
+	if (m_commands.empty())
+	{
+		m_commandBuffer->setStorage(std::vector<DrawElementsIndirectCommand>(1), GL_DYNAMIC_STORAGE_BIT);
+		m_drawBuffer->setStorage(std::vector<DrawData>(1), GL_NONE_BIT);
+		m_drawIndexBuffer->setStorage(std::vector<uint>(1, 0), GL_NONE_BIT);
+	}
+	else
+	{
+		m_commandBuffer->setStorage(m_commands, GL_DYNAMIC_STORAGE_BIT);
+		m_drawBuffer->setStorage(draws, GL_NONE_BIT);
+		m_drawIndexBuffer->setStorage(drawIndices, GL_NONE_BIT);
+	}
+
+	m_statistics.draws = m_commands.size();
+	m_statistics.enabledDraws = m_commands.size();
+}
+
+IndirectDrawBuffer::~IndirectDrawBuffer()
+{
+	releaseTextureHandles();
+}
+
+Buffer & IndirectDrawBuffer::drawIndexBuffer()
+{
+	return *m_drawIndexBuffer.get();
+}
+
+void IndirectDrawBuffer::update(const std::vector<bool> & groupEnabled, const std::vector<std::uint8_t> & groupVisible)
+{
+	std::size_t first = m_commands.size();
+	std::size_t last = 0;
+
+	m_statistics.patchedCommands = 0;
+
+	for (std::size_t i = 0; i < m_groupCommands.size(); i++)
+	{
+		const std::size_t c = m_groupCommands[i];
+		const uint instanceCount = groupEnabled.at(i) && groupVisible.at(i) ? 1 : 0;
+
+		if (m_commands[c].instanceCount == instanceCount)
+			continue;
+
+		if (instanceCount)
+		{
+			m_runEnabled[m_commandRuns[c]]++;
+			m_statistics.enabledDraws++;
+		}
+		else
+		{
+			m_runEnabled[m_commandRuns[c]]--;
+			m_statistics.enabledDraws--;
+		}
+
+		m_commands[c].instanceCount = instanceCount;
+		first = std::min(first, c);
+		last = std::max(last, c);
+		m_statistics.patchedCommands++;
+	}
+
+	m_statistics.patchedBytes = 0;
+
+	// one upload for the span of the changed commands, they are usually close together when toggled from the menu
+	if (m_statistics.patchedCommands > 0)
+	{
+		const std::size_t size = (last - first + 1) * sizeof(DrawElementsIndirectCommand);
+		m_commandBuffer->setSubData(GLintptr(first * sizeof(DrawElementsIndirectCommand)), GLsizeiptr(size), &m_commands[first]);
+		m_statistics.patchedBytes = size;
+	}
+}
+
+bool IndirectDrawBuffer::supported()
+{
+	return globjects::hasExtension(GLextension::GL_ARB_multi_draw_indirect) && globjects::hasExtension(GLextension::GL_ARB_shader_storage_buffer_object);
+}
+
+bool IndirectDrawBuffer::bindlessSupported()
+{
+	return globjects::hasExtension(GLextension::GL_ARB_bindless_texture);
+}
+
+void IndirectDrawBuffer::submit(Program & program, const VertexArray & vertexArray, const std::vector<Material> & materials, bool bindless)
+{
+	m_statistics.drawCalls = 0;
+	m_statistics.textureBinds = 0;
+
+	beginRuns(program, materials, bindless);
+	m_commandBuffer->bind(GL_DRAW_INDIRECT_BUFFER);
+
+	for (std::size_t begin = 0; begin < m_runs.size();)
+	{
+		// the textures are not bound with handles, so runs of the same index type are drawn together
+		std::size_t end = begin + 1;
+		std::size_t enabled = m_runEnabled[begin];
+
+		while (bindless && end < m_runs.size() && m_runs[end].type == m_runs[begin].type)
+			enabled += m_runEnabled[end++];
+
+		if (enabled > 0)
+		{
+			const std::size_t commandCount = m_runs[end - 1].firstCommand + m_runs[end - 1].commandCount - m_runs[begin].firstCommand;
+
+			m_statistics.textureBinds += bindRunTextures(begin, materials);
+			vertexArray.multiDrawElementsIndirect(GL_TRIANGLES, m_runs[begin].type, reinterpret_cast<const void*>(m_runs[begin].firstCommand * sizeof(DrawElementsIndirectCommand)), GLsizei(commandCount), 0);
+			m_statistics.drawCalls++;
+		}
+
+		begin = end;
+	}
+
+	Buffer::unbind(GL_DRAW_INDIRECT_BUFFER);
+	endRuns();
+}
+
+const std::vector<IndirectDrawBuffer::Run> & IndirectDrawBuffer::runs() const
+{
+	return m_runs;
+}
+
+std::size_t IndirectDrawBuffer::groupCommand(std::size_t group) const
+{
+	return m_groupCommands[group];
+}
+
+std::size_t IndirectDrawBuffer::commandRun(std::size_t command) const
+{
+	return m_commandRuns[command];
+}
+
+Buffer & IndirectDrawBuffer::commandBuffer()
+{
+	return *m_commandBuffer.get();
+}
+
+Buffer & IndirectDrawBuffer::drawBuffer()
+{
+	return *m_drawBuffer.get();
+}
+
+void IndirectDrawBuffer::beginRuns(Program & program, const std::vector<Material> & materials, bool bindless)
+{
+	m_bindless = bindless;
+	m_drawBuffer->bindBase(GL_SHADER_STORAGE_BUFFER, drawBinding);
+
+	if (bindless)
+	{
+		updateTextureHandles(materials);
+		m_textureHandleBuffer->bindBase(GL_SHADER_STORAGE_BUFFER, textureHandleBinding);
+	}
+	else
+	{
+		for (std::size_t unit = 0; unit < RenderQueue::textureUnitCount; unit++)
+			program.setUniform(RenderQueue::samplerName(unit), GLint(unit));
+	}
+
+	std::fill(std::begin(m_boundTextures), std::end(m_boundTextures), nullptr);
+}
+
+std::size_t IndirectDrawBuffer::bindRunTextures(std::size_t run, const std::vector<Material> & materials)
+{
+	if (m_bindless)
+		return 0;
+
+	std::size_t binds = 0;
+
+	for (std::size_t unit = 0; unit < RenderQueue::textureUnitCount; unit++)
+	{
+		const Texture * t = RenderQueue::texture(materials.at(m_runs[run].material), unit);
+
+		if (t == m_boundTextures[unit])
+			continue;
+
+		if (t)
+			t->bindActive(GLuint(unit));
+		else
+			m_boundTextures[unit]->unbindActive(GLuint(unit));
+
+		m_boundTextures[unit] = t;
+		binds++;
+	}
+
+	return binds;
+}
+
+void IndirectDrawBuffer::endRuns()
+{
+	if (m_bindless)
+		Buffer::unbind(GL_SHADER_STORAGE_BUFFER, textureHandleBinding);
+
+	for (std::size_t unit = 0; unit < RenderQueue::textureUnitCount; unit++)
+	{
+		if (m_boundTextures[unit])
+			m_boundTextures[unit]->unbindActive(GLuint(unit));
+
+		m_boundTextures[unit] = nullptr;
+	}
+
+	Buffer::unbind(GL_SHADER_STORAGE_BUFFER, drawBinding);
+}
+
+const IndirectDrawBuffer::Statistics & IndirectDrawBuffer::statistics() const
+{
+	return m_statistics;
+}
+
+void IndirectDrawBuffer::updateTextureHandles(const std::vector<Material> & materials)
+{
+	std::vector<std::shared_ptr<Texture>> textures(materials.size() * RenderQueue::textureUnitCount);
+
+	for (std::size_t m = 0; m < materials.size(); m++)
+	{
+		const Material & material = materials[m];
+		std::shared_ptr<Texture> * t = &textures[m * RenderQueue::textureUnitCount];
+
+		t[0] = material.diffuseTexture;
+		t[1] = material.ambientTexture;
+		t[2] = material.specularTexture;
+		t[3] = material.objectSpaceNormalTexture;
+		t[4] = material.tangentSpaceNormalTexture;
+	}
+
+	if (textures == m_handleTextures && !m_textureHandles.empty())
+		return;
+
+	releaseTextureHandles();
+
+	m_handleTextures = textures;
+	m_textureHandles.assign(textures.size(), 0);
+
+	// a texture shared by several materials is made resident only once
+	std::map<const Texture*, GLuint64> handles;
+
+	for (std::size_t i = 0; i < textures.size(); i++)
+	{
+		if (!textures[i])
+			continue;
+
+		auto found = handles.find(textures[i].get());
+
+		if (found == handles.end())
+		{
+			const TextureHandle handle = textures[i]->textureHandle();
+			handle.makeResident();
+			m_residentTextures.push_back(textures[i]);
+
+			found = handles.emplace(textures[i].get(), handle.handle()).first;
+		}
+
+		m_textureHandles[i] = found->second;
+	}
+
+	if (m_textureHandles.empty())
+		m_textureHandles.push_back(0);
+
+	m_textureHandleBuffer->setData(m_textureHandles, GL_STATIC_DRAW);
+}
+
+void IndirectDrawBuffer::releaseTextureHandles()
+{
+	for (const auto & t : m_residentTextures)
+		t->textureHandle().makeNonResident();
+
+	m_residentTextures.clear();
+	m_handleTextures.clear();
+	m_textureHandles.clear();
+}
@@ -0,0 +1,134 @@
+#pragma once
+
+#include "Model.h"
+#include "RenderQueue.h"
+
+#include <glm/glm.hpp>
+#include <glbinding/gl/types.h>
+#include <globjects/Buffer.h>
+#include <globjects/Program.h>
+#include <globjects/Texture.h>
+#include <globjects/VertexArray.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace minity
+{
+	// draws all groups of the model from one buffer of indirect commands, the vertex shader reads the explosion offset
+	// and material of each draw from a storage buffer, indexed by an instanced attribute which the base instance of the
+	// command selects, so that no draw parameters extension is needed. with bindless textures the handles of the
+	// materials are in another storage buffer and a multi-draw per index type draws everything, otherwise there is one
+	// per texture set, binding its textures in between
+	class IndirectDrawBuffer
+	{
+	public:
+
+		// the layout glMultiDrawElementsIndirect expects
+		struct DrawElementsIndirectCommand
+		{
+			glm::uint count = 0;
+			glm::uint instanceCount = 0;
+			glm::uint firstIndex = 0;
+			gl::GLint baseVertex = 0;
+			glm::uint baseInstance = 0;
+		};
+
+		// std430 layout of the draws in the vertex shader
+		struct DrawData
+		{
+			glm::vec3 offsetVector = glm::vec3(0.0f);
+			glm::uint material = 0;
+		};
+
+		struct Statistics
+		{
+			std::size_t draws = 0;
+			std::size_t enabledDraws = 0;
+			std::size_t drawCalls = 0;
+			std::size_t textureBinds = 0;
+			// commands rewritten by the last update, and the bytes uploaded for them
+			std::size_t patchedCommands = 0;
+			std::size_t patchedBytes = 0;
+		};
+
+		// consecutive commands with the same index type and texture set
+		struct Run
+		{
+			std::size_t firstCommand = 0;
+			std::size_t commandCount = 0;
+			gl::GLenum type = gl::GL_UNSIGNED_INT;
+			glm::uint textureSet = 0;
+			// any material of the texture set
+			glm::uint material = 0;
+		};
+
+		// the storage buffer bindings of the draws and of the texture handles, the handles of a material are in the
+		// order of the units of RenderQueue
+		static constexpr gl::GLuint drawBinding = 2;
+		static constexpr gl::GLuint textureHandleBinding = 3;
+
+		// the commands draw the groups at full detail, sorted by index type and texture set
+		IndirectDrawBuffer(const std::vector<Group> & groups, const std::vector<Material> & materials);
+		~IndirectDrawBuffer();
+
+		// holds the index of each draw, for the instanced attribute
+		globjects::Buffer & drawIndexBuffer();
+
+		// a group is drawn if it is enabled and visible, only the commands whose instance count changes are uploaded
+		void update(const std::vector<bool> & groupEnabled, const std::vector<std::uint8_t> & groupVisible);
+
+		// whether the context has multi-draw indirect and storage buffers, and whether it can sample textures through handles
+		static bool supported();
+		static bool bindlessSupported();
+
+		// the program has to use the vertex array, with bindless textures the handles are only created once no
+		// texture is pending anymore, since their textures cannot change afterwards
+		void submit(globjects::Program & program, const globjects::VertexArray & vertexArray, const std::vector<Material> & materials, bool bindless);
+
+		const Statistics & statistics() const;
+
+		// the runs, the command of each group, which is also the index of its draw, and the run of each command
+		const std::vector<Run> & runs() const;
+		std::size_t groupCommand(std::size_t group) const;
+		std::size_t commandRun(std::size_t command) const;
+
+		globjects::Buffer & commandBuffer();
+		globjects::Buffer & drawBuffer();
+
+		// for drawing the runs from other command buffers, binds the draws and either the texture handles or the
+		// samplers, binding the textures of a run returns the number of units which changed
+		void beginRuns(globjects::Program & program, const std::vector<Material> & materials, bool bindless);
+		std::size_t bindRunTextures(std::size_t run, const std::vector<Material> & materials);
+		void endRuns();
+
+	private:
+
+		void updateTextureHandles(const std::vector<Material> & materials);
+		void releaseTextureHandles();
+
+		std::vector<DrawElementsIndirectCommand> m_commands;
+		std::vector<std::size_t> m_groupCommands;
+		std::vector<Run> m_runs;
+		std::vector<std::size_t> m_commandRuns;
+		std::vector<std::size_t> m_runEnabled;
+
+		std::unique_ptr<globjects::Buffer> m_commandBuffer = std::make_unique<globjects::Buffer>();
+		std::unique_ptr<globjects::Buffer> m_drawBuffer = std::make_unique<globjects::Buffer>();
+		std::unique_ptr<globjects::Buffer> m_drawIndexBuffer = std::make_unique<globjects::Buffer>();
+		std::unique_ptr<globjects::Buffer> m_textureHandleBuffer = std::make_unique<globjects::Buffer>();
+
+		// the textures the handles were made resident for, they are recreated when the materials change
+		// and kept alive until they are made non-resident again
+		std::vector<std::shared_ptr<globjects::Texture>> m_handleTextures;
+		std::vector<std::shared_ptr<globjects::Texture>> m_residentTextures;
+		std::vector<gl::GLuint64> m_textureHandles;
+
+		bool m_bindless = false;
+		const globjects::Texture * m_boundTextures[RenderQueue::textureUnitCount] = {};
+
+		Statistics m_statistics;
+	};
+}
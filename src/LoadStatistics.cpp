@@ -0,0 +1,189 @@
+#include "LoadStatistics.h"
+#include "MemoryStatistics.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+using namespace minity;
+
+namespace
+{
+	std::string escape(const std::string & text)
+	{
+		std::stringstream ss;
+
+		for (unsigned char c : text)
+		{
+			if (c == '"' || c == '\\')
+				ss << '\\' << c;
+			else if (c < 0x20)
+				ss << "\\u" << std::hex << std::setw(4) << std::setfill('0') << int(c) << std::dec;
+			else
+				ss << c;
+		}
+
+		return ss.str();
+	}
+}
+
+LoadStatistics::Scope::Scope(LoadStatistics * statistics, const std::string & name) : m_statistics(statistics)
+{
+	if (m_statistics)
+		m_phase = m_statistics->begin(name);
+}
+
+LoadStatistics::Scope::~Scope()
+{
+	end();
+}
+
+void LoadStatistics::Scope::add(std::uint64_t bytes, std::uint64_t items)
+{
+	if (m_statistics)
+		m_statistics->add(m_phase, bytes, items);
+}
+
+void LoadStatistics::Scope::end()
+{
+	if (m_statistics)
+		m_statistics->end(m_phase);
+
+	m_statistics = nullptr;
+}
+
+std::size_t LoadStatistics::begin(const std::string & name)
+{
+	// the peak is reset for every phase, so the enclosing one keeps what it has seen so far
+	if (!m_open.empty())
+		m_open.back().peakBytes = std::max(m_open.back().peakBytes, MemoryStatistics::counters().peakBytes);
+
+	MemoryStatistics::resetPeak();
+	const std::uint64_t currentBytes = MemoryStatistics::counters().currentBytes;
+
+	Phase phase;
+	phase.name = name;
+	phase.parent = m_open.empty() ? -1 : int(m_open.back().phase);
+	phase.depth = unsigned(m_open.size());
+	m_phases.push_back(phase);
+
+	OpenPhase open;
+	open.phase = m_phases.size() - 1;
+	open.start = std::chrono::steady_clock::now();
+	open.startBytes = currentBytes;
+	open.peakBytes = currentBytes;
+	m_open.push_back(open);
+
+	return open.phase;
+}
+
+void LoadStatistics::end(std::size_t phase)
+{
+	const auto end = std::chrono::steady_clock::now();
+	const MemoryStatistics::Counters counters = MemoryStatistics::counters();
+
+	if (std::none_of(m_open.begin(), m_open.end(), [phase](const OpenPhase & open) { return open.phase == phase; }))
+		return;
+
+	// phases still open inside of this one end with it
+	while (!m_open.empty())
+	{
+		const OpenPhase open = m_open.back();
+		m_open.pop_back();
+
+		const std::uint64_t peakBytes = std::max(open.peakBytes, counters.peakBytes);
+
+		Phase & p = m_phases[open.phase];
+		p.seconds = std::chrono::duration<double>(end - open.start).count();
+		p.peakMemoryDelta = std::int64_t(peakBytes) - std::int64_t(open.startBytes);
+		p.memoryDelta = std::int64_t(counters.currentBytes) - std::int64_t(open.startBytes);
+
+		if (!m_open.empty())
+			m_open.back().peakBytes = std::max(m_open.back().peakBytes, peakBytes);
+
+		if (open.phase == phase)
+			break;
+	}
+}
+
+void LoadStatistics::add(std::size_t phase, std::uint64_t bytes, std::uint64_t items)
+{
+	m_phases[phase].bytes += bytes;
+	m_phases[phase].items += items;
+}
+
+void LoadStatistics::clear()
+{
+	m_phases.clear();
+	m_open.clear();
+}
+
+const std::vector<LoadStatistics::Phase> & LoadStatistics::phases() const
+{
+	return m_phases;
+}
+
+const std::string & LoadStatistics::filename() const
+{
+	return m_filename;
+}
+
+void LoadStatistics::setFilename(const std::string & filename)
+{
+	m_filename = filename;
+}
+
+std::string LoadStatistics::table() const
+{
+	const double megabyte = 1024.0 * 1024.0;
+
+	std::stringstream ss;
+	ss << std::left << std::setw(32) << "phase" << std::right << std::setw(12) << "time [ms]" << std::setw(12) << "bytes [MB]" << std::setw(12) << "items"
+		<< std::setw(12) << "peak [MB]" << std::setw(12) << "heap [MB]" << "\n";
+
+	for (const auto & p : m_phases)
+	{
+		ss << std::left << std::setw(32) << (std::string(p.depth * 2, ' ') + p.name) << std::right << std::fixed
+			<< std::setw(12) << std::setprecision(2) << p.seconds * 1000.0
+			<< std::setw(12) << std::setprecision(2) << double(p.bytes) / megabyte
+			<< std::setw(12) << p.items
+			<< std::setw(12) << std::setprecision(2) << double(p.peakMemoryDelta) / megabyte
+			<< std::setw(12) << std::setprecision(2) << double(p.memoryDelta) / megabyte << "\n";
+	}
+
+	return ss.str();
+}
+
+std::string LoadStatistics::json() const
+{
+	std::stringstream ss;
+	ss << std::setprecision(6);
+
+	ss << "{\n";
+	ss << "\t\"model\": \"" << escape(m_filename) << "\",\n";
+	ss << "\t\"phases\": [\n";
+
+	for (std::size_t i = 0; i < m_phases.size(); i++)
+	{
+		const Phase & p = m_phases[i];
+		ss << "\t\t{ \"name\": \"" << escape(p.name) << "\", \"parent\": " << p.parent << ", \"seconds\": " << p.seconds << ", \"bytes\": " << p.bytes << ", \"items\": " << p.items
+			<< ", \"peakMemoryDelta\": " << p.peakMemoryDelta << ", \"memoryDelta\": " << p.memoryDelta << " }" << (i + 1 < m_phases.size() ? "," : "") << "\n";
+	}
+
+	ss << "\t]\n";
+	ss << "}\n";
+
+	return ss.str();
+}
+
+bool LoadStatistics::write(const std::string & filename) const
+{
+	std::ofstream os(filename, std::ios::trunc);
+
+	if (!os.is_open())
+		return false;
+
+	os << json();
+	return os.good();
+}
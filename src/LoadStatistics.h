@@ -0,0 +1,84 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace minity
+{
+	// wall time, processed amounts and heap growth of the phases of loading a model, phases nest and have to be
+	// recorded on the loading thread, while the heap is that of the whole process as counted by MemoryStatistics,
+	// which is zero unless the allocations are counted
+	class LoadStatistics
+	{
+	public:
+
+		struct Phase
+		{
+			std::string name;
+			// index of the enclosing phase, which comes first, -1 for phases at the top
+			int parent = -1;
+			unsigned int depth = 0;
+			double seconds = 0.0;
+			// the phase decides what counts, e.g. bytes of the file and parsed lines, or bytes uploaded and vertices
+			std::uint64_t bytes = 0;
+			std::uint64_t items = 0;
+			// highest heap during the phase and heap at its end, relative to the heap at its start
+			std::int64_t peakMemoryDelta = 0;
+			std::int64_t memoryDelta = 0;
+		};
+
+		// records a phase from construction to destruction, does nothing without statistics,
+		// so that loaders can be instrumented unconditionally
+		class Scope
+		{
+		public:
+			Scope(LoadStatistics * statistics, const std::string & name);
+			~Scope();
+
+			Scope(const Scope &) = delete;
+			Scope & operator=(const Scope &) = delete;
+
+			void add(std::uint64_t bytes, std::uint64_t items);
+			// ends the phase before the scope does
+			void end();
+
+		private:
+			LoadStatistics * m_statistics = nullptr;
+			std::size_t m_phase = 0;
+		};
+
+		std::size_t begin(const std::string & name);
+		void end(std::size_t phase);
+		void add(std::size_t phase, std::uint64_t bytes, std::uint64_t items);
+
+		void clear();
+		const std::vector<Phase> & phases() const;
+
+		// the model the phases belong to, only used for the reports
+		const std::string & filename() const;
+		void setFilename(const std::string & filename);
+
+		// an indented table with one line per phase
+		std::string table() const;
+		std::string json() const;
+		bool write(const std::string & filename) const;
+
+	private:
+
+		struct OpenPhase
+		{
+			std::size_t phase = 0;
+			std::chrono::steady_clock::time_point start;
+			std::uint64_t startBytes = 0;
+			// highest heap seen by the phase before its nested phases reset the peak
+			std::uint64_t peakBytes = 0;
+		};
+
+		std::string m_filename;
+		std::vector<Phase> m_phases;
+		std::vector<OpenPhase> m_open;
+	};
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <string>
+#include <cstddef>
+
+namespace minity
+{
+	// read-only memory mapping of a whole file, the contents stay valid until the object is closed or destroyed
+	class MappedFile
+	{
+	public:
+		MappedFile();
+		MappedFile(const std::string & filename);
+		~MappedFile();
+
+		MappedFile(const MappedFile &) = delete;
+		MappedFile & operator=(const MappedFile &) = delete;
+
+		bool open(const std::string & filename);
+		void close();
+
+		bool isOpen() const;
+		const char * data() const;
+		std::size_t size() const;
+
+	private:
+
+		const char * m_data = nullptr;
+		std::size_t m_size = 0;
+		bool m_open = false;
+
+#ifdef _WIN32
+		void * m_file = nullptr;
+		void * m_mapping = nullptr;
+#else
+		int m_file = -1;
+#endif
+	};
+}
\ No newline at end of file
@@ -0,0 +1,276 @@
+#include "MemoryStatistics.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#include <malloc.h>
+#elif defined(__APPLE__)
+#include <malloc/malloc.h>
+#include <sys/resource.h>
+#else
+#include <malloc.h>
+#include <sys/resource.h>
+#endif
+
+using namespace minity;
+
+#ifdef MINITY_COUNT_ALLOCATIONS
+
+namespace
+{
+	std::atomic<std::uint64_t> allocations(0);
+	std::atomic<std::uint64_t> deallocations(0);
+	std::atomic<std::uint64_t> allocatedBytes(0);
+	std::atomic<std::uint64_t> currentBytes(0);
+	std::atomic<std::uint64_t> peakBytes(0);
+
+	// the size is taken from the allocator, so that unsized deletes are accounted for correctly
+	std::size_t allocationSize(void * pointer, std::size_t alignment = 0)
+	{
+#ifdef _WIN32
+		if (alignment > alignof(std::max_align_t))
+			return _aligned_msize(pointer, alignment, 0);
+
+		return _msize(pointer);
+#elif defined(__APPLE__)
+		return malloc_size(pointer);
+#else
+		return malloc_usable_size(pointer);
+#endif
+	}
+
+	void * allocate(std::size_t size, std::size_t alignment = 0)
+	{
+		void * pointer = nullptr;
+
+		if (size == 0)
+			size = 1;
+
+		if (alignment > alignof(std::max_align_t))
+		{
+#ifdef _WIN32
+			pointer = _aligned_malloc(size, alignment);
+#else
+			if (posix_memalign(&pointer, alignment, size) != 0)
+				pointer = nullptr;
+#endif
+		}
+		else
+		{
+			pointer = std::malloc(size);
+		}
+
+		if (pointer == nullptr)
+			return nullptr;
+
+		const std::uint64_t bytes = allocationSize(pointer, alignment);
+		allocations.fetch_add(1, std::memory_order_relaxed);
+		allocatedBytes.fetch_add(bytes, std::memory_order_relaxed);
+
+		const std::uint64_t current = currentBytes.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+		std::uint64_t peak = peakBytes.load(std::memory_order_relaxed);
+
+		while (current > peak && !peakBytes.compare_exchange_weak(peak, current, std::memory_order_relaxed));
+
+		return pointer;
+	}
+
+	void deallocate(void * pointer, std::size_t alignment = 0)
+	{
+		if (pointer == nullptr)
+			return;
+
+		deallocations.fetch_add(1, std::memory_order_relaxed);
+		currentBytes.fetch_sub(allocationSize(pointer, alignment), std::memory_order_relaxed);
+
+#ifdef _WIN32
+		if (alignment > alignof(std::max_align_t))
+		{
+			_aligned_free(pointer);
+			return;
+		}
+#endif
+
+		std::free(pointer);
+	}
+}
+
+void * operator new(std::size_t size)
+{
+	if (void * pointer = allocate(size))
+		return pointer;
+
+	throw std::bad_alloc();
+}
+
+void * operator new[](std::size_t size)
+{
+	if (void * pointer = allocate(size))
+		return pointer;
+
+	throw std::bad_alloc();
+}
+
+void * operator new(std::size_t size, const std::nothrow_t &) noexcept
+{
+	return allocate(size);
+}
+
+void * operator new[](std::size_t size, const std::nothrow_t &) noexcept
+{
+	return allocate(size);
+}
+
+void operator delete(void * pointer) noexcept
+{
+	deallocate(pointer);
+}
+
+void operator delete[](void * pointer) noexcept
+{
+	deallocate(pointer);
+}
+
+void operator delete(void * pointer, std::size_t) noexcept
+{
+	deallocate(pointer);
+}
+
+void operator delete[](void * pointer, std::size_t) noexcept
+{
+	deallocate(pointer);
+}
+
+void operator delete(void * pointer, const std::nothrow_t &) noexcept
+{
+	deallocate(pointer);
+}
+
+void operator delete[](void * pointer, const std::nothrow_t &) noexcept
+{
+	deallocate(pointer);
+}
+
+void * operator new(std::size_t size, std::align_val_t alignment)
+{
+	if (void * pointer = allocate(size, std::size_t(alignment)))
+		return pointer;
+
+	throw std::bad_alloc();
+}
+
+void * operator new[](std::size_t size, std::align_val_t alignment)
+{
+	if (void * pointer = allocate(size, std::size_t(alignment)))
+		return pointer;
+
+	throw std::bad_alloc();
+}
+
+void * operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t &) noexcept
+{
+	return allocate(size, std::size_t(alignment));
+}
+
+void * operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t &) noexcept
+{
+	return allocate(size, std::size_t(alignment));
+}
+
+void operator delete(void * pointer, std::align_val_t alignment) noexcept
+{
+	deallocate(pointer, std::size_t(alignment));
+}
+
+void operator delete[](void * pointer, std::align_val_t alignment) noexcept
+{
+	deallocate(pointer, std::size_t(alignment));
+}
+
+void operator delete(void * pointer, std::size_t, std::align_val_t alignment) noexcept
+{
+	deallocate(pointer, std::size_t(alignment));
+}
+
+void operator delete[](void * pointer, std::size_t, std::align_val_t alignment) noexcept
+{
+	deallocate(pointer, std::size_t(alignment));
+}
+
+void operator delete(void * pointer, std::align_val_t alignment, const std::nothrow_t &) noexcept
+{
+	deallocate(pointer, std::size_t(alignment));
+}
+
+void operator delete[](void * pointer, std::align_val_t alignment, const std::nothrow_t &) noexcept
+{
+	deallocate(pointer, std::size_t(alignment));
+}
+
+bool MemoryStatistics::counting()
+{
+	return true;
+}
+
+MemoryStatistics::Counters MemoryStatistics::counters()
+{
+	Counters c;
+	c.allocations = allocations.load(std::memory_order_relaxed);
+	c.deallocations = deallocations.load(std::memory_order_relaxed);
+	c.allocatedBytes = allocatedBytes.load(std::memory_order_relaxed);
+	c.currentBytes = currentBytes.load(std::memory_order_relaxed);
+	c.peakBytes = peakBytes.load(std::memory_order_relaxed);
+	return c;
+}
+
+void MemoryStatistics::resetPeak()
+{
+	peakBytes.store(currentBytes.load(std::memory_order_relaxed), std::memory_order_relaxed);
+}
+
+#else
+
+bool MemoryStatistics::counting()
+{
+	return false;
+}
+
+MemoryStatistics::Counters MemoryStatistics::counters()
+{
+	return Counters();
+}
+
+void MemoryStatistics::resetPeak()
+{
+}
+
+#endif
+
+std::uint64_t MemoryStatistics::peakResidentBytes()
+{
+#ifdef _WIN32
+	PROCESS_MEMORY_COUNTERS memoryCounters;
+
+	if (GetProcessMemoryInfo(GetCurrentProcess(), &memoryCounters, sizeof(memoryCounters)))
+		return std::uint64_t(memoryCounters.PeakWorkingSetSize);
+
+	return 0;
+#else
+	struct rusage usage;
+
+	if (getrusage(RUSAGE_SELF, &usage) != 0)
+		return 0;
+
+#ifdef __APPLE__
+	return std::uint64_t(usage.ru_maxrss);
+#else
+	return std::uint64_t(usage.ru_maxrss) * 1024;
+#endif
+#endif
+}
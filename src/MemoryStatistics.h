@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace minity
+{
+	// counts heap allocations of the whole process through replaced global operators new and delete, which are only
+	// compiled in with the CMake option MINITY_COUNT_ALLOCATIONS, since they slow down every allocation of the viewer
+	class MemoryStatistics
+	{
+	public:
+
+		struct Counters
+		{
+			std::uint64_t allocations = 0;
+			std::uint64_t deallocations = 0;
+			std::uint64_t allocatedBytes = 0;
+			// bytes currently allocated and the maximum since the last resetPeak()
+			std::uint64_t currentBytes = 0;
+			std::uint64_t peakBytes = 0;
+		};
+
+		// without the replaced operators all counters stay zero
+		static bool counting();
+		static Counters counters();
+		static void resetPeak();
+
+		// peak resident set size of the process in bytes, as reported by the operating system
+		static std::uint64_t peakResidentBytes();
+	};
+}
@@ -0,0 +1,348 @@
+#include "MeshAnalyzer.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <sstream>
+#include <unordered_map>
+
+using namespace glm;
+using namespace minity;
+
+namespace
+{
+	const unsigned int cacheSizes[] = { 8, 16, 32 };
+
+	// the post-transform cache size used to decide which vertices are fetched
+	const unsigned int fetchCacheSize = 16;
+	const std::size_t cacheLineSize = 64;
+	// lines kept by the simulated vertex fetch cache, 16 KiB
+	const std::size_t cacheLineCount = 256;
+
+	const int overdrawResolution = 256;
+
+	std::string escape(const std::string & text)
+	{
+		std::stringstream ss;
+
+		for (unsigned char c : text)
+		{
+			if (c == '"' || c == '\\')
+				ss << '\\' << c;
+			else if (c < 0x20)
+				ss << "\\u" << std::hex << std::setw(4) << std::setfill('0') << int(c) << std::dec;
+			else
+				ss << c;
+		}
+
+		return ss.str();
+	}
+
+	const char * policyName(MeshAnalyzer::CachePolicy policy)
+	{
+		return policy == MeshAnalyzer::CachePolicy::FIFO ? "fifo" : "lru";
+	}
+}
+
+MeshAnalyzer::Report MeshAnalyzer::analyze(const std::vector<Vertex> & vertices, const std::vector<uint> & indices, const std::vector<Group> & groups, unsigned int threadCount)
+{
+	Report report;
+	report.groups.resize(groups.size());
+
+	ThreadPool pool(threadCount);
+
+	// the levels of detail are stored after the groups and are not part of the drawn model
+	std::size_t totalCount = groups.empty() ? indices.size() : 0;
+
+	for (const auto & g : groups)
+		totalCount = std::max(totalCount, std::min(std::size_t(g.endIndex), indices.size()));
+
+	// the whole model is analyzed as one more range, first because it takes the longest
+	pool.parallelFor(groups.size() + 1, [&](std::size_t i) {
+		if (i == 0)
+		{
+			report.total = analyzeRange(vertices, indices.data(), totalCount / 3 * 3);
+			report.total.name = "total";
+			return;
+		}
+
+		const Group & g = groups[i - 1];
+		const std::size_t begin = std::min(std::size_t(g.startIndex), indices.size());
+		const std::size_t end = std::min(std::size_t(g.endIndex), indices.size());
+
+		report.groups[i - 1] = analyzeRange(vertices, indices.data() + begin, end > begin ? (end - begin) / 3 * 3 : 0);
+		report.groups[i - 1].name = g.name;
+	});
+
+	return report;
+}
+
+std::string MeshAnalyzer::json(const Report & report)
+{
+	std::stringstream ss;
+	ss << std::setprecision(6);
+
+	auto writeGroup = [&ss](const GroupStatistics & g, const char * indent) {
+		ss << indent << "{\n";
+		ss << indent << "\t\"name\": \"" << escape(g.name) << "\",\n";
+		ss << indent << "\t\"triangles\": " << g.triangles << ",\n";
+		ss << indent << "\t\"vertices\": " << g.vertices << ",\n";
+		ss << indent << "\t\"caches\": [\n";
+
+		for (std::size_t i = 0; i < g.caches.size(); i++)
+		{
+			const CacheStatistics & c = g.caches[i];
+			ss << indent << "\t\t{ \"policy\": \"" << policyName(c.policy) << "\", \"size\": " << c.size
+				<< ", \"acmr\": " << c.averageCacheMissRatio << ", \"atvr\": " << c.averageTransformedVertexRatio << " }" << (i + 1 < g.caches.size() ? "," : "") << "\n";
+		}
+
+		ss << indent << "\t],\n";
+		ss << indent << "\t\"fetchOverread\": " << g.fetchOverread << ",\n";
+		ss << indent << "\t\"overdraw\": " << g.overdraw << "\n";
+		ss << indent << "}";
+	};
+
+	ss << "{\n";
+	ss << "\t\"model\": \"" << escape(report.filename) << "\",\n";
+	ss << "\t\"vertexSize\": " << report.vertexSize << ",\n";
+	ss << "\t\"total\":\n";
+	writeGroup(report.total, "\t");
+	ss << ",\n";
+	ss << "\t\"groups\": [\n";
+
+	for (std::size_t i = 0; i < report.groups.size(); i++)
+	{
+		writeGroup(report.groups[i], "\t\t");
+		ss << (i + 1 < report.groups.size() ? ",\n" : "\n");
+	}
+
+	ss << "\t]\n";
+	ss << "}\n";
+
+	return ss.str();
+}
+
+bool MeshAnalyzer::write(const Report & report, const std::string & filename)
+{
+	std::ofstream os(filename, std::ios::trunc);
+
+	if (!os.is_open())
+		return false;
+
+	os << json(report);
+	return os.good();
+}
+
+MeshAnalyzer::GroupStatistics MeshAnalyzer::analyzeRange(const std::vector<Vertex> & vertices, const uint * indices, std::size_t indexCount)
+{
+	GroupStatistics statistics;
+	statistics.triangles = indexCount / 3;
+
+	// the caches are simulated on indices local to the range, so that their tables are only as large as the range
+	std::vector<uint> unique(indices, indices + indexCount);
+	std::sort(unique.begin(), unique.end());
+	unique.erase(std::unique(unique.begin(), unique.end()), unique.end());
+	statistics.vertices = unique.size();
+
+	std::vector<uint> local(indexCount);
+
+	for (std::size_t i = 0; i < indexCount; i++)
+		local[i] = uint(std::lower_bound(unique.begin(), unique.end(), indices[i]) - unique.begin());
+
+	for (auto policy : { CachePolicy::FIFO, CachePolicy::LRU })
+	{
+		for (auto size : cacheSizes)
+		{
+			std::size_t misses = 0;
+
+			if (policy == CachePolicy::FIFO)
+			{
+				// a vertex is cached if fewer than size misses happened since it was loaded
+				std::vector<std::size_t> loaded(unique.size(), 0);
+				std::size_t time = size + 1;
+
+				for (auto v : local)
+				{
+					if (time - loaded[v] > size)
+					{
+						loaded[v] = time++;
+						misses++;
+					}
+				}
+			}
+			else
+			{
+				std::vector<uint> cache;
+				cache.reserve(size);
+
+				for (auto v : local)
+				{
+					auto entry = std::find(cache.begin(), cache.end(), v);
+
+					if (entry == cache.end())
+					{
+						misses++;
+
+						if (cache.size() == size)
+							cache.pop_back();
+					}
+					else
+					{
+						cache.erase(entry);
+					}
+
+					cache.insert(cache.begin(), v);
+				}
+			}
+
+			CacheStatistics c;
+			c.policy = policy;
+			c.size = size;
+			c.averageCacheMissRatio = statistics.triangles > 0 ? float(misses) / float(statistics.triangles) : 0.0f;
+			c.averageTransformedVertexRatio = statistics.vertices > 0 ? float(misses) / float(statistics.vertices) : 0.0f;
+			statistics.caches.push_back(c);
+		}
+	}
+
+	// vertices missing the post-transform cache are read from the vertex buffer in whole cache lines
+	{
+		std::vector<std::size_t> transformed(unique.size(), 0);
+		std::size_t time = fetchCacheSize + 1;
+		std::unordered_map<std::size_t, std::size_t> lines;
+		std::size_t lineTime = cacheLineCount + 1;
+		std::size_t fetchedLines = 0;
+
+		for (std::size_t i = 0; i < indexCount; i++)
+		{
+			const uint v = local[i];
+
+			if (time - transformed[v] <= fetchCacheSize)
+				continue;
+
+			transformed[v] = time++;
+
+			const std::size_t first = std::size_t(indices[i]) * sizeof(Vertex) / cacheLineSize;
+			const std::size_t last = (std::size_t(indices[i]) * sizeof(Vertex) + sizeof(Vertex) - 1) / cacheLineSize;
+
+			for (std::size_t line = first; line <= last; line++)
+			{
+				std::size_t & loaded = lines[line];
+
+				if (loaded == 0 || lineTime - loaded > cacheLineCount)
+				{
+					loaded = lineTime++;
+					fetchedLines++;
+				}
+			}
+		}
+
+		if (statistics.vertices > 0)
+			statistics.fetchOverread = float(fetchedLines * cacheLineSize) / float(statistics.vertices * sizeof(Vertex));
+	}
+
+	statistics.overdraw = overdraw(vertices, indices, indexCount);
+
+	return statistics;
+}
+
+float MeshAnalyzer::overdraw(const std::vector<Vertex> & vertices, const uint * indices, std::size_t indexCount)
+{
+	if (indexCount < 3)
+		return 0.0f;
+
+	vec3 minimum(std::numeric_limits<float>::max());
+	vec3 maximum(-std::numeric_limits<float>::max());
+
+	for (std::size_t i = 0; i < indexCount; i++)
+	{
+		minimum = min(minimum, vertices[indices[i]].position);
+		maximum = max(maximum, vertices[indices[i]].position);
+	}
+
+	const vec3 center = (minimum + maximum) * 0.5f;
+	const float radius = std::max(length(maximum - minimum) * 0.5f, std::numeric_limits<float>::min());
+
+	// the axes and the diagonals, each looked at from both sides
+	std::vector<vec3> directions;
+
+	for (int axis = 0; axis < 3; axis++)
+	{
+		vec3 d(0.0f);
+		d[axis] = 1.0f;
+		directions.push_back(d);
+		directions.push_back(-d);
+	}
+
+	for (int i = 0; i < 8; i++)
+		directions.push_back(normalize(vec3((i & 1) ? 1.0f : -1.0f, (i & 2) ? 1.0f : -1.0f, (i & 4) ? 1.0f : -1.0f)));
+
+	const int resolution = overdrawResolution;
+	std::vector<float> depth(std::size_t(resolution) * std::size_t(resolution));
+	std::size_t shaded = 0;
+	std::size_t covered = 0;
+
+	for (const auto & direction : directions)
+	{
+		// orthographic view from the side the direction points to, without culling like the renderer
+		const vec3 helper = std::abs(direction.y) < 0.9f ? vec3(0.0f, 1.0f, 0.0f) : vec3(1.0f, 0.0f, 0.0f);
+		const vec3 right = normalize(cross(helper, direction));
+		const vec3 up = cross(direction, right);
+
+		std::fill(depth.begin(), depth.end(), std::numeric_limits<float>::max());
+
+		for (std::size_t t = 0; t + 2 < indexCount; t += 3)
+		{
+			vec3 p[3];
+
+			for (int k = 0; k < 3; k++)
+			{
+				const vec3 d = vertices[indices[t + k]].position - center;
+				p[k] = vec3((dot(d, right) / radius * 0.5f + 0.5f) * float(resolution), (dot(d, up) / radius * 0.5f + 0.5f) * float(resolution), -dot(d, direction));
+			}
+
+			const float area = (p[1].x - p[0].x) * (p[2].y - p[0].y) - (p[2].x - p[0].x) * (p[1].y - p[0].y);
+
+			if (area == 0.0f)
+				continue;
+
+			const int x0 = std::max(0, int(std::floor(std::min({ p[0].x, p[1].x, p[2].x }))));
+			const int x1 = std::min(resolution - 1, int(std::ceil(std::max({ p[0].x, p[1].x, p[2].x }))));
+			const int y0 = std::max(0, int(std::floor(std::min({ p[0].y, p[1].y, p[2].y }))));
+			const int y1 = std::min(resolution - 1, int(std::ceil(std::max({ p[0].y, p[1].y, p[2].y }))));
+
+			for (int y = y0; y <= y1; y++)
+			{
+				for (int x = x0; x <= x1; x++)
+				{
+					const float px = float(x) + 0.5f;
+					const float py = float(y) + 0.5f;
+
+					// barycentric coordinates, positive inside for both windings
+					const float w0 = ((p[2].x - p[1].x) * (py - p[1].y) - (p[2].y - p[1].y) * (px - p[1].x)) / area;
+					const float w1 = ((p[0].x - p[2].x) * (py - p[2].y) - (p[0].y - p[2].y) * (px - p[2].x)) / area;
+					const float w2 = 1.0f - w0 - w1;
+
+					if (w0 < 0.0f || w1 < 0.0f || w2 < 0.0f)
+						continue;
+
+					const float z = w0 * p[0].z + w1 * p[1].z + w2 * p[2].z;
+					float & pixel = depth[std::size_t(y) * std::size_t(resolution) + std::size_t(x)];
+
+					if (z < pixel)
+					{
+						if (pixel == std::numeric_limits<float>::max())
+							covered++;
+
+						pixel = z;
+						shaded++;
+					}
+				}
+			}
+		}
+	}
+
+	return covered > 0 ? float(shaded) / float(covered) : 0.0f;
+}
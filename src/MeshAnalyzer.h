@@ -0,0 +1,63 @@
+#pragma once
+
+#include "Model.h"
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace minity
+{
+	// measures how efficiently the groups of a mesh use the GPU, independent of their triangle count
+	class MeshAnalyzer
+	{
+	public:
+
+		enum class CachePolicy
+		{
+			FIFO,
+			LRU
+		};
+
+		struct CacheStatistics
+		{
+			CachePolicy policy = CachePolicy::FIFO;
+			unsigned int size = 0;
+			// transformed vertices per triangle, 0.5 is the optimum for large regular meshes, 3 the worst case
+			float averageCacheMissRatio = 0.0f;
+			// transformed vertices per unique vertex, 1 is optimal
+			float averageTransformedVertexRatio = 0.0f;
+		};
+
+		struct GroupStatistics
+		{
+			std::string name;
+			std::size_t triangles = 0;
+			std::size_t vertices = 0;
+			std::vector<CacheStatistics> caches;
+			// bytes read from the vertex buffer in cache lines per byte of unique vertices, 1 is optimal
+			float fetchOverread = 0.0f;
+			// shaded fragments per covered pixel, averaged over all view directions, 1 is optimal
+			float overdraw = 0.0f;
+		};
+
+		struct Report
+		{
+			std::string filename;
+			std::size_t vertexSize = sizeof(Vertex);
+			GroupStatistics total;
+			std::vector<GroupStatistics> groups;
+		};
+
+		// a thread count of zero uses all hardware threads
+		static Report analyze(const std::vector<Vertex> & vertices, const std::vector<glm::uint> & indices, const std::vector<Group> & groups, unsigned int threadCount = 0);
+
+		static std::string json(const Report & report);
+		static bool write(const Report & report, const std::string & filename);
+
+	private:
+
+		static GroupStatistics analyzeRange(const std::vector<Vertex> & vertices, const glm::uint * indices, std::size_t indexCount);
+		static float overdraw(const std::vector<Vertex> & vertices, const glm::uint * indices, std::size_t indexCount);
+	};
+}
@@ -0,0 +1,292 @@
+#include "MeshCache.h"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <system_error>
+#include <globjects/globjects.h>
+#include <globjects/logging.h>
+
+using namespace minity;
+using namespace gl;
+using namespace glm;
+using namespace globjects;
+
+namespace
+{
+	const char magic[8] = { 'm','i','n','i','t','y','M','C' };
+}
+
+MeshCache::MeshCache(const std::string & filename, const LoadOptions & options) : m_filename(filename), m_options(options)
+{
+	m_cacheFilename = minity::cacheFilename(filename, m_options.cacheDirectory, ".cache");
+}
+
+const std::string & MeshCache::cacheFilename() const
+{
+	return m_cacheFilename;
+}
+
+bool MeshCache::read()
+{
+	close();
+
+	if (!m_file.open(m_cacheFilename))
+		return false;
+
+	CacheReader reader(m_file.data(), m_file.size());
+	const char * fileMagic = reader.readBytes(sizeof(magic));
+
+	if (!fileMagic || std::memcmp(fileMagic, magic, sizeof(magic)) != 0 || reader.read<std::uint32_t>() != version || reader.read<std::uint32_t>() != sizeof(Vertex) || reader.read<std::uint64_t>() != optionsKey(m_options))
+	{
+		close();
+		return false;
+	}
+
+	// the source file and all material libraries have to be unchanged
+	const std::uint32_t fileCount = reader.read<std::uint32_t>();
+
+	for (std::uint32_t i = 0; i < fileCount && reader.good(); i++)
+	{
+		CacheFileKey key = CacheFileKey::read(reader);
+
+		if (!reader.good() || !key.matches())
+		{
+			globjects::debug() << "Mesh cache " << m_cacheFilename << " is outdated";
+			close();
+			return false;
+		}
+	}
+
+	m_minimumBounds = reader.read<vec3>();
+	m_maximumBounds = reader.read<vec3>();
+
+	const std::uint32_t materialCount = reader.read<std::uint32_t>();
+
+	for (std::uint32_t i = 0; i < materialCount && reader.good(); i++)
+	{
+		ObjLoader::ObjMaterial m;
+		m.name = reader.readString();
+		m.Ka = reader.read<vec3>();
+		m.Kd = reader.read<vec3>();
+		m.Ks = reader.read<vec3>();
+		m.Ns = reader.read<float>();
+		m.d = reader.read<float>();
+		m.illum = reader.read<std::int32_t>();
+		m.map_Ka = reader.readString();
+		m.map_Kd = reader.readString();
+		m.map_Ks = reader.readString();
+		m.map_Ns = reader.readString();
+		m.map_d = reader.readString();
+		m.map_bump = reader.readString();
+		m.map_objectSpaceNormals = reader.readString();
+		m.map_tangentSpaceNormals = reader.readString();
+		m_objMaterials.push_back(m);
+	}
+
+	const std::uint32_t groupCount = reader.read<std::uint32_t>();
+
+	for (std::uint32_t i = 0; i < groupCount && reader.good(); i++)
+	{
+		Group g;
+		g.name = reader.readString();
+		g.materialIndex = reader.read<uint>();
+		g.startIndex = reader.read<uint>();
+		g.endIndex = reader.read<uint>();
+		g.centre_group = reader.read<vec3>();
+		g.radius_group = reader.read<float>();
+		g.minimum_group = reader.read<vec3>();
+		g.maximum_group = reader.read<vec3>();
+
+		const std::uint32_t levelCount = reader.read<std::uint32_t>();
+
+		for (std::uint32_t j = 0; j < levelCount && reader.good(); j++)
+		{
+			LevelOfDetail lod;
+			lod.startIndex = reader.read<uint>();
+			lod.endIndex = reader.read<uint>();
+			lod.error = reader.read<float>();
+			g.levelsOfDetail.push_back(lod);
+		}
+
+		m_groups.push_back(g);
+	}
+
+	m_vertexData = reader.readArray<Vertex>(m_vertexCount);
+	m_indexData = reader.readArray<uint>(m_indexCount);
+
+	if (!reader.good())
+	{
+		globjects::debug() << "Mesh cache " << m_cacheFilename << " is corrupt";
+		close();
+		return false;
+	}
+
+	return true;
+}
+
+void MeshCache::close()
+{
+	m_file.close();
+
+	m_vertexData = nullptr;
+	m_vertexCount = 0;
+	m_indexData = nullptr;
+	m_indexCount = 0;
+
+	m_groups.clear();
+	m_objMaterials.clear();
+}
+
+bool MeshCache::write(const ObjLoader & loader, const vec3 & minimumBounds, const vec3 & maximumBounds)
+{
+	std::vector<CacheFileKey> keys;
+	keys.push_back(CacheFileKey::create(m_filename, true));
+
+	for (const auto & f : loader.materialLibraries())
+		keys.push_back(CacheFileKey::create(f, true));
+
+	std::error_code error;
+	const std::filesystem::path cachePath(m_cacheFilename);
+
+	if (cachePath.has_parent_path())
+		std::filesystem::create_directories(cachePath.parent_path(), error);
+
+	// written to a temporary file first, so that concurrent readers never see a partial cache
+	const std::string temporaryFilename = m_cacheFilename + ".tmp";
+
+	{
+		std::ofstream os(temporaryFilename, std::ios::binary | std::ios::trunc);
+
+		if (!os.is_open())
+			return false;
+
+		CacheWriter writer(os);
+		writer.writeBytes(magic, sizeof(magic));
+		writer.write(version);
+		writer.write(std::uint32_t(sizeof(Vertex)));
+		writer.write(optionsKey(m_options));
+
+		writer.write(std::uint32_t(keys.size()));
+
+		for (const auto & k : keys)
+			k.write(writer);
+
+		writer.write(minimumBounds);
+		writer.write(maximumBounds);
+
+		writer.write(std::uint32_t(loader.objMaterials().size()));
+
+		for (const auto & m : loader.objMaterials())
+		{
+			writer.writeString(m.name);
+			writer.write(m.Ka);
+			writer.write(m.Kd);
+			writer.write(m.Ks);
+			writer.write(m.Ns);
+			writer.write(m.d);
+			writer.write(std::int32_t(m.illum));
+			writer.writeString(m.map_Ka);
+			writer.writeString(m.map_Kd);
+			writer.writeString(m.map_Ks);
+			writer.writeString(m.map_Ns);
+			writer.writeString(m.map_d);
+			writer.writeString(m.map_bump);
+			writer.writeString(m.map_objectSpaceNormals);
+			writer.writeString(m.map_tangentSpaceNormals);
+		}
+
+		writer.write(std::uint32_t(loader.groups().size()));
+
+		for (const auto & g : loader.groups())
+		{
+			writer.writeString(g.name);
+			writer.write(g.materialIndex);
+			writer.write(g.startIndex);
+			writer.write(g.endIndex);
+			writer.write(g.centre_group);
+			writer.write(g.radius_group);
+			writer.write(g.minimum_group);
+			writer.write(g.maximum_group);
+			writer.write(std::uint32_t(g.levelsOfDetail.size()));
+
+			for (const auto & lod : g.levelsOfDetail)
+			{
+				writer.write(lod.startIndex);
+				writer.write(lod.endIndex);
+				writer.write(lod.error);
+			}
+		}
+
+		writer.writeArray(loader.vertices().data(), loader.vertices().size());
+		writer.writeArray(loader.indices().data(), loader.indices().size());
+
+		if (!os.good())
+		{
+			os.close();
+			std::filesystem::remove(temporaryFilename, error);
+			return false;
+		}
+	}
+
+	return commitCacheFile(temporaryFilename, m_cacheFilename);
+}
+
+const Vertex * MeshCache::vertexData() const
+{
+	return m_vertexData;
+}
+
+std::size_t MeshCache::vertexCount() const
+{
+	return m_vertexCount;
+}
+
+const uint * MeshCache::indexData() const
+{
+	return m_indexData;
+}
+
+std::size_t MeshCache::indexCount() const
+{
+	return m_indexCount;
+}
+
+const std::vector<Group> & MeshCache::groups() const
+{
+	return m_groups;
+}
+
+const std::vector<ObjLoader::ObjMaterial> & MeshCache::objMaterials() const
+{
+	return m_objMaterials;
+}
+
+vec3 MeshCache::minimumBounds() const
+{
+	return m_minimumBounds;
+}
+
+vec3 MeshCache::maximumBounds() const
+{
+	return m_maximumBounds;
+}
+
+std::uint64_t MeshCache::optionsKey(const LoadOptions & options)
+{
+	std::uint64_t key = 0;
+	key |= options.weldVertices ? 1 : 0;
+	key |= std::uint64_t(options.normalWeighting) << 1;
+	key |= options.optimizeMesh ? 8 : 0;
+	key |= options.levelsOfDetail ? 16 : 0;
+
+	// the default of smoothing all faces keeps the key of files written before creases existed
+	if (options.creaseAngle < 180.0f)
+	{
+		std::uint32_t creaseBits;
+		std::memcpy(&creaseBits, &options.creaseAngle, sizeof(creaseBits));
+		key |= std::uint64_t(creaseBits) << 32;
+	}
+
+	return key;
+}
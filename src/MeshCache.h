@@ -0,0 +1,63 @@
+#pragma once
+
+#include "Model.h"
+#include "ObjLoader.h"
+#include "MappedFile.h"
+#include "CacheFile.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace minity
+{
+	// versioned binary file holding the final geometry of a model, so repeated loads skip parsing
+	class MeshCache
+	{
+	public:
+
+		// bumped whenever the layout of the file or the output of the loader changes
+		static constexpr std::uint32_t version = 5;
+
+		MeshCache(const std::string & filename, const LoadOptions & options = LoadOptions());
+
+		const std::string & cacheFilename() const;
+
+		// maps the cache file and checks that it is still valid for the source file,
+		// the vertex and index data point directly into the mapping until close()
+		bool read();
+		void close();
+
+		bool write(const ObjLoader & loader, const glm::vec3 & minimumBounds, const glm::vec3 & maximumBounds);
+
+		const Vertex * vertexData() const;
+		std::size_t vertexCount() const;
+		const glm::uint * indexData() const;
+		std::size_t indexCount() const;
+
+		const std::vector<Group> & groups() const;
+		const std::vector<ObjLoader::ObjMaterial> & objMaterials() const;
+		glm::vec3 minimumBounds() const;
+		glm::vec3 maximumBounds() const;
+
+		// combines all load options which change the cached geometry
+		static std::uint64_t optionsKey(const LoadOptions & options);
+
+	private:
+
+		std::string m_filename;
+		std::string m_cacheFilename;
+		LoadOptions m_options;
+
+		MappedFile m_file;
+		const Vertex * m_vertexData = nullptr;
+		std::size_t m_vertexCount = 0;
+		const glm::uint * m_indexData = nullptr;
+		std::size_t m_indexCount = 0;
+
+		std::vector<Group> m_groups;
+		std::vector<ObjLoader::ObjMaterial> m_objMaterials;
+		glm::vec3 m_minimumBounds = glm::vec3(0.0f);
+		glm::vec3 m_maximumBounds = glm::vec3(0.0f);
+	};
+}
@@ -0,0 +1,381 @@
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+
+using namespace glm;
+using namespace minity;
+
+namespace
+{
+	const uint invalidIndex = std::numeric_limits<uint>::max();
+
+	// FIFO post-transform cache modeled with time stamps, a vertex is a hit if fewer than cacheSize misses happened since it was loaded
+	class CacheSimulation
+	{
+	public:
+
+		CacheSimulation(std::size_t vertexCount, unsigned int cacheSize) : m_times(vertexCount, 0), m_cacheSize(cacheSize), m_time(cacheSize + 1)
+		{
+
+		}
+
+		// returns true for a miss
+		bool access(uint vertex)
+		{
+			if (m_time - m_times[vertex] > m_cacheSize)
+			{
+				m_times[vertex] = m_time++;
+				return true;
+			}
+
+			return false;
+		}
+
+		unsigned int age(uint vertex) const
+		{
+			return m_time - m_times[vertex];
+		}
+
+		void flush()
+		{
+			m_time += m_cacheSize + 1;
+		}
+
+	private:
+
+		std::vector<unsigned int> m_times;
+		unsigned int m_cacheSize;
+		unsigned int m_time;
+	};
+}
+
+void MeshOptimizer::optimize(std::vector<Vertex> & vertices, std::vector<uint> & indices, const std::vector<Group> & groups)
+{
+	// the passes work on indices local to a group, so that their tables are only as large as the group
+	std::vector<uint> localIndex(vertices.size(), invalidIndex);
+	std::vector<uint> localToGlobal;
+	std::vector<uint> local;
+
+	for (const auto & g : groups)
+	{
+		const std::size_t begin = std::min(std::size_t(g.startIndex), indices.size());
+		const std::size_t end = std::min(std::size_t(g.endIndex), indices.size());
+		const std::size_t count = end > begin ? (end - begin) / 3 * 3 : 0;
+
+		if (count < 6)
+			continue;
+
+		localToGlobal.clear();
+		local.resize(count);
+
+		for (std::size_t i = 0; i < count; i++)
+		{
+			const uint v = indices[begin + i];
+
+			if (localIndex[v] == invalidIndex)
+			{
+				localIndex[v] = uint(localToGlobal.size());
+				localToGlobal.push_back(v);
+			}
+
+			local[i] = localIndex[v];
+		}
+
+		// exported meshes are sometimes already in a good order, which is kept if the passes cannot improve it,
+		// and the overdraw order is only used if it does not give back all that was gained for the vertex cache
+		const float inputRatio = averageCacheMissRatio(local.data(), count, localToGlobal.size());
+		const std::vector<uint> input = local;
+
+		std::vector<std::size_t> clusters = optimizeVertexCache(local.data(), count, localToGlobal.size());
+
+		if (averageCacheMissRatio(local.data(), count, localToGlobal.size()) >= inputRatio)
+		{
+			local = input;
+		}
+		else
+		{
+			const std::vector<uint> cacheOrder = local;
+			optimizeOverdraw(local.data(), count, vertices, localToGlobal, std::move(clusters));
+
+			if (averageCacheMissRatio(local.data(), count, localToGlobal.size()) >= inputRatio)
+				local = cacheOrder;
+		}
+
+		for (std::size_t i = 0; i < count; i++)
+			indices[begin + i] = localToGlobal[local[i]];
+
+		for (auto v : localToGlobal)
+			localIndex[v] = invalidIndex;
+	}
+
+	optimizeVertexFetch(vertices, indices);
+}
+
+std::vector<std::size_t> MeshOptimizer::optimizeVertexCache(uint * indices, std::size_t indexCount, std::size_t vertexCount)
+{
+	const std::size_t triangleCount = indexCount / 3;
+	std::vector<std::size_t> clusters;
+
+	if (triangleCount == 0)
+		return clusters;
+
+	// triangles around each vertex
+	std::vector<uint> offsets(vertexCount + 1, 0);
+
+	for (std::size_t i = 0; i < triangleCount * 3; i++)
+		offsets[indices[i] + 1]++;
+
+	for (std::size_t v = 0; v < vertexCount; v++)
+		offsets[v + 1] += offsets[v];
+
+	std::vector<uint> adjacency(triangleCount * 3);
+
+	{
+		std::vector<uint> cursor(offsets.begin(), offsets.end() - 1);
+
+		for (std::size_t i = 0; i < triangleCount * 3; i++)
+			adjacency[cursor[indices[i]]++] = uint(i / 3);
+	}
+
+	// number of triangles around each vertex which were not emitted yet
+	std::vector<uint> live(vertexCount);
+
+	for (std::size_t v = 0; v < vertexCount; v++)
+		live[v] = offsets[v + 1] - offsets[v];
+
+	CacheSimulation cache(vertexCount, cacheSize);
+	std::vector<bool> emitted(triangleCount, false);
+	std::vector<uint> deadEnd;
+	std::vector<uint> candidates;
+	std::vector<uint> output(triangleCount * 3);
+	std::size_t outputTriangles = 0;
+	std::size_t scanCursor = 0;
+
+	clusters.push_back(0);
+	std::int64_t fanning = indices[0];
+
+	while (fanning >= 0)
+	{
+		candidates.clear();
+
+		for (uint a = offsets[fanning]; a < offsets[fanning + 1]; a++)
+		{
+			const uint t = adjacency[a];
+
+			if (emitted[t])
+				continue;
+
+			for (int k = 0; k < 3; k++)
+			{
+				const uint v = indices[3 * t + k];
+				output[3 * outputTriangles + k] = v;
+				deadEnd.push_back(v);
+				candidates.push_back(v);
+				live[v]--;
+				cache.access(v);
+			}
+
+			emitted[t] = true;
+			outputTriangles++;
+		}
+
+		// the oldest candidate which is still cached after emitting all of its triangles, which keeps the rest in the cache
+		std::int64_t next = -1;
+		int bestPriority = -1;
+
+		for (auto v : candidates)
+		{
+			if (live[v] == 0)
+				continue;
+
+			int priority = 0;
+
+			if (cache.age(v) + 2 * live[v] <= cacheSize)
+				priority = int(cache.age(v));
+
+			if (priority > bestPriority)
+			{
+				bestPriority = priority;
+				next = v;
+			}
+		}
+
+		if (next < 0)
+		{
+			// dead end, the most recently used vertex with triangles left, or any vertex which has some
+			while (!deadEnd.empty() && next < 0)
+			{
+				const uint v = deadEnd.back();
+				deadEnd.pop_back();
+
+				if (live[v] > 0)
+					next = v;
+			}
+
+			while (next < 0 && scanCursor < vertexCount)
+			{
+				if (live[scanCursor] > 0)
+					next = std::int64_t(scanCursor);
+				else
+					scanCursor++;
+			}
+
+			if (next >= 0)
+				clusters.push_back(outputTriangles);
+		}
+
+		fanning = next;
+	}
+
+	std::copy(output.begin(), output.end(), indices);
+	return clusters;
+}
+
+void MeshOptimizer::optimizeOverdraw(uint * indices, std::size_t indexCount, const std::vector<Vertex> & vertices, const std::vector<uint> & localToGlobal,
+	std::vector<std::size_t> clusters, float threshold)
+{
+	const std::size_t triangleCount = indexCount / 3;
+
+	if (triangleCount == 0)
+		return;
+
+	if (clusters.empty() || clusters.front() != 0)
+		clusters.insert(clusters.begin(), 0);
+
+	clusters.push_back(triangleCount);
+
+	// a cluster is split wherever its miss ratio so far has dropped to the threshold times the ratio of the whole cluster,
+	// so that drawing the parts in any order costs little more vertex processing than drawing the cluster
+	CacheSimulation cache(localToGlobal.size(), cacheSize);
+	std::vector<std::size_t> parts;
+
+	for (std::size_t c = 0; c + 1 < clusters.size(); c++)
+	{
+		const std::size_t begin = clusters[c];
+		const std::size_t end = clusters[c + 1];
+
+		if (end <= begin)
+			continue;
+
+		std::size_t misses = 0;
+		cache.flush();
+
+		for (std::size_t t = begin; t < end; t++)
+			misses += cache.access(indices[3 * t + 0]) + cache.access(indices[3 * t + 1]) + cache.access(indices[3 * t + 2]);
+
+		const float clusterThreshold = threshold * float(misses) / float(end - begin);
+
+		parts.push_back(begin);
+		std::size_t partBegin = begin;
+		misses = 0;
+		cache.flush();
+
+		for (std::size_t t = begin; t < end; t++)
+		{
+			misses += cache.access(indices[3 * t + 0]) + cache.access(indices[3 * t + 1]) + cache.access(indices[3 * t + 2]);
+
+			if (t + 1 < end && float(misses) / float(t + 1 - partBegin) <= clusterThreshold)
+			{
+				parts.push_back(t + 1);
+				partBegin = t + 1;
+				misses = 0;
+				cache.flush();
+			}
+		}
+	}
+
+	parts.push_back(triangleCount);
+
+	vec3 center(0.0f);
+
+	for (auto v : localToGlobal)
+		center += vertices[v].position;
+
+	center /= float(localToGlobal.size());
+
+	// parts facing away from the center are likely in front of the rest from the views which can see them
+	std::vector<float> sortKeys(parts.size() - 1);
+
+	for (std::size_t p = 0; p + 1 < parts.size(); p++)
+	{
+		vec3 centroid(0.0f);
+		vec3 normal(0.0f);
+		float area = 0.0f;
+
+		for (std::size_t t = parts[p]; t < parts[p + 1]; t++)
+		{
+			const vec3 & p0 = vertices[localToGlobal[indices[3 * t + 0]]].position;
+			const vec3 & p1 = vertices[localToGlobal[indices[3 * t + 1]]].position;
+			const vec3 & p2 = vertices[localToGlobal[indices[3 * t + 2]]].position;
+
+			const vec3 n = cross(p1 - p0, p2 - p0);
+			const float a = length(n);
+
+			centroid += (p0 + p1 + p2) * (a / 3.0f);
+			normal += n;
+			area += a;
+		}
+
+		if (area > 0.0f && dot(normal, normal) > 0.0f)
+			sortKeys[p] = dot(centroid / area - center, normalize(normal));
+		else
+			sortKeys[p] = 0.0f;
+	}
+
+	std::vector<std::size_t> order(sortKeys.size());
+	std::iota(order.begin(), order.end(), 0);
+	std::stable_sort(order.begin(), order.end(), [&sortKeys](std::size_t a, std::size_t b) { return sortKeys[a] > sortKeys[b]; });
+
+	std::vector<uint> sorted;
+	sorted.reserve(triangleCount * 3);
+
+	for (auto p : order)
+		sorted.insert(sorted.end(), indices + 3 * parts[p], indices + 3 * parts[p + 1]);
+
+	std::copy(sorted.begin(), sorted.end(), indices);
+}
+
+void MeshOptimizer::optimizeVertexFetch(std::vector<Vertex> & vertices, std::vector<uint> & indices)
+{
+	std::vector<uint> remap(vertices.size(), invalidIndex);
+	std::vector<Vertex> sorted;
+	sorted.reserve(vertices.size());
+
+	for (auto & i : indices)
+	{
+		if (remap[i] == invalidIndex)
+		{
+			remap[i] = uint(sorted.size());
+			sorted.push_back(vertices[i]);
+		}
+
+		i = remap[i];
+	}
+
+	for (std::size_t v = 0; v < vertices.size(); v++)
+	{
+		if (remap[v] == invalidIndex)
+			sorted.push_back(vertices[v]);
+	}
+
+	vertices.swap(sorted);
+}
+
+float MeshOptimizer::averageCacheMissRatio(const uint * indices, std::size_t indexCount, std::size_t vertexCount, unsigned int cacheSize)
+{
+	const std::size_t triangleCount = indexCount / 3;
+
+	if (triangleCount == 0)
+		return 0.0f;
+
+	CacheSimulation cache(vertexCount, cacheSize);
+	std::size_t misses = 0;
+
+	for (std::size_t i = 0; i < triangleCount * 3; i++)
+		misses += cache.access(indices[i]);
+
+	return float(misses) / float(triangleCount);
+}
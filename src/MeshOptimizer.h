@@ -0,0 +1,37 @@
+#pragma once
+
+#include "Model.h"
+
+#include <cstddef>
+#include <vector>
+
+namespace minity
+{
+	// reorders triangles and vertices for the GPU: triangles for the post-transform vertex cache and then for overdraw,
+	// vertices in the order they are first used, the triangles of a group never leave its index range
+	class MeshOptimizer
+	{
+	public:
+
+		// size of the simulated post-transform cache, a little smaller than on most GPUs, which is the safe side
+		static constexpr unsigned int cacheSize = 16;
+
+		// runs all passes over the groups and renumbers the vertices, indices left over at the end of a group are kept in place
+		static void optimize(std::vector<Vertex> & vertices, std::vector<glm::uint> & indices, const std::vector<Group> & groups);
+
+		// Tipsify: emits the triangles around a fanning vertex which is still in the cache, the indices are local to
+		// the range and below vertexCount, returns the triangles where the fanning ran into a dead end and had to jump
+		static std::vector<std::size_t> optimizeVertexCache(glm::uint * indices, std::size_t indexCount, std::size_t vertexCount);
+
+		// splits the clusters further where the cache miss ratio stays low and sorts them so that the clusters facing
+		// away from the center are drawn first, which lets them occlude the rest of the range from most views
+		static void optimizeOverdraw(glm::uint * indices, std::size_t indexCount, const std::vector<Vertex> & vertices, const std::vector<glm::uint> & localToGlobal,
+			std::vector<std::size_t> clusters, float threshold = 1.05f);
+
+		// renumbers the vertices in the order of their first use, unused vertices move to the end
+		static void optimizeVertexFetch(std::vector<Vertex> & vertices, std::vector<glm::uint> & indices);
+
+		// transformed vertices per triangle with a FIFO cache of the given size
+		static float averageCacheMissRatio(const glm::uint * indices, std::size_t indexCount, std::size_t vertexCount, unsigned int cacheSize = MeshOptimizer::cacheSize);
+	};
+}
@@ -0,0 +1,523 @@
+#include "MeshSimplifier.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <unordered_map>
+
+using namespace glm;
+using namespace minity;
+
+namespace
+{
+	enum class VertexKind : std::uint8_t
+	{
+		// inside the surface, can collapse onto any neighbor
+		Manifold,
+		// on an open border, can only collapse along it
+		Border,
+		// on a seam or a non-manifold edge, never moves
+		Locked
+	};
+
+	// weight of the planes through border edges relative to those of the triangles, so that borders keep their shape
+	const double borderWeight = 10.0;
+	// weight of normal and texture coordinate differences in the cost of a collapse, relative to the size of the range
+	const double attributeWeight = 1e-3;
+	// collapses must not rotate the remaining triangles by more than the angle with this cosine
+	const float minimumNormalDot = 0.25f;
+	const int maximumPasses = 100;
+	const uint invalidIndex = std::numeric_limits<uint>::max();
+
+	// sum of weighted squared distances to a set of planes
+	struct Quadric
+	{
+		double a00 = 0.0, a01 = 0.0, a02 = 0.0, a11 = 0.0, a12 = 0.0, a22 = 0.0;
+		double b0 = 0.0, b1 = 0.0, b2 = 0.0;
+		double c = 0.0;
+		double weight = 0.0;
+
+		// the plane of points p with dot(normal, p) + distance = 0, the normal has unit length
+		void addPlane(const vec3 & normal, float distance, double w)
+		{
+			const double x = normal.x, y = normal.y, z = normal.z, d = distance;
+
+			a00 += w * x * x; a01 += w * x * y; a02 += w * x * z;
+			a11 += w * y * y; a12 += w * y * z; a22 += w * z * z;
+			b0 += w * x * d; b1 += w * y * d; b2 += w * z * d;
+			c += w * d * d;
+			weight += w;
+		}
+
+		void add(const Quadric & q)
+		{
+			a00 += q.a00; a01 += q.a01; a02 += q.a02;
+			a11 += q.a11; a12 += q.a12; a22 += q.a22;
+			b0 += q.b0; b1 += q.b1; b2 += q.b2;
+			c += q.c;
+			weight += q.weight;
+		}
+
+		double evaluate(const vec3 & p) const
+		{
+			const double x = p.x, y = p.y, z = p.z;
+			const double result = a00 * x * x + a11 * y * y + a22 * z * z + 2.0 * (a01 * x * y + a02 * x * z + a12 * y * z) + 2.0 * (b0 * x + b1 * y + b2 * z) + c;
+			return std::max(result, 0.0);
+		}
+	};
+
+	struct PositionHash
+	{
+		std::size_t operator()(const vec3 & p) const
+		{
+			std::uint32_t bits[3];
+			std::memcpy(bits, &p.x, sizeof(bits));
+			return std::size_t(bits[0] * 73856093u ^ bits[1] * 19349663u ^ bits[2] * 83492791u);
+		}
+	};
+
+	struct Collapse
+	{
+		double cost;
+		uint from;
+		uint to;
+	};
+
+	std::uint64_t edgeKey(uint from, uint to)
+	{
+		return (std::uint64_t(from) << 32) | to;
+	}
+
+	// finds the directed edges between positions without an opposite edge, sorted, and the pairs of vertices
+	// on edges used by more than two triangles or twice in the same direction
+	void findBorderEdges(const std::vector<uint> & indices, const std::vector<uint> & canonical, std::vector<std::uint64_t> & edges,
+		std::vector<std::uint64_t> & borderEdges, std::vector<std::uint64_t> & nonManifoldEdges)
+	{
+		// undirected edges with the direction in the lowest bit, so that both directions end up next to each other
+		edges.clear();
+
+		for (std::size_t t = 0; t + 2 < indices.size(); t += 3)
+		{
+			for (std::size_t k = 0; k < 3; k++)
+			{
+				const uint a = canonical[indices[t + k]];
+				const uint b = canonical[indices[t + (k + 1) % 3]];
+
+				if (a != b)
+					edges.push_back((std::uint64_t(std::min(a, b)) << 33) | (std::uint64_t(std::max(a, b)) << 1) | (a > b ? 1 : 0));
+			}
+		}
+
+		std::sort(edges.begin(), edges.end());
+		borderEdges.clear();
+		nonManifoldEdges.clear();
+
+		for (std::size_t begin = 0, end = 0; begin < edges.size(); begin = end)
+		{
+			while (end < edges.size() && edges[end] >> 1 == edges[begin] >> 1)
+				end++;
+
+			const uint low = uint(edges[begin] >> 33);
+			const uint high = uint((edges[begin] >> 1) & 0xffffffffu);
+
+			if (end - begin == 1)
+				borderEdges.push_back(edges[begin] & 1 ? edgeKey(high, low) : edgeKey(low, high));
+			else if (end - begin > 2 || edges[begin] == edges[begin + 1])
+				nonManifoldEdges.push_back(edgeKey(low, high));
+		}
+
+		std::sort(borderEdges.begin(), borderEdges.end());
+	}
+
+	bool hasEdge(const std::vector<std::uint64_t> & edges, uint from, uint to)
+	{
+		return std::binary_search(edges.begin(), edges.end(), edgeKey(from, to));
+	}
+}
+
+std::vector<uint> MeshSimplifier::simplify(const std::vector<Vertex> & vertices, const uint * indices, std::size_t indexCount, std::size_t targetIndexCount, float * error)
+{
+	indexCount = indexCount / 3 * 3;
+	double maximumError = 0.0;
+
+	// the passes work on indices local to the range, so that their tables are only as large as the range
+	std::vector<uint> localToGlobal(indices, indices + indexCount);
+	std::sort(localToGlobal.begin(), localToGlobal.end());
+	localToGlobal.erase(std::unique(localToGlobal.begin(), localToGlobal.end()), localToGlobal.end());
+
+	const std::size_t vertexCount = localToGlobal.size();
+	std::vector<uint> result(indexCount);
+
+	for (std::size_t i = 0; i < indexCount; i++)
+		result[i] = uint(std::lower_bound(localToGlobal.begin(), localToGlobal.end(), indices[i]) - localToGlobal.begin());
+
+	std::vector<vec3> positions(vertexCount);
+	vec3 minimum(std::numeric_limits<float>::max());
+	vec3 maximum(-std::numeric_limits<float>::max());
+
+	for (std::size_t v = 0; v < vertexCount; v++)
+	{
+		positions[v] = vertices[localToGlobal[v]].position;
+		minimum = min(minimum, positions[v]);
+		maximum = max(maximum, positions[v]);
+	}
+
+	// vertices at the same position with different attributes are on a seam, the topology is built between positions
+	std::vector<uint> canonical(vertexCount);
+	std::vector<VertexKind> kind(vertexCount, VertexKind::Manifold);
+
+	{
+		std::unordered_map<vec3, uint, PositionHash> first;
+		first.reserve(vertexCount);
+
+		for (std::size_t v = 0; v < vertexCount; v++)
+		{
+			// adding zero turns negative zeros positive, so that equal positions hash the same
+			const auto inserted = first.emplace(positions[v] + vec3(0.0f), uint(v));
+			canonical[v] = inserted.first->second;
+
+			if (!inserted.second)
+				kind[v] = kind[canonical[v]] = VertexKind::Locked;
+		}
+	}
+
+	std::vector<std::uint64_t> edges;
+	std::vector<std::uint64_t> borderEdges;
+	std::vector<std::uint64_t> nonManifoldEdges;
+	findBorderEdges(result, canonical, edges, borderEdges, nonManifoldEdges);
+
+	// vertices on a border can move along it if there is no other border through them
+	{
+		std::vector<uint> borderIn(vertexCount, 0);
+		std::vector<uint> borderOut(vertexCount, 0);
+
+		for (auto e : borderEdges)
+		{
+			borderOut[uint(e >> 32)]++;
+			borderIn[uint(e & 0xffffffffu)]++;
+		}
+
+		for (std::size_t v = 0; v < vertexCount; v++)
+		{
+			if (kind[v] == VertexKind::Manifold && (borderIn[v] > 0 || borderOut[v] > 0))
+				kind[v] = borderIn[v] == 1 && borderOut[v] == 1 ? VertexKind::Border : VertexKind::Locked;
+		}
+
+		for (auto e : nonManifoldEdges)
+			kind[uint(e >> 32)] = kind[uint(e & 0xffffffffu)] = VertexKind::Locked;
+	}
+
+	// the planes of the triangles weighted by their area, and planes perpendicular to them through border edges
+	std::vector<Quadric> quadrics(vertexCount);
+
+	for (std::size_t t = 0; t < indexCount; t += 3)
+	{
+		const vec3 & p0 = positions[result[t + 0]];
+		const vec3 & p1 = positions[result[t + 1]];
+		const vec3 & p2 = positions[result[t + 2]];
+
+		vec3 normal = cross(p1 - p0, p2 - p0);
+		const float length2 = length(normal);
+
+		if (!(length2 > 0.0f))
+			continue;
+
+		normal /= length2;
+
+		for (std::size_t k = 0; k < 3; k++)
+			quadrics[result[t + k]].addPlane(normal, -dot(normal, p0), 0.5 * length2);
+
+		for (std::size_t k = 0; k < 3; k++)
+		{
+			const uint a = result[t + k];
+			const uint b = result[t + (k + 1) % 3];
+
+			if (!hasEdge(borderEdges, canonical[a], canonical[b]))
+				continue;
+
+			const vec3 edge = positions[b] - positions[a];
+			const vec3 edgeNormal = cross(edge, normal);
+			const float edgeLength = length(edgeNormal);
+
+			if (!(edgeLength > 0.0f))
+				continue;
+
+			const vec3 unitNormal = edgeNormal / edgeLength;
+			quadrics[a].addPlane(unitNormal, -dot(unitNormal, positions[a]), borderWeight * edgeLength * edgeLength);
+			quadrics[b].addPlane(unitNormal, -dot(unitNormal, positions[a]), borderWeight * edgeLength * edgeLength);
+		}
+	}
+
+	// attribute differences count like displacements of this length per unit of the difference
+	const double attributeScale = attributeWeight * double(dot(maximum - minimum, maximum - minimum));
+
+	auto attributeDistance = [&](uint a, uint b) {
+		const Vertex & va = vertices[localToGlobal[a]];
+		const Vertex & vb = vertices[localToGlobal[b]];
+		const vec3 normal = va.normal - vb.normal;
+		const vec2 texcoord = va.texcoord - vb.texcoord;
+
+		return 0.25 * double(dot(normal, normal)) + std::min(double(dot(texcoord, texcoord)), 1.0);
+	};
+
+	std::vector<uint> offsets(vertexCount + 1);
+	std::vector<uint> adjacency;
+	std::vector<Collapse> bestCollapses;
+	std::vector<Collapse> collapses;
+	std::vector<Collapse> retries;
+	std::vector<bool> touched(vertexCount);
+	std::vector<uint> remap(vertexCount);
+
+	for (int pass = 0; pass < maximumPasses && result.size() > targetIndexCount; pass++)
+	{
+		const std::size_t triangleCount = result.size() / 3;
+
+		if (pass > 0)
+			findBorderEdges(result, canonical, edges, borderEdges, nonManifoldEdges);
+
+		// triangles around each vertex
+		std::fill(offsets.begin(), offsets.end(), 0);
+
+		for (auto v : result)
+			offsets[v + 1]++;
+
+		for (std::size_t v = 0; v < vertexCount; v++)
+			offsets[v + 1] += offsets[v];
+
+		adjacency.resize(result.size());
+
+		{
+			std::vector<uint> cursor(offsets.begin(), offsets.end() - 1);
+
+			for (std::size_t i = 0; i < result.size(); i++)
+				adjacency[cursor[result[i]]++] = uint(i / 3);
+		}
+
+		auto collapseCost = [&](uint from, uint to) {
+			if (kind[from] == VertexKind::Locked)
+				return std::numeric_limits<double>::max();
+
+			if (kind[from] == VertexKind::Border && !hasEdge(borderEdges, canonical[from], canonical[to]) && !hasEdge(borderEdges, canonical[to], canonical[from]))
+				return std::numeric_limits<double>::max();
+
+			return quadrics[from].evaluate(positions[to]) + attributeScale * quadrics[from].weight * attributeDistance(from, to);
+		};
+
+		// the triangles a collapse removes, or zero if it would flip any of the remaining ones
+		auto vanishingTriangles = [&](uint from, uint to) {
+			std::size_t vanishing = 0;
+
+			for (uint a = offsets[from]; a < offsets[from + 1]; a++)
+			{
+				const uint * triangle = &result[3 * adjacency[a]];
+
+				if (triangle[0] == to || triangle[1] == to || triangle[2] == to)
+				{
+					vanishing++;
+					continue;
+				}
+
+				vec3 p[3];
+				vec3 q[3];
+
+				for (int k = 0; k < 3; k++)
+				{
+					p[k] = positions[triangle[k]];
+					q[k] = triangle[k] == from ? positions[to] : p[k];
+				}
+
+				const vec3 before = cross(p[1] - p[0], p[2] - p[0]);
+				const vec3 after = cross(q[1] - q[0], q[2] - q[0]);
+
+				if (dot(before, after) <= minimumNormalDot * length(before) * length(after))
+					return std::size_t(0);
+			}
+
+			return vanishing;
+		};
+
+		// only the cheapest collapse of each vertex is a candidate, which keeps the sort short
+		bestCollapses.assign(vertexCount, Collapse{ std::numeric_limits<double>::max(), invalidIndex, invalidIndex });
+
+		for (std::size_t i = 0; i < result.size(); i++)
+		{
+			const uint from = result[i];
+			const uint to = result[i - i % 3 + (i + 1) % 3];
+
+			for (const auto & c : { Collapse{ collapseCost(from, to), from, to }, Collapse{ collapseCost(to, from), to, from } })
+			{
+				if (c.cost < bestCollapses[c.from].cost)
+					bestCollapses[c.from] = c;
+			}
+		}
+
+		collapses.clear();
+
+		for (const auto & c : bestCollapses)
+		{
+			if (c.from != invalidIndex)
+				collapses.push_back(c);
+		}
+
+		auto cheaper = [](const Collapse & a, const Collapse & b) { return a.cost < b.cost; };
+		std::sort(collapses.begin(), collapses.end(), cheaper);
+
+		// the cheapest collapses first, the triangles around a collapsed vertex do not change again in the same pass,
+		// so that the flip tests stay valid
+		std::fill(touched.begin(), touched.end(), false);
+
+		for (std::size_t v = 0; v < vertexCount; v++)
+			remap[v] = uint(v);
+
+		const std::size_t neededTriangles = (result.size() - targetIndexCount + 2) / 3;
+		std::size_t removedTriangles = 0;
+		std::size_t collapseCount = 0;
+
+		// vertices whose cheapest collapse flips triangles get their next cheapest one after all others
+		retries.clear();
+
+		for (int round = 0; round < 2; round++)
+		{
+			for (const auto & c : round == 0 ? collapses : retries)
+			{
+				if (removedTriangles >= neededTriangles)
+					break;
+
+				if (touched[c.from] || touched[c.to])
+					continue;
+
+				const std::size_t vanishing = vanishingTriangles(c.from, c.to);
+
+				if (vanishing == 0)
+				{
+					if (round > 0)
+						continue;
+
+					Collapse next{ std::numeric_limits<double>::max(), c.from, invalidIndex };
+
+					for (uint a = offsets[c.from]; a < offsets[c.from + 1]; a++)
+					{
+						for (int k = 0; k < 3; k++)
+						{
+							const uint to = result[3 * adjacency[a] + k];
+							const double cost = to == c.from || to == c.to ? std::numeric_limits<double>::max() : collapseCost(c.from, to);
+
+							if (cost < next.cost)
+								next = { cost, c.from, to };
+						}
+					}
+
+					if (next.to != invalidIndex)
+						retries.push_back(next);
+
+					continue;
+				}
+
+				if (quadrics[c.from].weight > 0.0)
+					maximumError = std::max(maximumError, std::sqrt(quadrics[c.from].evaluate(positions[c.to]) / quadrics[c.from].weight));
+
+				remap[c.from] = c.to;
+				quadrics[c.to].add(quadrics[c.from]);
+
+				for (uint a = offsets[c.from]; a < offsets[c.from + 1]; a++)
+				{
+					for (int k = 0; k < 3; k++)
+						touched[result[3 * adjacency[a] + k]] = true;
+				}
+
+				touched[c.to] = true;
+				removedTriangles += vanishing;
+				collapseCount++;
+			}
+
+			std::sort(retries.begin(), retries.end(), cheaper);
+		}
+
+		if (collapseCount == 0)
+			break;
+
+		std::size_t write = 0;
+
+		for (std::size_t t = 0; t < triangleCount; t++)
+		{
+			const uint a = remap[result[3 * t + 0]];
+			const uint b = remap[result[3 * t + 1]];
+			const uint c = remap[result[3 * t + 2]];
+
+			if (a == b || b == c || a == c)
+				continue;
+
+			result[write++] = a;
+			result[write++] = b;
+			result[write++] = c;
+		}
+
+		result.resize(write);
+	}
+
+	for (auto & i : result)
+		i = localToGlobal[i];
+
+	if (error)
+		*error = float(maximumError);
+
+	return result;
+}
+
+void MeshSimplifier::buildLevelsOfDetail(const std::vector<Vertex> & vertices, std::vector<uint> & indices, std::vector<Group> & groups, unsigned int threadCount)
+{
+	struct Level
+	{
+		std::vector<uint> indices;
+		float error = 0.0f;
+	};
+
+	std::vector<std::vector<Level>> levels(groups.size());
+	ThreadPool pool(threadCount);
+
+	pool.parallelFor(groups.size(), [&](std::size_t i) {
+		const std::size_t begin = std::min(std::size_t(groups[i].startIndex), indices.size());
+		const std::size_t end = std::min(std::size_t(groups[i].endIndex), indices.size());
+
+		const uint * current = indices.data() + begin;
+		std::size_t currentCount = end > begin ? (end - begin) / 3 * 3 : 0;
+		float error = 0.0f;
+
+		while (levels[i].size() < maxLevels && currentCount / 3 >= minimumTriangles)
+		{
+			Level level;
+			float levelError = 0.0f;
+			level.indices = simplify(vertices, current, currentCount, currentCount / 6 * 3, &levelError);
+
+			// levels which barely reduce the triangles are not worth their memory
+			if (level.indices.size() * 4 > currentCount * 3)
+				break;
+
+			// each level is simplified from the one before, so their errors add up
+			error += levelError;
+			level.error = error;
+			levels[i].push_back(std::move(level));
+
+			current = levels[i].back().indices.data();
+			currentCount = levels[i].back().indices.size();
+		}
+	});
+
+	for (std::size_t i = 0; i < groups.size(); i++)
+	{
+		groups[i].levelsOfDetail.clear();
+
+		for (const auto & level : levels[i])
+		{
+			LevelOfDetail lod;
+			lod.startIndex = uint(indices.size());
+			indices.insert(indices.end(), level.indices.begin(), level.indices.end());
+			lod.endIndex = uint(indices.size());
+			lod.error = level.error;
+			groups[i].levelsOfDetail.push_back(lod);
+		}
+	}
+}
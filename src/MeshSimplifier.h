@@ -0,0 +1,28 @@
+#pragma once
+
+#include "Model.h"
+
+#include <cstddef>
+#include <vector>
+
+namespace minity
+{
+	// quadric error simplification by collapsing vertices onto their neighbors, so that the simplified triangles use
+	// the original vertices with their attributes, vertices on texture or normal seams are kept and borders only shrink along themselves
+	class MeshSimplifier
+	{
+	public:
+
+		// at most this many levels are built per group, each with about half the triangles of the one before
+		static constexpr unsigned int maxLevels = 8;
+		// groups and levels with fewer triangles are not simplified further
+		static constexpr std::size_t minimumTriangles = 128;
+
+		// collapses until at most targetIndexCount indices are left or no collapse is possible without flipping triangles,
+		// error receives the largest distance of the result from the input in model units
+		static std::vector<glm::uint> simplify(const std::vector<Vertex> & vertices, const glm::uint * indices, std::size_t indexCount, std::size_t targetIndexCount, float * error = nullptr);
+
+		// appends the levels of detail of all groups to the indices, a thread count of zero uses all hardware threads
+		static void buildLevelsOfDetail(const std::vector<Vertex> & vertices, std::vector<glm::uint> & indices, std::vector<Group> & groups, unsigned int threadCount = 0);
+	};
+}
@@ -0,0 +1,132 @@
+#include "MeshletBuilder.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using namespace glm;
+using namespace minity;
+
+namespace
+{
+	// normal cones wider than this are not worth testing, few views could cull them
+	const float minimumConeDot = 0.1f;
+}
+
+std::vector<Meshlet> MeshletBuilder::build(const std::vector<Vertex> & vertices, const std::vector<uint> & indices, std::vector<Group> & groups)
+{
+	std::vector<Meshlet> meshlets;
+
+	// the meshlet which used a vertex last, plus one, so that zero is no meshlet
+	std::vector<uint> owner(vertices.size(), 0);
+	uint current = 1;
+
+	// vertices of a triangle which are not in the current meshlet yet
+	auto newVertices = [&](std::size_t i) {
+		unsigned int count = 0;
+
+		for (std::size_t k = 0; k < 3; k++)
+		{
+			const uint v = indices[i + k];
+
+			if (owner[v] != current && (k == 0 || indices[i] != v) && (k < 2 || indices[i + 1] != v))
+				count++;
+		}
+
+		return count;
+	};
+
+	for (auto & g : groups)
+	{
+		const std::size_t begin = std::min(std::size_t(g.startIndex), indices.size());
+		const std::size_t end = std::min(std::size_t(g.endIndex), indices.size());
+
+		g.firstMeshlet = uint(meshlets.size());
+
+		Meshlet meshlet;
+
+		for (std::size_t i = begin; i + 2 < end; i += 3)
+		{
+			unsigned int count = newVertices(i);
+
+			if (meshlet.indexCount / 3 == maxTriangles || meshlet.vertexCount + count > maxVertices)
+			{
+				computeBounds(meshlet, vertices, indices.data() + begin + meshlet.firstIndex);
+				meshlets.push_back(meshlet);
+
+				meshlet = Meshlet();
+				meshlet.firstIndex = uint(i - begin);
+				current = uint(meshlets.size()) + 1;
+				count = newVertices(i);
+			}
+
+			for (std::size_t k = 0; k < 3; k++)
+				owner[indices[i + k]] = current;
+
+			meshlet.vertexCount += count;
+			meshlet.indexCount += 3;
+		}
+
+		if (meshlet.indexCount > 0)
+		{
+			computeBounds(meshlet, vertices, indices.data() + begin + meshlet.firstIndex);
+			meshlets.push_back(meshlet);
+			current = uint(meshlets.size()) + 1;
+		}
+
+		g.meshletCount = uint(meshlets.size()) - g.firstMeshlet;
+	}
+
+	return meshlets;
+}
+
+void MeshletBuilder::computeBounds(Meshlet & meshlet, const std::vector<Vertex> & vertices, const uint * indices)
+{
+	vec3 minimum(std::numeric_limits<float>::max());
+	vec3 maximum(-std::numeric_limits<float>::max());
+	vec3 normalSum(0.0f);
+
+	for (uint i = 0; i < meshlet.indexCount; i += 3)
+	{
+		const vec3 & p0 = vertices[indices[i + 0]].position;
+		const vec3 & p1 = vertices[indices[i + 1]].position;
+		const vec3 & p2 = vertices[indices[i + 2]].position;
+
+		minimum = min(min(minimum, p0), min(p1, p2));
+		maximum = max(max(maximum, p0), max(p1, p2));
+
+		// area weighted
+		normalSum += cross(p1 - p0, p2 - p0);
+	}
+
+	meshlet.center = (minimum + maximum) * 0.5f;
+	meshlet.radius = 0.0f;
+
+	for (uint i = 0; i < meshlet.indexCount; i++)
+		meshlet.radius = std::max(meshlet.radius, length(vertices[indices[i]].position - meshlet.center));
+
+	// a cutoff above one never culls
+	meshlet.coneAxis = vec3(0.0f, 0.0f, 1.0f);
+	meshlet.coneCutoff = 2.0f;
+
+	if (!(dot(normalSum, normalSum) > 0.0f))
+		return;
+
+	const vec3 axis = normalize(normalSum);
+	float minimumDot = 1.0f;
+
+	for (uint i = 0; i < meshlet.indexCount; i += 3)
+	{
+		const vec3 & p0 = vertices[indices[i + 0]].position;
+		const vec3 n = cross(vertices[indices[i + 1]].position - p0, vertices[indices[i + 2]].position - p0);
+
+		if (dot(n, n) > 0.0f)
+			minimumDot = std::min(minimumDot, dot(normalize(n), axis));
+	}
+
+	if (minimumDot < minimumConeDot)
+		return;
+
+	meshlet.coneAxis = axis;
+	meshlet.coneCutoff = std::sqrt(1.0f - minimumDot * minimumDot);
+}
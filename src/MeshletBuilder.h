@@ -0,0 +1,24 @@
+#pragma once
+
+#include "Model.h"
+
+#include <vector>
+
+namespace minity
+{
+	// splits the groups into meshlets of consecutive triangles, so that the triangle order chosen for the vertex cache is kept
+	class MeshletBuilder
+	{
+	public:
+
+		static constexpr unsigned int maxVertices = 64;
+		static constexpr unsigned int maxTriangles = 124;
+
+		// returns the meshlets of all groups in order and sets the meshlet range of every group
+		static std::vector<Meshlet> build(const std::vector<Vertex> & vertices, const std::vector<glm::uint> & indices, std::vector<Group> & groups);
+
+	private:
+
+		static void computeBounds(Meshlet & meshlet, const std::vector<Vertex> & vertices, const glm::uint * indices);
+	};
+}
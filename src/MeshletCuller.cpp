@@ -0,0 +1,197 @@
+#include "MeshletCuller.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+
+using namespace glm;
+using namespace minity;
+
+MeshletCuller::MeshletCuller(const std::vector<Meshlet> & meshlets, const std::vector<Group> & groups, unsigned int threadCount) : m_pool(threadCount)
+{
+	const std::size_t count = meshlets.size();
+
+	for (auto array : { &m_centerX, &m_centerY, &m_centerZ, &m_radius, &m_axisX, &m_axisY, &m_axisZ, &m_cutoff })
+		array->resize(count);
+
+	m_triangles.resize(count);
+	m_visible.assign(count, 1);
+
+	for (std::size_t i = 0; i < count; i++)
+	{
+		const Meshlet & m = meshlets[i];
+
+		m_centerX[i] = m.center.x;
+		m_centerY[i] = m.center.y;
+		m_centerZ[i] = m.center.z;
+		m_radius[i] = m.radius;
+		m_axisX[i] = m.coneAxis.x;
+		m_axisY[i] = m.coneAxis.y;
+		m_axisZ[i] = m.coneAxis.z;
+		m_cutoff[i] = m.coneCutoff;
+		m_triangles[i] = m.indexCount / 3;
+	}
+
+	for (const auto & g : groups)
+		m_groupMeshlets.push_back(g.firstMeshlet);
+
+	m_groupMeshlets.push_back(groups.empty() ? 0 : groups.back().firstMeshlet + groups.back().meshletCount);
+
+	m_statistics.meshlets = count;
+
+	for (auto t : m_triangles)
+		m_statistics.triangles += t;
+}
+
+void MeshletCuller::cull(const mat4 & modelViewProjectionMatrix, const vec3 & cameraPosition, const std::vector<vec3> & groupOffsets, bool frustumCulling, bool coneCulling)
+{
+	auto start = std::chrono::steady_clock::now();
+
+	// the planes of the frustum from the rows of the matrix, pointing inwards
+	vec4 planes[6];
+	const vec4 row0(modelViewProjectionMatrix[0][0], modelViewProjectionMatrix[1][0], modelViewProjectionMatrix[2][0], modelViewProjectionMatrix[3][0]);
+	const vec4 row1(modelViewProjectionMatrix[0][1], modelViewProjectionMatrix[1][1], modelViewProjectionMatrix[2][1], modelViewProjectionMatrix[3][1]);
+	const vec4 row2(modelViewProjectionMatrix[0][2], modelViewProjectionMatrix[1][2], modelViewProjectionMatrix[2][2], modelViewProjectionMatrix[3][2]);
+	const vec4 row3(modelViewProjectionMatrix[0][3], modelViewProjectionMatrix[1][3], modelViewProjectionMatrix[2][3], modelViewProjectionMatrix[3][3]);
+
+	planes[0] = row3 + row0;
+	planes[1] = row3 - row0;
+	planes[2] = row3 + row1;
+	planes[3] = row3 - row1;
+	planes[4] = row3 + row2;
+	planes[5] = row3 - row2;
+
+	for (auto & p : planes)
+	{
+		const float l = length(vec3(p));
+
+		if (l > 0.0f)
+			p /= l;
+	}
+
+	const std::size_t count = m_visible.size();
+	const std::size_t taskCount = std::max<std::size_t>(1, std::min<std::size_t>(m_pool.threadCount(), count / minimumTaskSize));
+	std::vector<Statistics> taskStatistics(taskCount);
+
+	auto task = [&](std::size_t t) {
+		cullRange(count * t / taskCount, count * (t + 1) / taskCount, planes, cameraPosition, groupOffsets, frustumCulling, coneCulling, taskStatistics[t]);
+	};
+
+	if (taskCount == 1)
+		task(0);
+	else
+		m_pool.parallelFor(taskCount, task);
+
+	m_statistics.visibleMeshlets = 0;
+	m_statistics.frustumCulledTriangles = 0;
+	m_statistics.coneCulledTriangles = 0;
+
+	for (const auto & s : taskStatistics)
+	{
+		m_statistics.visibleMeshlets += s.visibleMeshlets;
+		m_statistics.frustumCulledTriangles += s.frustumCulledTriangles;
+		m_statistics.coneCulledTriangles += s.coneCulledTriangles;
+	}
+
+	auto end = std::chrono::steady_clock::now();
+	m_statistics.seconds = std::chrono::duration<double>(end - start).count();
+}
+
+void MeshletCuller::cullRange(std::size_t begin, std::size_t end, const vec4 * planes, const vec3 & cameraPosition, const std::vector<vec3> & groupOffsets,
+	bool frustumCulling, bool coneCulling, Statistics & statistics)
+{
+	const float * centerX = m_centerX.data();
+	const float * centerY = m_centerY.data();
+	const float * centerZ = m_centerZ.data();
+	const float * radius = m_radius.data();
+	const float * axisX = m_axisX.data();
+	const float * axisY = m_axisY.data();
+	const float * axisZ = m_axisZ.data();
+	const float * cutoff = m_cutoff.data();
+	const std::uint32_t * triangles = m_triangles.data();
+	std::uint8_t * visible = m_visible.data();
+
+	// disabled tests use planes and cutoffs which pass everything
+	const float frustumBias = frustumCulling ? 0.0f : std::numeric_limits<float>::infinity();
+	const float coneBias = coneCulling ? 0.0f : std::numeric_limits<float>::infinity();
+
+	std::size_t visibleMeshlets = 0;
+	std::size_t frustumCulled = 0;
+	std::size_t coneCulled = 0;
+
+	// the meshlets of a group share an offset, so the inner loop runs over meshlets with a constant offset,
+	// which are all of them as long as the model is not exploded
+	auto offsetOf = [&groupOffsets](std::size_t group) {
+		return group < groupOffsets.size() ? groupOffsets[group] : vec3(0.0f);
+	};
+
+	std::size_t group = std::size_t(std::upper_bound(m_groupMeshlets.begin(), m_groupMeshlets.end(), begin) - m_groupMeshlets.begin() - 1);
+
+	for (std::size_t runBegin = begin; runBegin < end;)
+	{
+		const vec3 offset = offsetOf(group);
+		std::size_t runEnd;
+
+		do
+		{
+			group++;
+			runEnd = std::min(end, m_groupMeshlets[group]);
+		} while (runEnd < end && offsetOf(group) == offset);
+
+		// the planes and the camera are moved against the group instead of moving every meshlet with it
+		float plane[6][4];
+
+		for (int p = 0; p < 6; p++)
+		{
+			plane[p][0] = planes[p].x;
+			plane[p][1] = planes[p].y;
+			plane[p][2] = planes[p].z;
+			plane[p][3] = planes[p].w + dot(vec3(planes[p]), offset) + frustumBias;
+		}
+
+		const vec3 camera = cameraPosition - offset;
+
+		for (std::size_t i = runBegin; i < runEnd; i++)
+		{
+			const float x = centerX[i];
+			const float y = centerY[i];
+			const float z = centerZ[i];
+			const float r = radius[i];
+
+			bool inside = true;
+
+			for (int p = 0; p < 6; p++)
+				inside &= plane[p][0] * x + plane[p][1] * y + plane[p][2] * z + plane[p][3] > -r;
+
+			const float dx = x - camera.x;
+			const float dy = y - camera.y;
+			const float dz = z - camera.z;
+			const float distance = std::sqrt(dx * dx + dy * dy + dz * dz);
+			const bool backFacing = dx * axisX[i] + dy * axisY[i] + dz * axisZ[i] >= cutoff[i] * distance + r + coneBias;
+
+			const bool draw = inside & !backFacing;
+			visible[i] = std::uint8_t(draw);
+
+			visibleMeshlets += draw;
+			frustumCulled += inside ? 0 : triangles[i];
+			coneCulled += (inside & backFacing) ? triangles[i] : 0;
+		}
+
+		runBegin = runEnd;
+	}
+
+	statistics.visibleMeshlets = visibleMeshlets;
+	statistics.frustumCulledTriangles = frustumCulled;
+	statistics.coneCulledTriangles = coneCulled;
+}
+
+const std::vector<std::uint8_t> & MeshletCuller::visible() const
+{
+	return m_visible;
+}
+
+const MeshletCuller::Statistics & MeshletCuller::statistics() const
+{
+	return m_statistics;
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "Model.h"
+#include "ThreadPool.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace minity
+{
+	// tests the bounds of all meshlets against the view frustum and their normal cones against the camera position
+	// every frame, the bounds are kept as structure of arrays so that the tests vectorize
+	class MeshletCuller
+	{
+	public:
+
+		struct Statistics
+		{
+			std::size_t meshlets = 0;
+			std::size_t visibleMeshlets = 0;
+			std::size_t triangles = 0;
+			std::size_t frustumCulledTriangles = 0;
+			std::size_t coneCulledTriangles = 0;
+			double seconds = 0.0;
+		};
+
+		// a thread count of zero uses all hardware threads
+		MeshletCuller(const std::vector<Meshlet> & meshlets, const std::vector<Group> & groups, unsigned int threadCount = 0);
+
+		// the matrix and camera position are in model space, the groups are moved by their offsets like in the vertex shader
+		void cull(const glm::mat4 & modelViewProjectionMatrix, const glm::vec3 & cameraPosition, const std::vector<glm::vec3> & groupOffsets, bool frustumCulling, bool coneCulling);
+
+		// one entry per meshlet, non-zero if it has to be drawn
+		const std::vector<std::uint8_t> & visible() const;
+		const Statistics & statistics() const;
+
+	private:
+
+		void cullRange(std::size_t begin, std::size_t end, const glm::vec4 * planes, const glm::vec3 & cameraPosition, const std::vector<glm::vec3> & groupOffsets,
+			bool frustumCulling, bool coneCulling, Statistics & statistics);
+
+		// below this many meshlets per task the threads cost more than they save
+		static constexpr std::size_t minimumTaskSize = 16384;
+
+		std::vector<float> m_centerX, m_centerY, m_centerZ, m_radius;
+		std::vector<float> m_axisX, m_axisY, m_axisZ, m_cutoff;
+		std::vector<std::uint32_t> m_triangles;
+		// first meshlet of every group and the end of the last one
+		std::vector<std::size_t> m_groupMeshlets;
+
+		std::vector<std::uint8_t> m_visible;
+		Statistics m_statistics;
+		ThreadPool m_pool;
+	};
+}
@@ -0,0 +1,132 @@
+#include "MipmapCache.h"
+#include "CacheFile.h"
+#include "MappedFile.h"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <system_error>
+
+using namespace minity;
+
+namespace
+{
+	const char magic[8] = { 'm','i','n','i','t','y','M','M' };
+}
+
+MipmapCache::MipmapCache(const std::string & filename, TextureLoader::Usage usage, const std::string & cacheDirectory) : m_filename(filename)
+{
+	m_cacheFilename = minity::cacheFilename(filename, cacheDirectory, std::string(".") + TextureLoader::name(usage) + ".mipmaps");
+}
+
+const std::string & MipmapCache::cacheFilename() const
+{
+	return m_cacheFilename;
+}
+
+bool MipmapCache::read(TextureLoader::Image & image, bool srgb)
+{
+	auto file = std::make_shared<MappedFile>();
+
+	if (!file->open(m_cacheFilename))
+		return false;
+
+	CacheReader reader(file->data(), file->size());
+	const char * fileMagic = reader.readBytes(sizeof(magic));
+
+	if (!fileMagic || std::memcmp(fileMagic, magic, sizeof(magic)) != 0 || reader.read<std::uint32_t>() != version || reader.read<std::uint8_t>() != (srgb ? 1 : 0))
+		return false;
+
+	CacheFileKey key = CacheFileKey::read(reader);
+
+	if (!reader.good() || !key.matches())
+		return false;
+
+	TextureLoader::Image cached;
+	cached.contentHash = key.contentHash;
+	cached.width = int(reader.read<std::uint32_t>());
+	cached.height = int(reader.read<std::uint32_t>());
+	cached.channels = int(reader.read<std::uint32_t>());
+	cached.format = BlockCompressor::Format(reader.read<std::uint32_t>());
+
+	if (cached.format != BlockCompressor::Format::None && (BlockCompressor::allFormats() & BlockCompressor::formatBit(cached.format)) == 0)
+		return false;
+
+	const std::uint32_t levelCount = reader.read<std::uint32_t>();
+
+	for (std::uint32_t i = 0; i < levelCount && reader.good(); i++)
+	{
+		MipmapGenerator::Level level;
+		level.width = int(reader.read<std::uint32_t>());
+		level.height = int(reader.read<std::uint32_t>());
+
+		const char * data = reader.readArray<char>(level.size);
+		level.offset = std::size_t(data - file->data());
+
+		const std::size_t expectedSize = cached.format != BlockCompressor::Format::None ? BlockCompressor::compressedSize(cached.format, level.width, level.height) : std::size_t(level.width) * std::size_t(level.height) * std::size_t(cached.channels);
+
+		if (level.size != expectedSize)
+			return false;
+
+		cached.levels.push_back(level);
+	}
+
+	if (!reader.good() || cached.levels.empty())
+		return false;
+
+	cached.data = reinterpret_cast<const unsigned char*>(file->data());
+	cached.storage = file;
+	image = std::move(cached);
+	return true;
+}
+
+bool MipmapCache::write(const TextureLoader::Image & image, bool srgb)
+{
+	// the content hash of the image is the one of the file it was decoded from
+	CacheFileKey key = CacheFileKey::create(m_filename, false);
+	key.contentHash = image.contentHash;
+
+	std::error_code error;
+	const std::filesystem::path cachePath(m_cacheFilename);
+
+	if (cachePath.has_parent_path())
+		std::filesystem::create_directories(cachePath.parent_path(), error);
+
+	// several loaders may write the same image at once, so the temporary file is unique to the image object
+	const std::string temporaryFilename = m_cacheFilename + "." + std::to_string(reinterpret_cast<std::uintptr_t>(image.data)) + ".tmp";
+
+	{
+		std::ofstream os(temporaryFilename, std::ios::binary | std::ios::trunc);
+
+		if (!os.is_open())
+			return false;
+
+		CacheWriter writer(os);
+		writer.writeBytes(magic, sizeof(magic));
+		writer.write(version);
+		writer.write(std::uint8_t(srgb ? 1 : 0));
+		key.write(writer);
+
+		writer.write(std::uint32_t(image.width));
+		writer.write(std::uint32_t(image.height));
+		writer.write(std::uint32_t(image.channels));
+		writer.write(std::uint32_t(image.format));
+		writer.write(std::uint32_t(image.levels.size()));
+
+		for (const auto & level : image.levels)
+		{
+			writer.write(std::uint32_t(level.width));
+			writer.write(std::uint32_t(level.height));
+			writer.writeArray(image.data + level.offset, level.size);
+		}
+
+		if (!os.good())
+		{
+			os.close();
+			std::filesystem::remove(temporaryFilename, error);
+			return false;
+		}
+	}
+
+	return commitCacheFile(temporaryFilename, m_cacheFilename);
+}
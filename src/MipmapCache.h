@@ -0,0 +1,34 @@
+#pragma once
+
+#include "TextureLoader.h"
+
+#include <cstdint>
+#include <string>
+
+namespace minity
+{
+	// raw file holding a decoded image with all of its mipmaps, possibly block compressed,
+	// so repeated loads skip decoding, mipmap generation and compression
+	class MipmapCache
+	{
+	public:
+
+		// bumped whenever the layout of the file or the filtering of the mipmaps changes
+		static constexpr std::uint32_t version = 2;
+
+		// an empty cache directory places the cache file next to the image, each usage of the image has its own file
+		MipmapCache(const std::string & filename, TextureLoader::Usage usage, const std::string & cacheDirectory = std::string());
+
+		const std::string & cacheFilename() const;
+
+		// maps the cache file if it is still valid for the image, the levels of the image then point into the mapping
+		bool read(TextureLoader::Image & image, bool srgb);
+
+		bool write(const TextureLoader::Image & image, bool srgb);
+
+	private:
+
+		std::string m_filename;
+		std::string m_cacheFilename;
+	};
+}
@@ -0,0 +1,223 @@
+#include "MipmapGenerator.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MINITY_SSE2
+#include <emmintrin.h>
+#endif
+
+using namespace minity;
+
+namespace
+{
+	// linear values are quantized to this many steps before they are encoded again, which keeps
+	// the error of the round trip below a quarter of an 8 bit step even in the dark sRGB range
+	const int encodeSteps = 16383;
+
+	struct TransferTables
+	{
+		// index 0 is used for linear channels, index 1 for sRGB encoded ones
+		float decode[2][256];
+		unsigned char encode[2][encodeSteps + 1];
+
+		TransferTables()
+		{
+			for (int i = 0; i < 256; i++)
+			{
+				const float v = float(i) / 255.0f;
+				decode[0][i] = v;
+				decode[1][i] = v <= 0.04045f ? v / 12.92f : std::pow((v + 0.055f) / 1.055f, 2.4f);
+			}
+
+			for (int i = 0; i <= encodeSteps; i++)
+			{
+				const float v = float(i) / float(encodeSteps);
+				const float s = v <= 0.0031308f ? v * 12.92f : 1.055f * std::pow(v, 1.0f / 2.4f) - 0.055f;
+				encode[0][i] = (unsigned char)(std::min(255.0f, v * 255.0f + 0.5f));
+				encode[1][i] = (unsigned char)(std::min(255.0f, s * 255.0f + 0.5f));
+			}
+		}
+	};
+
+	const TransferTables & transferTables()
+	{
+		static const TransferTables tables;
+		return tables;
+	}
+
+	// alpha is stored linearly, so only the color channels of gray/alpha and RGBA images are sRGB encoded
+	bool isSrgbChannel(int channel, int channels, bool srgb)
+	{
+		if (!srgb)
+			return false;
+
+		if (channels == 2 || channels == 4)
+			return channel < channels - 1;
+
+		return true;
+	}
+
+	// target[i] = (sum[2i] + sum[2i+1]) / 4 for texels of the given channel count
+	void averagePairs(const float * sum, float * target, int targetWidth, int channels)
+	{
+		int i = 0;
+
+#ifdef MINITY_SSE2
+		const __m128 quarter = _mm_set1_ps(0.25f);
+
+		if (channels == 4)
+		{
+			for (; i < targetWidth; i++)
+			{
+				const __m128 a = _mm_loadu_ps(sum + 8 * i);
+				const __m128 b = _mm_loadu_ps(sum + 8 * i + 4);
+				_mm_storeu_ps(target + 4 * i, _mm_mul_ps(_mm_add_ps(a, b), quarter));
+			}
+		}
+		else if (channels == 2)
+		{
+			for (; i + 2 <= targetWidth; i += 2)
+			{
+				const __m128 a = _mm_loadu_ps(sum + 4 * i);
+				const __m128 b = _mm_loadu_ps(sum + 4 * i + 4);
+				const __m128 first = _mm_shuffle_ps(a, b, _MM_SHUFFLE(1, 0, 1, 0));
+				const __m128 second = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 2, 3, 2));
+				_mm_storeu_ps(target + 2 * i, _mm_mul_ps(_mm_add_ps(first, second), quarter));
+			}
+		}
+		else if (channels == 1)
+		{
+			for (; i + 4 <= targetWidth; i += 4)
+			{
+				const __m128 a = _mm_loadu_ps(sum + 2 * i);
+				const __m128 b = _mm_loadu_ps(sum + 2 * i + 4);
+				const __m128 even = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+				const __m128 odd = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+				_mm_storeu_ps(target + i, _mm_mul_ps(_mm_add_ps(even, odd), quarter));
+			}
+		}
+#endif
+
+		for (; i < targetWidth; i++)
+		{
+			for (int k = 0; k < channels; k++)
+				target[i * channels + k] = (sum[2 * i * channels + k] + sum[(2 * i + 1) * channels + k]) * 0.25f;
+		}
+	}
+
+	// converts linear values in [0,1] to indices into the encode tables
+	void quantize(const float * values, int * indices, std::size_t count)
+	{
+		std::size_t i = 0;
+
+#ifdef MINITY_SSE2
+		const __m128 scale = _mm_set1_ps(float(encodeSteps));
+		const __m128 half = _mm_set1_ps(0.5f);
+		const __m128 lowest = _mm_setzero_ps();
+		const __m128 highest = _mm_set1_ps(float(encodeSteps));
+
+		for (; i + 4 <= count; i += 4)
+		{
+			__m128 v = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(values + i), scale), half);
+			v = _mm_min_ps(_mm_max_ps(v, lowest), highest);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(indices + i), _mm_cvttps_epi32(v));
+		}
+#endif
+
+		for (; i < count; i++)
+			indices[i] = int(std::min(std::max(values[i] * float(encodeSteps) + 0.5f, 0.0f), float(encodeSteps)));
+	}
+}
+
+std::vector<MipmapGenerator::Level> MipmapGenerator::layout(int width, int height, int channels)
+{
+	std::vector<Level> levels;
+	std::size_t offset = 0;
+
+	while (true)
+	{
+		Level level;
+		level.width = width;
+		level.height = height;
+		level.offset = offset;
+		level.size = std::size_t(width) * std::size_t(height) * std::size_t(channels);
+		levels.push_back(level);
+
+		offset = (offset + level.size + 15) & ~std::size_t(15);
+
+		if (width == 1 && height == 1)
+			break;
+
+		width = std::max(1, width / 2);
+		height = std::max(1, height / 2);
+	}
+
+	return levels;
+}
+
+void MipmapGenerator::generate(unsigned char * data, const std::vector<Level> & levels, int channels, bool srgb)
+{
+	for (std::size_t i = 1; i < levels.size(); i++)
+	{
+		const Level & source = levels[i - 1];
+		downsample(data + source.offset, source.width, source.height, data + levels[i].offset, channels, srgb);
+	}
+}
+
+void MipmapGenerator::downsample(const unsigned char * source, int width, int height, unsigned char * target, int channels, bool srgb)
+{
+	const TransferTables & tables = transferTables();
+	const int targetWidth = std::max(1, width / 2);
+	const int targetHeight = std::max(1, height / 2);
+
+	const float * decode[4];
+	const unsigned char * encode[4];
+
+	for (int k = 0; k < channels; k++)
+	{
+		const int table = isSrgbChannel(k, channels, srgb) ? 1 : 0;
+		decode[k] = tables.decode[table];
+		encode[k] = tables.encode[table];
+	}
+
+	// a single column is used twice, so that every target texel averages two columns
+	const std::size_t rowLength = std::size_t(width) * std::size_t(channels);
+	std::vector<float> sum(std::max(rowLength, std::size_t(2 * channels)));
+	std::vector<float> averaged(std::size_t(targetWidth) * std::size_t(channels));
+	std::vector<int> indices(averaged.size());
+
+	for (int y = 0; y < targetHeight; y++)
+	{
+		// an odd last row is dropped like the last column, as the GL does for non power of two textures
+		const unsigned char * row0 = source + std::size_t(std::min(2 * y, height - 1)) * rowLength;
+		const unsigned char * row1 = source + std::size_t(std::min(2 * y + 1, height - 1)) * rowLength;
+
+		for (int x = 0; x < width; x++)
+		{
+			for (int k = 0; k < channels; k++)
+			{
+				const std::size_t i = std::size_t(x) * std::size_t(channels) + std::size_t(k);
+				sum[i] = decode[k][row0[i]] + decode[k][row1[i]];
+			}
+		}
+
+		if (width == 1)
+			std::copy(sum.begin(), sum.begin() + channels, sum.begin() + channels);
+
+		averagePairs(sum.data(), averaged.data(), targetWidth, channels);
+		quantize(averaged.data(), indices.data(), averaged.size());
+
+		unsigned char * targetRow = target + std::size_t(y) * averaged.size();
+
+		for (int x = 0; x < targetWidth; x++)
+		{
+			for (int k = 0; k < channels; k++)
+			{
+				const std::size_t i = std::size_t(x) * std::size_t(channels) + std::size_t(k);
+				targetRow[i] = encode[k][indices[i]];
+			}
+		}
+	}
+}
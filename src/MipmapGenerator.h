@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+namespace minity
+{
+	// builds mipmap chains of 8 bit images on the CPU with a 2x2 box filter,
+	// sRGB encoded color channels are averaged in linear space, alpha and data channels as they are
+	class MipmapGenerator
+	{
+	public:
+
+		struct Level
+		{
+			int width = 0;
+			int height = 0;
+			// relative to the start of the image data
+			std::size_t offset = 0;
+			std::size_t size = 0;
+		};
+
+		// all levels down to 1x1 with tightly packed rows, each level starts on a 16 byte boundary
+		static std::vector<Level> layout(int width, int height, int channels);
+
+		// fills all levels but the first of data, which is laid out according to levels
+		static void generate(unsigned char * data, const std::vector<Level> & levels, int channels, bool srgb);
+
+		// halves both dimensions, a dimension of one stays one
+		static void downsample(const unsigned char * source, int width, int height, unsigned char * target, int channels, bool srgb);
+	};
+}
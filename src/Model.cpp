@@ -1,25 +1,27 @@
 #include "Model.h"
+#include "ObjLoader.h"
+#include "MeshCache.h"
+#include "TextureLoader.h"
+#include "VertexQuantizer.h"
+#include "IndexPacker.h"
+#include "MeshletBuilder.h"
+#include "MeshletCuller.h"
+#include "GroupCuller.h"
+#include "IndirectDrawBuffer.h"
+#include "OcclusionCuller.h"
+#include "OcclusionQueries.h"
+#include "OutOfCoreLoader.h"
 
-#include <list>
-#include <fstream>
 #include <string>
-#include <sstream>
-#include <cstdlib>
-#include <iterator>
+#include <chrono>
 #include <iostream>
 #include <limits>
-#include <unordered_map>
-#include <array>
-#include <algorithm> 
-#include <cctype>
-#include <locale>
+#include <algorithm>
+#include <cstddef>
 #include <filesystem>
 #include <globjects/globjects.h>
 #include <globjects/logging.h>
 
-#define STB_IMAGE_IMPLEMENTATION
-#include <stb_image.h>
-
 #define GLM_ENABLE_EXPERIMENTAL
 #include <glm/gtx/string_cast.hpp>
 
@@ -28,1024 +30,316 @@ using namespace gl;
 using namespace glm;
 using namespace globjects;
 
-std::string trimLeft(const std::string &str, const std::string &whitespace = "\n\r\t ")
-{
-	size_t uIndex = str.find_first_not_of(whitespace);
-	if (uIndex != std::string::npos)
-		return str.substr(uIndex);
-
-	return "";
-}
-
-std::string trimRight(const std::string &str, const std::string &whitespace = "\n\r\t ")
+Model::Model()
 {
-	size_t  uIndex = str.find_last_not_of(whitespace);
-	if (uIndex != std::string::npos)
-		return str.substr(0, uIndex + 1);
 
-	return str;
 }
 
-std::string trim(const std::string &str, const std::string & whitespace = "\n\r\t ")
+Model::Model(const std::string& filename, const LoadOptions & options)
 {
-	return trimRight(trimLeft(str, whitespace), whitespace);
+	load(filename, options);
 }
 
-template<class e, class t, int N>
-std::basic_istream<e, t>& operator>>(std::basic_istream<e, t>& in, const e(&sliteral)[N])
+Model::~Model()
 {
-	std::array<e, N - 1> buffer; //get buffer
-	in >> buffer[0]; //skips whitespace
-	if (N > 2)
-		in.read(&buffer[1], N - 2); //read the rest
-	if (strncmp(&buffer[0], sliteral, N - 1)) //if it failed
-		in.setstate(in.rdstate() | std::ios::failbit); //set the state
-	return in;
-}
 
-template<class e, class t>
-std::basic_istream<e, t>& operator>>(std::basic_istream<e, t>& in, const e& cliteral)
-{
-	e buffer;  //get buffer
-	in >> buffer; //read data
-	if (buffer != cliteral) //if it failed
-		in.setstate(in.rdstate() | std::ios::failbit); //set the state
-	return in;
 }
 
-//redirect mutable char arrays to their normal function
-template<class e, class t, int N>
-std::basic_istream<e, t>& operator>>(std::basic_istream<e, t>& in, e(&carray)[N])
+void Model::load(const std::string& filename, const LoadOptions & options)
 {
-	return std::operator>>(in, carray);
-}
+	globjects::debug() << "Loading file " << filename << " ...";
 
-class ObjLoader
-{
-public:
+	auto loadStart = std::chrono::steady_clock::now();
 
-	struct ObjGroup
-	{
-		std::string name;
-		std::string material;
-		std::vector<unsigned int> positionIndices;
-		std::vector<unsigned int> normalIndices;
-		std::vector<unsigned int> texCoordIndices;
-	};
-
-	struct ObjMaterial
-	{
-		// Material Name
-		std::string name;
-		// Ambient Color
-		vec3 Ka = vec3(0.2f,0.2f,0.2f);
-		// Diffuse Color
-		vec3 Kd = vec3(0.8f,0.8f,0.8f);
-		// Specular Color
-		vec3 Ks = vec3(1.0f,1.0f,1.0f);
-		// Specular Exponent
-		float Ns = 0.0f;
-		// Dissolve
-		float d = 1.0f;
-		// Illumination
-		int illum = 0;
-		// Ambient Texture Map
-		std::string map_Ka;
-		// Diffuse Texture Map
-		std::string map_Kd;
-		// Specular Texture Map
-		std::string map_Ks;
-		// Specular Hightlight Map
-		std::string map_Ns;
-		// Alpha Texture Map
-		std::string map_d;
-		// Bump Map
-		std::string map_bump;
-		// Object Space Normal Map
-		std::string map_objectSpaceNormals;
-		// Tanget Space Normal Map
-		std::string map_tangentSpaceNormals;
-	};
-
-	bool loadObjFile(const std::string & filename)
-	{
-		std::filesystem::path path(filename);
-		std::ifstream is(filename);
+	m_loadStatistics.clear();
+	m_loadStatistics.setFilename(filename);
+	LoadStatistics::Scope loadScope(&m_loadStatistics, "model");
 
-		if (!is.is_open())
-			return false;
+	m_minimumBounds = vec3(std::numeric_limits<float>::max());
+	m_maximumBounds = vec3(-std::numeric_limits<float>::max());
 
-		std::vector< vec3 > positions;
-		std::vector< vec3 > normals;
-		std::vector< vec2 > texCoords;
+	// a failed load returns early with an empty model, which the renderers draw as an empty scene
+	m_vertices.clear();
+	m_indices.clear();
+	m_materials.clear();
+	m_groups.clear();
+	m_meshlets.clear();
+	m_meshletCuller = std::make_unique<MeshletCuller>(m_meshlets, m_groups, 1);
+	m_groupCuller = std::make_unique<GroupCuller>(m_groups, 1);
+	m_indirectDraws = std::make_unique<IndirectDrawBuffer>(m_groups, m_materials);
+	m_occlusionCuller = std::make_unique<OcclusionCuller>(m_meshlets, m_groups, *m_indirectDraws);
+	m_occlusionQueries = std::make_unique<OcclusionQueries>(m_groups);
+
+	// the texture loader outlives the loader, since decoding continues after loading has finished
+	if (options.loadTextures && options.asyncTextures)
+		m_textureLoader = std::make_unique<TextureLoader>(options);
+	else
+		m_textureLoader.reset();
 
-		positions.push_back(vec3(0.0f));
-		normals.push_back(vec3(0.0f));
-		texCoords.push_back(vec2(1.0f));
+	ObjLoader loader(options, m_textureLoader.get(), &m_loadStatistics);
+	MeshCache cache(filename, options);
 
-		std::unordered_map< std::string, int > materialMap;
-		std::vector<ObjMaterial> materials;
+	// loading in core takes several times the size of the file
+	std::error_code sizeError;
+	const std::uintmax_t fileSize = std::filesystem::file_size(filename, sizeError);
+	m_outOfCore = options.memoryLimit > 0 && !sizeError && fileSize > options.memoryLimit / 4;
+	m_compactVertices = options.compactVertices;
 
-		ObjMaterial defaultMaterial;
-		defaultMaterial.name = "default";
+	LoadStatistics::Scope cacheScope(!m_outOfCore && options.meshCache ? &m_loadStatistics : nullptr, "mesh cache read");
+	const bool cached = !m_outOfCore && options.meshCache && cache.read();
 
-		materialMap.insert(std::make_pair(defaultMaterial.name, int(materials.size())));
-		materials.push_back(defaultMaterial);
+	if (cached)
+		cacheScope.add(cache.vertexCount() * sizeof(Vertex) + cache.indexCount() * sizeof(uint), cache.indexCount() / 3);
 
-		std::string currentMaterial;
-		currentMaterial = defaultMaterial.name;
+	cacheScope.end();
 
-		std::unordered_map< std::string, typename std::list<ObjGroup>::iterator > groupMap;
-		std::list<ObjGroup> groupList;
-		std::list<ObjGroup>::iterator groupIterator;
+	if (m_outOfCore)
+	{
+		if (!loadOutOfCore(filename, options))
+		{
+			globjects::debug() << "Error loading << " << filename << "!";
+			return;
+		}
 
-		ObjGroup defaultGroup;
-		defaultGroup.name = "default";
-		defaultGroup.material = currentMaterial;
-		groupList.push_back(defaultGroup);
-		groupIterator = groupList.end();
-		groupIterator--;
-		groupMap[defaultGroup.name] = groupIterator;
+		auto loadEnd = std::chrono::steady_clock::now();
+		globjects::debug() << "Loaded from source in " << std::chrono::duration<double>(loadEnd - loadStart).count() << " s (out of core)";
+	}
+	else if (cached)
+	{
+		m_filename = filename;
+		m_vertices.assign(cache.vertexData(), cache.vertexData() + cache.vertexCount());
+		m_indices.assign(cache.indexData(), cache.indexData() + cache.indexCount());
+		m_groups = cache.groups();
+		m_minimumBounds = cache.minimumBounds();
+		m_maximumBounds = cache.maximumBounds();
 
-		std::string buffer;
+		loader.createMaterials(filename, cache.objMaterials());
+		m_materials = loader.materials();
 
-		while (is.good())
+		// the vertex buffer is filled directly from the mapped cache file, compact vertices and the indices are packed below
+		if (!options.compactVertices)
 		{
-			if (getline(is, buffer))
-			{
-				std::istringstream iss(buffer);
-				std::string token;
-
-				if (iss >> token)
-				{
-					switch (token.at(0))
-					{
-						// v, vn, vt
-					case 'v':
-					{
-						if (token == "v")
-						{
-							vec3 p(0.0f);
-
-							if (iss >> p.x >> p.y >> p.z)
-								positions.push_back(p);
-						}
-						else if (token == "vn")
-						{
-							vec3 n(0.0f);
-
-							if (iss >> n.x >> n.y >> n.z)
-								normals.push_back(n);
-						}
-						else if (token == "vt")
-						{
-							vec2 t(0.0f);
-
-							if (iss >> t.x >> t.y)
-								texCoords.push_back(t);
-						}
-					}
-					break;
-
-					// mtllib
-					case 'm':
-					{
-						// the Wavefront obj specification does not really allow for spaces in the mtl file name,
-						// since multiple libraries are supposed to be separated by spaces, but many programs
-						// do not take care of that -- therefore, we first try whether it is a single filename,
-						// and only if that fails we use the interpretation according to the specification
-						std::string libraryName;
-
-						if (getline(iss, libraryName))
-						{
-							libraryName = trim(libraryName);
-							std::filesystem::path libraryPath = libraryName;
-
-							// first try
-							if (libraryPath.is_absolute())
-							{
-								if (loadMtlFile(libraryPath.string(), materials, materialMap))
-									break;
-							}
-
-							std::stringstream mss(libraryName);
-
-							while (mss >> libraryName)
-							{
-								libraryName = trim(libraryName);
-								std::filesystem::path libraryPath = path.parent_path();
-								libraryPath.append(libraryName);
-								loadMtlFile(libraryPath.string(), materials, materialMap);
-							}
-						}
-					}
-					break;
-
-					// use material
-					case 'u':
-					{
-						std::string materialName;
-
-						if (getline(iss, materialName))
-						{
-							materialName = trim(materialName);
-							currentMaterial = materialName;
-							groupIterator->material = currentMaterial;
-						}
-					}
-					break;
-
-					// group
-					case 'g':
-					case 'o':
-					{
-						std::string groupName;
-						
-						if (getline(iss,groupName))
-						{
-							groupName = trim(groupName);
-							std::unordered_map< std::string, typename std::list<ObjGroup>::iterator >::iterator j = groupMap.find(groupName);
-
-							if (j == groupMap.end())
-							{
-								ObjGroup newGroup;
-								newGroup.name = groupName;
-
-								groupList.push_back(newGroup);
-								groupIterator = groupList.end();
-								groupIterator--;
-							}
-							else
-								groupIterator = j->second;
-
-							groupIterator->material = currentMaterial;
-						}
-					}
-					break;
-
-					// face
-					case 'f':
-					{
-						int v = 0, n = 0, t = 0;
-
-						if (buffer.find("//") != std::string::npos)
-						{
-							// v//n
-							if (iss >> v >> ("//") >> n)
-							{
-								groupIterator->positionIndices.push_back(v < 0 ? (unsigned int) (v + positions.size()) : (unsigned int) (v));
-								groupIterator->texCoordIndices.push_back(0);
-								groupIterator->normalIndices.push_back(n < 0 ? (unsigned int) (n + normals.size()) : (unsigned int) (n));
-							}
-
-							if (iss >> v >> ("//") >> n)
-							{
-								groupIterator->positionIndices.push_back(v < 0 ? (unsigned int) (v + positions.size()) : (unsigned int) (v));
-								groupIterator->texCoordIndices.push_back(0);
-								groupIterator->normalIndices.push_back(n < 0 ? (unsigned int) (n + normals.size()) : (unsigned int) (n));
-							}
-
-							if (iss >> v >> ("//") >> n)
-							{
-								groupIterator->positionIndices.push_back(v < 0 ? (unsigned int) (v + positions.size()) : (unsigned int) (v));
-								groupIterator->texCoordIndices.push_back(0);
-								groupIterator->normalIndices.push_back(n < 0 ? (unsigned int) (n + normals.size()) : (unsigned int) (n));
-							}
-
-							while (iss >> v >> ("//") >> n)
-							{
-								groupIterator->positionIndices.push_back(groupIterator->positionIndices[groupIterator->positionIndices.size() - 3]);
-								groupIterator->texCoordIndices.push_back(0);
-								groupIterator->normalIndices.push_back(groupIterator->normalIndices[groupIterator->normalIndices.size() - 3]);
-
-								groupIterator->positionIndices.push_back(groupIterator->positionIndices[groupIterator->positionIndices.size() - 2]);
-								groupIterator->texCoordIndices.push_back(0);
-								groupIterator->normalIndices.push_back(groupIterator->normalIndices[groupIterator->normalIndices.size() - 2]);
-
-								groupIterator->positionIndices.push_back(v < 0 ? (unsigned int) (v + positions.size()) : (unsigned int) (v));
-								groupIterator->texCoordIndices.push_back(0);
-								groupIterator->normalIndices.push_back(n < 0 ? (unsigned int) (n + normals.size()) : (unsigned int) (n));
-							}
-
-							break;
-						}
-
-						iss = std::istringstream(buffer);
-						iss >> token;
-
-						if (iss >> v >> ("/") >> t >> ("/") >> n)
-						{
-							// v/t/n
-							groupIterator->positionIndices.push_back(v < 0 ? (unsigned int) (v + positions.size()) : (unsigned int) (v));
-							groupIterator->texCoordIndices.push_back(t < 0 ? (unsigned int) (t + texCoords.size()) : (unsigned int) (t));
-							groupIterator->normalIndices.push_back(n < 0 ? (unsigned int) (n + normals.size()) : (unsigned int) (n));
-
-							if (iss >> v >> ("/") >> t >> ("/") >> n)
-							{
-								groupIterator->positionIndices.push_back(v < 0 ? (unsigned int) (v + positions.size()) : (unsigned int) (v));
-								groupIterator->texCoordIndices.push_back(t < 0 ? (unsigned int) (t + texCoords.size()) : (unsigned int) (t));
-								groupIterator->normalIndices.push_back(n < 0 ? (unsigned int) (n + normals.size()) : (unsigned int) (n));
-							}
-
-							if (iss >> v >> ("/") >> t >> ("/") >> n)
-							{
-								groupIterator->positionIndices.push_back(v < 0 ? (unsigned int) (v + positions.size()) : (unsigned int) (v));
-								groupIterator->texCoordIndices.push_back(t < 0 ? (unsigned int) (t + texCoords.size()) : (unsigned int) (t));
-								groupIterator->normalIndices.push_back(n < 0 ? (unsigned int) (n + normals.size()) : (unsigned int) (n));
-							}
-
-							while (iss >> v >> ("/") >> t >> ("/") >> n)
-							{
-								groupIterator->positionIndices.push_back(groupIterator->positionIndices[groupIterator->positionIndices.size() - 3]);
-								groupIterator->texCoordIndices.push_back(groupIterator->texCoordIndices[groupIterator->texCoordIndices.size() - 3]);
-								groupIterator->normalIndices.push_back(groupIterator->normalIndices[groupIterator->normalIndices.size() - 3]);
-
-								groupIterator->positionIndices.push_back(groupIterator->positionIndices[groupIterator->positionIndices.size() - 2]);
-								groupIterator->texCoordIndices.push_back(groupIterator->texCoordIndices[groupIterator->texCoordIndices.size() - 2]);
-								groupIterator->normalIndices.push_back(groupIterator->normalIndices[groupIterator->normalIndices.size() - 2]);
-
-								groupIterator->positionIndices.push_back(v < 0 ? (unsigned int) (v + positions.size()) : (unsigned int) (v));
-								groupIterator->texCoordIndices.push_back(t < 0 ? (unsigned int) (t + texCoords.size()) : (unsigned int) (t));
-								groupIterator->normalIndices.push_back(n < 0 ? (unsigned int) (n + normals.size()) : (unsigned int) (n));
-							}
-
-							break;
-						}
-
-						iss = std::istringstream(buffer);
-						iss >> token;
-
-						if (iss >> v >> ("/") >> t)
-						{
-							// v/t
-							groupIterator->positionIndices.push_back(v < 0 ? (unsigned int) (v + positions.size()) : (unsigned int) (v));
-							groupIterator->texCoordIndices.push_back(t < 0 ? (unsigned int) (t + texCoords.size()) : (unsigned int) (t));
-							groupIterator->normalIndices.push_back(0);
-
-							if (iss >> v >> ("/") >> t)
-							{
-								groupIterator->positionIndices.push_back(v < 0 ? (unsigned int) (v + positions.size()) : (unsigned int) (v));
-								groupIterator->texCoordIndices.push_back(t < 0 ? (unsigned int) (t + texCoords.size()) : (unsigned int) (t));
-								groupIterator->normalIndices.push_back(0);
-							}
-
-							if (iss >> v >> ("/") >> t)
-							{
-								groupIterator->positionIndices.push_back(v < 0 ? (unsigned int) (v + positions.size()) : (unsigned int) (v));
-								groupIterator->texCoordIndices.push_back(t < 0 ? (unsigned int) (t + texCoords.size()) : (unsigned int) (t));
-								groupIterator->normalIndices.push_back(0);
-							}
-
-							while (iss >> v >> ("/") >> t)
-							{
-								groupIterator->positionIndices.push_back(groupIterator->positionIndices[groupIterator->positionIndices.size() - 3]);
-								groupIterator->texCoordIndices.push_back(groupIterator->texCoordIndices[groupIterator->texCoordIndices.size() - 3]);
-								groupIterator->normalIndices.push_back(0);
-
-								groupIterator->positionIndices.push_back(groupIterator->positionIndices[groupIterator->positionIndices.size() - 2]);
-								groupIterator->texCoordIndices.push_back(groupIterator->texCoordIndices[groupIterator->texCoordIndices.size() - 2]);
-								groupIterator->normalIndices.push_back(0);
-
-								groupIterator->positionIndices.push_back(v < 0 ? (unsigned int) (v + positions.size()) : (unsigned int) (v));
-								groupIterator->texCoordIndices.push_back(t < 0 ? (unsigned int) (t + texCoords.size()) : (unsigned int) (t));
-								groupIterator->normalIndices.push_back(0);
-							}
-
-							break;
-						}
-						else
-						{
-							iss = std::istringstream(buffer);
-							iss >> token;
-
-							// v
-							if (iss >> v)
-							{
-								groupIterator->positionIndices.push_back(v < 0 ? (unsigned int) (v + positions.size()) : (unsigned int) (v));
-								groupIterator->texCoordIndices.push_back(0);
-								groupIterator->normalIndices.push_back(0);
-							}
-
-							if (iss >> v)
-							{
-								groupIterator->positionIndices.push_back(v < 0 ? (unsigned int) (v + positions.size()) : (unsigned int) (v));
-								groupIterator->texCoordIndices.push_back(0);
-								groupIterator->normalIndices.push_back(0);
-							}
-
-							if (iss >> v)
-							{
-								groupIterator->positionIndices.push_back(v < 0 ? (unsigned int) (v + positions.size()) : (unsigned int) (v));
-								groupIterator->texCoordIndices.push_back(0);
-								groupIterator->normalIndices.push_back(0);
-							}
-
-							while (iss >> v)
-							{
-								groupIterator->positionIndices.push_back(groupIterator->positionIndices[groupIterator->positionIndices.size() - 3]);
-								groupIterator->texCoordIndices.push_back(0);
-								groupIterator->normalIndices.push_back(0);
-
-								groupIterator->positionIndices.push_back(groupIterator->positionIndices[groupIterator->positionIndices.size() - 2]);
-								groupIterator->texCoordIndices.push_back(0);
-								groupIterator->normalIndices.push_back(0);
-
-								groupIterator->positionIndices.push_back(v < 0 ? (unsigned int) (v + positions.size()) : (unsigned int) (v));
-								groupIterator->texCoordIndices.push_back(0);
-								groupIterator->normalIndices.push_back(0);
-							}
-						}
-					}
-					break;
-					}
-				}
-			}
+			LoadStatistics::Scope uploadScope(&m_loadStatistics, "vertex upload");
+			uploadScope.add(cache.vertexCount() * sizeof(Vertex), cache.vertexCount());
+			m_vertexBuffer->setStorage(GLsizeiptr(cache.vertexCount() * sizeof(Vertex)), cache.vertexData(), gl::GL_NONE_BIT);
 		}
 
-		if (materials.size() <= 1)
-		{
-			std::filesystem::path libraryPath = path;
-			libraryPath.replace_extension("mtl");
-			loadMtlFile(libraryPath.string(), materials, materialMap);
-		}
+		cache.close();
+
+		auto loadEnd = std::chrono::steady_clock::now();
+		globjects::debug() << "Loaded from mesh cache " << cache.cacheFilename() << " in " << std::chrono::duration<double>(loadEnd - loadStart).count() << " s (warm)";
+	}
+	else if (loader.loadObjFile(filename))
+	{
+		m_filename = filename;
+		m_vertices = loader.vertices();
+		m_indices = loader.indices();
+		m_materials = loader.materials();
+		m_groups = loader.groups();
 
-		// compute normals if not present in the file
-		if (normals.size() <= 1)
+		for (auto i : m_indices)
 		{
-			// compute face normals
-			for (std::list<ObjGroup>::iterator i = groupList.begin(); i != groupList.end(); i++)
-			{
-				if (i->positionIndices.size() > 0)
-				{
-					for (unsigned int j = 0; j < i->positionIndices.size() - 2; j += 3)
-					{
-						const vec3 & p0 = positions[i->positionIndices[j + 0]];
-						const vec3 & p1 = positions[i->positionIndices[j + 1]];
-						const vec3 & p2 = positions[i->positionIndices[j + 2]];
-
-						if (i->normalIndices[j + 0] == 0 || i->normalIndices[j + 1] == 0 || i->normalIndices[j + 2] == 0)
-						{
-							if (i->normalIndices[j + 0] == 0)
-								i->normalIndices[j + 0] = normals.size();
-
-							if (i->normalIndices[j + 1] == 0)
-								i->normalIndices[j + 1] = normals.size();
-
-							if (i->normalIndices[j + 2] == 0)
-								i->normalIndices[j + 2] = normals.size();
-
-							const vec3 a(p2 - p1);
-							const vec3 b(p0 - p1);
-							const vec3 n = normalize(cross(a, b));
-							normals.push_back(n);
-						}
-					}
-				}
-			}
-
-			// compute vertex normals
-			std::vector< vec3 > vertexNormals(positions.size());
-			std::vector< vec3 > groupNormals(positions.size());
-
-			for (std::list<ObjGroup>::iterator i = groupList.begin(); i != groupList.end(); i++)
-			{
-				if (i->positionIndices.size() > 0)
-				{
-					for (unsigned int j = 0; j < i->positionIndices.size() - 2; j += 3)
-					{
-						groupNormals[i->positionIndices[j + 0]] = groupNormals[i->positionIndices[j + 0]] + normals[i->normalIndices[j + 0]];
-						groupNormals[i->positionIndices[j + 1]] = groupNormals[i->positionIndices[j + 1]] + normals[i->normalIndices[j + 1]];
-						groupNormals[i->positionIndices[j + 2]] = groupNormals[i->positionIndices[j + 2]] + normals[i->normalIndices[j + 2]];
-					}
-
-					for (unsigned int j = 0; j < i->positionIndices.size() - 2; j += 3)
-					{
-						vertexNormals[i->positionIndices[j + 0]] = normalize(groupNormals[i->positionIndices[j + 0]]);
-						vertexNormals[i->positionIndices[j + 1]] = normalize(groupNormals[i->positionIndices[j + 1]]);
-						vertexNormals[i->positionIndices[j + 2]] = normalize(groupNormals[i->positionIndices[j + 2]]);
-					}
-
-					for (unsigned int j = 0; j < i->positionIndices.size() - 2; j += 3)
-					{
-						groupNormals[i->positionIndices[j + 0]] = vec3(0.0f);
-						groupNormals[i->positionIndices[j + 1]] = vec3(0.0f);
-						groupNormals[i->positionIndices[j + 2]] = vec3(0.0f);
-					}
-
-					i->normalIndices = i->positionIndices;
-				}
-			}
-
-			normals.swap(vertexNormals);
+			const auto & v = m_vertices[i];
+			m_minimumBounds = min(m_minimumBounds, v.position);
+			m_maximumBounds = max(m_maximumBounds, v.position);
 		}
 
-		m_vertices.resize(positions.size());
-
-		for (std::list<ObjGroup>::iterator i = groupList.begin(); i != groupList.end(); i++)
+		if (!options.compactVertices)
 		{
-			if (i->positionIndices.size() > 0)
-			{
-				Group newGroup;
-
-				//Assignment3
-				glm::vec3 minVertex, maxVertex;
-				bool firstTime = true;
-
-				newGroup.name = i->name;
-				newGroup.startIndex = m_indices.size();
-
-				std::unordered_map<std::string, int>::iterator j = materialMap.find(i->material);
-
-				if (j != materialMap.end())
-					newGroup.materialIndex = j->second;
-				else
-					newGroup.materialIndex = 0;
-
-				for (unsigned int j = 0; j < i->positionIndices.size(); j++)
-				{
-					const uint index = i->positionIndices[j];
-
-					Vertex vertex;
-					vertex.position = positions[index];
-
-					//OBTAINING THE MAX AND MIN
-					if (firstTime)
-					{
-						minVertex = maxVertex = vertex.position;
-						firstTime = false;
-
-					}
-					else
-					{
-						minVertex = min(minVertex, vertex.position);
-						maxVertex = max(maxVertex, vertex.position);
-					}
-					vertex.normal = normals[i->normalIndices[j]];
-					vertex.texcoord = texCoords[i->texCoordIndices[j]];
-
-					if (m_vertices[index].position == vertex.position)
-					{
-						if (m_vertices[index].texcoord != vertex.texcoord || m_vertices[index].normal != vertex.normal)
-						{
-							m_indices.push_back(m_vertices.size());
-							m_vertices.push_back(vertex);
-						}
-						else
-						{
-							m_vertices[index] = vertex;
-							m_indices.push_back(index);
-						}
-					}
-					else
-					{
-						m_vertices[index] = vertex;
-						m_indices.push_back(index);
-					}
-				}
-
-				newGroup.endIndex = m_indices.size();
-
-				//IMPLEMENTING THE CENTRE
-
-				newGroup.centre_group = (minVertex + maxVertex) * 0.5f;
-
-				m_groups.push_back(newGroup);
-			}
+			LoadStatistics::Scope uploadScope(&m_loadStatistics, "vertex upload");
+			uploadScope.add(m_vertices.size() * sizeof(Vertex), m_vertices.size());
+			m_vertexBuffer->setStorage(m_vertices, gl::GL_NONE_BIT);
 		}
 
-		m_materials.reserve(materials.size());
-		
+		auto loadEnd = std::chrono::steady_clock::now();
+		globjects::debug() << "Loaded from source in " << std::chrono::duration<double>(loadEnd - loadStart).count() << " s (cold)";
 
-		for (auto & m : materials)
+		if (options.meshCache)
 		{
-			Material newMaterial;
-			newMaterial.ambient = m.Ka;
-			newMaterial.diffuse = m.Kd;
-			newMaterial.specular = m.Ks;
-			newMaterial.shininess = m.Ns;
-
-			if (!m.map_Ka.empty())
-			{
-				std::filesystem::path texturePath = m.map_Ka;
-
-				if (!texturePath.is_absolute())
-				{
-					texturePath = path.parent_path();
-					texturePath.append(m.map_Ka);
-				}
-
-				newMaterial.ambientTexture = std::move(loadTexture(texturePath.string()));
-			}
-
-			if (!m.map_Kd.empty())
-			{
-				std::filesystem::path texturePath = m.map_Kd;
-
-				if (!texturePath.is_absolute())
-				{
-					texturePath = path.parent_path();
-					texturePath.append(m.map_Kd);
-				}
-
-				newMaterial.diffuseTexture = std::move(loadTexture(texturePath.string()));
-			}
-
-			if (!m.map_Ks.empty())
-			{
-				std::filesystem::path texturePath = m.map_Ks;
-
-				if (!texturePath.is_absolute())
-				{
-					texturePath = path.parent_path();
-					texturePath.append(m.map_Ks);
-				}
-
-				newMaterial.specularTexture = std::move(loadTexture(texturePath.string()));
-			}
-
-			if (!m.map_Ns.empty())
-			{
-				std::filesystem::path texturePath = m.map_Ns;
-
-				if (!texturePath.is_absolute())
-				{
-					texturePath = path.parent_path();
-					texturePath.append(m.map_Ns);
-				}
-
-				newMaterial.shininessTexture = std::move(loadTexture(texturePath.string()));
-			}
-
-			if (!m.map_bump.empty())
-			{
-				std::filesystem::path texturePath = m.map_bump;
-
-				if (!texturePath.is_absolute())
-				{
-					texturePath = path.parent_path();
-					texturePath.append(m.map_bump);
-				}
-
-				newMaterial.bumpTexture = std::move(loadTexture(texturePath.string()));
-			}
-
-			if (!m.map_objectSpaceNormals.empty())
-			{
-				std::filesystem::path texturePath = m.map_objectSpaceNormals;
-
-				if (!texturePath.is_absolute())
-				{
-					texturePath = path.parent_path();
-					texturePath.append(m.map_objectSpaceNormals);
-				}
-
-				newMaterial.objectSpaceNormalTexture = std::move(loadTexture(texturePath.string()));
-			}
-
-			if (!m.map_tangentSpaceNormals.empty())
-			{
-				std::filesystem::path texturePath = m.map_tangentSpaceNormals;
-
-				if (!texturePath.is_absolute())
-				{
-					texturePath = path.parent_path();
-					texturePath.append(m.map_tangentSpaceNormals);
-				}
-
-				newMaterial.tangentSpaceNormalTexture = std::move(loadTexture(texturePath.string()));
-			}
-
-			m_materials.push_back(newMaterial);
+			LoadStatistics::Scope cacheWriteScope(&m_loadStatistics, "mesh cache write");
 
+			if (cache.write(loader, m_minimumBounds, m_maximumBounds))
+				cacheWriteScope.add(m_vertices.size() * sizeof(Vertex) + m_indices.size() * sizeof(uint), m_indices.size() / 3);
+			else
+				globjects::debug() << "Could not write mesh cache " << cache.cacheFilename();
 		}
-
-		return true;
 	}
-
-	bool loadMtlFile(const std::string & filename, std::vector<ObjMaterial> & materials, std::unordered_map< std::string, int > & materialMap)
+	else
 	{
-		std::ifstream is(filename);
-
-		if (!is.is_open())
-			return false;
-
-		std::string buffer;
-		int currentMaterialIndex = 0;
-
-		while (is.good())
-		{
-			if (getline(is, buffer))
-			{
-				std::istringstream iss(buffer);
-				std::string token;
-
-				if (iss >> token)
-				{
-					if (token == "newmtl")
-					{
-						std::string materialName;
-
-						if (getline(iss, materialName))
-						{
-							materialName = trim(materialName);
-
-							auto i = materialMap.find(materialName);
-
-							if (i == materialMap.end())
-							{
-								ObjMaterial newMaterial;
-								newMaterial.name = materialName;
-								currentMaterialIndex = materials.size();
-								materialMap.insert(std::make_pair(newMaterial.name, currentMaterialIndex));
-								materials.push_back(newMaterial);
-							}
-							else
-							{
-								currentMaterialIndex = i->second;
-							}
-						}
-					}
-					// Ambient Color
-					else if (token == "Ka")
-					{
-						vec3 Ka(0.0f);
-						if (iss >> Ka.x >> Ka.y >> Ka.z)
-							materials[currentMaterialIndex].Ka = Ka;
-					}
-					// Diffuse Color
-					else if (token == "Kd")
-					{
-						vec3 Kd(0.0f);
-						if (iss >> Kd.x >> Kd.y >> Kd.z)
-							materials[currentMaterialIndex].Kd = Kd;
-					}
-					// Specular Color
-					else if (token == "Ks")
-					{
-						vec3 Ks(0.0f);
-						if (iss >> Ks.x >> Ks.y >> Ks.z)
-							materials[currentMaterialIndex].Ks = Ks;
-					}
-					// Specular Exponent
-					else if (token == "Ns")
-					{
-						float Ns = 0.0f;
-						if (iss >> Ns)
-							materials[currentMaterialIndex].Ns = Ns;
-					}
-					// Dissolve
-					else if (token == "d")
-					{
-						float d = 0.0f;
-						if (iss >> d)
-							materials[currentMaterialIndex].d = d;
-					}
-					// Illumination
-					else if (token == "illum")
-					{
-						int illum = 0;
-						if (iss >> illum)
-							materials[currentMaterialIndex].illum = illum;
-					}
-					// Ambient Texture Map
-					else if (token == "map_Ka")
-					{
-						std::string map_Ka;
-						if (getline(iss, map_Ka))
-						{
-							map_Ka = trim(map_Ka);
-							materials[currentMaterialIndex].map_Ka = map_Ka;
-						}
-					}
-					// Diffuse Texture Map
-					else if (token == "map_Kd")
-					{
-						std::string map_Kd;
-						if (getline(iss, map_Kd))
-						{
-							map_Kd = trim(map_Kd);
-							materials[currentMaterialIndex].map_Kd = map_Kd;
-						}
-					}
-					// Specular Texture Map
-					else if (token == "map_Ks")
-					{
-						std::string map_Ks;
-						if (getline(iss, map_Ks))
-						{
-							map_Ks = trim(map_Ks);
-							materials[currentMaterialIndex].map_Ks = map_Ks;
-						}
-					}
-					// Specular Hightlight Map
-					else if (token == "map_Ns")
-					{
-						std::string map_Ns;
-						if (getline(iss, map_Ns))
-						{
-							map_Ns = trim(map_Ns);
-							materials[currentMaterialIndex].map_Ns = map_Ns;
-						}
-					}
-					// Alpha Texture Map
-					else if (token == "map_d")
-					{
-						std::string map_d;
-						if (getline(iss, map_d))
-						{
-							map_d = trim(map_d);
-							materials[currentMaterialIndex].map_d = map_d;
-						}
-					}
-					// Bump Map
-					else if (token == "map_bump" || buffer == "map_Bump" || buffer == "bump")
-					{
-						std::string map_bump;
-						if (getline(iss, map_bump))
-						{
-							map_bump = trim(map_bump);
-							materials[currentMaterialIndex].map_bump = map_bump;
-						}
-					}
-					// Object Space Normal Map
-					else if (token == "map_ObjectNormals")
-					{
-						std::string map_objectSpaceNormals;
-						if (getline(iss, map_objectSpaceNormals))
-						{
-							map_objectSpaceNormals = trim(map_objectSpaceNormals);
-							materials[currentMaterialIndex].map_objectSpaceNormals = map_objectSpaceNormals;
-						}
-					}
-					// Tangent Space Normal Map
-					else if (token == "map_TangentNormals")
-					{
-						std::string map_tangentSpaceNormals;
-						if (getline(iss, map_tangentSpaceNormals))
-						{
-							map_tangentSpaceNormals = trim(map_tangentSpaceNormals);
-							materials[currentMaterialIndex].map_tangentSpaceNormals = map_tangentSpaceNormals;
-						}
-					}
-				}
-			}
-		}
-
-		return true;
+		globjects::debug() << "Error loading << " << filename << "!";
+		return;
 	}
 
-	std::unique_ptr<Texture> loadTexture(const std::string & filename)
-	{
-		int width, height, channels;
+	//IMPLEMENTING THE OFFSET
 
-		stbi_set_flip_vertically_on_load(true);
-		unsigned char *data = stbi_load(filename.c_str(), &width, &height, &channels, 0);
+	m_centre = (m_minimumBounds + m_maximumBounds) * 0.5f;
 
-		if (data)
-		{
-			std::cout << "Loaded " << filename << std::endl;
-
-			auto texture = Texture::create(GL_TEXTURE_2D);
-			texture->setParameter(GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-			texture->setParameter(GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-			texture->setParameter(GL_TEXTURE_WRAP_S, GL_REPEAT);
-			texture->setParameter(GL_TEXTURE_WRAP_T, GL_REPEAT);
-
-			GLenum format = GL_RGBA;
+	// a group centred on the model, e.g. the only one, stays in place instead of getting a NaN direction
+	for (auto &g : m_groups)
+	{
+		const vec3 direction = g.centre_group - m_centre;
+		g.offsetVector = length(direction) > 0.0f ? normalize(direction) : vec3(0.0f);
+	}
 
-			switch (channels)
-			{
-			case 1:
-				format = GL_RED;
-				break;
+	globjects::debug() << "Minimum bounds: " << m_minimumBounds;
+	globjects::debug() << "Maximum bounds: " << m_maximumBounds;
 
-			case 2:
-				format = GL_RG;
-				break;
+	// the bounds are only known now, and the shaders dequantize the positions with them
+	if (m_compactVertices && !m_outOfCore)
+	{
+		LoadStatistics::Scope uploadScope(&m_loadStatistics, "vertex upload");
+		uploadScope.add(m_vertices.size() * sizeof(CompactVertex), m_vertices.size());
+		m_vertexBuffer->setStorage(VertexQuantizer::quantize(m_vertices, m_minimumBounds, m_maximumBounds), gl::GL_NONE_BIT);
+	}
 
-			case 3:
-				format = GL_RGB;
-				break;
+	const double megabyte = 1024.0 * 1024.0;
+	const double vertexMegabytes = double(m_vertices.size() * vertexSize()) / megabyte;
 
-			case 4:
-				format = GL_RGBA;
-				break;
-			}
-				
-			texture->image2D(0, format, ivec2(width,height), 0, format, GL_UNSIGNED_BYTE, data);
-			texture->generateMipmap();
+	if (m_outOfCore)
+		globjects::debug() << "Vertex buffer: " << double(m_vertexBuffer->getParameter(GL_BUFFER_SIZE)) / megabyte << " MB" << (m_compactVertices ? " compact" : "");
+	else if (m_compactVertices)
+		globjects::debug() << "Vertex buffer: " << vertexMegabytes << " MB compact, " << double(m_vertices.size() * (sizeof(Vertex) - sizeof(CompactVertex))) / megabyte << " MB saved";
+	else
+		globjects::debug() << "Vertex buffer: " << vertexMegabytes << " MB";
 
-			stbi_image_free(data);
+	// groups drawing from fewer than 65536 consecutive vertices use 16-bit indices with a base vertex,
+	// out of core the indices were already uploaded as they are
+	if (!m_outOfCore)
+	{
+		LoadStatistics::Scope uploadScope(&m_loadStatistics, "index upload");
 
-			return texture;
-		}
+		const std::vector<std::uint8_t> indexData = IndexPacker::pack(m_indices, m_groups);
+		m_indexBuffer->setStorage(indexData, gl::GL_NONE_BIT);
+		uploadScope.add(indexData.size(), m_indices.size());
 
-		return std::unique_ptr<Texture>();
+		const std::size_t shortGroups = std::count_if(m_groups.begin(), m_groups.end(), [](const Group & g) { return g.shortIndices; });
+		globjects::debug() << "Index buffer: " << double(indexData.size()) / megabyte << " MB, " << double(m_indices.size() * sizeof(uint) - std::min(m_indices.size() * sizeof(uint), indexData.size())) / megabyte << " MB saved, "
+			<< shortGroups << " of " << m_groups.size() << " groups with 16-bit indices";
 	}
 
-	const std::vector<Group> & groups() const
 	{
-		return m_groups;
-	}
+		LoadStatistics::Scope meshletScope(&m_loadStatistics, "meshlets");
 
-	const std::vector<Vertex> & vertices() const
-	{
-		return m_vertices;
+		m_meshlets = MeshletBuilder::build(m_vertices, m_indices, m_groups);
+		m_meshletCuller = std::make_unique<MeshletCuller>(m_meshlets, m_groups, options.threadCount);
+		globjects::debug() << "Split " << m_groups.size() << " groups into " << m_meshlets.size() << " meshlets";
+
+		meshletScope.add(m_meshlets.size() * sizeof(Meshlet), m_meshlets.size());
 	}
 
-	const std::vector<uint> & indices() const
+	m_groupCuller = std::make_unique<GroupCuller>(m_groups, options.threadCount);
+	m_indirectDraws = std::make_unique<IndirectDrawBuffer>(m_groups, m_materials);
+	m_occlusionCuller = std::make_unique<OcclusionCuller>(m_meshlets, m_groups, *m_indirectDraws);
+	m_occlusionQueries = std::make_unique<OcclusionQueries>(m_groups);
+
+	auto vertexBindingPosition = m_vertexArray->binding(0);
+	vertexBindingPosition->setAttribute(0);
+	auto vertexBindingNormal = m_vertexArray->binding(1);
+	vertexBindingNormal->setAttribute(1);
+	auto vertexBindingTexCoord = m_vertexArray->binding(2);
+	vertexBindingTexCoord->setAttribute(2);
+	auto vertexBindingTangent = m_vertexArray->binding(3);
+	vertexBindingTangent->setAttribute(3);
+
+	if (m_compactVertices)
 	{
-		return m_indices;
+		vertexBindingPosition->setBuffer(m_vertexBuffer.get(), offsetof(CompactVertex, position), sizeof(CompactVertex));
+		vertexBindingPosition->setFormat(4, GL_UNSIGNED_SHORT, GL_TRUE);
+		vertexBindingNormal->setBuffer(m_vertexBuffer.get(), offsetof(CompactVertex, normal), sizeof(CompactVertex));
+		vertexBindingNormal->setFormat(2, GL_SHORT, GL_TRUE);
+		vertexBindingTexCoord->setBuffer(m_vertexBuffer.get(), offsetof(CompactVertex, texcoord), sizeof(CompactVertex));
+		vertexBindingTexCoord->setFormat(2, GL_HALF_FLOAT);
+		vertexBindingTangent->setBuffer(m_vertexBuffer.get(), offsetof(CompactVertex, tangent), sizeof(CompactVertex));
+		vertexBindingTangent->setFormat(2, GL_SHORT, GL_TRUE);
 	}
-
-	const std::vector<Material> & materials() const
+	else
 	{
-		return m_materials;
+		vertexBindingPosition->setBuffer(m_vertexBuffer.get(), 0, sizeof(Vertex));
+		vertexBindingPosition->setFormat(3, GL_FLOAT);
+		vertexBindingNormal->setBuffer(m_vertexBuffer.get(), sizeof(vec3), sizeof(Vertex));
+		vertexBindingNormal->setFormat(3, GL_FLOAT);
+		vertexBindingTexCoord->setBuffer(m_vertexBuffer.get(), sizeof(vec3) + sizeof(vec3), sizeof(Vertex));
+		vertexBindingTexCoord->setFormat(2, GL_FLOAT);
+		vertexBindingTangent->setBuffer(m_vertexBuffer.get(), sizeof(vec3) + sizeof(vec3) + sizeof(vec2), sizeof(Vertex));
+		vertexBindingTangent->setFormat(4, GL_FLOAT);
 	}
 
-private:
+	m_vertexArray->enable(0);
+	m_vertexArray->enable(1);
+	m_vertexArray->enable(2);
+	m_vertexArray->enable(3);
 
-	std::vector < Group > m_groups;
-	std::vector < Vertex > m_vertices;
-	std::vector < glm::uint > m_indices;
-	std::vector < Material > m_materials;
+	// the indirect draws find their group through the instance, the other draws only use its first entry
+	auto vertexBindingDrawIndex = m_vertexArray->binding(4);
+	vertexBindingDrawIndex->setAttribute(4);
+	vertexBindingDrawIndex->setBuffer(&m_indirectDraws->drawIndexBuffer(), 0, sizeof(uint));
+	vertexBindingDrawIndex->setIFormat(1, GL_UNSIGNED_INT);
+	vertexBindingDrawIndex->setDivisor(1);
+	m_vertexArray->enable(4);
 
-};
+	m_vertexArray->bindElementBuffer(m_indexBuffer.get());
 
-Model::Model()
-{
+	loadScope.end();
+	globjects::debug() << "Load phases:\n" << m_loadStatistics.table();
 
+	if (!options.statisticsFilename.empty() && !m_loadStatistics.write(options.statisticsFilename))
+		globjects::debug() << "Could not write load statistics " << options.statisticsFilename;
 }
 
-Model::Model(const std::string& filename)
+bool Model::loadOutOfCore(const std::string & filename, const LoadOptions & options)
 {
-	load(filename);
-}
+	OutOfCoreLoader loader(options, m_textureLoader.get(), &m_loadStatistics);
 
-void Model::load(const std::string& filename)
-{
-	globjects::debug() << "Loading file " << filename << " ...";
+	if (!loader.load(filename))
+		return false;
 
-	m_minimumBounds = vec3(std::numeric_limits<float>::max());
-	m_maximumBounds = vec3(-std::numeric_limits<float>::max());
+	m_filename = filename;
+	m_vertices.clear();
+	m_indices.clear();
+	m_groups = loader.groups();
+	m_materials = loader.materials();
+	m_minimumBounds = loader.minimumBounds();
+	m_maximumBounds = loader.maximumBounds();
+
+	// the buffers are filled a chunk at a time from the mapped files, so that no copy of all of the geometry is made
+	const std::size_t chunkVertices = std::max(loader.uploadChunkSize() / sizeof(Vertex), std::size_t(1));
+	const std::size_t chunkIndices = std::max(loader.uploadChunkSize() / sizeof(uint), std::size_t(1));
 
-	ObjLoader loader;
+	LoadStatistics::Scope vertexScope(&m_loadStatistics, "vertex upload");
+	vertexScope.add(loader.vertexCount() * vertexSize(), loader.vertexCount());
 
-	if (loader.loadObjFile(filename))
+	m_vertexBuffer->setStorage(GLsizeiptr(loader.vertexCount() * vertexSize()), nullptr, gl::GL_DYNAMIC_STORAGE_BIT);
+
+	for (std::size_t first = 0; first < loader.vertexCount(); first += chunkVertices)
 	{
-		m_filename = filename;
-		m_vertices = loader.vertices();
-		m_indices = loader.indices();
-		m_materials = loader.materials();
-		m_groups = loader.groups();
+		const std::size_t count = std::min(chunkVertices, loader.vertexCount() - first);
 
-		for (auto i : m_indices)
+		if (m_compactVertices)
 		{
-			const auto & v = m_vertices[i];
-			m_minimumBounds = min(m_minimumBounds, v.position);
-			m_maximumBounds = max(m_maximumBounds, v.position);
+			const std::vector<Vertex> chunk(loader.vertexData() + first, loader.vertexData() + first + count);
+			const std::vector<CompactVertex> compact = VertexQuantizer::quantize(chunk, m_minimumBounds, m_maximumBounds);
+			m_vertexBuffer->setSubData(GLintptr(first * sizeof(CompactVertex)), GLsizeiptr(count * sizeof(CompactVertex)), compact.data());
 		}
-
-		//IMPLEMENTING THE OFFSET
-
-		m_centre = (m_minimumBounds + m_maximumBounds) * 0.5f;
-
-		for (auto &g : m_groups)
+		else
 		{
-			g.offsetVector = normalize(g.centre_group - m_centre);			
+			m_vertexBuffer->setSubData(GLintptr(first * sizeof(Vertex)), GLsizeiptr(count * sizeof(Vertex)), loader.vertexData() + first);
 		}
+	}
 
-		globjects::debug() << "Minimum bounds: " << m_minimumBounds;
-		globjects::debug() << "Maximum bounds: " << m_maximumBounds;
-
-		m_vertexBuffer->setStorage(m_vertices, gl::GL_NONE_BIT);
-		m_indexBuffer->setStorage(m_indices, gl::GL_NONE_BIT);
-
-		auto vertexBindingPosition = m_vertexArray->binding(0);
-		vertexBindingPosition->setAttribute(0);
-		vertexBindingPosition->setBuffer(m_vertexBuffer.get(), 0, sizeof(Vertex));
-		vertexBindingPosition->setFormat(3, GL_FLOAT);
-		m_vertexArray->enable(0);
-
-		auto vertexBindingNormal = m_vertexArray->binding(1);
-		vertexBindingNormal->setAttribute(1);
-		vertexBindingNormal->setBuffer(m_vertexBuffer.get(), sizeof(vec3), sizeof(Vertex));
-		vertexBindingNormal->setFormat(3, GL_FLOAT);
-		m_vertexArray->enable(1);
+	vertexScope.end();
 
-		auto vertexBindingTexCoord = m_vertexArray->binding(2);
-		vertexBindingTexCoord->setAttribute(2);
-		vertexBindingTexCoord->setBuffer(m_vertexBuffer.get(), sizeof(vec3) + sizeof(vec3), sizeof(Vertex));
-		vertexBindingTexCoord->setFormat(2, GL_FLOAT);
-		m_vertexArray->enable(2);
+	LoadStatistics::Scope indexScope(&m_loadStatistics, "index upload");
+	indexScope.add(loader.indexCount() * sizeof(uint), loader.indexCount());
 
-		m_vertexArray->bindElementBuffer(m_indexBuffer.get());
+	m_indexBuffer->setStorage(GLsizeiptr(loader.indexCount() * sizeof(uint)), nullptr, gl::GL_DYNAMIC_STORAGE_BIT);
 
-	}
-	else
+	for (std::size_t first = 0; first < loader.indexCount(); first += chunkIndices)
 	{
-		globjects::debug() << "Error loading << " << filename << "!";
+		const std::size_t count = std::min(chunkIndices, loader.indexCount() - first);
+		m_indexBuffer->setSubData(GLintptr(first * sizeof(uint)), GLsizeiptr(count * sizeof(uint)), loader.indexData() + first);
 	}
+
+	return true;
 }
 
 const std::string & Model::filename() const
@@ -1073,6 +367,55 @@ const std::vector<Material> & Model::materials() const
 	return m_materials;
 }
 
+const std::vector<Meshlet> & Model::meshlets() const
+{
+	return m_meshlets;
+}
+
+MeshletCuller & Model::meshletCuller()
+{
+	return *m_meshletCuller.get();
+}
+
+GroupCuller & Model::groupCuller()
+{
+	return *m_groupCuller.get();
+}
+
+IndirectDrawBuffer & Model::indirectDraws()
+{
+	return *m_indirectDraws.get();
+}
+
+OcclusionCuller & Model::occlusionCuller()
+{
+	return *m_occlusionCuller.get();
+}
+
+OcclusionQueries & Model::occlusionQueries()
+{
+	return *m_occlusionQueries.get();
+}
+
+const LoadStatistics & Model::loadStatistics() const
+{
+	return m_loadStatistics;
+}
+
+void Model::updateTextures()
+{
+	if (m_textureLoader)
+	{
+		m_textureLoader->update();
+		m_textureLoader->replaceDuplicates(m_materials);
+	}
+}
+
+std::size_t Model::pendingTextureCount() const
+{
+	return m_textureLoader ? m_textureLoader->pendingCount() : 0;
+}
+
 vec3 Model::minimumBounds() const
 {
 	return m_minimumBounds;
@@ -1083,6 +426,21 @@ vec3 Model::maximumBounds() const
 	return m_maximumBounds;
 }
 
+bool Model::compactVertices() const
+{
+	return m_compactVertices;
+}
+
+bool Model::outOfCore() const
+{
+	return m_outOfCore;
+}
+
+std::size_t Model::vertexSize() const
+{
+	return m_compactVertices ? sizeof(CompactVertex) : sizeof(Vertex);
+}
+
 VertexArray & Model::vertexArray()
 {
 	return *m_vertexArray.get();
@@ -1,6 +1,9 @@
 #pragma once
 
+#include "LoadStatistics.h"
+
 #include <glm/glm.hpp>
+#include <glm/gtc/type_precision.hpp>
 #include <glbinding/gl/gl.h>
 #include <glbinding/gl/enum.h>
 #include <glbinding/gl/functions.h>
@@ -10,32 +13,109 @@
 #include <globjects/Buffer.h>
 
 #include <vector>
+#include <string>
+#include <memory>
+#include <cstdint>
 
 namespace minity
 {
+	class TextureLoader;
+	class MeshletCuller;
+	class GroupCuller;
+	class IndirectDrawBuffer;
+	class OcclusionCuller;
+	class OcclusionQueries;
+
 	struct Vertex
 	{
 		glm::vec3 position;
 		glm::vec3 normal;
 		glm::vec2 texcoord;
+		// xyz is the tangent, w the handedness of the bitangent, which is cross(normal, tangent) * w
+		glm::vec4 tangent = glm::vec4(1.0f, 0.0f, 0.0f, 1.0f);
 	};
 
-	struct Group
+	// the vertex layout uploaded with LoadOptions::compactVertices, 20 instead of 48 bytes
+	struct CompactVertex
+	{
+		// unsigned normalized within the bounds of the model, w is 0 for a negative handedness of the bitangent and 1 otherwise
+		glm::u16vec4 position = glm::u16vec4(0);
+		// octahedral encodings, signed normalized
+		glm::i16vec2 normal = glm::i16vec2(0);
+		glm::i16vec2 tangent = glm::i16vec2(0);
+		// half floats
+		glm::u16vec2 texcoord = glm::u16vec2(0);
+	};
+
+	// a range of the index buffer
+	struct IndexRange
 	{
-		std::string name;
-		glm::uint materialIndex = 0;
 		glm::uint startIndex = 0;
 		glm::uint endIndex = 0;
 
-		glm::vec3 centre_group = glm::vec3(0.0f);
-		glm::vec3 offsetVector = glm::vec3(0.0f);
+		// the layout in the index buffer set by IndexPacker, the indices are relative to baseVertex and start indexOffset bytes into the buffer
+		glm::uint baseVertex = 0;
+		bool shortIndices = false;
+		std::size_t indexOffset = 0;
 
-		
 		glm::uint count() const
 		{
-			return endIndex - startIndex + 1;
+			return endIndex - startIndex;
 		}
 
+		std::size_t indexSize() const
+		{
+			return shortIndices ? sizeof(std::uint16_t) : sizeof(glm::uint);
+		}
+
+		gl::GLenum indexType() const
+		{
+			return shortIndices ? gl::GL_UNSIGNED_SHORT : gl::GL_UNSIGNED_INT;
+		}
+	};
+
+	// a simplified version of a group, its indices follow those of all groups in the index buffer
+	struct LevelOfDetail : IndexRange
+	{
+		// largest distance of the simplified surface from the original one in model units
+		float error = 0.0f;
+	};
+
+	struct Group : IndexRange
+	{
+		std::string name;
+		glm::uint materialIndex = 0;
+
+		glm::vec3 centre_group = glm::vec3(0.0f);
+		// radius of the sphere around the bounding box of the group
+		float radius_group = 0.0f;
+		// bounding box of the group before it is moved by the explosion
+		glm::vec3 minimum_group = glm::vec3(0.0f);
+		glm::vec3 maximum_group = glm::vec3(0.0f);
+		glm::vec3 offsetVector = glm::vec3(0.0f);
+
+		// the meshlets of the group set by MeshletBuilder, consecutive in Model::meshlets()
+		glm::uint firstMeshlet = 0;
+		glm::uint meshletCount = 0;
+
+		// increasingly coarse, the group itself is level zero
+		std::vector<LevelOfDetail> levelsOfDetail;
+	};
+
+	// a run of consecutive triangles of a group with bounds for culling
+	struct Meshlet
+	{
+		// relative to the first index of the group
+		glm::uint firstIndex = 0;
+		glm::uint indexCount = 0;
+		glm::uint vertexCount = 0;
+
+		glm::vec3 center = glm::vec3(0.0f);
+		float radius = 0.0f;
+
+		// all triangles face away from viewers at positions p with dot(center - p, coneAxis) >= coneCutoff * length(center - p) + radius
+		glm::vec3 coneAxis = glm::vec3(0.0f, 0.0f, 1.0f);
+		float coneCutoff = 1.0f;
 	};
 
 	struct Material
@@ -56,42 +136,142 @@ namespace minity
 		std::shared_ptr<globjects::Texture> tangentSpaceNormalTexture;
 	};
 
+	struct LoadOptions
+	{
+		enum class Parser
+		{
+			// line by line using iostreams
+			Stream,
+			// tokenizes a memory mapping of the file in place
+			Mapped,
+			// like Mapped, but parses chunks of the file on multiple threads
+			Parallel
+		};
+
+		enum class NormalWeighting
+		{
+			// every face counts the same
+			Uniform,
+			// faces count with their area
+			Area,
+			// faces count with the angle of the corner at the vertex
+			Angle
+		};
+
+		Parser parser = Parser::Parallel;
+
+		// number of threads used by the parallel parser and the normal generation, zero uses all hardware threads
+		unsigned int threadCount = 0;
+
+		// weighting of the faces around a vertex for models without normals
+		NormalWeighting normalWeighting = NormalWeighting::Uniform;
+		// faces meeting at a larger angle in degrees are not smoothed together, 180 smooths all faces of a group
+		float creaseAngle = 180.0f;
+
+		// shares one vertex between all corners with the same position, normal and texture coordinate indices
+		bool weldVertices = true;
+		// reorders the triangles of every group for the vertex cache and overdraw and the vertices for fetching
+		bool optimizeMesh = true;
+		// simplifies every group into a chain of coarser levels of detail, which are stored in the mesh cache as well
+		bool levelsOfDetail = true;
+		// uploads the vertices quantized to CompactVertex, the CPU copy keeps full precision
+		bool compactVertices = false;
+
+		// bytes of memory loading may use, zero for no limit -- models too large for it are loaded out of core through
+		// temporary files next to the cache files, without the mesh cache and the steps which need all of the geometry at once
+		std::size_t memoryLimit = 0;
+
+		// stores the loaded geometry in a binary cache file and uses it instead of parsing if it is up to date
+		bool meshCache = true;
+		// directory for the cache files, empty places them next to the source files
+		std::string cacheDirectory;
+
+		// textures need a current OpenGL context, so benchmarks and tools can skip them
+		bool loadTextures = true;
+		// stores decoded textures with all of their mipmaps in raw cache files next to the images or in the cache directory
+		bool textureCache = true;
+		// decodes images in the background, groups render with placeholder textures until theirs are uploaded
+		bool asyncTextures = true;
+		// encodes textures to the block compressed formats the context supports, BC1 to BC7 depending on the channels and usage
+		bool textureCompression = true;
+
+		// writes the phases of loading with their times, amounts and heap growth as JSON to this file, nothing if empty
+		std::string statisticsFilename;
+	};
+
 	class Model
 	{
 	public:
 		Model();
-		Model(const std::string& filename);
-		void load(const std::string& filename);
+		Model(const std::string& filename, const LoadOptions & options = LoadOptions());
+		~Model();
+		void load(const std::string& filename, const LoadOptions & options = LoadOptions());
 		const std::string & filename() const;
 
 		const std::vector<Group> & groups() const;
 		const std::vector<Vertex> & vertices() const;
 		const std::vector<glm::uint> & indices() const;
 		const std::vector<Material> & materials() const;
+		const std::vector<Meshlet> & meshlets() const;
+		MeshletCuller & meshletCuller();
+		GroupCuller & groupCuller();
+		IndirectDrawBuffer & indirectDraws();
+		OcclusionCuller & occlusionCuller();
+		OcclusionQueries & occlusionQueries();
+
+		// the phases of the last load, which are also logged as a table
+		const LoadStatistics & loadStatistics() const;
+
+		// uploads textures which finished decoding in the background, has to be called with the context current
+		void updateTextures();
+		std::size_t pendingTextureCount() const;
 
 		glm::vec3 minimumBounds() const;
 		glm::vec3 maximumBounds() const;
 
+		// whether the vertex buffer holds CompactVertex instead of Vertex, which is quantized within the bounds
+		bool compactVertices() const;
+		std::size_t vertexSize() const;
+
+		// loaded in bounded memory because of LoadOptions::memoryLimit, the geometry is only in the GPU buffers then,
+		// without CPU copies of the vertices and indices, meshlets or levels of detail
+		bool outOfCore() const;
+
 		globjects::VertexArray & vertexArray();
 		globjects::Buffer & vertexBuffer();
 		globjects::Buffer & indexBuffer();
 
 	private:
 
+		// parses into temporary files and uploads the buffers from them in chunks
+		bool loadOutOfCore(const std::string & filename, const LoadOptions & options);
+
 		std::string m_filename;
 		
 		std::vector < Group > m_groups;
 		std::vector < Vertex > m_vertices;
 		std::vector < glm::uint > m_indices;
 		std::vector < Material > m_materials;
+		std::vector < Meshlet > m_meshlets;
 
 		glm::vec3 m_minimumBounds = glm::vec3(0.0);
 		glm::vec3 m_maximumBounds = glm::vec3(0.0);
 		glm::vec3 m_centre = glm::vec3(0.0);
+		bool m_compactVertices = false;
+		bool m_outOfCore = false;
 
 		std::unique_ptr<globjects::VertexArray> m_vertexArray = std::make_unique<globjects::VertexArray>();
 		std::unique_ptr<globjects::Buffer> m_vertexBuffer = std::make_unique<globjects::Buffer>();
 		std::unique_ptr< globjects::Buffer > m_indexBuffer = std::make_unique<globjects::Buffer>();
 
+		std::unique_ptr<TextureLoader> m_textureLoader;
+		std::unique_ptr<MeshletCuller> m_meshletCuller;
+		std::unique_ptr<GroupCuller> m_groupCuller;
+		std::unique_ptr<IndirectDrawBuffer> m_indirectDraws;
+		std::unique_ptr<OcclusionCuller> m_occlusionCuller;
+		std::unique_ptr<OcclusionQueries> m_occlusionQueries;
+
+		LoadStatistics m_loadStatistics;
+
 	};
 }
\ No newline at end of file
@@ -1,13 +1,22 @@
 #include "ModelRenderer.h"
 #include <globjects/base/File.h>
 #include <globjects/State.h>
+#include <globjects/globjects.h>
 #include <iostream>
 #include <filesystem>
 #include <imgui.h>
 #include "Viewer.h"
 #include "Scene.h"
 #include "Model.h"
+#include "MeshAnalyzer.h"
+#include "MeshletCuller.h"
+#include "GroupCuller.h"
+#include "IndirectDrawBuffer.h"
+#include "OcclusionCuller.h"
+#include "OcclusionQueries.h"
+#include "MeshSimplifier.h"
 #include <sstream>
+#include <chrono>
 
 #include <glm/gtc/type_ptr.hpp>
 #include <glm/gtc/matrix_transform.hpp>
@@ -29,11 +38,78 @@ ModelRenderer::ModelRenderer(Viewer* viewer) : Renderer(viewer)
 	m_lightArray->enable(0);
 	m_lightArray->unbind();
 
+	// the tangent frames are vertex attributes, so the main pass runs without a geometry shader
 	createShaderProgram("model-base", {
 		{ GL_VERTEX_SHADER,"./res/model/model-base-vs.glsl" },
-		{ GL_GEOMETRY_SHADER,"./res/model/model-base-gs.glsl" },
 		{ GL_FRAGMENT_SHADER,"./res/model/model-base-fs.glsl" },
 		}, 
+		{ "./res/model/model-globals.glsl", "./res/model/model-vertex.glsl", "./res/model/model-shading.glsl" });
+
+	// fetches the vertices itself to know the barycentric coordinates of the corners for the wireframe overlay,
+	// contexts without storage buffers fall back to a geometry shader behind the vertex shader of the main pass
+	m_wireframeFetchSupported = globjects::hasExtension(GLextension::GL_ARB_shader_storage_buffer_object);
+
+	if (m_wireframeFetchSupported)
+	{
+		createShaderProgram("model-wireframe", {
+			{ GL_VERTEX_SHADER,"./res/model/model-wireframe-vs.glsl" },
+			{ GL_FRAGMENT_SHADER,"./res/model/model-base-fs.glsl" },
+			},
+			{ "./res/model/model-globals.glsl", "./res/model/model-shading.glsl" });
+	}
+	else
+	{
+		createShaderProgram("model-wireframe", {
+			{ GL_VERTEX_SHADER,"./res/model/model-base-vs.glsl" },
+			{ GL_GEOMETRY_SHADER,"./res/model/model-wireframe-gs.glsl" },
+			{ GL_FRAGMENT_SHADER,"./res/model/model-base-fs.glsl" },
+			},
+			{ "./res/model/model-globals.glsl", "./res/model/model-vertex.glsl", "./res/model/model-shading.glsl" });
+	}
+
+	// draws the whole model from the indirect buffer, with the textures bound per texture set or through handles
+	m_indirectSupported = IndirectDrawBuffer::supported();
+	m_bindlessSupported = m_indirectSupported && IndirectDrawBuffer::bindlessSupported();
+
+	if (m_indirectSupported)
+	{
+		createShaderProgram("model-indirect", {
+			{ GL_VERTEX_SHADER,"./res/model/model-indirect-vs.glsl" },
+			{ GL_FRAGMENT_SHADER,"./res/model/model-base-fs.glsl" },
+			},
+			{ "./res/model/model-globals.glsl", "./res/model/model-vertex.glsl", "./res/model/model-shading.glsl" });
+	}
+
+	if (m_bindlessSupported)
+	{
+		createShaderProgram("model-bindless", {
+			{ GL_VERTEX_SHADER,"./res/model/model-indirect-vs.glsl" },
+			{ GL_FRAGMENT_SHADER,"./res/model/model-bindless-fs.glsl" },
+			},
+			{ "./res/model/model-globals.glsl", "./res/model/model-vertex.glsl", "./res/model/model-shading.glsl" });
+	}
+
+	// culls the meshlets on the GPU against the frustum and the depth of the previous frame
+	m_gpuCullingSupported = OcclusionCuller::supported();
+
+	if (m_gpuCullingSupported)
+	{
+		createShaderProgram("model-cull", {
+			{ GL_COMPUTE_SHADER,"./res/model/model-cull-cs.glsl" },
+			},
+			{ "./res/model/model-globals.glsl" });
+
+		createShaderProgram("model-pyramid", {
+			{ GL_COMPUTE_SHADER,"./res/model/model-pyramid-cs.glsl" },
+			},
+			{ "./res/model/model-globals.glsl" });
+	}
+
+	// the bounding boxes of the groups for the occlusion queries
+	createShaderProgram("model-proxy", {
+		{ GL_VERTEX_SHADER,"./res/model/model-proxy-vs.glsl" },
+		{ GL_FRAGMENT_SHADER,"./res/model/model-proxy-fs.glsl" },
+		},
 		{ "./res/model/model-globals.glsl" });
 
 	createShaderProgram("model-light", {
@@ -42,6 +118,19 @@ ModelRenderer::ModelRenderer(Viewer* viewer) : Renderer(viewer)
 		}, { "./res/model/model-globals.glsl" });
 }
 
+std::vector<Program*> ModelRenderer::modelPrograms()
+{
+	std::vector<Program*> programs = { shaderProgram("model-base"), shaderProgram("model-wireframe") };
+
+	if (m_indirectSupported)
+		programs.push_back(shaderProgram("model-indirect"));
+
+	if (m_bindlessSupported)
+		programs.push_back(shaderProgram("model-bindless"));
+
+	return programs;
+}
+
 void ModelRenderer::display()
 {
 	// Save OpenGL state
@@ -62,8 +151,6 @@ void ModelRenderer::display()
 	const mat3 inverseNormalMatrix = inverse(normalMatrix);
 	const vec2 viewportSize = viewer()->viewportSize();
 
-	auto shaderProgramModelBase = shaderProgram("model-base");
-
 	glEnable(GL_DEPTH_TEST);
 	glDepthFunc(GL_LESS);
 
@@ -71,11 +158,52 @@ void ModelRenderer::display()
 
 	const std::vector<Group> & groups = viewer()->scene()->model()->groups();
 	const std::vector<Material> & materials = viewer()->scene()->model()->materials();
+	const std::vector<Meshlet> & meshlets = viewer()->scene()->model()->meshlets();
 
 	static std::vector<bool> groupEnabled(groups.size(), true);
 	static bool wireframeEnabled = false;
 	static bool lightSourceEnabled = true;
 	static vec4 wireframeLineColor = vec4(1.0f);
+	static std::unique_ptr<MeshAnalyzer::Report> analysis;
+	static bool groupCulling = true;
+	// sorts the draws by material and merges them, otherwise every group binds its textures on its own
+	static bool batching = true;
+	// one multi-draw for all groups, toggling groups only patches the commands
+	static bool indirectDrawing = false;
+	static bool bindlessTextures = true;
+	// draws the meshlets which the compute pass found inside of the frustum and not hidden behind the depth of the previous frame
+	static bool gpuCulling = false;
+	static bool occlusionCulling = true;
+	// hides groups whose bounding boxes had no samples passing the depth test, with the results of the previous frame
+	// read back by the CPU or with conditional rendering, visible groups are queried again every few frames
+	static int occlusionQueryMode = 0;
+	static int visibleQueryInterval = 4;
+	static float occlusionQueryFrameTimes[3] = { 0.0f, 0.0f, 0.0f };
+	// averaged time spent on the CPU building and submitting the draws, per group and indirect
+	static double submitTimes[2] = { 0.0, 0.0 };
+	static bool frustumCulling = true;
+	// like backface culling, which hides the back of open surfaces
+	static bool coneCulling = true;
+	static bool levelsOfDetail = true;
+	// largest projected error of a level of detail in pixels, higher values trade quality for speed
+	static float levelOfDetailThreshold = 1.0f;
+	static int forcedLevelOfDetail = -1;
+	static std::vector<std::size_t> levelGroups(MeshSimplifier::maxLevels + 1, 0);
+	static std::vector<std::size_t> levelTriangles(MeshSimplifier::maxLevels + 1, 0);
+	static std::vector<float> levelFrameTimes(MeshSimplifier::maxLevels + 1, 0.0f);
+
+	// the frame times are averaged while a level is forced, so that they can be compared between the levels
+	if (levelsOfDetail && forcedLevelOfDetail >= 0)
+	{
+		float & frameTime = levelFrameTimes[forcedLevelOfDetail];
+		const float milliseconds = ImGui::GetIO().DeltaTime * 1000.0f;
+		frameTime = frameTime > 0.0f ? frameTime * 0.95f + milliseconds * 0.05f : milliseconds;
+	}
+
+	// averaged for every mode of the occlusion queries, so that they can be compared with each other
+	float & queryFrameTime = occlusionQueryFrameTimes[occlusionQueryMode];
+	const float frameMilliseconds = ImGui::GetIO().DeltaTime * 1000.0f;
+	queryFrameTime = queryFrameTime > 0.0f ? queryFrameTime * 0.95f + frameMilliseconds * 0.05f : frameMilliseconds;
 
 	if (ImGui::BeginMenu("Model"))
 	{
@@ -101,92 +229,369 @@ void ModelRenderer::display()
 
 		}
 
-		ImGui::EndMenu();
-	}
-
-	vec4 worldCameraPosition = inverseModelViewMatrix * vec4(0.0f, 0.0f, 0.0f, 1.0f);
-	vec4 worldLightPosition = inverseModelLightMatrix * vec4(0.0f, 0.0f, 0.0f, 1.0f);
+		if (ImGui::CollapsingHeader("Batching"))
+		{
+			ImGui::Checkbox("Batching Enabled", &batching);
 
-	shaderProgramModelBase->setUniform("modelViewProjectionMatrix", modelViewProjectionMatrix);
-	shaderProgramModelBase->setUniform("viewportSize", viewportSize);
-	shaderProgramModelBase->setUniform("worldCameraPosition", vec3(worldCameraPosition));
-	shaderProgramModelBase->setUniform("worldLightPosition", vec3(worldLightPosition));
-	shaderProgramModelBase->setUniform("wireframeEnabled", wireframeEnabled);
-	shaderProgramModelBase->setUniform("wireframeLineColor", wireframeLineColor);
+			const RenderQueue::Statistics & statistics = m_renderQueue.statistics();
 
-	shaderProgramModelBase->use();
+			ImGui::Text("Draw Calls: %zu for %zu ranges", statistics.drawCalls, statistics.draws);
+			ImGui::Text("State Changes: %zu (%zu textures, %zu uniforms)", statistics.textureBinds + statistics.uniformChanges, statistics.textureBinds, statistics.uniformChanges);
+			ImGui::Text("Redundant Changes Skipped: %zu", statistics.skippedChanges);
+		}
 
-	for (uint i = 0; i < groups.size(); i++)
-	{
-		if (groupEnabled.at(i))
+		if (ImGui::CollapsingHeader("Indirect Drawing"))
 		{
-			const Material & material = materials.at(groups.at(i).materialIndex);
+			if (m_indirectSupported)
+			{
+				ImGui::Checkbox("Indirect Drawing Enabled", &indirectDrawing);
 
-			shaderProgramModelBase->setUniform("explosionVector", groups.at(i).offsetVector * viewer()->explosion());
+				if (m_bindlessSupported)
+					ImGui::Checkbox("Bindless Textures", &bindlessTextures);
 
-			if (reset_prop) {
-				m_diffuse = material.diffuse;
-				m_specular = material.specular;
-				m_ambient = material.ambient;
-				m_shininess = material.shininess;
-				reset_prop = false;
-			}
+				const IndirectDrawBuffer::Statistics & statistics = viewer()->scene()->model()->indirectDraws().statistics();
 
-			if (material.diffuseTexture)
-			{
-				shaderProgramModelBase->setUniform("diffuseTexture", 0);
-				material.diffuseTexture->bindActive(0);
+				ImGui::Text("Draws: %zu of %zu enabled, %zu draw calls", statistics.enabledDraws, statistics.draws, statistics.drawCalls);
+				ImGui::Text("Patched Commands: %zu (%zu bytes)", statistics.patchedCommands, statistics.patchedBytes);
 			}
-
-			if (material.ambientTexture)
+			else
 			{
-				shaderProgramModelBase->setUniform("ambientTexture", 1);
-				material.ambientTexture->bindActive(1);
+				ImGui::Text("Not supported by the context");
 			}
 
-			if (material.specularTexture)
+			ImGui::Text("Submit Time: %.3f ms per group, %.3f ms indirect", submitTimes[0] * 1000.0, submitTimes[1] * 1000.0);
+		}
+
+		if (ImGui::CollapsingHeader("GPU Culling"))
+		{
+			if (m_gpuCullingSupported && !meshlets.empty())
 			{
-				shaderProgramModelBase->setUniform("specularTexture", 2);
-				material.specularTexture->bindActive(2);
-			}
+				ImGui::Checkbox("GPU Meshlet Culling", &gpuCulling);
+				ImGui::Checkbox("Occlusion Culling", &occlusionCulling);
+
+				const OcclusionCuller::Statistics & statistics = viewer()->scene()->model()->occlusionCuller().statistics();
 
-			if (material.objectSpaceNormalTexture)
+				ImGui::Text("Meshlets: %zu early, %zu late, %zu occluded, %zu outside of %zu", statistics.earlyMeshlets, statistics.lateMeshlets, statistics.occludedMeshlets, statistics.frustumCulledMeshlets, statistics.meshlets);
+				ImGui::Text("Triangles: %zu drawn, %zu occluded (%.1f%%), %zu outside", statistics.earlyTriangles + statistics.lateTriangles, statistics.occludedTriangles,
+					statistics.triangles > 0 ? 100.0 * double(statistics.occludedTriangles) / double(statistics.triangles) : 0.0, statistics.frustumCulledTriangles);
+				ImGui::Text("Draw Calls: %zu", statistics.drawCalls);
+			}
+			else
 			{
-				shaderProgramModelBase->setUniform("objectSpaceNormals", 3);
-				material.objectSpaceNormalTexture->bindActive(3);
+				ImGui::Text("%s", m_gpuCullingSupported ? "The model has no meshlets" : "Not supported by the context");
 			}
+		}
 
-			if (material.tangentSpaceNormalTexture)
+		if (ImGui::CollapsingHeader("Occlusion Queries"))
+		{
+			ImGui::Combo("Query Mode", &occlusionQueryMode, "Disabled\0Previous Frame\0Conditional Rendering\0");
+			ImGui::SliderInt("Visible Group Interval", &visibleQueryInterval, 1, 16);
+
+			const OcclusionQueries::Statistics & statistics = viewer()->scene()->model()->occlusionQueries().statistics();
+
+			if (occlusionQueryMode != 0)
 			{
-				shaderProgramModelBase->setUniform("tangentSpaceNormals", 4);
-				material.tangentSpaceNormalTexture->bindActive(4);
+				ImGui::Text("Hidden Groups: %zu of %zu (%zu triangles)", statistics.hiddenGroups, statistics.groups, statistics.hiddenTriangles);
+				ImGui::Text("Queries: %zu issued, %zu pending, %zu groups at the near plane", statistics.issuedQueries, statistics.pendingQueries, statistics.nearGroups);
+				ImGui::Text("Query Time: %.3f ms", statistics.seconds * 1000.0);
 			}
 
-			viewer()->scene()->model()->vertexArray().drawElements(GL_TRIANGLES, groups.at(i).count(), GL_UNSIGNED_INT, (void*)(sizeof(GLuint)*groups.at(i).startIndex));
+			ImGui::Text("Frame Time: %.2f ms disabled, %.2f ms previous frame, %.2f ms conditional", occlusionQueryFrameTimes[0], occlusionQueryFrameTimes[1], occlusionQueryFrameTimes[2]);
+		}
+
+		if (ImGui::CollapsingHeader("Group Culling"))
+		{
+			ImGui::Checkbox("Group Frustum Culling", &groupCulling);
+
+			const GroupCuller::Statistics & statistics = viewer()->scene()->model()->groupCuller().statistics();
+
+			ImGui::Text("Groups: %zu visible, %zu culled of %zu", statistics.visibleGroups, statistics.culledGroups, statistics.groups);
+			ImGui::Text("Culling Time: %.3f ms", statistics.seconds * 1000.0);
+		}
+
+		if (ImGui::CollapsingHeader("Meshlets"))
+		{
+			ImGui::Checkbox("Frustum Culling", &frustumCulling);
+			ImGui::Checkbox("Cone Culling", &coneCulling);
+
+			const MeshletCuller::Statistics & statistics = viewer()->scene()->model()->meshletCuller().statistics();
+			const std::size_t culledTriangles = statistics.frustumCulledTriangles + statistics.coneCulledTriangles;
 
-			if (material.tangentSpaceNormalTexture)
+			ImGui::Text("Meshlets: %zu of %zu visible", statistics.visibleMeshlets, statistics.meshlets);
+			ImGui::Text("Triangles: %zu of %zu culled (%.1f%%)", culledTriangles, statistics.triangles, statistics.triangles > 0 ? 100.0 * double(culledTriangles) / double(statistics.triangles) : 0.0);
+			ImGui::Text("Frustum: %zu, Cone: %zu", statistics.frustumCulledTriangles, statistics.coneCulledTriangles);
+			ImGui::Text("Culling Time: %.3f ms", statistics.seconds * 1000.0);
+		}
+
+		if (ImGui::CollapsingHeader("Levels of Detail"))
+		{
+			ImGui::Checkbox("Levels of Detail Enabled", &levelsOfDetail);
+			ImGui::SliderFloat("LOD Threshold (pixels)", &levelOfDetailThreshold, 0.25f, 32.0f, "%.2f");
+			ImGui::SliderInt("Forced Level", &forcedLevelOfDetail, -1, int(MeshSimplifier::maxLevels));
+			ImGui::Text("Frame Time: %.2f ms", ImGui::GetIO().DeltaTime * 1000.0f);
+
+			for (std::size_t l = 0; l < levelGroups.size(); l++)
 			{
-				material.tangentSpaceNormalTexture->unbind();
+				if (levelGroups[l] > 0 || levelFrameTimes[l] > 0.0f)
+					ImGui::Text("Level %zu: %zu groups, %zu triangles, %.2f ms", l, levelGroups[l], levelTriangles[l], levelFrameTimes[l]);
 			}
-			if (material.objectSpaceNormalTexture)
+		}
+
+		if (ImGui::CollapsingHeader("Analysis"))
+		{
+			// runs on the CPU copy of the geometry, the report is written next to the model
+			if (ImGui::Button("Analyze Mesh"))
 			{
-				material.objectSpaceNormalTexture->unbind();
+				const Model & model = *viewer()->scene()->model();
+
+				analysis = std::make_unique<MeshAnalyzer::Report>(MeshAnalyzer::analyze(model.vertices(), model.indices(), model.groups()));
+				analysis->filename = model.filename();
+
+				const std::string reportFilename = model.filename() + ".analysis.json";
+
+				if (MeshAnalyzer::write(*analysis, reportFilename))
+					globjects::debug() << "Wrote mesh analysis to " << reportFilename;
+				else
+					globjects::debug() << "Could not write " << reportFilename;
 			}
-			if (material.specularTexture)
+
+			if (analysis)
 			{
-				material.specularTexture->unbind();
+				const MeshAnalyzer::GroupStatistics & total = analysis->total;
+
+				ImGui::Text("Triangles: %zu, Vertices: %zu", total.triangles, total.vertices);
+
+				for (const auto & c : total.caches)
+					ImGui::Text("%s %2u: ACMR %.3f, ATVR %.3f", c.policy == MeshAnalyzer::CachePolicy::FIFO ? "FIFO" : "LRU ", c.size, c.averageCacheMissRatio, c.averageTransformedVertexRatio);
+
+				ImGui::Text("Fetch Overread: %.3f", total.fetchOverread);
+				ImGui::Text("Overdraw: %.3f", total.overdraw);
 			}
-			if (material.ambientTexture)
+		}
+
+		ImGui::EndMenu();
+	}
+
+	vec4 worldCameraPosition = inverseModelViewMatrix * vec4(0.0f, 0.0f, 0.0f, 1.0f);
+	vec4 worldLightPosition = inverseModelLightMatrix * vec4(0.0f, 0.0f, 0.0f, 1.0f);
+
+	const Model & model = *viewer()->scene()->model();
+
+	// the wireframe is always drawn per group, fetching the indices itself if it can, the texture handles are only made once all textures are uploaded,
+	// the culling on the GPU writes indirect commands and needs the meshlets, models loaded out of core have none
+	const bool gpuCulled = gpuCulling && m_gpuCullingSupported && !wireframeEnabled && !meshlets.empty();
+	const bool indirect = (indirectDrawing || gpuCulled) && m_indirectSupported && !wireframeEnabled;
+	const bool bindless = indirect && m_bindlessSupported && bindlessTextures && model.pendingTextureCount() == 0;
+	const bool wireframeFetched = wireframeEnabled && m_wireframeFetchSupported;
+
+	auto shaderProgramModelBase = shaderProgram(wireframeEnabled ? "model-wireframe" : bindless ? "model-bindless" : indirect ? "model-indirect" : "model-base");
+
+	shaderProgramModelBase->setUniform("modelViewProjectionMatrix", modelViewProjectionMatrix);
+	shaderProgramModelBase->setUniform("worldCameraPosition", vec3(worldCameraPosition));
+	shaderProgramModelBase->setUniform("worldLightPosition", vec3(worldLightPosition));
+	shaderProgramModelBase->setUniform("wireframeEnabled", wireframeEnabled);
+	shaderProgramModelBase->setUniform("wireframeLineColor", wireframeLineColor);
+
+	shaderProgramModelBase->setUniform("compactVertices", model.compactVertices());
+	shaderProgramModelBase->setUniform("positionOffset", model.minimumBounds());
+	shaderProgramModelBase->setUniform("positionScale", model.maximumBounds() - model.minimumBounds());
+
+	if (indirect)
+		shaderProgramModelBase->setUniform("explosion", viewer()->explosion());
+
+	shaderProgramModelBase->use();
+
+	if (wireframeFetched)
+	{
+		viewer()->scene()->model()->vertexBuffer().bindBase(GL_SHADER_STORAGE_BUFFER, 0);
+		viewer()->scene()->model()->indexBuffer().bindBase(GL_SHADER_STORAGE_BUFFER, 1);
+	}
+
+	// groups entirely outside of the frustum are skipped as a whole
+	viewer()->scene()->model()->groupCuller().cull(modelViewProjectionMatrix, viewer()->explosion(), groupCulling);
+
+	// the culling on the GPU already tests against the depth, conditional rendering needs a draw per group
+	OcclusionQueries & occlusionQueries = viewer()->scene()->model()->occlusionQueries();
+	const bool occlusionQueried = occlusionQueryMode != 0 && !gpuCulled;
+	const bool conditionalRendering = occlusionQueried && occlusionQueryMode == 2 && !indirect;
+
+	if (occlusionQueried)
+		occlusionQueries.update(groupEnabled, viewer()->scene()->model()->groupCuller().visible(), modelViewProjectionMatrix, viewer()->explosion(), conditionalRendering);
+	else
+		occlusionQueries.reset();
+
+	const std::vector<std::uint8_t> & groupVisible = occlusionQueried ? occlusionQueries.visible() : viewer()->scene()->model()->groupCuller().visible();
+
+	const bool meshletCulling = !indirect && (frustumCulling || coneCulling) && !meshlets.empty();
+
+	if (meshletCulling)
+	{
+		std::vector<vec3> groupOffsets(groups.size());
+
+		for (uint i = 0; i < groups.size(); i++)
+			groupOffsets[i] = groups.at(i).offsetVector * viewer()->explosion();
+
+		viewer()->scene()->model()->meshletCuller().cull(modelViewProjectionMatrix, vec3(worldCameraPosition), groupOffsets, frustumCulling, coneCulling);
+	}
+
+	// pixels per unit of error at unit distance
+	const float pixelScale = viewportSize.y * 0.5f * projectionMatrix[1][1];
+
+	std::fill(levelGroups.begin(), levelGroups.end(), 0);
+	std::fill(levelTriangles.begin(), levelTriangles.end(), 0);
+
+	if (reset_prop && !groups.empty())
+	{
+		const Material & material = materials.at(groups.front().materialIndex);
+		m_diffuse = material.diffuse;
+		m_specular = material.specular;
+		m_ambient = material.ambient;
+		m_shininess = material.shininess;
+		reset_prop = false;
+	}
+
+	// the CPU time of building and submitting the draws, the culling is measured on its own
+	auto submitStart = std::chrono::steady_clock::now();
+
+	// triangles submitted for the benchmark, conditionally rendered groups count even if the GPU skips them
+	std::size_t drawnTriangles = 0;
+
+	if (indirect)
+	{
+		IndirectDrawBuffer & indirectDraws = viewer()->scene()->model()->indirectDraws();
+		indirectDraws.update(groupEnabled, groupVisible);
+
+		if (gpuCulled)
+		{
+			OcclusionCuller & occlusionCuller = viewer()->scene()->model()->occlusionCuller();
+
+			// the early phase draws what was visible in the previous frame, the pyramid built from its depth decides about the rest
+			occlusionCuller.cull(*shaderProgram("model-cull"), OcclusionCuller::Phase::Early, modelViewProjectionMatrix, viewer()->explosion(), occlusionCulling);
+			shaderProgramModelBase->use();
+			occlusionCuller.draw(*shaderProgramModelBase, viewer()->scene()->model()->vertexArray(), materials, bindless, OcclusionCuller::Phase::Early);
+
+			if (occlusionCulling)
 			{
-				material.ambientTexture->unbind();
+				occlusionCuller.buildPyramid(*shaderProgram("model-pyramid"), ivec2(viewportSize), modelViewProjectionMatrix);
+				occlusionCuller.cull(*shaderProgram("model-cull"), OcclusionCuller::Phase::Late, modelViewProjectionMatrix, viewer()->explosion(), occlusionCulling);
+				shaderProgramModelBase->use();
+				occlusionCuller.draw(*shaderProgramModelBase, viewer()->scene()->model()->vertexArray(), materials, bindless, OcclusionCuller::Phase::Late);
 			}
-			if (material.diffuseTexture)
+
+			// only known on the GPU, read back one frame late
+			drawnTriangles = occlusionCuller.statistics().earlyTriangles + occlusionCuller.statistics().lateTriangles;
+		}
+		else
+		{
+			indirectDraws.submit(*shaderProgramModelBase, viewer()->scene()->model()->vertexArray(), materials, bindless);
+		}
+	}
+	else
+	{
+		// index ranges of a group to draw, relative to its first index, neighboring visible meshlets are merged into one draw
+		std::vector<std::pair<GLuint, GLuint>> ranges;
+		m_renderQueue.clear();
+
+		for (uint i = 0; i < groups.size(); i++)
+		{
+			if (groupEnabled.at(i) && groupVisible[i])
 			{
-				material.diffuseTexture->unbind();
-			}			
+				ranges.clear();
+
+				// the coarsest level whose error projected from the closest point of the group bounds stays below the threshold
+				std::size_t level = 0;
+
+				if (levelsOfDetail && forcedLevelOfDetail >= 0)
+				{
+					level = std::min(std::size_t(forcedLevelOfDetail), groups.at(i).levelsOfDetail.size());
+				}
+				else if (levelsOfDetail)
+				{
+					const vec3 centre = groups.at(i).centre_group + groups.at(i).offsetVector * viewer()->explosion();
+					const float distance = length(vec3(worldCameraPosition) - centre) - groups.at(i).radius_group;
+
+					while (distance > 0.0f && level < groups.at(i).levelsOfDetail.size() && groups.at(i).levelsOfDetail[level].error * pixelScale <= levelOfDetailThreshold * distance)
+						level++;
+				}
+
+				const IndexRange & drawn = level == 0 ? static_cast<const IndexRange &>(groups.at(i)) : groups.at(i).levelsOfDetail[level - 1];
+
+				// models loaded out of core have no meshlets, their groups are always drawn whole
+				const bool culled = meshletCulling && groups.at(i).meshletCount > 0;
+
+				if (culled)
+				{
+					const std::vector<std::uint8_t> & visible = viewer()->scene()->model()->meshletCuller().visible();
+					const uint meshletEnd = groups.at(i).firstMeshlet + groups.at(i).meshletCount;
+
+					for (uint m = groups.at(i).firstMeshlet; m < meshletEnd; m++)
+					{
+						if (!visible[m])
+							continue;
+
+						if (!ranges.empty() && ranges.back().first + ranges.back().second == meshlets[m].firstIndex)
+							ranges.back().second += meshlets[m].indexCount;
+						else
+							ranges.emplace_back(meshlets[m].firstIndex, meshlets[m].indexCount);
+					}
+
+					if (ranges.empty())
+						continue;
+				}
+
+				// the meshlets belong to the full detail, coarser levels are drawn whole when any meshlet is visible
+				if (!culled || level > 0)
+				{
+					ranges.clear();
+					ranges.emplace_back(0, drawn.count());
+				}
+
+				levelGroups[level]++;
+
+				for (const auto & range : ranges)
+					levelTriangles[level] += range.second / 3;
+
+				for (const auto & range : ranges)
+					m_renderQueue.add(groups.at(i).materialIndex, drawn, range.first, range.second, groups.at(i).offsetVector * viewer()->explosion(), conditionalRendering ? occlusionQueries.condition(i) : 0);
+			}
+		}
+
+		m_renderQueue.submit(*shaderProgramModelBase, viewer()->scene()->model()->vertexArray(), materials, wireframeFetched, batching);
+
+		for (auto triangles : levelTriangles)
+			drawnTriangles += triangles;
+	}
+
+	const double submitSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - submitStart).count();
+	double & submitTime = submitTimes[indirect ? 1 : 0];
+	submitTime = submitTime > 0.0 ? submitTime * 0.95 + submitSeconds * 0.05 : submitSeconds;
+
+	// the indirect commands draw the enabled groups in the frustum whole, counted outside of the submit time
+	if (indirect && !gpuCulled)
+	{
+		for (uint i = 0; i < groups.size(); i++)
+		{
+			if (groupEnabled.at(i) && groupVisible[i])
+				drawnTriangles += groups.at(i).count() / 3;
 		}
 	}
 
+	viewer()->drawnTriangles() += drawnTriangles;
+
+	if (wireframeFetched)
+	{
+		Buffer::unbind(GL_SHADER_STORAGE_BUFFER, 0);
+		Buffer::unbind(GL_SHADER_STORAGE_BUFFER, 1);
+	}
+
+	// the boxes are tested against the depth of the whole model, their results decide about the next frame
+	if (occlusionQueried)
+	{
+		occlusionQueries.issue(*shaderProgram("model-proxy"), modelViewProjectionMatrix, viewer()->explosion(), visibleQueryInterval);
+		viewer()->scene()->model()->vertexArray().bind();
+		shaderProgramModelBase->use();
+	}
+
 	if (ImGui::BeginMenu("Assignment1")) {
 		if (ImGui::CollapsingHeader("Light Control"))
 		{
@@ -206,14 +611,18 @@ void ModelRenderer::display()
 		ImGui::EndMenu();
 	}
 
-	shaderProgramModelBase->setUniform("light_A", light_a);
-	shaderProgramModelBase->setUniform("light_S", light_s);
-	shaderProgramModelBase->setUniform("light_D", light_d);
-
-	shaderProgramModelBase->setUniform("shininess", m_shininess);
-	shaderProgramModelBase->setUniform("diffuseColor", m_diffuse);
-	shaderProgramModelBase->setUniform("specularColor", m_specular);
-	shaderProgramModelBase->setUniform("ambientColor", m_ambient);
+	// the settings are shared by all programs, so that switching between them does not start from stale ones
+	for (auto program : modelPrograms())
+	{
+		program->setUniform("light_A", light_a);
+		program->setUniform("light_S", light_s);
+		program->setUniform("light_D", light_d);
+
+		program->setUniform("shininess", m_shininess);
+		program->setUniform("diffuseColor", m_diffuse);
+		program->setUniform("specularColor", m_specular);
+		program->setUniform("ambientColor", m_ambient);
+	}
 
 	if (ImGui::BeginMenu("Assignment2")) {
 
@@ -267,14 +676,17 @@ void ModelRenderer::display()
 		ImGui::EndMenu();
 	}
 
-	shaderProgramModelBase->setUniform("diff_txt", difTxt);
-	shaderProgramModelBase->setUniform("ambn_txt", ambTxt);
-	shaderProgramModelBase->setUniform("spec_txt", spcTxt);
-	shaderProgramModelBase->setUniform("objSpace", objSpace);
-	shaderProgramModelBase->setUniform("tangSpace", tangSpace);
-	shaderProgramModelBase->setUniform("bumpMapping", bumpMapping);
-	shaderProgramModelBase->setUniform("amp", amp);
-	shaderProgramModelBase->setUniform("freq", freq);
+	for (auto program : modelPrograms())
+	{
+		program->setUniform("diff_txt", difTxt);
+		program->setUniform("ambn_txt", ambTxt);
+		program->setUniform("spec_txt", spcTxt);
+		program->setUniform("objSpace", objSpace);
+		program->setUniform("tangSpace", tangSpace);
+		program->setUniform("bumpMapping", bumpMapping);
+		program->setUniform("amp", amp);
+		program->setUniform("freq", freq);
+	}
 
 	if (ImGui::BeginMenu("Assignment3")) {
 		ImGui::SliderFloat("Explosion Degree", &viewer()->explosion(), 0.0f, 10.0f);
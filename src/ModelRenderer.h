@@ -1,6 +1,8 @@
 #pragma once
 #include "Renderer.h"
+#include "RenderQueue.h"
 #include <memory>
+#include <vector>
 
 #include <glm/glm.hpp>
 #include <glbinding/gl/gl.h>
@@ -32,9 +34,19 @@ namespace minity
 
 	private:
 
+		// all programs drawing the model, which share the light and material settings
+		std::vector<globjects::Program*> modelPrograms();
+
 		std::unique_ptr<globjects::VertexArray> m_lightArray = std::make_unique<globjects::VertexArray>();
 		std::unique_ptr<globjects::Buffer> m_lightVertices = std::make_unique<globjects::Buffer>();
 
+		RenderQueue m_renderQueue;
+
+		bool m_wireframeFetchSupported = false;
+		bool m_indirectSupported = false;
+		bool m_bindlessSupported = false;
+		bool m_gpuCullingSupported = false;
+
 		glm::vec3 light_a = glm::vec3(0.05f, 0.05f, 0.05f);
 		glm::vec3 light_d = glm::vec3(0.5f, 0.5f, 0.5f);
 		glm::vec3 light_s = glm::vec3(0.5f, 0.5f, 0.5f);
@@ -0,0 +1,297 @@
+#include "NormalGenerator.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <memory>
+
+using namespace glm;
+using namespace minity;
+
+namespace
+{
+	// the complete triangles of a group, numbered consecutively over all groups
+	struct TriangleRange
+	{
+		std::size_t cornerBegin;
+		std::size_t cornerEnd;
+		std::size_t triangleBegin;
+		std::size_t triangleEnd;
+	};
+}
+
+NormalGenerator::NormalGenerator(LoadOptions::NormalWeighting weighting, float creaseAngle, unsigned int threadCount) :
+	m_weighting(weighting), m_creaseAngle(creaseAngle), m_threadCount(threadCount)
+{
+
+}
+
+void NormalGenerator::generate(const std::pmr::vector<vec3> & positions, const std::pmr::vector<unsigned int> & positionIndices, const std::vector<Range> & groups,
+	std::pmr::vector<vec3> & normals, std::pmr::vector<unsigned int> & normalIndices) const
+{
+	using Weighting = LoadOptions::NormalWeighting;
+
+	// trailing corners which do not form a complete triangle are ignored
+	std::vector<TriangleRange> ranges;
+	std::size_t triangleCount = 0;
+
+	for (const auto & g : groups)
+	{
+		const std::size_t count = (g.cornerEnd - g.cornerBegin) / 3;
+
+		if (count > 0)
+		{
+			ranges.push_back({ g.cornerBegin, g.cornerBegin + 3 * count, triangleCount, triangleCount + count });
+			triangleCount += count;
+		}
+	}
+
+	const unsigned int threadCount = m_threadCount > 0 ? m_threadCount : ThreadPool::hardwareThreads();
+	std::unique_ptr<ThreadPool> pool;
+
+	if (threadCount > 1)
+		pool = std::make_unique<ThreadPool>(threadCount);
+
+	auto parallelFor = [&pool](std::size_t count, const std::function<void(std::size_t)> & function) {
+		if (pool)
+			pool->parallelFor(count, function);
+		else
+			for (std::size_t i = 0; i < count; i++)
+				function(i);
+	};
+
+	auto rangeOfTriangle = [&ranges](std::size_t triangle) {
+		return std::size_t(std::upper_bound(ranges.begin(), ranges.end(), triangle, [](std::size_t t, const TriangleRange & r) { return t < r.triangleEnd; }) - ranges.begin());
+	};
+
+	auto rangeOfCorner = [&ranges](std::size_t corner) -> const TriangleRange & {
+		return *std::upper_bound(ranges.begin(), ranges.end(), corner, [](std::size_t c, const TriangleRange & r) { return c < r.cornerEnd; });
+	};
+
+	// the corners are sorted into buckets of consecutive positions, so that every position can gather
+	// its faces in corner order without any synchronization, which also keeps the sums identical to a serial loop
+	const std::size_t positionCount = positions.size();
+	const std::size_t bucketSize = std::max(std::size_t(1), (positionCount + std::size_t(threadCount) * 16 - 1) / (std::size_t(threadCount) * 16));
+	const std::size_t bucketCount = (positionCount + bucketSize - 1) / bucketSize;
+	const std::size_t chunkCount = std::max(std::size_t(1), std::min(triangleCount, std::size_t(threadCount) * 4));
+
+	// unit face normals, or the cross products for area weighting, whose length is twice the area
+	std::vector<vec3> faces(triangleCount);
+	// corner counts per chunk and bucket, then the offsets the chunks scatter their corners to
+	std::vector<std::size_t> chunkBuckets(chunkCount * bucketCount, 0);
+
+	auto forEachTriangle = [&](std::size_t chunk, const std::function<void(std::size_t, const unsigned int *)> & function) {
+		const std::size_t begin = triangleCount * chunk / chunkCount;
+		const std::size_t end = triangleCount * (chunk + 1) / chunkCount;
+		std::size_t r = rangeOfTriangle(begin);
+
+		for (std::size_t t = begin; t < end; t++)
+		{
+			while (t >= ranges[r].triangleEnd)
+				r++;
+
+			function(t, &positionIndices[ranges[r].cornerBegin + 3 * (t - ranges[r].triangleBegin)]);
+		}
+	};
+
+	parallelFor(chunkCount, [&](std::size_t chunk) {
+		std::size_t * counts = chunkBuckets.data() + chunk * bucketCount;
+
+		forEachTriangle(chunk, [&](std::size_t t, const unsigned int * corner) {
+			const vec3 & p0 = positions[corner[0]];
+			const vec3 & p1 = positions[corner[1]];
+			const vec3 & p2 = positions[corner[2]];
+
+			const vec3 a(p2 - p1);
+			const vec3 b(p0 - p1);
+			const vec3 n = cross(a, b);
+			faces[t] = m_weighting == Weighting::Area ? n : normalize(n);
+
+			counts[corner[0] / bucketSize]++;
+			counts[corner[1] / bucketSize]++;
+			counts[corner[2] / bucketSize]++;
+		});
+	});
+
+	std::vector<std::size_t> bucketBegin(bucketCount + 1, 0);
+	std::size_t offset = 0;
+
+	for (std::size_t b = 0; b < bucketCount; b++)
+	{
+		bucketBegin[b] = offset;
+
+		for (std::size_t chunk = 0; chunk < chunkCount; chunk++)
+		{
+			const std::size_t count = chunkBuckets[chunk * bucketCount + b];
+			chunkBuckets[chunk * bucketCount + b] = offset;
+			offset += count;
+		}
+	}
+
+	bucketBegin[bucketCount] = offset;
+
+	// chunks are in triangle order, so the corners within a bucket stay in ascending order
+	std::vector<unsigned int> bucketCorners(offset);
+
+	parallelFor(chunkCount, [&](std::size_t chunk) {
+		std::size_t * offsets = chunkBuckets.data() + chunk * bucketCount;
+
+		forEachTriangle(chunk, [&](std::size_t, const unsigned int * corner) {
+			const unsigned int first = unsigned(corner - positionIndices.data());
+
+			for (unsigned int i = 0; i < 3; i++)
+				bucketCorners[offsets[corner[i] / bucketSize]++] = first + i;
+		});
+	});
+
+	auto triangleOf = [](std::size_t corner, const TriangleRange & r) {
+		return r.triangleBegin + (corner - r.cornerBegin) / 3;
+	};
+
+	auto unitNormal = [&](std::size_t corner, const TriangleRange & r) {
+		const vec3 & face = faces[triangleOf(corner, r)];
+		return m_weighting == Weighting::Area ? normalize(face) : face;
+	};
+
+	auto contribution = [&](std::size_t corner, const TriangleRange & r) {
+		const vec3 & face = faces[triangleOf(corner, r)];
+
+		if (m_weighting != Weighting::Angle)
+			return face;
+
+		// degenerate faces have no direction to contribute
+		if (!(dot(face, face) > 0.0f))
+			return vec3(0.0f);
+
+		const std::size_t first = r.cornerBegin + (corner - r.cornerBegin) / 3 * 3;
+		const std::size_t i = corner - first;
+		const vec3 & p = positions[positionIndices[corner]];
+		const vec3 e1 = positions[positionIndices[first + (i + 1) % 3]] - p;
+		const vec3 e2 = positions[positionIndices[first + (i + 2) % 3]] - p;
+		const float lengths = length(e1) * length(e2);
+
+		if (!(lengths > 0.0f))
+			return vec3(0.0f);
+
+		return face * std::acos(clamp(dot(e1, e2) / lengths, -1.0f, 1.0f));
+	};
+
+	const bool creases = m_creaseAngle < 180.0f;
+	const float creaseCosine = std::cos(radians(m_creaseAngle));
+
+	// normals of the corners of every bucket when they are split at creases, indexed locally to the bucket
+	std::vector< std::vector<vec3> > bucketNormals(creases ? bucketCount : 0);
+
+	if (creases)
+		normalIndices.assign(positionIndices.size(), 0);
+	else
+	{
+		normals.assign(positionCount, vec3(0.0f));
+		normalIndices = positionIndices;
+	}
+
+	parallelFor(bucketCount, [&](std::size_t b) {
+		const std::size_t positionBegin = b * bucketSize;
+		const std::size_t positionEnd = std::min(positionCount, positionBegin + bucketSize);
+		const unsigned int * corners = bucketCorners.data() + bucketBegin[b];
+		const std::size_t cornerCount = bucketBegin[b + 1] - bucketBegin[b];
+
+		// stable counting sort by position, the corners of each position stay in ascending order
+		std::vector<std::size_t> positionOffsets(positionEnd - positionBegin + 1, 0);
+		std::vector<unsigned int> sorted(cornerCount);
+
+		for (std::size_t i = 0; i < cornerCount; i++)
+			positionOffsets[positionIndices[corners[i]] - positionBegin + 1]++;
+
+		for (std::size_t i = 1; i < positionOffsets.size(); i++)
+			positionOffsets[i] += positionOffsets[i - 1];
+
+		{
+			std::vector<std::size_t> targets(positionOffsets.begin(), positionOffsets.end() - 1);
+
+			for (std::size_t i = 0; i < cornerCount; i++)
+				sorted[targets[positionIndices[corners[i]] - positionBegin]++] = corners[i];
+		}
+
+		for (std::size_t p = positionBegin; p < positionEnd; p++)
+		{
+			const unsigned int * begin = sorted.data() + positionOffsets[p - positionBegin];
+			const unsigned int * end = sorted.data() + positionOffsets[p - positionBegin + 1];
+
+			if (begin == end)
+				continue;
+
+			if (!creases)
+			{
+				// a position used by several groups gets the normal of the last one
+				const TriangleRange & r = rangeOfCorner(end[-1]);
+				vec3 sum(0.0f);
+
+				for (const unsigned int * c = begin; c != end; c++)
+				{
+					if (*c >= r.cornerBegin)
+						sum += contribution(*c, r);
+				}
+
+				normals[p] = normalize(sum);
+				continue;
+			}
+
+			std::vector<vec3> & local = bucketNormals[b];
+			const std::size_t positionNormals = local.size();
+
+			for (const unsigned int * groupBegin = begin; groupBegin != end; )
+			{
+				const TriangleRange & r = rangeOfCorner(*groupBegin);
+				const unsigned int * groupEnd = groupBegin;
+
+				while (groupEnd != end && *groupEnd < r.cornerEnd)
+					groupEnd++;
+
+				for (const unsigned int * c = groupBegin; c != groupEnd; c++)
+				{
+					const vec3 n = unitNormal(*c, r);
+					vec3 sum(0.0f);
+
+					for (const unsigned int * other = groupBegin; other != groupEnd; other++)
+					{
+						if (dot(n, unitNormal(*other, r)) >= creaseCosine)
+							sum += contribution(*other, r);
+					}
+
+					const vec3 normal = normalize(sum);
+					std::size_t index = positionNormals;
+
+					while (index < local.size() && local[index] != normal)
+						index++;
+
+					if (index == local.size())
+						local.push_back(normal);
+
+					normalIndices[*c] = unsigned(index);
+				}
+
+				groupBegin = groupEnd;
+			}
+		}
+	});
+
+	if (!creases)
+		return;
+
+	// normal zero is kept for corners outside of complete triangles
+	normals.assign(1, vec3(0.0f));
+	std::vector<std::size_t> bucketBase(bucketCount);
+
+	for (std::size_t b = 0; b < bucketCount; b++)
+	{
+		bucketBase[b] = normals.size();
+		normals.insert(normals.end(), bucketNormals[b].begin(), bucketNormals[b].end());
+	}
+
+	parallelFor(bucketCount, [&](std::size_t b) {
+		for (std::size_t i = bucketBegin[b]; i < bucketBegin[b + 1]; i++)
+			normalIndices[bucketCorners[i]] += unsigned(bucketBase[b]);
+	});
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "Model.h"
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <memory_resource>
+#include <vector>
+
+namespace minity
+{
+	// smooth vertex normals for meshes without normals, computed on multiple threads
+	// by gathering the faces around every position instead of scattering into shared sums
+	class NormalGenerator
+	{
+	public:
+
+		// corners [cornerBegin, cornerEnd) form the triangles of one group, the ranges are ascending and do not overlap
+		struct Range
+		{
+			std::size_t cornerBegin = 0;
+			std::size_t cornerEnd = 0;
+		};
+
+		// a thread count of zero uses all hardware threads
+		NormalGenerator(LoadOptions::NormalWeighting weighting = LoadOptions::NormalWeighting::Uniform, float creaseAngle = 180.0f, unsigned int threadCount = 0);
+
+		// without a crease angle, every position gets the normal smoothed over the last group using it, and the normal indices
+		// are the position indices, otherwise corners only average faces within the crease angle of their own group
+		// and share normals which came out the same, normal zero is then used for corners of incomplete triangles
+		void generate(const std::pmr::vector<glm::vec3> & positions, const std::pmr::vector<unsigned int> & positionIndices, const std::vector<Range> & groups,
+			std::pmr::vector<glm::vec3> & normals, std::pmr::vector<unsigned int> & normalIndices) const;
+
+	private:
+
+		LoadOptions::NormalWeighting m_weighting;
+		float m_creaseAngle;
+		unsigned int m_threadCount;
+	};
+}
@@ -0,0 +1,1892 @@
+#include "ObjLoader.h"
+#include "MappedFile.h"
+#include "ThreadPool.h"
+#include "TextureLoader.h"
+#include "NormalGenerator.h"
+#include "TangentGenerator.h"
+#include "MeshOptimizer.h"
+#include "MeshSimplifier.h"
+
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <sstream>
+#include <cstdlib>
+#include <cstring>
+#include <charconv>
+#include <chrono>
+#include <iterator>
+#include <iostream>
+#include <limits>
+#include <array>
+#include <algorithm> 
+#include <cctype>
+#include <locale>
+#include <globjects/globjects.h>
+#include <globjects/logging.h>
+
+using namespace minity;
+using namespace gl;
+using namespace glm;
+using namespace globjects;
+
+std::string trimLeft(const std::string &str, const std::string &whitespace = "\n\r\t ")
+{
+	size_t uIndex = str.find_first_not_of(whitespace);
+	if (uIndex != std::string::npos)
+		return str.substr(uIndex);
+
+	return "";
+}
+
+std::string trimRight(const std::string &str, const std::string &whitespace = "\n\r\t ")
+{
+	size_t  uIndex = str.find_last_not_of(whitespace);
+	if (uIndex != std::string::npos)
+		return str.substr(0, uIndex + 1);
+
+	return str;
+}
+
+std::string trim(const std::string &str, const std::string & whitespace = "\n\r\t ")
+{
+	return trimRight(trimLeft(str, whitespace), whitespace);
+}
+
+template<class e, class t, int N>
+std::basic_istream<e, t>& operator>>(std::basic_istream<e, t>& in, const e(&sliteral)[N])
+{
+	std::array<e, N - 1> buffer; //get buffer
+	in >> buffer[0]; //skips whitespace
+	if (N > 2)
+		in.read(&buffer[1], N - 2); //read the rest
+	if (strncmp(&buffer[0], sliteral, N - 1)) //if it failed
+		in.setstate(in.rdstate() | std::ios::failbit); //set the state
+	return in;
+}
+
+template<class e, class t>
+std::basic_istream<e, t>& operator>>(std::basic_istream<e, t>& in, const e& cliteral)
+{
+	e buffer;  //get buffer
+	in >> buffer; //read data
+	if (buffer != cliteral) //if it failed
+		in.setstate(in.rdstate() | std::ios::failbit); //set the state
+	return in;
+}
+
+//redirect mutable char arrays to their normal function
+template<class e, class t, int N>
+std::basic_istream<e, t>& operator>>(std::basic_istream<e, t>& in, e(&carray)[N])
+{
+	return std::operator>>(in, carray);
+}
+
+namespace
+{
+	// like trim(), but without copying
+	std::string_view trimView(std::string_view str, std::string_view whitespace = "\n\r\t ")
+	{
+		const size_t begin = str.find_first_not_of(whitespace);
+
+		if (begin == std::string_view::npos)
+			return std::string_view();
+
+		const size_t end = str.find_last_not_of(whitespace);
+		return str.substr(begin, end - begin + 1);
+	}
+
+	// whitespace as seen by operator>>, line breaks are handled by the caller
+	inline bool isBlank(char c)
+	{
+		return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+	}
+
+	inline void skipBlanks(const char *& p, const char * end)
+	{
+		while (p < end && isBlank(*p))
+			p++;
+	}
+
+	inline bool parseInt(const char *& p, const char * end, int & value)
+	{
+		skipBlanks(p, end);
+
+		const char * first = p;
+
+		// from_chars does not accept an explicit plus sign
+		if (first < end && *first == '+')
+		{
+			first++;
+
+			if (first >= end || *first == '-')
+				return false;
+		}
+
+		auto result = std::from_chars(first, end, value);
+
+		if (result.ec != std::errc())
+			return false;
+
+		p = result.ptr;
+		return true;
+	}
+
+	inline bool parseFloat(const char *& p, const char * end, float & value)
+	{
+		skipBlanks(p, end);
+
+		const char * first = p;
+		const char * digits = p;
+
+		if (first < end && *first == '+')
+			digits = ++first;
+		else if (first < end && *first == '-')
+			digits = first + 1;
+
+		// from_chars would also accept inf and nan, which operator>> rejects
+		if (digits >= end || !(std::isdigit((unsigned char)*digits) || *digits == '.'))
+			return false;
+
+		auto result = std::from_chars(first, end, value);
+
+		if (result.ec != std::errc())
+			return false;
+
+		p = result.ptr;
+		return true;
+	}
+
+	inline bool parseSlash(const char *& p, const char * end)
+	{
+		skipBlanks(p, end);
+
+		if (p < end && *p == '/')
+		{
+			p++;
+			return true;
+		}
+
+		return false;
+	}
+
+	inline bool parseDoubleSlash(const char *& p, const char * end)
+	{
+		skipBlanks(p, end);
+
+		if (end - p >= 2 && p[0] == '/' && p[1] == '/')
+		{
+			p += 2;
+			return true;
+		}
+
+		return false;
+	}
+
+	enum class FaceFormat
+	{
+		Position,
+		PositionTexCoord,
+		PositionTexCoordNormal,
+		PositionNormal
+	};
+
+	inline bool parseCorner(const char *& p, const char * end, FaceFormat format, int & v, int & t, int & n)
+	{
+		switch (format)
+		{
+		case FaceFormat::Position:
+			return parseInt(p, end, v);
+
+		case FaceFormat::PositionTexCoord:
+			return parseInt(p, end, v) && parseSlash(p, end) && parseInt(p, end, t);
+
+		case FaceFormat::PositionTexCoordNormal:
+			return parseInt(p, end, v) && parseSlash(p, end) && parseInt(p, end, t) && parseSlash(p, end) && parseInt(p, end, n);
+
+		case FaceFormat::PositionNormal:
+			return parseInt(p, end, v) && parseDoubleSlash(p, end) && parseInt(p, end, n);
+		}
+
+		return false;
+	}
+
+	// open addressing hash table mapping (position, normal, texcoord) index triples to vertex indices,
+	// sized for the number of corners up front so it never has to grow
+	class CornerTable
+	{
+	public:
+		CornerTable(size_t cornerCount)
+		{
+			size_t capacity = 16;
+
+			while (capacity < cornerCount * 2)
+				capacity *= 2;
+
+			m_mask = capacity - 1;
+			m_keys.resize(capacity);
+			m_values.resize(capacity, empty);
+		}
+
+		// returns the vertex index of an equal triple, or stores and returns vertexIndex if there is none
+		unsigned int insert(unsigned int position, unsigned int normal, unsigned int texCoord, unsigned int vertexIndex)
+		{
+			size_t slot = hash(position, normal, texCoord) & m_mask;
+
+			while (m_values[slot] != empty)
+			{
+				const Key & key = m_keys[slot];
+
+				if (key.position == position && key.normal == normal && key.texCoord == texCoord)
+					return m_values[slot];
+
+				slot = (slot + 1) & m_mask;
+			}
+
+			m_keys[slot] = { position, normal, texCoord };
+			m_values[slot] = vertexIndex;
+			return vertexIndex;
+		}
+
+	private:
+
+		struct Key
+		{
+			unsigned int position;
+			unsigned int normal;
+			unsigned int texCoord;
+		};
+
+		static constexpr unsigned int empty = ~0u;
+
+		static size_t hash(unsigned int position, unsigned int normal, unsigned int texCoord)
+		{
+			std::uint64_t h = std::uint64_t(position) * 0x9e3779b97f4a7c15ull;
+			h ^= std::uint64_t(normal) * 0xc2b2ae3d27d4eb4full;
+			h ^= std::uint64_t(texCoord) * 0x165667b19e3779f9ull;
+			h ^= h >> 29;
+			return size_t(h);
+		}
+
+		std::vector<Key> m_keys;
+		std::vector<unsigned int> m_values;
+		size_t m_mask = 0;
+	};
+}
+
+ObjLoader::ObjLoader(const LoadOptions & options, TextureLoader * textureLoader, LoadStatistics * statistics) : m_options(options), m_textureLoader(textureLoader), m_statistics(statistics),
+	m_positions(&m_arena), m_normals(&m_arena), m_texCoords(&m_arena),
+	m_materialNames(&m_arena), m_materialNameMap(&m_arena),
+	m_corners(&m_arena), m_objGroups(&m_arena), m_groupRuns(&m_arena), m_groupNames(&m_arena)
+{
+
+}
+
+bool ObjLoader::loadObjFile(const std::string & filename)
+{
+	LoadStatistics::Scope loadScope(m_statistics, "obj file");
+
+	if (!parseObjFile(filename))
+		return false;
+
+	loadDefaultMaterialLibrary();
+
+	{
+		LoadStatistics::Scope normalScope(m_statistics, "normals");
+
+		if (generateNormals())
+			normalScope.add(m_normals.size() * sizeof(vec3), m_normals.size() - 1);
+	}
+
+	LoadStatistics::Scope vertexScope(m_statistics, m_options.weldVertices ? "weld" : "flatten");
+
+	const size_t cornerCount = m_corners.size();
+
+	// with welding, every unique combination of attributes becomes exactly one vertex,
+	// otherwise vertices are only shared if they match the last corner using the same position
+	// the table is a single large allocation which is better returned to the heap right away than kept in the arena
+	CornerTable cornerTable(m_options.weldVertices ? cornerCount : 0);
+
+	if (!m_options.weldVertices)
+		m_vertices.resize(m_positions.size());
+	else
+		m_vertices.reserve(std::min(cornerCount, m_positions.size() * 2));
+
+	// the names used with usemtl are resolved only now, since libraries can be loaded after their materials were used
+	const std::vector<uint> materialIndices = this->materialIndices();
+
+	m_groups.reserve(m_objGroups.size());
+
+	for (const auto & g : m_objGroups)
+	{
+		if (g.cornerEnd > g.cornerBegin)
+		{
+			Group newGroup;
+
+			//Assignment3
+			glm::vec3 minVertex, maxVertex;
+			bool firstTime = true;
+
+			newGroup.name = std::string(groupName(g));
+			newGroup.startIndex = m_indices.size();
+
+			newGroup.materialIndex = materialIndices[g.material];
+
+			for (size_t j = g.cornerBegin; j < g.cornerEnd; j++)
+			{
+				const uint index = m_corners.positionIndices[j];
+
+				Vertex vertex;
+				vertex.position = m_positions[index];
+
+				//OBTAINING THE MAX AND MIN
+				if (firstTime)
+				{
+					minVertex = maxVertex = vertex.position;
+					firstTime = false;
+
+				}
+				else
+				{
+					minVertex = min(minVertex, vertex.position);
+					maxVertex = max(maxVertex, vertex.position);
+				}
+				vertex.normal = m_normals[m_corners.normalIndices[j]];
+				vertex.texcoord = m_texCoords[m_corners.texCoordIndices[j]];
+
+				if (m_options.weldVertices)
+				{
+					const uint vertexIndex = cornerTable.insert(index, m_corners.normalIndices[j], m_corners.texCoordIndices[j], uint(m_vertices.size()));
+
+					if (vertexIndex == m_vertices.size())
+						m_vertices.push_back(vertex);
+
+					m_indices.push_back(vertexIndex);
+				}
+				else if (m_vertices[index].position == vertex.position)
+				{
+					if (m_vertices[index].texcoord != vertex.texcoord || m_vertices[index].normal != vertex.normal)
+					{
+						m_indices.push_back(m_vertices.size());
+						m_vertices.push_back(vertex);
+					}
+					else
+					{
+						m_vertices[index] = vertex;
+						m_indices.push_back(index);
+					}
+				}
+				else
+				{
+					m_vertices[index] = vertex;
+					m_indices.push_back(index);
+				}
+			}
+
+			newGroup.endIndex = m_indices.size();
+
+			//IMPLEMENTING THE CENTRE
+
+			newGroup.centre_group = (minVertex + maxVertex) * 0.5f;
+			newGroup.radius_group = length(maxVertex - minVertex) * 0.5f;
+			newGroup.minimum_group = minVertex;
+			newGroup.maximum_group = maxVertex;
+
+			m_groups.push_back(std::move(newGroup));
+		}
+	}
+
+	if (m_options.weldVertices)
+		globjects::debug() << "Welded " << cornerCount << " corners into " << m_vertices.size() << " vertices";
+	else
+		globjects::debug() << "Flattened " << cornerCount << " corners into " << m_vertices.size() << " vertices";
+
+	vertexScope.add(m_vertices.size() * sizeof(Vertex) + m_indices.size() * sizeof(uint), cornerCount);
+	vertexScope.end();
+
+	{
+		LoadStatistics::Scope tangentScope(m_statistics, "tangents");
+		TangentGenerator::generate(m_vertices, m_indices, m_groups);
+		tangentScope.add(m_vertices.size() * sizeof(Vertex), m_vertices.size());
+	}
+
+	if (m_options.levelsOfDetail)
+	{
+		LoadStatistics::Scope levelScope(m_statistics, "levels of detail");
+
+		const std::size_t triangleCount = m_indices.size() / 3;
+		MeshSimplifier::buildLevelsOfDetail(m_vertices, m_indices, m_groups, m_options.threadCount);
+		globjects::debug() << "Simplified " << triangleCount << " triangles into " << m_indices.size() / 3 - triangleCount << " triangles of levels of detail";
+
+		levelScope.add((m_indices.size() - triangleCount * 3) * sizeof(uint), m_indices.size() / 3 - triangleCount);
+	}
+
+	if (m_options.optimizeMesh)
+	{
+		LoadStatistics::Scope optimizeScope(m_statistics, "optimize");
+		optimizeScope.add(m_indices.size() * sizeof(uint) + m_vertices.size() * sizeof(Vertex), m_indices.size() / 3);
+
+		// the levels of detail are optimized like groups of their own, after the groups so that these decide the vertex order
+		std::vector<Group> ranges = m_groups;
+
+		for (const auto & g : m_groups)
+		{
+			for (const auto & lod : g.levelsOfDetail)
+			{
+				Group range;
+				range.startIndex = lod.startIndex;
+				range.endIndex = lod.endIndex;
+				range.centre_group = g.centre_group;
+				ranges.push_back(range);
+			}
+		}
+
+		const float missRatio = MeshOptimizer::averageCacheMissRatio(m_indices.data(), m_indices.size(), m_vertices.size());
+		MeshOptimizer::optimize(m_vertices, m_indices, ranges);
+		globjects::debug() << "Optimized " << m_indices.size() / 3 << " triangles, average cache miss ratio " << missRatio << " -> " << MeshOptimizer::averageCacheMissRatio(m_indices.data(), m_indices.size(), m_vertices.size());
+	}
+
+	createMaterials(m_path.string(), m_objMaterials);
+	loadScope.add(m_vertices.size() * sizeof(Vertex) + m_indices.size() * sizeof(uint), cornerCount);
+
+	return true;
+}
+
+bool ObjLoader::generateNormals()
+{
+	if (m_normals.size() > 1)
+		return false;
+
+	std::vector<NormalGenerator::Range> groups;
+	groups.reserve(m_objGroups.size());
+
+	for (const auto & g : m_objGroups)
+		groups.push_back({ g.cornerBegin, g.cornerEnd });
+
+	NormalGenerator generator(m_options.normalWeighting, m_options.creaseAngle, m_options.threadCount);
+	generator.generate(m_positions, m_corners.positionIndices, groups, m_normals, m_corners.normalIndices);
+	return true;
+}
+
+void ObjLoader::createMaterials(const std::string & filename, const std::vector<ObjMaterial> & objMaterials)
+{
+	LoadStatistics::Scope materialScope(m_statistics, "materials");
+	materialScope.add(0, objMaterials.size());
+
+	m_path = std::filesystem::path(filename);
+	m_materials.clear();
+	m_materials.reserve(objMaterials.size());
+
+	for (auto & m : objMaterials)
+	{
+		Material newMaterial;
+		newMaterial.ambient = m.Ka;
+		newMaterial.diffuse = m.Kd;
+		newMaterial.specular = m.Ks;
+		newMaterial.shininess = m.Ns;
+
+		if (!m.map_Ka.empty())
+			newMaterial.ambientTexture = loadTexture(texturePath(m.map_Ka), TextureLoader::Usage::Color);
+
+		if (!m.map_Kd.empty())
+			newMaterial.diffuseTexture = loadTexture(texturePath(m.map_Kd), TextureLoader::Usage::Color);
+
+		if (!m.map_Ks.empty())
+			newMaterial.specularTexture = loadTexture(texturePath(m.map_Ks), TextureLoader::Usage::Color);
+
+		if (!m.map_Ns.empty())
+			newMaterial.shininessTexture = loadTexture(texturePath(m.map_Ns), TextureLoader::Usage::Data);
+
+		if (!m.map_bump.empty())
+			newMaterial.bumpTexture = loadTexture(texturePath(m.map_bump), TextureLoader::Usage::Data);
+
+		if (!m.map_objectSpaceNormals.empty())
+			newMaterial.objectSpaceNormalTexture = loadTexture(texturePath(m.map_objectSpaceNormals), TextureLoader::Usage::ObjectSpaceNormal);
+
+		if (!m.map_tangentSpaceNormals.empty())
+			newMaterial.tangentSpaceNormalTexture = loadTexture(texturePath(m.map_tangentSpaceNormals), TextureLoader::Usage::TangentSpaceNormal);
+
+		m_materials.push_back(newMaterial);
+	}
+}
+
+bool ObjLoader::parseObjFile(const std::string & filename)
+{
+	LoadStatistics::Scope parseScope(m_statistics, "parse");
+
+	beginParse(filename);
+
+	auto parseStart = std::chrono::steady_clock::now();
+	bool parsed = false;
+
+	if (m_options.parser == LoadOptions::Parser::Stream)
+		parsed = parseObjStream(filename);
+	else
+		parsed = parseObjMapped(filename);
+
+	if (!parsed)
+		return false;
+
+	finishGroups();
+
+	auto parseEnd = std::chrono::steady_clock::now();
+	double parseSeconds = std::chrono::duration<double>(parseEnd - parseStart).count();
+
+	std::error_code error;
+	double megabytes = double(std::filesystem::file_size(m_path, error)) / (1024.0 * 1024.0);
+
+	if (error)
+		megabytes = 0.0;
+
+	parseScope.add(std::uint64_t(megabytes * 1024.0 * 1024.0), m_corners.size());
+
+	const char * parserNames[] = { "stream", "mapped", "parallel" };
+	globjects::debug() << "Parsed " << megabytes << " MB in " << parseSeconds << " s (" << (parseSeconds > 0.0 ? megabytes / parseSeconds : 0.0) << " MB/s, " << parserNames[int(m_options.parser)] << " parser)";
+
+	return true;
+}
+
+void ObjLoader::beginParse(const std::string & filename)
+{
+	m_path = std::filesystem::path(filename);
+
+	m_positions.push_back(vec3(0.0f));
+	m_normals.push_back(vec3(0.0f));
+	m_texCoords.push_back(vec2(1.0f));
+
+	ObjMaterial defaultMaterial;
+	defaultMaterial.name = "default";
+
+	m_materialMap.insert(std::make_pair(defaultMaterial.name, int(m_objMaterials.size())));
+	m_objMaterials.push_back(defaultMaterial);
+
+	m_materialNames.emplace_back(defaultMaterial.name);
+	m_materialNameMap.emplace(m_materialNames.back(), 0);
+	m_currentMaterial = 0;
+
+	m_groupNames = "default";
+
+	ObjGroup defaultGroup;
+	defaultGroup.nameLength = std::uint32_t(m_groupNames.size());
+	defaultGroup.material = m_currentMaterial;
+	m_objGroups.push_back(defaultGroup);
+	m_groupRuns.push_back({ 0, 0 });
+	m_currentGroup = 0;
+}
+
+void ObjLoader::loadDefaultMaterialLibrary()
+{
+	if (m_objMaterials.size() <= 1)
+	{
+		std::filesystem::path libraryPath = m_path;
+		libraryPath.replace_extension("mtl");
+		loadMtlFile(libraryPath.string(), m_objMaterials, m_materialMap);
+	}
+}
+
+std::uint64_t ObjLoader::parseChecksum() const
+{
+	// FNV-1a, the attributes are hashed bitwise, so any difference in float parsing shows up
+	std::uint64_t hash = 14695981039346656037ull;
+
+	auto hashBytes = [&hash](const void * data, size_t size) {
+		const unsigned char * bytes = static_cast<const unsigned char*>(data);
+
+		for (size_t i = 0; i < size; i++)
+		{
+			hash ^= bytes[i];
+			hash *= 1099511628211ull;
+		}
+	};
+
+	auto hashVector = [&hashBytes](const auto & v) {
+		const std::uint64_t size = v.size();
+		hashBytes(&size, sizeof(size));
+		hashBytes(v.data(), v.size() * sizeof(v[0]));
+	};
+
+	hashVector(m_positions);
+	hashVector(m_normals);
+	hashVector(m_texCoords);
+
+	hashVector(m_corners.positionIndices);
+	hashVector(m_corners.normalIndices);
+	hashVector(m_corners.texCoordIndices);
+
+	for (const auto & g : m_objGroups)
+	{
+		hashVector(groupName(g));
+		hashVector(m_materialNames[g.material]);
+
+		const std::uint64_t range[2] = { g.cornerBegin, g.cornerEnd };
+		hashBytes(range, sizeof(range));
+	}
+
+	return hash;
+}
+
+bool ObjLoader::parseObjStream(const std::string & filename)
+{
+	std::ifstream is(filename);
+
+	if (!is.is_open())
+		return false;
+
+	std::string buffer;
+
+	while (is.good())
+	{
+		if (getline(is, buffer))
+		{
+			std::istringstream iss(buffer);
+			std::string token;
+
+			if (iss >> token)
+			{
+				switch (token.at(0))
+				{
+					// v, vn, vt
+				case 'v':
+				{
+					if (token == "v")
+					{
+						vec3 p(0.0f);
+
+						if (iss >> p.x >> p.y >> p.z)
+							m_positions.push_back(p);
+					}
+					else if (token == "vn")
+					{
+						vec3 n(0.0f);
+
+						if (iss >> n.x >> n.y >> n.z)
+							m_normals.push_back(n);
+					}
+					else if (token == "vt")
+					{
+						vec2 t(0.0f);
+
+						if (iss >> t.x >> t.y)
+							m_texCoords.push_back(t);
+					}
+				}
+				break;
+
+				// mtllib
+				case 'm':
+				{
+					std::string libraryNames;
+
+					if (getline(iss, libraryNames))
+						loadMaterialLibraries(libraryNames);
+				}
+				break;
+
+				// use material
+				case 'u':
+				{
+					std::string materialName;
+
+					if (getline(iss, materialName))
+						useMaterial(materialName);
+				}
+				break;
+
+				// group
+				case 'g':
+				case 'o':
+				{
+					std::string groupName;
+					
+					if (getline(iss,groupName))
+						beginGroup(groupName);
+				}
+				break;
+
+				// face
+				case 'f':
+				{
+					int v = 0, n = 0, t = 0;
+
+					if (buffer.find("//") != std::string::npos)
+					{
+						// v//n
+						if (iss >> v >> ("//") >> n)
+						{
+							m_corners.positionIndices.push_back(v < 0 ? (unsigned int) (v + m_positions.size()) : (unsigned int) (v));
+							m_corners.texCoordIndices.push_back(0);
+							m_corners.normalIndices.push_back(n < 0 ? (unsigned int) (n + m_normals.size()) : (unsigned int) (n));
+						}
+
+						if (iss >> v >> ("//") >> n)
+						{
+							m_corners.positionIndices.push_back(v < 0 ? (unsigned int) (v + m_positions.size()) : (unsigned int) (v));
+							m_corners.texCoordIndices.push_back(0);
+							m_corners.normalIndices.push_back(n < 0 ? (unsigned int) (n + m_normals.size()) : (unsigned int) (n));
+						}
+
+						if (iss >> v >> ("//") >> n)
+						{
+							m_corners.positionIndices.push_back(v < 0 ? (unsigned int) (v + m_positions.size()) : (unsigned int) (v));
+							m_corners.texCoordIndices.push_back(0);
+							m_corners.normalIndices.push_back(n < 0 ? (unsigned int) (n + m_normals.size()) : (unsigned int) (n));
+						}
+
+						while (iss >> v >> ("//") >> n)
+						{
+							m_corners.positionIndices.push_back(m_corners.positionIndices[m_corners.positionIndices.size() - 3]);
+							m_corners.texCoordIndices.push_back(0);
+							m_corners.normalIndices.push_back(m_corners.normalIndices[m_corners.normalIndices.size() - 3]);
+
+							m_corners.positionIndices.push_back(m_corners.positionIndices[m_corners.positionIndices.size() - 2]);
+							m_corners.texCoordIndices.push_back(0);
+							m_corners.normalIndices.push_back(m_corners.normalIndices[m_corners.normalIndices.size() - 2]);
+
+							m_corners.positionIndices.push_back(v < 0 ? (unsigned int) (v + m_positions.size()) : (unsigned int) (v));
+							m_corners.texCoordIndices.push_back(0);
+							m_corners.normalIndices.push_back(n < 0 ? (unsigned int) (n + m_normals.size()) : (unsigned int) (n));
+						}
+
+						break;
+					}
+
+					iss = std::istringstream(buffer);
+					iss >> token;
+
+					if (iss >> v >> ("/") >> t >> ("/") >> n)
+					{
+						// v/t/n
+						m_corners.positionIndices.push_back(v < 0 ? (unsigned int) (v + m_positions.size()) : (unsigned int) (v));
+						m_corners.texCoordIndices.push_back(t < 0 ? (unsigned int) (t + m_texCoords.size()) : (unsigned int) (t));
+						m_corners.normalIndices.push_back(n < 0 ? (unsigned int) (n + m_normals.size()) : (unsigned int) (n));
+
+						if (iss >> v >> ("/") >> t >> ("/") >> n)
+						{
+							m_corners.positionIndices.push_back(v < 0 ? (unsigned int) (v + m_positions.size()) : (unsigned int) (v));
+							m_corners.texCoordIndices.push_back(t < 0 ? (unsigned int) (t + m_texCoords.size()) : (unsigned int) (t));
+							m_corners.normalIndices.push_back(n < 0 ? (unsigned int) (n + m_normals.size()) : (unsigned int) (n));
+						}
+
+						if (iss >> v >> ("/") >> t >> ("/") >> n)
+						{
+							m_corners.positionIndices.push_back(v < 0 ? (unsigned int) (v + m_positions.size()) : (unsigned int) (v));
+							m_corners.texCoordIndices.push_back(t < 0 ? (unsigned int) (t + m_texCoords.size()) : (unsigned int) (t));
+							m_corners.normalIndices.push_back(n < 0 ? (unsigned int) (n + m_normals.size()) : (unsigned int) (n));
+						}
+
+						while (iss >> v >> ("/") >> t >> ("/") >> n)
+						{
+							m_corners.positionIndices.push_back(m_corners.positionIndices[m_corners.positionIndices.size() - 3]);
+							m_corners.texCoordIndices.push_back(m_corners.texCoordIndices[m_corners.texCoordIndices.size() - 3]);
+							m_corners.normalIndices.push_back(m_corners.normalIndices[m_corners.normalIndices.size() - 3]);
+
+							m_corners.positionIndices.push_back(m_corners.positionIndices[m_corners.positionIndices.size() - 2]);
+							m_corners.texCoordIndices.push_back(m_corners.texCoordIndices[m_corners.texCoordIndices.size() - 2]);
+							m_corners.normalIndices.push_back(m_corners.normalIndices[m_corners.normalIndices.size() - 2]);
+
+							m_corners.positionIndices.push_back(v < 0 ? (unsigned int) (v + m_positions.size()) : (unsigned int) (v));
+							m_corners.texCoordIndices.push_back(t < 0 ? (unsigned int) (t + m_texCoords.size()) : (unsigned int) (t));
+							m_corners.normalIndices.push_back(n < 0 ? (unsigned int) (n + m_normals.size()) : (unsigned int) (n));
+						}
+
+						break;
+					}
+
+					iss = std::istringstream(buffer);
+					iss >> token;
+
+					if (iss >> v >> ("/") >> t)
+					{
+						// v/t
+						m_corners.positionIndices.push_back(v < 0 ? (unsigned int) (v + m_positions.size()) : (unsigned int) (v));
+						m_corners.texCoordIndices.push_back(t < 0 ? (unsigned int) (t + m_texCoords.size()) : (unsigned int) (t));
+						m_corners.normalIndices.push_back(0);
+
+						if (iss >> v >> ("/") >> t)
+						{
+							m_corners.positionIndices.push_back(v < 0 ? (unsigned int) (v + m_positions.size()) : (unsigned int) (v));
+							m_corners.texCoordIndices.push_back(t < 0 ? (unsigned int) (t + m_texCoords.size()) : (unsigned int) (t));
+							m_corners.normalIndices.push_back(0);
+						}
+
+						if (iss >> v >> ("/") >> t)
+						{
+							m_corners.positionIndices.push_back(v < 0 ? (unsigned int) (v + m_positions.size()) : (unsigned int) (v));
+							m_corners.texCoordIndices.push_back(t < 0 ? (unsigned int) (t + m_texCoords.size()) : (unsigned int) (t));
+							m_corners.normalIndices.push_back(0);
+						}
+
+						while (iss >> v >> ("/") >> t)
+						{
+							m_corners.positionIndices.push_back(m_corners.positionIndices[m_corners.positionIndices.size() - 3]);
+							m_corners.texCoordIndices.push_back(m_corners.texCoordIndices[m_corners.texCoordIndices.size() - 3]);
+							m_corners.normalIndices.push_back(0);
+
+							m_corners.positionIndices.push_back(m_corners.positionIndices[m_corners.positionIndices.size() - 2]);
+							m_corners.texCoordIndices.push_back(m_corners.texCoordIndices[m_corners.texCoordIndices.size() - 2]);
+							m_corners.normalIndices.push_back(0);
+
+							m_corners.positionIndices.push_back(v < 0 ? (unsigned int) (v + m_positions.size()) : (unsigned int) (v));
+							m_corners.texCoordIndices.push_back(t < 0 ? (unsigned int) (t + m_texCoords.size()) : (unsigned int) (t));
+							m_corners.normalIndices.push_back(0);
+						}
+
+						break;
+					}
+					else
+					{
+						iss = std::istringstream(buffer);
+						iss >> token;
+
+						// v
+						if (iss >> v)
+						{
+							m_corners.positionIndices.push_back(v < 0 ? (unsigned int) (v + m_positions.size()) : (unsigned int) (v));
+							m_corners.texCoordIndices.push_back(0);
+							m_corners.normalIndices.push_back(0);
+						}
+
+						if (iss >> v)
+						{
+							m_corners.positionIndices.push_back(v < 0 ? (unsigned int) (v + m_positions.size()) : (unsigned int) (v));
+							m_corners.texCoordIndices.push_back(0);
+							m_corners.normalIndices.push_back(0);
+						}
+
+						if (iss >> v)
+						{
+							m_corners.positionIndices.push_back(v < 0 ? (unsigned int) (v + m_positions.size()) : (unsigned int) (v));
+							m_corners.texCoordIndices.push_back(0);
+							m_corners.normalIndices.push_back(0);
+						}
+
+						while (iss >> v)
+						{
+							m_corners.positionIndices.push_back(m_corners.positionIndices[m_corners.positionIndices.size() - 3]);
+							m_corners.texCoordIndices.push_back(0);
+							m_corners.normalIndices.push_back(0);
+
+							m_corners.positionIndices.push_back(m_corners.positionIndices[m_corners.positionIndices.size() - 2]);
+							m_corners.texCoordIndices.push_back(0);
+							m_corners.normalIndices.push_back(0);
+
+							m_corners.positionIndices.push_back(v < 0 ? (unsigned int) (v + m_positions.size()) : (unsigned int) (v));
+							m_corners.texCoordIndices.push_back(0);
+							m_corners.normalIndices.push_back(0);
+						}
+					}
+				}
+				break;
+				}
+			}
+		}
+	}
+
+	return true;
+}
+
+ObjLoader::ObjCorners::ObjCorners(std::pmr::memory_resource * resource) : positionIndices(resource), normalIndices(resource), texCoordIndices(resource)
+{
+
+}
+
+size_t ObjLoader::ObjCorners::size() const
+{
+	return positionIndices.size();
+}
+
+void ObjLoader::ObjCorners::reserve(size_t count)
+{
+	positionIndices.reserve(count);
+	normalIndices.reserve(count);
+	texCoordIndices.reserve(count);
+}
+
+void ObjLoader::ObjCorners::resize(size_t count)
+{
+	positionIndices.resize(count);
+	normalIndices.resize(count);
+	texCoordIndices.resize(count);
+}
+
+void ObjLoader::ObjCorners::push(unsigned int positionIndex, unsigned int texCoordIndex, unsigned int normalIndex)
+{
+	positionIndices.push_back(positionIndex);
+	texCoordIndices.push_back(texCoordIndex);
+	normalIndices.push_back(normalIndex);
+}
+
+void ObjLoader::ObjCorners::append(const ObjCorners & source, size_t begin, size_t end)
+{
+	if (begin >= end)
+		return;
+
+	positionIndices.insert(positionIndices.end(), source.positionIndices.begin() + begin, source.positionIndices.begin() + end);
+	normalIndices.insert(normalIndices.end(), source.normalIndices.begin() + begin, source.normalIndices.begin() + end);
+	texCoordIndices.insert(texCoordIndices.end(), source.texCoordIndices.begin() + begin, source.texCoordIndices.begin() + end);
+}
+
+struct ObjLoader::ObjChunk
+{
+	enum class DirectiveType
+	{
+		MaterialLibrary,
+		UseMaterial,
+		Group
+	};
+
+	// records changing the group or material state, replayed in file order when merging
+	struct Directive
+	{
+		DirectiveType type;
+		// points into the mapped file, which stays open until all chunks are merged
+		std::string_view argument;
+		size_t cornerOffset = 0;
+	};
+
+	// chunks parsed alongside others allocate from an arena of their own, so the threads do not contend
+	// for the heap, and the arena is released right after merging -- the first chunk uses the loader's arena
+	ObjChunk(ArenaResource * sharedArena = nullptr);
+
+	ArenaResource arena;
+	ArenaResource * resource;
+
+	std::pmr::vector< vec3 > positions;
+	std::pmr::vector< vec3 > normals;
+	std::pmr::vector< vec2 > texCoords;
+
+	// relative indices are resolved against the attributes of the chunk itself, all chunks except
+	// the first one are missing the dummy attributes at index zero that the serial parser starts with
+	size_t attributeBias = 1;
+
+	ObjCorners corners;
+
+	// corners with relative indices, which still need the number of attributes in preceding chunks added
+	std::pmr::vector<size_t> positionFixups;
+	std::pmr::vector<size_t> texCoordFixups;
+	std::pmr::vector<size_t> normalFixups;
+
+	std::pmr::vector<Directive> directives;
+
+	void parse(const char * begin, const char * end);
+	void parseFace(const char * begin, const char * end);
+	void pushCorner(unsigned int positionIndex, unsigned int texCoordIndex, unsigned int normalIndex, unsigned int relative);
+};
+
+ObjLoader::ObjChunk::ObjChunk(ArenaResource * sharedArena) :
+	resource(sharedArena ? sharedArena : &arena),
+	positions(resource), normals(resource), texCoords(resource),
+	corners(resource),
+	positionFixups(resource), texCoordFixups(resource), normalFixups(resource),
+	directives(resource)
+{
+
+}
+
+void ObjLoader::ObjChunk::parse(const char * begin, const char * end)
+{
+	const char * current = begin;
+
+	while (current < end)
+	{
+		const char * lineEnd = static_cast<const char*>(std::memchr(current, '\n', end - current));
+
+		if (lineEnd == nullptr)
+			lineEnd = end;
+
+		const char * p = current;
+		skipBlanks(p, lineEnd);
+
+		const char * tokenBegin = p;
+
+		while (p < lineEnd && !isBlank(*p))
+			p++;
+
+		const std::string_view token(tokenBegin, p - tokenBegin);
+
+		if (!token.empty())
+		{
+			switch (token[0])
+			{
+				// v, vn, vt
+			case 'v':
+			{
+				if (token == "v")
+				{
+					vec3 v(0.0f);
+
+					if (parseFloat(p, lineEnd, v.x) && parseFloat(p, lineEnd, v.y) && parseFloat(p, lineEnd, v.z))
+						positions.push_back(v);
+				}
+				else if (token == "vn")
+				{
+					vec3 n(0.0f);
+
+					if (parseFloat(p, lineEnd, n.x) && parseFloat(p, lineEnd, n.y) && parseFloat(p, lineEnd, n.z))
+						normals.push_back(n);
+				}
+				else if (token == "vt")
+				{
+					vec2 t(0.0f);
+
+					if (parseFloat(p, lineEnd, t.x) && parseFloat(p, lineEnd, t.y))
+						texCoords.push_back(t);
+				}
+			}
+			break;
+
+			// like getline() on the token stream, the following only apply if the line did not end with the token
+
+			// mtllib
+			case 'm':
+			{
+				if (p < lineEnd)
+					directives.push_back({ DirectiveType::MaterialLibrary, std::string_view(p, lineEnd - p), corners.size() });
+			}
+			break;
+
+			// use material
+			case 'u':
+			{
+				if (p < lineEnd)
+					directives.push_back({ DirectiveType::UseMaterial, std::string_view(p, lineEnd - p), corners.size() });
+			}
+			break;
+
+			// group
+			case 'g':
+			case 'o':
+			{
+				if (p < lineEnd)
+					directives.push_back({ DirectiveType::Group, std::string_view(p, lineEnd - p), corners.size() });
+			}
+			break;
+
+			// face
+			case 'f':
+			{
+				parseFace(p, lineEnd);
+			}
+			break;
+			}
+		}
+
+		current = lineEnd + 1;
+	}
+}
+
+void ObjLoader::ObjChunk::parseFace(const char * begin, const char * end)
+{
+	const size_t previousSize = corners.size();
+	const size_t previousPositionFixups = positionFixups.size();
+	const size_t previousTexCoordFixups = texCoordFixups.size();
+	const size_t previousNormalFixups = normalFixups.size();
+
+	const char * p = begin;
+	int v = 0, t = 0, n = 0;
+
+	// the format is decided by the first corner, in the same order of precedence as the stream parser
+	FaceFormat format = FaceFormat::PositionNormal;
+
+	if (!parseCorner(p, end, format, v, t, n))
+	{
+		format = FaceFormat::PositionTexCoordNormal;
+		p = begin;
+
+		if (!parseCorner(p, end, format, v, t, n))
+		{
+			format = FaceFormat::PositionTexCoord;
+			p = begin;
+
+			if (!parseCorner(p, end, format, v, t, n))
+			{
+				format = FaceFormat::Position;
+				p = begin;
+
+				if (!parseCorner(p, end, format, v, t, n))
+					return;
+			}
+		}
+	}
+
+	const bool hasTexCoord = format == FaceFormat::PositionTexCoord || format == FaceFormat::PositionTexCoordNormal;
+	const bool hasNormal = format == FaceFormat::PositionNormal || format == FaceFormat::PositionTexCoordNormal;
+
+	const size_t positionCount = positions.size() + attributeBias;
+	const size_t texCoordCount = texCoords.size() + attributeBias;
+	const size_t normalCount = normals.size() + attributeBias;
+
+	// bit 0, 1 and 2 are set if the position, texture coordinate or normal index of a corner is relative
+	unsigned int firstRelative = 0;
+	unsigned int previousRelative = 0;
+
+	unsigned int count = 0;
+	const char * cornerBegin = begin;
+
+	do
+	{
+		unsigned int relative = 0;
+
+		const unsigned int positionIndex = v < 0 ? (unsigned int)(v + positionCount) : (unsigned int)(v);
+		relative |= v < 0 ? 1u : 0u;
+
+		unsigned int texCoordIndex = 0;
+
+		if (hasTexCoord)
+		{
+			texCoordIndex = t < 0 ? (unsigned int)(t + texCoordCount) : (unsigned int)(t);
+			relative |= t < 0 ? 2u : 0u;
+		}
+
+		unsigned int normalIndex = 0;
+
+		if (hasNormal)
+		{
+			normalIndex = n < 0 ? (unsigned int)(n + normalCount) : (unsigned int)(n);
+			relative |= n < 0 ? 4u : 0u;
+		}
+
+		// polygons are triangulated as a fan around the first corner
+		if (count >= 3)
+		{
+			const size_t size = corners.positionIndices.size();
+			pushCorner(corners.positionIndices[size - 3], corners.texCoordIndices[size - 3], corners.normalIndices[size - 3], firstRelative);
+			pushCorner(corners.positionIndices[size - 1], corners.texCoordIndices[size - 1], corners.normalIndices[size - 1], previousRelative);
+		}
+
+		pushCorner(positionIndex, texCoordIndex, normalIndex, relative);
+
+		if (count == 0)
+			firstRelative = relative;
+
+		previousRelative = relative;
+		count++;
+		cornerBegin = p;
+	}
+	while (parseCorner(p, end, format, v, t, n));
+
+	// the stream parser only accepts v//n faces if the line contains a double slash, and then nothing else --
+	// parsed corners can never contain one, so only the unparsed remainder of the line needs to be checked
+	if (format != FaceFormat::PositionNormal)
+	{
+		const std::string_view remainder(cornerBegin, end - cornerBegin);
+
+		if (remainder.find("//") != std::string_view::npos)
+		{
+			corners.resize(previousSize);
+			positionFixups.resize(previousPositionFixups);
+			texCoordFixups.resize(previousTexCoordFixups);
+			normalFixups.resize(previousNormalFixups);
+		}
+	}
+}
+
+void ObjLoader::ObjChunk::pushCorner(unsigned int positionIndex, unsigned int texCoordIndex, unsigned int normalIndex, unsigned int relative)
+{
+	const size_t slot = corners.size();
+
+	if (relative & 1u)
+		positionFixups.push_back(slot);
+
+	if (relative & 2u)
+		texCoordFixups.push_back(slot);
+
+	if (relative & 4u)
+		normalFixups.push_back(slot);
+
+	corners.push(positionIndex, texCoordIndex, normalIndex);
+}
+
+bool ObjLoader::parseObjMapped(const std::string & filename)
+{
+	MappedFile file;
+
+	if (!file.open(filename))
+		return false;
+
+	const char * begin = file.data();
+	const char * end = begin + file.size();
+
+	unsigned int threadCount = 1;
+
+	if (m_options.parser == LoadOptions::Parser::Parallel)
+		threadCount = m_options.threadCount > 0 ? m_options.threadCount : ThreadPool::hardwareThreads();
+
+	// a few chunks per thread even out differences in line complexity, but tiny chunks are not worth merging
+	const size_t minimumChunkSize = size_t(1) << 20;
+	const size_t chunkCount = threadCount > 1 ? std::max(size_t(1), std::min(file.size() / minimumChunkSize, size_t(threadCount) * 4)) : 1;
+
+	// chunks always start at the beginning of a line
+	std::vector<const char *> boundaries;
+	boundaries.push_back(begin);
+
+	for (size_t i = 1; i < chunkCount; i++)
+	{
+		const char * target = std::max(begin + file.size() / chunkCount * i, boundaries.back());
+		const char * lineEnd = static_cast<const char*>(std::memchr(target, '\n', end - target));
+
+		if (lineEnd == nullptr)
+			break;
+
+		if (lineEnd + 1 > boundaries.back())
+			boundaries.push_back(lineEnd + 1);
+	}
+
+	boundaries.push_back(end);
+
+	std::vector< std::unique_ptr<ObjChunk> > chunks;
+
+	for (size_t i = 0; i + 1 < boundaries.size(); i++)
+		chunks.push_back(std::make_unique<ObjChunk>(i == 0 ? &m_arena : nullptr));
+
+	// the first chunk directly continues the attributes with the dummy elements at index zero
+	chunks.front()->attributeBias = 0;
+	chunks.front()->positions.swap(m_positions);
+	chunks.front()->normals.swap(m_normals);
+	chunks.front()->texCoords.swap(m_texCoords);
+
+	if (chunks.size() > 1)
+	{
+		ThreadPool pool(std::min(threadCount, unsigned(chunks.size())));
+
+		pool.parallelFor(chunks.size(), [&](size_t i) {
+			chunks[i]->parse(boundaries[i], boundaries[i + 1]);
+		});
+	}
+	else
+	{
+		chunks.front()->parse(begin, end);
+	}
+
+	size_t positionCount = 0, normalCount = 0, texCoordCount = 0, cornerCount = 0;
+
+	for (const auto & c : chunks)
+	{
+		positionCount += c->positions.size();
+		normalCount += c->normals.size();
+		texCoordCount += c->texCoords.size();
+		cornerCount += c->corners.size();
+	}
+
+	m_corners.reserve(cornerCount);
+
+	for (size_t i = 0; i < chunks.size(); i++)
+	{
+		mergeChunk(*chunks[i]);
+		const ArenaResource::Statistics & chunkStatistics = chunks[i]->arena.statistics();
+		m_chunkStatistics.allocations += chunkStatistics.allocations;
+		m_chunkStatistics.blocks += chunkStatistics.blocks;
+		m_chunkStatistics.blockBytes += chunkStatistics.blockBytes;
+		m_chunkStatistics.largeAllocations += chunkStatistics.largeAllocations;
+		m_chunkStatistics.largeBytes += chunkStatistics.largeBytes;
+		chunks[i].reset();
+
+		// the first chunk is moved, so the space for all others can only be reserved afterwards
+		if (i == 0)
+		{
+			m_positions.reserve(positionCount);
+			m_normals.reserve(normalCount);
+			m_texCoords.reserve(texCoordCount);
+		}
+	}
+
+	globjects::debug() << "Parsed " << chunks.size() << " chunks on " << std::min(threadCount, unsigned(chunks.size())) << " threads";
+
+	return true;
+}
+
+bool ObjLoader::streamObjFile(const std::string & filename, std::size_t windowSize, const std::function<bool(const ObjWindow &)> & callback)
+{
+	beginParse(filename);
+
+	MappedFile file;
+
+	if (!file.open(filename))
+		return false;
+
+	auto parseStart = std::chrono::steady_clock::now();
+
+	const char * begin = file.data();
+	const char * end = begin + file.size();
+
+	// the defaults at index zero are counted, but never passed on
+	size_t positionCount = m_positions.size();
+	size_t texCoordCount = m_texCoords.size();
+	size_t normalCount = m_normals.size();
+	size_t cornerCount = 0;
+	size_t windowCount = 0;
+
+	windowSize = std::max(windowSize, size_t(1));
+
+	while (begin < end)
+	{
+		// windows always end at the end of a line
+		const char * windowEnd = end;
+
+		if (size_t(end - begin) > windowSize)
+		{
+			const char * lineEnd = static_cast<const char*>(std::memchr(begin + windowSize, '\n', end - begin - windowSize));
+			windowEnd = lineEnd ? lineEnd + 1 : end;
+		}
+
+		ObjChunk chunk;
+		chunk.parse(begin, windowEnd);
+
+		for (auto slot : chunk.positionFixups)
+			chunk.corners.positionIndices[slot] += (unsigned int)(positionCount - 1);
+
+		for (auto slot : chunk.texCoordFixups)
+			chunk.corners.texCoordIndices[slot] += (unsigned int)(texCoordCount - 1);
+
+		for (auto slot : chunk.normalFixups)
+			chunk.corners.normalIndices[slot] += (unsigned int)(normalCount - 1);
+
+		// the directives see the number of corners before them, as if all corners were kept
+		for (const auto & d : chunk.directives)
+		{
+			m_streamedCorners = cornerCount + d.cornerOffset;
+
+			switch (d.type)
+			{
+			case ObjChunk::DirectiveType::MaterialLibrary:
+				loadMaterialLibraries(d.argument);
+				break;
+
+			case ObjChunk::DirectiveType::UseMaterial:
+				useMaterial(d.argument);
+				break;
+
+			case ObjChunk::DirectiveType::Group:
+				beginGroup(d.argument);
+				break;
+			}
+		}
+
+		if (!callback(ObjWindow{ chunk.positions, chunk.normals, chunk.texCoords, chunk.corners, cornerCount }))
+			return false;
+
+		positionCount += chunk.positions.size();
+		texCoordCount += chunk.texCoords.size();
+		normalCount += chunk.normals.size();
+		cornerCount += chunk.corners.size();
+		m_streamedCorners = cornerCount;
+		windowCount++;
+		begin = windowEnd;
+	}
+
+	loadDefaultMaterialLibrary();
+
+	auto parseEnd = std::chrono::steady_clock::now();
+	const double parseSeconds = std::chrono::duration<double>(parseEnd - parseStart).count();
+	const double megabytes = double(file.size()) / (1024.0 * 1024.0);
+
+	globjects::debug() << "Streamed " << megabytes << " MB in " << windowCount << " windows in " << parseSeconds << " s (" << (parseSeconds > 0.0 ? megabytes / parseSeconds : 0.0) << " MB/s)";
+
+	return true;
+}
+
+void ObjLoader::mergeChunk(ObjChunk & chunk)
+{
+	// the first chunk holds the dummy elements, so it can simply be moved
+	const size_t positionOffset = m_positions.empty() ? 0 : m_positions.size() - 1;
+	const size_t texCoordOffset = m_texCoords.empty() ? 0 : m_texCoords.size() - 1;
+	const size_t normalOffset = m_normals.empty() ? 0 : m_normals.size() - 1;
+
+	if (m_positions.empty())
+		m_positions.swap(chunk.positions);
+	else
+		m_positions.insert(m_positions.end(), chunk.positions.begin(), chunk.positions.end());
+
+	if (m_texCoords.empty())
+		m_texCoords.swap(chunk.texCoords);
+	else
+		m_texCoords.insert(m_texCoords.end(), chunk.texCoords.begin(), chunk.texCoords.end());
+
+	if (m_normals.empty())
+		m_normals.swap(chunk.normals);
+	else
+		m_normals.insert(m_normals.end(), chunk.normals.begin(), chunk.normals.end());
+
+	for (auto slot : chunk.positionFixups)
+		chunk.corners.positionIndices[slot] += (unsigned int)positionOffset;
+
+	for (auto slot : chunk.texCoordFixups)
+		chunk.corners.texCoordIndices[slot] += (unsigned int)texCoordOffset;
+
+	for (auto slot : chunk.normalFixups)
+		chunk.corners.normalIndices[slot] += (unsigned int)normalOffset;
+
+	size_t cornerBegin = 0;
+
+	for (const auto & d : chunk.directives)
+	{
+		m_corners.append(chunk.corners, cornerBegin, d.cornerOffset);
+		cornerBegin = d.cornerOffset;
+
+		switch (d.type)
+		{
+		case ObjChunk::DirectiveType::MaterialLibrary:
+			loadMaterialLibraries(d.argument);
+			break;
+
+		case ObjChunk::DirectiveType::UseMaterial:
+			useMaterial(d.argument);
+			break;
+
+		case ObjChunk::DirectiveType::Group:
+			beginGroup(d.argument);
+			break;
+		}
+	}
+
+	m_corners.append(chunk.corners, cornerBegin, chunk.corners.size());
+}
+
+void ObjLoader::loadMaterialLibraries(std::string_view libraryNames)
+{
+	// the Wavefront obj specification does not really allow for spaces in the mtl file name,
+	// since multiple libraries are supposed to be separated by spaces, but many programs
+	// do not take care of that -- therefore, we first try whether it is a single filename,
+	// and only if that fails we use the interpretation according to the specification
+	std::string libraryName(trimView(libraryNames));
+	std::filesystem::path libraryPath = libraryName;
+
+	// first try
+	if (libraryPath.is_absolute())
+	{
+		if (loadMtlFile(libraryPath.string(), m_objMaterials, m_materialMap))
+			return;
+	}
+
+	std::stringstream mss(libraryName);
+
+	while (mss >> libraryName)
+	{
+		libraryName = trim(libraryName);
+		std::filesystem::path libraryPath = m_path.parent_path();
+		libraryPath.append(libraryName);
+		loadMtlFile(libraryPath.string(), m_objMaterials, m_materialMap);
+	}
+}
+
+void ObjLoader::useMaterial(std::string_view materialName)
+{
+	const std::pmr::string name(trimView(materialName), &m_arena);
+	auto j = m_materialNameMap.find(name);
+
+	if (j == m_materialNameMap.end())
+	{
+		j = m_materialNameMap.insert(std::make_pair(name, std::uint32_t(m_materialNames.size()))).first;
+		m_materialNames.push_back(name);
+	}
+
+	m_currentMaterial = j->second;
+	m_objGroups[m_currentGroup].material = m_currentMaterial;
+}
+
+void ObjLoader::beginGroup(std::string_view groupName)
+{
+	const std::string_view name = trimView(groupName);
+
+	// only the default group is ever continued, other groups with the same name remain separate groups
+	if (name == this->groupName(m_objGroups.front()))
+	{
+		m_currentGroup = 0;
+	}
+	else
+	{
+		ObjGroup newGroup;
+		newGroup.nameOffset = std::uint32_t(m_groupNames.size());
+		newGroup.nameLength = std::uint32_t(name.size());
+		m_groupNames.append(name.data(), name.size());
+
+		m_currentGroup = std::uint32_t(m_objGroups.size());
+		m_objGroups.push_back(newGroup);
+	}
+
+	m_objGroups[m_currentGroup].material = m_currentMaterial;
+
+	// groups without any faces do not need a run of their own
+	const size_t cornerCount = m_corners.size() + m_streamedCorners;
+
+	if (m_groupRuns.back().cornerBegin == cornerCount)
+		m_groupRuns.back().group = m_currentGroup;
+	else
+		m_groupRuns.push_back({ m_currentGroup, cornerCount });
+}
+
+void ObjLoader::finishGroups()
+{
+	// counting sort of the runs by group, which keeps the order of the corners within each group
+	std::pmr::vector<size_t> groupOffsets(m_objGroups.size() + 1, 0, &m_arena);
+
+	for (size_t i = 0; i < m_groupRuns.size(); i++)
+	{
+		const size_t runEnd = i + 1 < m_groupRuns.size() ? m_groupRuns[i + 1].cornerBegin : m_corners.size();
+		groupOffsets[m_groupRuns[i].group + 1] += runEnd - m_groupRuns[i].cornerBegin;
+	}
+
+	for (size_t i = 0; i < m_objGroups.size(); i++)
+	{
+		groupOffsets[i + 1] += groupOffsets[i];
+		m_objGroups[i].cornerBegin = groupOffsets[i];
+		m_objGroups[i].cornerEnd = groupOffsets[i + 1];
+	}
+
+	// usually every group is a single run and they are already in order
+	bool sorted = true;
+
+	for (size_t i = 0; i < m_groupRuns.size() && sorted; i++)
+	{
+		if (m_groupRuns[i].cornerBegin != groupOffsets[m_groupRuns[i].group])
+			sorted = false;
+
+		const size_t runEnd = i + 1 < m_groupRuns.size() ? m_groupRuns[i + 1].cornerBegin : m_corners.size();
+		groupOffsets[m_groupRuns[i].group] += runEnd - m_groupRuns[i].cornerBegin;
+	}
+
+	if (!sorted)
+	{
+		for (size_t i = 0; i < m_objGroups.size(); i++)
+			groupOffsets[i] = m_objGroups[i].cornerBegin;
+
+		ObjCorners sortedCorners(&m_arena);
+		sortedCorners.resize(m_corners.size());
+
+		for (size_t i = 0; i < m_groupRuns.size(); i++)
+		{
+			const size_t runBegin = m_groupRuns[i].cornerBegin;
+			const size_t runEnd = i + 1 < m_groupRuns.size() ? m_groupRuns[i + 1].cornerBegin : m_corners.size();
+			size_t & target = groupOffsets[m_groupRuns[i].group];
+
+			std::copy(m_corners.positionIndices.begin() + runBegin, m_corners.positionIndices.begin() + runEnd, sortedCorners.positionIndices.begin() + target);
+			std::copy(m_corners.normalIndices.begin() + runBegin, m_corners.normalIndices.begin() + runEnd, sortedCorners.normalIndices.begin() + target);
+			std::copy(m_corners.texCoordIndices.begin() + runBegin, m_corners.texCoordIndices.begin() + runEnd, sortedCorners.texCoordIndices.begin() + target);
+			target += runEnd - runBegin;
+		}
+
+		m_corners = std::move(sortedCorners);
+	}
+
+	m_groupRuns.clear();
+	m_groupRuns.shrink_to_fit();
+}
+
+std::string_view ObjLoader::groupName(const ObjGroup & group) const
+{
+	return std::string_view(m_groupNames.data() + group.nameOffset, group.nameLength);
+}
+
+bool ObjLoader::loadMtlFile(const std::string & filename, std::vector<ObjMaterial> & materials, std::unordered_map< std::string, int > & materialMap)
+{
+	// libraries which do not exist are also recorded, since creating them changes the result
+	m_materialLibraries.push_back(filename);
+
+	LoadStatistics::Scope mtlScope(m_statistics, "mtl file");
+	const std::size_t materialCount = materials.size();
+
+	std::ifstream is(filename);
+
+	if (!is.is_open())
+		return false;
+
+	std::string buffer;
+	int currentMaterialIndex = 0;
+
+	while (is.good())
+	{
+		if (getline(is, buffer))
+		{
+			std::istringstream iss(buffer);
+			std::string token;
+
+			if (iss >> token)
+			{
+				if (token == "newmtl")
+				{
+					std::string materialName;
+
+					if (getline(iss, materialName))
+					{
+						materialName = trim(materialName);
+
+						auto i = materialMap.find(materialName);
+
+						if (i == materialMap.end())
+						{
+							ObjMaterial newMaterial;
+							newMaterial.name = materialName;
+							currentMaterialIndex = materials.size();
+							materialMap.insert(std::make_pair(newMaterial.name, currentMaterialIndex));
+							materials.push_back(newMaterial);
+						}
+						else
+						{
+							currentMaterialIndex = i->second;
+						}
+					}
+				}
+				// Ambient Color
+				else if (token == "Ka")
+				{
+					vec3 Ka(0.0f);
+					if (iss >> Ka.x >> Ka.y >> Ka.z)
+						materials[currentMaterialIndex].Ka = Ka;
+				}
+				// Diffuse Color
+				else if (token == "Kd")
+				{
+					vec3 Kd(0.0f);
+					if (iss >> Kd.x >> Kd.y >> Kd.z)
+						materials[currentMaterialIndex].Kd = Kd;
+				}
+				// Specular Color
+				else if (token == "Ks")
+				{
+					vec3 Ks(0.0f);
+					if (iss >> Ks.x >> Ks.y >> Ks.z)
+						materials[currentMaterialIndex].Ks = Ks;
+				}
+				// Specular Exponent
+				else if (token == "Ns")
+				{
+					float Ns = 0.0f;
+					if (iss >> Ns)
+						materials[currentMaterialIndex].Ns = Ns;
+				}
+				// Dissolve
+				else if (token == "d")
+				{
+					float d = 0.0f;
+					if (iss >> d)
+						materials[currentMaterialIndex].d = d;
+				}
+				// Illumination
+				else if (token == "illum")
+				{
+					int illum = 0;
+					if (iss >> illum)
+						materials[currentMaterialIndex].illum = illum;
+				}
+				// Ambient Texture Map
+				else if (token == "map_Ka")
+				{
+					std::string map_Ka;
+					if (getline(iss, map_Ka))
+					{
+						map_Ka = trim(map_Ka);
+						materials[currentMaterialIndex].map_Ka = map_Ka;
+					}
+				}
+				// Diffuse Texture Map
+				else if (token == "map_Kd")
+				{
+					std::string map_Kd;
+					if (getline(iss, map_Kd))
+					{
+						map_Kd = trim(map_Kd);
+						materials[currentMaterialIndex].map_Kd = map_Kd;
+					}
+				}
+				// Specular Texture Map
+				else if (token == "map_Ks")
+				{
+					std::string map_Ks;
+					if (getline(iss, map_Ks))
+					{
+						map_Ks = trim(map_Ks);
+						materials[currentMaterialIndex].map_Ks = map_Ks;
+					}
+				}
+				// Specular Hightlight Map
+				else if (token == "map_Ns")
+				{
+					std::string map_Ns;
+					if (getline(iss, map_Ns))
+					{
+						map_Ns = trim(map_Ns);
+						materials[currentMaterialIndex].map_Ns = map_Ns;
+					}
+				}
+				// Alpha Texture Map
+				else if (token == "map_d")
+				{
+					std::string map_d;
+					if (getline(iss, map_d))
+					{
+						map_d = trim(map_d);
+						materials[currentMaterialIndex].map_d = map_d;
+					}
+				}
+				// Bump Map
+				else if (token == "map_bump" || buffer == "map_Bump" || buffer == "bump")
+				{
+					std::string map_bump;
+					if (getline(iss, map_bump))
+					{
+						map_bump = trim(map_bump);
+						materials[currentMaterialIndex].map_bump = map_bump;
+					}
+				}
+				// Object Space Normal Map
+				else if (token == "map_ObjectNormals")
+				{
+					std::string map_objectSpaceNormals;
+					if (getline(iss, map_objectSpaceNormals))
+					{
+						map_objectSpaceNormals = trim(map_objectSpaceNormals);
+						materials[currentMaterialIndex].map_objectSpaceNormals = map_objectSpaceNormals;
+					}
+				}
+				// Tangent Space Normal Map
+				else if (token == "map_TangentNormals")
+				{
+					std::string map_tangentSpaceNormals;
+					if (getline(iss, map_tangentSpaceNormals))
+					{
+						map_tangentSpaceNormals = trim(map_tangentSpaceNormals);
+						materials[currentMaterialIndex].map_tangentSpaceNormals = map_tangentSpaceNormals;
+					}
+				}
+			}
+		}
+	}
+
+	// the images are decoded while the rest of the file is loaded
+	prefetchTextures(materials);
+
+	std::error_code error;
+	const std::uintmax_t fileSize = std::filesystem::file_size(filename, error);
+	mtlScope.add(error ? 0 : fileSize, materials.size() - materialCount);
+
+	return true;
+}
+
+std::shared_ptr<Texture> ObjLoader::loadTexture(const std::string & filename, TextureLoader::Usage usage)
+{
+	if (!m_options.loadTextures)
+		return std::shared_ptr<Texture>();
+
+	// decoding in the background is not part of the phase, only the request
+	LoadStatistics::Scope textureScope(m_statistics, m_textureLoader ? "texture request" : "texture");
+
+	std::error_code error;
+	const std::uintmax_t fileSize = std::filesystem::file_size(filename, error);
+	textureScope.add(error ? 0 : fileSize, 1);
+
+	if (m_textureLoader)
+		return m_textureLoader->texture(filename, usage);
+
+	return TextureLoader::load(filename, usage, m_options);
+}
+
+std::string ObjLoader::texturePath(const std::string & mapName) const
+{
+	std::filesystem::path texturePath = mapName;
+
+	if (!texturePath.is_absolute())
+	{
+		texturePath = m_path.parent_path();
+		texturePath.append(mapName);
+	}
+
+	return texturePath.string();
+}
+
+void ObjLoader::prefetchTextures(const std::vector<ObjMaterial> & materials)
+{
+	if (!m_options.loadTextures || !m_textureLoader)
+		return;
+
+	for (auto & map : textureMaps(materials))
+		m_textureLoader->prefetch(map.first, map.second);
+}
+
+std::vector< std::pair<std::string, TextureLoader::Usage> > ObjLoader::textureMaps(const std::vector<ObjMaterial> & materials) const
+{
+	using Usage = TextureLoader::Usage;
+
+	std::vector< std::pair<std::string, Usage> > textureMaps;
+
+	for (auto & m : materials)
+	{
+		const std::pair<const std::string*, Usage> maps[] = {
+			{ &m.map_Ka, Usage::Color }, { &m.map_Kd, Usage::Color }, { &m.map_Ks, Usage::Color }, { &m.map_Ns, Usage::Data }, { &m.map_bump, Usage::Data },
+			{ &m.map_objectSpaceNormals, Usage::ObjectSpaceNormal }, { &m.map_tangentSpaceNormals, Usage::TangentSpaceNormal }
+		};
+
+		for (auto & map : maps)
+		{
+			if (!map.first->empty())
+				textureMaps.emplace_back(texturePath(*map.first), map.second);
+		}
+	}
+
+	return textureMaps;
+}
+
+const std::vector<Group> & ObjLoader::groups() const
+{
+	return m_groups;
+}
+
+const std::vector<Vertex> & ObjLoader::vertices() const
+{
+	return m_vertices;
+}
+
+const std::vector<uint> & ObjLoader::indices() const
+{
+	return m_indices;
+}
+
+const std::vector<Material> & ObjLoader::materials() const
+{
+	return m_materials;
+}
+
+const std::vector<ObjLoader::ObjMaterial> & ObjLoader::objMaterials() const
+{
+	return m_objMaterials;
+}
+
+const std::pmr::vector<ObjLoader::ObjGroup> & ObjLoader::objGroups() const
+{
+	return m_objGroups;
+}
+
+const std::pmr::vector<ObjLoader::ObjGroupRun> & ObjLoader::groupRuns() const
+{
+	return m_groupRuns;
+}
+
+std::vector<uint> ObjLoader::materialIndices() const
+{
+	std::vector<uint> indices(m_materialNames.size(), 0);
+
+	for (size_t i = 0; i < m_materialNames.size(); i++)
+	{
+		auto j = m_materialMap.find(std::string(m_materialNames[i]));
+
+		if (j != m_materialMap.end())
+			indices[i] = j->second;
+	}
+
+	return indices;
+}
+
+const std::vector<std::string> & ObjLoader::materialLibraries() const
+{
+	return m_materialLibraries;
+}
+
+ArenaResource::Statistics ObjLoader::arenaStatistics() const
+{
+	ArenaResource::Statistics statistics = m_arena.statistics();
+	statistics.allocations += m_chunkStatistics.allocations;
+	statistics.blocks += m_chunkStatistics.blocks;
+	statistics.blockBytes += m_chunkStatistics.blockBytes;
+	statistics.largeAllocations += m_chunkStatistics.largeAllocations;
+	statistics.largeBytes += m_chunkStatistics.largeBytes;
+	return statistics;
+}
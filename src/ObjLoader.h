@@ -0,0 +1,213 @@
+#pragma once
+
+#include "Model.h"
+#include "ArenaResource.h"
+#include "TextureLoader.h"
+#include "LoadStatistics.h"
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <filesystem>
+#include <functional>
+#include <memory_resource>
+#include <unordered_map>
+#include <vector>
+
+namespace minity
+{
+	class ObjLoader
+	{
+	public:
+
+		// face corners of all groups in one table, with the three indices of a corner in separate arrays
+		struct ObjCorners
+		{
+			ObjCorners(std::pmr::memory_resource * resource = std::pmr::get_default_resource());
+
+			std::pmr::vector<unsigned int> positionIndices;
+			std::pmr::vector<unsigned int> normalIndices;
+			std::pmr::vector<unsigned int> texCoordIndices;
+
+			std::size_t size() const;
+			void reserve(std::size_t count);
+			void resize(std::size_t count);
+			void push(unsigned int positionIndex, unsigned int texCoordIndex, unsigned int normalIndex);
+			void append(const ObjCorners & source, std::size_t begin, std::size_t end);
+		};
+
+		// once parsing is finished, the corners of a group are the range [cornerBegin, cornerEnd) of the corner table,
+		// names are kept in a shared pool so that groups do not allocate
+		struct ObjGroup
+		{
+			std::uint32_t nameOffset = 0;
+			std::uint32_t nameLength = 0;
+			// index into the names used with usemtl
+			std::uint32_t material = 0;
+			std::size_t cornerBegin = 0;
+			std::size_t cornerEnd = 0;
+		};
+
+		// while parsing, a new run of corners starts whenever the current group changes
+		struct ObjGroupRun
+		{
+			std::uint32_t group;
+			std::size_t cornerBegin;
+		};
+
+		// the attributes and triangulated corners of one window of a file passed on by streamObjFile, the indices
+		// are absolute and count from one like in the file, index zero refers to the defaults
+		struct ObjWindow
+		{
+			const std::pmr::vector<glm::vec3> & positions;
+			const std::pmr::vector<glm::vec3> & normals;
+			const std::pmr::vector<glm::vec2> & texCoords;
+			const ObjCorners & corners;
+			// number of corners in all windows before this one
+			std::size_t cornerOffset;
+		};
+
+		struct ObjMaterial
+		{
+			// Material Name
+			std::string name;
+			// Ambient Color
+			glm::vec3 Ka = glm::vec3(0.2f,0.2f,0.2f);
+			// Diffuse Color
+			glm::vec3 Kd = glm::vec3(0.8f,0.8f,0.8f);
+			// Specular Color
+			glm::vec3 Ks = glm::vec3(1.0f,1.0f,1.0f);
+			// Specular Exponent
+			float Ns = 0.0f;
+			// Dissolve
+			float d = 1.0f;
+			// Illumination
+			int illum = 0;
+			// Ambient Texture Map
+			std::string map_Ka;
+			// Diffuse Texture Map
+			std::string map_Kd;
+			// Specular Texture Map
+			std::string map_Ks;
+			// Specular Hightlight Map
+			std::string map_Ns;
+			// Alpha Texture Map
+			std::string map_d;
+			// Bump Map
+			std::string map_bump;
+			// Object Space Normal Map
+			std::string map_objectSpaceNormals;
+			// Tanget Space Normal Map
+			std::string map_tangentSpaceNormals;
+		};
+
+		// with a texture loader, images are decoded in the background and the textures are filled in by its update(),
+		// otherwise they are loaded synchronously, with statistics the phases of loading are recorded in them
+		ObjLoader(const LoadOptions & options = LoadOptions(), TextureLoader * textureLoader = nullptr, LoadStatistics * statistics = nullptr);
+
+		ObjLoader(const ObjLoader &) = delete;
+		ObjLoader & operator=(const ObjLoader &) = delete;
+
+		bool loadObjFile(const std::string & filename);
+
+		// only fills the intermediate representation, without building vertices or loading materials
+		bool parseObjFile(const std::string & filename);
+
+		// parses the file in windows of about windowSize bytes, which are passed to the callback and released instead
+		// of being collected, so that memory does not grow with the file -- groups, group runs and materials are still
+		// collected, the corners of a group are found through the runs, parsing stops if the callback returns false
+		bool streamObjFile(const std::string & filename, std::size_t windowSize, const std::function<bool(const ObjWindow &)> & callback);
+
+		// hash over the intermediate representation, for comparing the output of different parsers
+		std::uint64_t parseChecksum() const;
+
+		// replaces the normals of the intermediate representation with smooth vertex normals if the file had none,
+		// called by loadObjFile after parsing, returns false if the file had normals
+		bool generateNormals();
+
+		bool loadMtlFile(const std::string & filename, std::vector<ObjMaterial> & materials, std::unordered_map< std::string, int > & materialMap);
+		std::shared_ptr<globjects::Texture> loadTexture(const std::string & filename, TextureLoader::Usage usage = TextureLoader::Usage::Color);
+
+		// converts the materials and loads their textures, relative texture paths are resolved against filename
+		void createMaterials(const std::string & filename, const std::vector<ObjMaterial> & objMaterials);
+
+		const std::vector<Group> & groups() const;
+		const std::vector<Vertex> & vertices() const;
+		const std::vector<glm::uint> & indices() const;
+		const std::vector<Material> & materials() const;
+
+		const std::vector<ObjMaterial> & objMaterials() const;
+		const std::pmr::vector<ObjGroup> & objGroups() const;
+		// only kept after streamObjFile, the runs are in file order
+		const std::pmr::vector<ObjGroupRun> & groupRuns() const;
+		std::string_view groupName(const ObjGroup & group) const;
+		// the index into objMaterials() of every material name used in the file
+		std::vector<glm::uint> materialIndices() const;
+		// resolved paths of all maps of the materials with the usage they are loaded with, maps may be listed more than once
+		std::vector< std::pair<std::string, TextureLoader::Usage> > textureMaps(const std::vector<ObjMaterial> & materials) const;
+		// all material libraries the loader tried to open, including those which did not exist
+		const std::vector<std::string> & materialLibraries() const;
+
+		// summed over the loader's arena and the arenas of all parsed chunks
+		ArenaResource::Statistics arenaStatistics() const;
+
+	private:
+
+		// the parsers only fill the intermediate representation below, everything else is shared
+		bool parseObjStream(const std::string & filename);
+		bool parseObjMapped(const std::string & filename);
+
+		// the mapped parsers split the file into chunks which are parsed independently and merged in order
+		struct ObjChunk;
+
+		void mergeChunk(ObjChunk & chunk);
+		void loadMaterialLibraries(std::string_view libraryNames);
+		void useMaterial(std::string_view materialName);
+		void beginGroup(std::string_view groupName);
+
+		// sets up the defaults at index zero, the default material and the default group
+		void beginParse(const std::string & filename);
+		// loads the library with the name of the file if no other library was found
+		void loadDefaultMaterialLibrary();
+		// sorts the corners by group if a group was continued later in the file and sets the group ranges
+		void finishGroups();
+
+		// resolves relative texture paths against the directory of the loaded file
+		std::string texturePath(const std::string & mapName) const;
+		void prefetchTextures(const std::vector<ObjMaterial> & materials);
+
+		LoadOptions m_options;
+		TextureLoader * m_textureLoader = nullptr;
+		LoadStatistics * m_statistics = nullptr;
+		std::filesystem::path m_path;
+
+		// all intermediate data lives in an arena, which is released at once with the loader
+		ArenaResource m_arena;
+		ArenaResource::Statistics m_chunkStatistics;
+
+		std::pmr::vector< glm::vec3 > m_positions;
+		std::pmr::vector< glm::vec3 > m_normals;
+		std::pmr::vector< glm::vec2 > m_texCoords;
+
+		std::unordered_map< std::string, int > m_materialMap;
+		std::vector<ObjMaterial> m_objMaterials;
+		std::vector<std::string> m_materialLibraries;
+
+		std::pmr::vector<std::pmr::string> m_materialNames;
+		std::pmr::unordered_map< std::pmr::string, std::uint32_t > m_materialNameMap;
+		std::uint32_t m_currentMaterial = 0;
+
+		ObjCorners m_corners;
+		// corners passed on by streamObjFile instead of being kept
+		std::size_t m_streamedCorners = 0;
+		std::pmr::vector<ObjGroup> m_objGroups;
+		std::pmr::vector<ObjGroupRun> m_groupRuns;
+		std::pmr::string m_groupNames;
+		std::uint32_t m_currentGroup = 0;
+
+		std::vector < Group > m_groups;
+		std::vector < Vertex > m_vertices;
+		std::vector < glm::uint > m_indices;
+		std::vector < Material > m_materials;
+	};
+}
\ No newline at end of file
@@ -0,0 +1,291 @@
+#include "OcclusionCuller.h"
+#include "IndirectDrawBuffer.h"
+
+#include <globjects/globjects.h>
+
+#include <algorithm>
+
+using namespace minity;
+using namespace gl;
+using namespace glm;
+using namespace globjects;
+
+namespace
+{
+	int nextPowerOfTwo(int value)
+	{
+		int power = 1;
+
+		while (power < value)
+			power *= 2;
+
+		return power;
+	}
+}
+
+OcclusionCuller::OcclusionCuller(const std::vector<Meshlet> & meshlets, const std::vector<Group> & groups, IndirectDrawBuffer & indirectDraws) : m_indirectDraws(indirectDraws)
+{
+	const std::size_t runCount = indirectDraws.runs().size();
+
+	// every run gets as many slots as it has meshlets, so that it can draw all of them in one phase
+	m_runCapacities.assign(runCount, 0);
+	m_runSlots.assign(runCount, 0);
+
+	for (std::size_t g = 0; g < groups.size(); g++)
+		m_runCapacities[indirectDraws.commandRun(indirectDraws.groupCommand(g))] += groups[g].meshletCount;
+
+	for (std::size_t r = 1; r < runCount; r++)
+		m_runSlots[r] = m_runSlots[r - 1] + m_runCapacities[r - 1];
+
+	std::vector<MeshletData> data(meshlets.size());
+
+	for (std::size_t g = 0; g < groups.size(); g++)
+	{
+		const Group & group = groups[g];
+		const std::size_t command = indirectDraws.groupCommand(g);
+		const std::size_t run = indirectDraws.commandRun(command);
+
+		for (uint m = group.firstMeshlet; m < group.firstMeshlet + group.meshletCount; m++)
+		{
+			MeshletData & d = data[m];
+			d.sphere = vec4(meshlets[m].center, meshlets[m].radius);
+			d.firstIndex = uint(group.indexOffset / group.indexSize()) + meshlets[m].firstIndex;
+			d.indexCount = meshlets[m].indexCount;
+			d.baseVertex = GLint(group.baseVertex);
+			d.draw = uint(command);
+			d.run = uint(run);
+			d.firstSlot = uint(m_runSlots[run]);
+
+			m_triangleCount += meshlets[m].indexCount / 3;
+		}
+	}
+
+	m_meshletCount = meshlets.size();
+
+	// empty storage is not allowed
+	const std::size_t slots = std::max<std::size_t>(1, m_meshletCount);
+
+	if (data.empty())
+		data.resize(1);
+
+	m_meshletBuffer->setStorage(data, GL_NONE_BIT);
+	m_commandBuffer->setStorage(GLsizeiptr(2 * slots * sizeof(IndirectDrawBuffer::DrawElementsIndirectCommand)), nullptr, GL_NONE_BIT);
+	m_countBuffer->setStorage(GLsizeiptr(2 * std::max<std::size_t>(1, runCount) * sizeof(uint)), nullptr, GL_NONE_BIT);
+	m_stateBuffer->setStorage(GLsizeiptr(slots * sizeof(uint)), nullptr, GL_NONE_BIT);
+
+	for (auto & buffer : m_statisticsBuffers)
+		buffer->setStorage(std::vector<uint>(statisticsCount, 0), GL_NONE_BIT);
+
+	m_indirectParameters = globjects::hasExtension(GLextension::GL_ARB_indirect_parameters);
+
+	m_statistics.meshlets = m_meshletCount;
+	m_statistics.triangles = m_triangleCount;
+}
+
+bool OcclusionCuller::supported()
+{
+	return IndirectDrawBuffer::supported() && globjects::hasExtension(GLextension::GL_ARB_compute_shader);
+}
+
+void OcclusionCuller::cull(Program & cullProgram, Phase phase, const mat4 & modelViewProjectionMatrix, float explosion, bool occlusionCulling)
+{
+	if (phase == Phase::Early)
+	{
+		readStatistics();
+		m_frame++;
+
+		m_statisticsBuffers[m_frame % 2]->clearData(GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, nullptr);
+		m_countBuffer->clearData(GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, nullptr);
+
+		// without the counts in a buffer all slots are drawn, the ones nothing was written to have to be empty
+		if (!m_indirectParameters)
+			m_commandBuffer->clearData(GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, nullptr);
+
+		m_statistics.drawCalls = 0;
+
+		// a pyramid left from before occlusion culling was disabled does not show the current frame
+		if (!occlusionCulling)
+			m_pyramidValid = false;
+
+		m_lateCulling = occlusionCulling && m_pyramidValid;
+	}
+	else if (!m_lateCulling || !m_pyramidValid)
+	{
+		return;
+	}
+
+	if (m_meshletCount == 0)
+		return;
+
+	cullProgram.setUniform("modelViewProjectionMatrix", modelViewProjectionMatrix);
+	cullProgram.setUniform("pyramidMatrix", m_pyramidMatrix);
+	cullProgram.setUniform("explosion", explosion);
+	cullProgram.setUniform("phase", phase == Phase::Early ? 0 : 1);
+	cullProgram.setUniform("occlusionCulling", occlusionCulling);
+	cullProgram.setUniform("depthPyramid", 0);
+	cullProgram.setUniform("viewportSize", m_viewportSize);
+	cullProgram.setUniform("pyramidLevels", m_pyramidValid ? m_pyramidLevels : 0);
+	cullProgram.setUniform("meshletCount", uint(m_meshletCount));
+	cullProgram.setUniform("runCount", uint(m_runSlots.size()));
+
+	if (m_pyramidValid)
+		m_pyramidTexture->bindActive(0);
+
+	m_meshletBuffer->bindBase(GL_SHADER_STORAGE_BUFFER, meshletBinding);
+	m_commandBuffer->bindBase(GL_SHADER_STORAGE_BUFFER, commandBinding);
+	m_indirectDraws.drawBuffer().bindBase(GL_SHADER_STORAGE_BUFFER, IndirectDrawBuffer::drawBinding);
+	m_countBuffer->bindBase(GL_SHADER_STORAGE_BUFFER, countBinding);
+	m_stateBuffer->bindBase(GL_SHADER_STORAGE_BUFFER, stateBinding);
+	m_statisticsBuffers[m_frame % 2]->bindBase(GL_SHADER_STORAGE_BUFFER, statisticsBinding);
+	m_indirectDraws.commandBuffer().bindBase(GL_SHADER_STORAGE_BUFFER, groupCommandBinding);
+
+	cullProgram.use();
+	cullProgram.dispatchCompute(GLuint((m_meshletCount + 63) / 64), 1, 1);
+	cullProgram.release();
+
+	for (GLuint binding : { meshletBinding, commandBinding, IndirectDrawBuffer::drawBinding, countBinding, stateBinding, statisticsBinding, groupCommandBinding })
+		Buffer::unbind(GL_SHADER_STORAGE_BUFFER, binding);
+
+	if (m_pyramidValid)
+		m_pyramidTexture->unbindActive(0);
+
+	// the commands and counts are read by the draws, the states by the late phase
+	glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT);
+}
+
+void OcclusionCuller::draw(Program & program, const VertexArray & vertexArray, const std::vector<Material> & materials, bool bindless, Phase phase)
+{
+	if (m_meshletCount == 0 || (phase == Phase::Late && !m_lateCulling))
+		return;
+
+	const std::vector<IndirectDrawBuffer::Run> & runs = m_indirectDraws.runs();
+	const std::size_t phaseIndex = phase == Phase::Early ? 0 : 1;
+
+	m_indirectDraws.beginRuns(program, materials, bindless);
+	m_commandBuffer->bind(GL_DRAW_INDIRECT_BUFFER);
+
+	if (m_indirectParameters)
+		m_countBuffer->bind(GL_PARAMETER_BUFFER_ARB);
+
+	for (std::size_t r = 0; r < runs.size(); r++)
+	{
+		if (m_runCapacities[r] == 0)
+			continue;
+
+		m_indirectDraws.bindRunTextures(r, materials);
+
+		const std::size_t offset = (phaseIndex * m_meshletCount + m_runSlots[r]) * sizeof(IndirectDrawBuffer::DrawElementsIndirectCommand);
+
+		if (m_indirectParameters)
+			glMultiDrawElementsIndirectCountARB(GL_TRIANGLES, runs[r].type, reinterpret_cast<const void*>(offset), GLintptr((phaseIndex * runs.size() + r) * sizeof(uint)), GLsizei(m_runCapacities[r]), 0);
+		else
+			vertexArray.multiDrawElementsIndirect(GL_TRIANGLES, runs[r].type, reinterpret_cast<const void*>(offset), GLsizei(m_runCapacities[r]), 0);
+
+		m_statistics.drawCalls++;
+	}
+
+	if (m_indirectParameters)
+		Buffer::unbind(GL_PARAMETER_BUFFER_ARB);
+
+	Buffer::unbind(GL_DRAW_INDIRECT_BUFFER);
+	m_indirectDraws.endRuns();
+}
+
+void OcclusionCuller::buildPyramid(Program & pyramidProgram, const ivec2 & viewportSize, const mat4 & modelViewProjectionMatrix)
+{
+	if (viewportSize.x <= 0 || viewportSize.y <= 0)
+		return;
+
+	if (viewportSize != m_viewportSize || !m_pyramidTexture)
+	{
+		m_viewportSize = viewportSize;
+
+		// the format of the default framebuffer, so that its depth can be blitted
+		m_depthTexture = Texture::create(GL_TEXTURE_2D);
+		m_depthTexture->setParameter(GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		m_depthTexture->setParameter(GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		m_depthTexture->storage2D(1, GL_DEPTH24_STENCIL8, viewportSize);
+
+		m_depthFramebuffer = Framebuffer::create();
+		m_depthFramebuffer->attachTexture(GL_DEPTH_STENCIL_ATTACHMENT, m_depthTexture.get(), 0);
+
+		// padded to powers of two, so that each texel covers exactly the 2x2 texels below it and every pixel is in the
+		// texel at its coordinates shifted by the level
+		m_pyramidSize = ivec2(nextPowerOfTwo(viewportSize.x), nextPowerOfTwo(viewportSize.y));
+		m_pyramidLevels = 1;
+
+		while ((std::max(m_pyramidSize.x, m_pyramidSize.y) >> (m_pyramidLevels - 1)) > 1)
+			m_pyramidLevels++;
+
+		m_pyramidTexture = Texture::create(GL_TEXTURE_2D);
+		m_pyramidTexture->setParameter(GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+		m_pyramidTexture->setParameter(GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		m_pyramidTexture->setParameter(GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		m_pyramidTexture->setParameter(GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		m_pyramidTexture->setParameter(GL_TEXTURE_BASE_LEVEL, 0);
+		m_pyramidTexture->setParameter(GL_TEXTURE_MAX_LEVEL, m_pyramidLevels - 1);
+		m_pyramidTexture->storage2D(m_pyramidLevels, GL_R32F, m_pyramidSize);
+
+		m_pyramidValid = false;
+	}
+
+	// multisampled depth is resolved to a value between the nearest and farthest sample
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+	m_depthFramebuffer->bind(GL_DRAW_FRAMEBUFFER);
+	glBlitFramebuffer(0, 0, viewportSize.x, viewportSize.y, 0, 0, viewportSize.x, viewportSize.y, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	pyramidProgram.setUniform("viewportSize", viewportSize);
+	pyramidProgram.setUniform("depthTexture", 0);
+
+	m_depthTexture->bindActive(0);
+	pyramidProgram.use();
+
+	for (int level = 0; level < m_pyramidLevels; level++)
+	{
+		const ivec2 size = max(ivec2(m_pyramidSize.x >> level, m_pyramidSize.y >> level), ivec2(1));
+
+		m_pyramidTexture->bindImageTexture(0, std::max(level - 1, 0), GL_FALSE, 0, GL_READ_ONLY, GL_R32F);
+		m_pyramidTexture->bindImageTexture(1, level, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+
+		pyramidProgram.setUniform("level", level);
+		pyramidProgram.dispatchCompute(GLuint((size.x + 7) / 8), GLuint((size.y + 7) / 8), 1);
+
+		glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+	}
+
+	pyramidProgram.release();
+	m_depthTexture->unbindActive(0);
+
+	// the culling fetches the pyramid through a sampler
+	glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+
+	m_pyramidMatrix = modelViewProjectionMatrix;
+	m_pyramidValid = true;
+}
+
+void OcclusionCuller::invalidatePyramid()
+{
+	m_pyramidValid = false;
+}
+
+const OcclusionCuller::Statistics & OcclusionCuller::statistics() const
+{
+	return m_statistics;
+}
+
+void OcclusionCuller::readStatistics()
+{
+	// written by the previous frame, which has usually finished by now
+	uint values[statisticsCount] = {};
+	m_statisticsBuffers[m_frame % 2]->getSubData(0, GLsizeiptr(sizeof(values)), values);
+
+	m_statistics.frustumCulledMeshlets = values[0];
+	m_statistics.frustumCulledTriangles = values[1];
+	m_statistics.earlyMeshlets = values[2];
+	m_statistics.earlyTriangles = values[3];
+	m_statistics.lateMeshlets = values[4];
+	m_statistics.lateTriangles = values[5];
+	m_statistics.occludedMeshlets = values[6];
+	m_statistics.occludedTriangles = values[7];
+}
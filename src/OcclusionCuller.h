@@ -0,0 +1,139 @@
+#pragma once
+
+#include "Model.h"
+
+#include <glm/glm.hpp>
+#include <glbinding/gl/types.h>
+#include <globjects/Buffer.h>
+#include <globjects/Framebuffer.h>
+#include <globjects/Program.h>
+#include <globjects/Texture.h>
+#include <globjects/VertexArray.h>
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace minity
+{
+	class IndirectDrawBuffer;
+
+	// culls the meshlets on the GPU, a compute shader tests their bounding spheres against the frustum and a hierarchical
+	// depth pyramid and writes the visible ones as indirect commands, compacted into a range of slots per run of the
+	// IndirectDrawBuffer. the first phase tests against the pyramid of the previous frame, the second one tests the
+	// meshlets it found occluded again against a pyramid of what the first phase drew, so that geometry which becomes
+	// visible is drawn in the same frame instead of popping in one frame late
+	class OcclusionCuller
+	{
+	public:
+
+		enum class Phase
+		{
+			// frustum and the pyramid of the previous frame
+			Early,
+			// the meshlets occluded in the early phase against the pyramid of the current frame
+			Late
+		};
+
+		// read back one frame late, so that the culling never waits for the GPU
+		struct Statistics
+		{
+			std::size_t meshlets = 0;
+			std::size_t triangles = 0;
+			std::size_t frustumCulledMeshlets = 0;
+			std::size_t frustumCulledTriangles = 0;
+			std::size_t earlyMeshlets = 0;
+			std::size_t earlyTriangles = 0;
+			std::size_t lateMeshlets = 0;
+			std::size_t lateTriangles = 0;
+			std::size_t occludedMeshlets = 0;
+			std::size_t occludedTriangles = 0;
+			std::size_t drawCalls = 0;
+		};
+
+		// the storage buffer bindings of the culling shader besides the draws of the IndirectDrawBuffer, only eight
+		// are guaranteed, so the ones of the wireframe and the texture handles are reused
+		static constexpr gl::GLuint meshletBinding = 0;
+		static constexpr gl::GLuint commandBinding = 1;
+		static constexpr gl::GLuint countBinding = 3;
+		static constexpr gl::GLuint stateBinding = 4;
+		static constexpr gl::GLuint statisticsBinding = 5;
+		static constexpr gl::GLuint groupCommandBinding = 6;
+
+		OcclusionCuller(const std::vector<Meshlet> & meshlets, const std::vector<Group> & groups, IndirectDrawBuffer & indirectDraws);
+
+		// compute shaders, image load store and indirect draws, the draw counts are read from a buffer if the
+		// context has indirect parameters, otherwise all slots of a run are drawn and the unused ones are empty
+		static bool supported();
+
+		// the early phase starts the frame, groups whose command in the IndirectDrawBuffer has no instances are skipped,
+		// occlusion culling also needs a pyramid, without one all meshlets in the frustum are drawn early
+		void cull(globjects::Program & cullProgram, Phase phase, const glm::mat4 & modelViewProjectionMatrix, float explosion, bool occlusionCulling);
+
+		// the program has to use the vertex array of the model
+		void draw(globjects::Program & program, const globjects::VertexArray & vertexArray, const std::vector<Material> & materials, bool bindless, Phase phase);
+
+		// copies the depth of the default framebuffer and reduces it to the farthest depth of each texel of every level,
+		// the matrix is the one the depth was drawn with and is used to test against the pyramid
+		void buildPyramid(globjects::Program & pyramidProgram, const glm::ivec2 & viewportSize, const glm::mat4 & modelViewProjectionMatrix);
+
+		// the next early phase draws everything in the frustum, for example after the model was drawn differently
+		void invalidatePyramid();
+
+		const Statistics & statistics() const;
+
+	private:
+
+		// std430 layout of the meshlets in the culling shader
+		struct MeshletData
+		{
+			glm::vec4 sphere = glm::vec4(0.0f);
+			// in units of the index type of the group, from the start of the index buffer
+			glm::uint firstIndex = 0;
+			glm::uint indexCount = 0;
+			gl::GLint baseVertex = 0;
+			// command of the group in the IndirectDrawBuffer, the index of its draw
+			glm::uint draw = 0;
+			glm::uint run = 0;
+			// first slot of the run in the compacted commands of a phase
+			glm::uint firstSlot = 0;
+			glm::uint padding[2] = { 0, 0 };
+		};
+
+		static constexpr glm::uint statisticsCount = 8;
+
+		void readStatistics();
+
+		IndirectDrawBuffer & m_indirectDraws;
+
+		std::size_t m_meshletCount = 0;
+		std::size_t m_triangleCount = 0;
+		// slots and meshlets of each run
+		std::vector<std::size_t> m_runSlots;
+		std::vector<std::size_t> m_runCapacities;
+		bool m_indirectParameters = false;
+
+		std::unique_ptr<globjects::Buffer> m_meshletBuffer = std::make_unique<globjects::Buffer>();
+		// the slots of both phases one after another, and the counts of all runs of both phases
+		std::unique_ptr<globjects::Buffer> m_commandBuffer = std::make_unique<globjects::Buffer>();
+		std::unique_ptr<globjects::Buffer> m_countBuffer = std::make_unique<globjects::Buffer>();
+		// whether the early phase found a meshlet occluded
+		std::unique_ptr<globjects::Buffer> m_stateBuffer = std::make_unique<globjects::Buffer>();
+		// written by the frames alternately, the one of the previous frame is read back
+		std::unique_ptr<globjects::Buffer> m_statisticsBuffers[2] = { std::make_unique<globjects::Buffer>(), std::make_unique<globjects::Buffer>() };
+		std::size_t m_frame = 0;
+
+		std::unique_ptr<globjects::Texture> m_depthTexture;
+		std::unique_ptr<globjects::Texture> m_pyramidTexture;
+		std::unique_ptr<globjects::Framebuffer> m_depthFramebuffer;
+		glm::ivec2 m_viewportSize = glm::ivec2(0);
+		glm::ivec2 m_pyramidSize = glm::ivec2(0);
+		int m_pyramidLevels = 0;
+		glm::mat4 m_pyramidMatrix = glm::mat4(1.0f);
+		bool m_pyramidValid = false;
+		// whether the early phase tested against a pyramid, otherwise it drew everything in the frustum
+		bool m_lateCulling = false;
+
+		Statistics m_statistics;
+	};
+}
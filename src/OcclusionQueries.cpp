@@ -0,0 +1,214 @@
+#include "OcclusionQueries.h"
+#include "BoundingBoxRenderer.h"
+
+#include <globjects/globjects.h>
+
+#include <algorithm>
+#include <chrono>
+
+using namespace minity;
+using namespace gl;
+using namespace glm;
+using namespace globjects;
+
+OcclusionQueries::OcclusionQueries(const std::vector<Group> & groups)
+{
+	const std::size_t count = groups.size();
+
+	m_centers.resize(count);
+	m_extents.resize(count);
+	m_offsets.resize(count);
+	m_triangles.resize(count);
+	m_queries.resize(count);
+	m_pending.assign(count, 0);
+	m_queried.assign(count, 0);
+	m_hidden.assign(count, 0);
+	m_candidates.assign(count, 0);
+	m_visible.assign(count, 1);
+
+	for (std::size_t i = 0; i < count; i++)
+	{
+		const Group & g = groups[i];
+		const vec3 extent = (g.maximum_group - g.minimum_group) * 0.5f;
+
+		m_centers[i] = (g.minimum_group + g.maximum_group) * 0.5f;
+		m_extents[i] = extent + vec3(length(extent) * boxMargin);
+		m_offsets[i] = g.offsetVector;
+		m_triangles[i] = g.count() / 3;
+	}
+
+	// the boxes of the BoundingBoxRenderer, with their quads split into triangles
+	const auto & vertices = BoundingBoxRenderer::boxVertices();
+	std::vector<GLushort> indices;
+
+	for (const auto & face : BoundingBoxRenderer::boxFaces())
+		indices.insert(indices.end(), { face[0], face[1], face[2], face[0], face[2], face[3] });
+
+	m_vertices->setData(vertices, GL_STATIC_DRAW);
+	m_indices->setData(indices, GL_STATIC_DRAW);
+	m_indexCount = GLsizei(indices.size());
+
+	m_vertexArray->bindElementBuffer(m_indices.get());
+
+	auto vertexBinding = m_vertexArray->binding(0);
+	vertexBinding->setAttribute(0);
+	vertexBinding->setBuffer(m_vertices.get(), 0, sizeof(vec3));
+	vertexBinding->setFormat(3, GL_FLOAT);
+	m_vertexArray->enable(0);
+
+	m_vertexArray->unbind();
+
+	// the conservative queries may answer without rasterizing all samples
+	m_target = globjects::hasExtension(GLextension::GL_ARB_ES3_compatibility) ? GL_ANY_SAMPLES_PASSED_CONSERVATIVE : GL_ANY_SAMPLES_PASSED;
+
+	m_statistics.groups = count;
+}
+
+void OcclusionQueries::update(const std::vector<bool> & groupEnabled, const std::vector<std::uint8_t> & groupVisible, const mat4 & modelViewProjectionMatrix, float explosion, bool conditional)
+{
+	auto start = std::chrono::steady_clock::now();
+
+	m_frame++;
+	m_active = true;
+
+	m_statistics.hiddenGroups = 0;
+	m_statistics.hiddenTriangles = 0;
+	m_statistics.pendingQueries = 0;
+	m_statistics.nearGroups = 0;
+
+	for (std::size_t i = 0; i < m_visible.size(); i++)
+	{
+		// never waits, a result which is not available yet is read in one of the next frames
+		if (m_pending[i] && m_queries[i]->resultAvailable())
+		{
+			m_hidden[i] = m_queries[i]->get(GL_QUERY_RESULT) == 0;
+			m_pending[i] = 0;
+		}
+
+		m_candidates[i] = groupEnabled.at(i) && groupVisible.at(i);
+
+		if (m_candidates[i] && crossesNearPlane(i, modelViewProjectionMatrix, explosion))
+		{
+			m_candidates[i] = 0;
+			m_statistics.nearGroups++;
+		}
+
+		// a group which was not queried while it was outside of the frustum starts over as visible, the result of a
+		// query still running is ignored and the next query replaces it
+		if (!m_candidates[i])
+		{
+			m_pending[i] = 0;
+			m_queried[i] = 0;
+			m_hidden[i] = 0;
+		}
+
+		if (m_pending[i])
+			m_statistics.pendingQueries++;
+
+		if (m_hidden[i])
+		{
+			m_statistics.hiddenGroups++;
+			m_statistics.hiddenTriangles += m_triangles[i];
+		}
+
+		m_visible[i] = groupVisible.at(i) && (conditional || !m_hidden[i]);
+	}
+
+	m_statistics.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+const std::vector<std::uint8_t> & OcclusionQueries::visible() const
+{
+	return m_visible;
+}
+
+GLuint OcclusionQueries::condition(std::size_t group) const
+{
+	return m_candidates[group] && m_queried[group] ? m_queries[group]->id() : 0;
+}
+
+void OcclusionQueries::issue(Program & proxyProgram, const mat4 & modelViewProjectionMatrix, float explosion, int visibleInterval)
+{
+	auto start = std::chrono::steady_clock::now();
+
+	const std::size_t interval = std::size_t(std::max(visibleInterval, 1));
+
+	m_statistics.issuedQueries = 0;
+
+	proxyProgram.setUniform("modelViewProjectionMatrix", modelViewProjectionMatrix);
+	proxyProgram.use();
+
+	// the proxies only test the depth, surfaces of the group may touch the faces of its box
+	glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+	glDepthMask(GL_FALSE);
+	glDepthFunc(GL_LEQUAL);
+
+	m_vertexArray->bind();
+
+	for (std::size_t i = 0; i < m_visible.size(); i++)
+	{
+		if (!m_candidates[i] || m_pending[i])
+			continue;
+
+		// hidden groups are queried in every frame, so that they appear as soon as possible
+		if (m_queried[i] && !m_hidden[i] && (m_frame + i) % interval != 0)
+			continue;
+
+		if (!m_queries[i])
+			m_queries[i] = Query::create();
+
+		proxyProgram.setUniform("boxCenter", m_centers[i] + m_offsets[i] * explosion);
+		proxyProgram.setUniform("boxExtent", m_extents[i]);
+
+		m_queries[i]->begin(m_target);
+		m_vertexArray->drawElements(GL_TRIANGLES, m_indexCount, GL_UNSIGNED_SHORT, nullptr);
+		m_queries[i]->end(m_target);
+
+		m_pending[i] = 1;
+		m_queried[i] = 1;
+		m_statistics.issuedQueries++;
+	}
+
+	m_vertexArray->unbind();
+
+	glDepthFunc(GL_LESS);
+	glDepthMask(GL_TRUE);
+	glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+
+	proxyProgram.release();
+
+	m_statistics.seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void OcclusionQueries::reset()
+{
+	if (!m_active)
+		return;
+
+	std::fill(m_pending.begin(), m_pending.end(), std::uint8_t(0));
+	std::fill(m_queried.begin(), m_queried.end(), std::uint8_t(0));
+	std::fill(m_hidden.begin(), m_hidden.end(), std::uint8_t(0));
+	m_active = false;
+}
+
+const OcclusionQueries::Statistics & OcclusionQueries::statistics() const
+{
+	return m_statistics;
+}
+
+bool OcclusionQueries::crossesNearPlane(std::size_t group, const mat4 & modelViewProjectionMatrix, float explosion) const
+{
+	const vec3 center = m_centers[group] + m_offsets[group] * explosion;
+	const vec3 extent = m_extents[group];
+
+	for (int c = 0; c < 8; c++)
+	{
+		const vec3 corner = center + extent * vec3((c & 1) ? 1.0f : -1.0f, (c & 2) ? 1.0f : -1.0f, (c & 4) ? 1.0f : -1.0f);
+		const vec4 clip = modelViewProjectionMatrix * vec4(corner, 1.0f);
+
+		if (clip.z < -clip.w)
+			return true;
+	}
+
+	return false;
+}
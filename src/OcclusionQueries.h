@@ -0,0 +1,98 @@
+#pragma once
+
+#include "Model.h"
+
+#include <glm/glm.hpp>
+#include <glbinding/gl/types.h>
+#include <globjects/Buffer.h>
+#include <globjects/Program.h>
+#include <globjects/Query.h>
+#include <globjects/VertexArray.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace minity
+{
+	// decides the visibility of whole groups with hardware occlusion queries, a lighter alternative to the OcclusionCuller.
+	// the bounding boxes of the groups are drawn as proxies against the depth of the model after it was drawn, and their
+	// results decide about the next frame, either read back once they are available without ever waiting for them, or
+	// left to the GPU with conditional rendering. groups found visible are only queried again every few frames
+	class OcclusionQueries
+	{
+	public:
+
+		struct Statistics
+		{
+			std::size_t groups = 0;
+			// groups whose last result had no samples passing and their triangles
+			std::size_t hiddenGroups = 0;
+			std::size_t hiddenTriangles = 0;
+			// proxies drawn in the last frame and queries still waiting for their results
+			std::size_t issuedQueries = 0;
+			std::size_t pendingQueries = 0;
+			// groups crossing the near plane, whose boxes would be clipped, are always drawn without a query
+			std::size_t nearGroups = 0;
+			double seconds = 0.0;
+		};
+
+		OcclusionQueries(const std::vector<Group> & groups);
+
+		// collects the results which are available, the matrix is in model space and the groups are moved by their offset
+		// vectors times the explosion. with conditional rendering the hidden groups are left in visible() for the GPU to skip,
+		// otherwise they are removed
+		void update(const std::vector<bool> & groupEnabled, const std::vector<std::uint8_t> & groupVisible, const glm::mat4 & modelViewProjectionMatrix, float explosion, bool conditional);
+
+		// the groups in the frustum which are not known to be hidden
+		const std::vector<std::uint8_t> & visible() const;
+
+		// the query to draw the group under with conditional rendering, zero if it is drawn unconditionally
+		gl::GLuint condition(std::size_t group) const;
+
+		// draws the boxes of the groups which need a new result, with the depth of the model in the framebuffer,
+		// groups found visible are queried again only every interval frames, staggered over the frames
+		void issue(globjects::Program & proxyProgram, const glm::mat4 & modelViewProjectionMatrix, float explosion, int visibleInterval);
+
+		// forgets all results while the queries are not used, they do not show the view once they are used again
+		void reset();
+
+		const Statistics & statistics() const;
+
+	private:
+
+		// the box is slightly larger than the group, so that surfaces on its faces do not hide it from itself
+		static constexpr float boxMargin = 1.0e-3f;
+
+		// with the depth range of the matrix, also true for boxes around the camera
+		bool crossesNearPlane(std::size_t group, const glm::mat4 & modelViewProjectionMatrix, float explosion) const;
+
+		std::vector<glm::vec3> m_centers;
+		std::vector<glm::vec3> m_extents;
+		std::vector<glm::vec3> m_offsets;
+		std::vector<std::size_t> m_triangles;
+
+		// created when a group is queried for the first time
+		std::vector<std::unique_ptr<globjects::Query>> m_queries;
+		// a query was issued whose result was not read yet
+		std::vector<std::uint8_t> m_pending;
+		// the query holds a result of the group while it was queried in every frame it was a candidate
+		std::vector<std::uint8_t> m_queried;
+		std::vector<std::uint8_t> m_hidden;
+		// enabled, in the frustum and not crossing the near plane
+		std::vector<std::uint8_t> m_candidates;
+		std::vector<std::uint8_t> m_visible;
+
+		gl::GLenum m_target = gl::GL_ANY_SAMPLES_PASSED;
+		std::size_t m_frame = 0;
+		bool m_active = false;
+
+		std::unique_ptr<globjects::VertexArray> m_vertexArray = std::make_unique<globjects::VertexArray>();
+		std::unique_ptr<globjects::Buffer> m_vertices = std::make_unique<globjects::Buffer>();
+		std::unique_ptr<globjects::Buffer> m_indices = std::make_unique<globjects::Buffer>();
+		gl::GLsizei m_indexCount = 0;
+
+		Statistics m_statistics;
+	};
+}
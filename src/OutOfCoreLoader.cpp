@@ -0,0 +1,463 @@
+#include "OutOfCoreLoader.h"
+#include "TangentGenerator.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <filesystem>
+#include <limits>
+#include <sstream>
+#include <unordered_map>
+
+#include <globjects/globjects.h>
+#include <globjects/logging.h>
+
+using namespace glm;
+using namespace minity;
+
+namespace
+{
+	const std::size_t defaultMemoryLimit = std::size_t(256) << 20;
+
+	// estimated bytes per vertex of a welding window: the vertex, its entry in the welding table, about six indices
+	// and the temporary arrays of the tangent generation
+	const std::size_t windowBytesPerVertex = 192;
+
+	struct CornerKey
+	{
+		uint position;
+		uint texCoord;
+		uint normal;
+
+		bool operator==(const CornerKey & other) const
+		{
+			return position == other.position && texCoord == other.texCoord && normal == other.normal;
+		}
+	};
+
+	struct CornerKeyHash
+	{
+		std::size_t operator()(const CornerKey & key) const
+		{
+			std::uint64_t h = std::uint64_t(key.position) * 0x9e3779b97f4a7c15ull;
+			h ^= std::uint64_t(key.normal) * 0xc2b2ae3d27d4eb4full;
+			h ^= std::uint64_t(key.texCoord) * 0x165667b19e3779f9ull;
+			h ^= h >> 29;
+			return std::size_t(h);
+		}
+	};
+}
+
+OutOfCoreLoader::SpillFile::SpillFile(const std::string & filename) : m_filename(filename), m_os(filename, std::ios::binary | std::ios::trunc)
+{
+
+}
+
+OutOfCoreLoader::SpillFile::~SpillFile()
+{
+	m_file.close();
+
+	if (m_os.is_open())
+		m_os.close();
+
+	std::error_code error;
+	std::filesystem::remove(m_filename, error);
+}
+
+bool OutOfCoreLoader::SpillFile::map()
+{
+	if (m_os.is_open())
+	{
+		m_os.close();
+
+		if (m_os.fail())
+			return false;
+	}
+
+	return m_file.isOpen() || m_file.open(m_filename);
+}
+
+std::size_t OutOfCoreLoader::SpillFile::size() const
+{
+	return m_size;
+}
+
+const std::string & OutOfCoreLoader::SpillFile::filename() const
+{
+	return m_filename;
+}
+
+OutOfCoreLoader::OutOfCoreLoader(const LoadOptions & options, TextureLoader * textureLoader, LoadStatistics * statistics) : m_options(options), m_statistics(statistics), m_loader(options, textureLoader, statistics)
+{
+	std::error_code error;
+	std::filesystem::path directory = options.cacheDirectory.empty() ? std::filesystem::temp_directory_path(error) : std::filesystem::path(options.cacheDirectory);
+
+	if (error)
+		directory = ".";
+
+	// loaders running at the same time must not share their files
+	std::stringstream name;
+	name << "minity-" << std::hex << std::chrono::steady_clock::now().time_since_epoch().count() << "-" << reinterpret_cast<std::uintptr_t>(this);
+	m_spillPrefix = (directory / name.str()).string();
+}
+
+OutOfCoreLoader::~OutOfCoreLoader()
+{
+
+}
+
+bool OutOfCoreLoader::load(const std::string & filename)
+{
+	auto loadStart = std::chrono::steady_clock::now();
+
+	LoadStatistics::Scope streamScope(m_statistics, "stream");
+
+	m_positions = createSpillFile("positions");
+	m_texCoords = createSpillFile("texcoords");
+	m_normals = createSpillFile("normals");
+	m_corners = createSpillFile("corners");
+
+	// the defaults at index zero, like the in-core loader has them
+	const vec3 defaultPosition(0.0f);
+	const vec2 defaultTexCoord(1.0f);
+	const vec3 defaultNormal(0.0f);
+	m_positions->write(&defaultPosition, 1);
+	m_texCoords->write(&defaultTexCoord, 1);
+	m_normals->write(&defaultNormal, 1);
+
+	std::vector<Corner> corners;
+
+	// a window of the file takes about twice its size once parsed
+	const bool parsed = m_loader.streamObjFile(filename, std::max(memoryLimit() / 8, std::size_t(1) << 16), [&](const ObjLoader::ObjWindow & window) {
+		m_positions->write(window.positions.data(), window.positions.size());
+		m_texCoords->write(window.texCoords.data(), window.texCoords.size());
+		m_normals->write(window.normals.data(), window.normals.size());
+
+		corners.resize(window.corners.size());
+
+		for (std::size_t i = 0; i < corners.size(); i++)
+			corners[i] = { window.corners.positionIndices[i], window.corners.texCoordIndices[i], window.corners.normalIndices[i] };
+
+		m_corners->write(corners.data(), corners.size());
+
+		m_positionCount += window.positions.size();
+		m_texCoordCount += window.texCoords.size();
+		m_normalCount += window.normals.size();
+		m_cornerCount += window.corners.size();
+		return true;
+	});
+
+	corners.clear();
+	corners.shrink_to_fit();
+
+	if (!parsed || !m_positions->map() || !m_texCoords->map() || !m_corners->map())
+		return false;
+
+	streamScope.add(m_positions->size() + m_texCoords->size() + m_normals->size() + m_corners->size(), m_cornerCount);
+	streamScope.end();
+
+	if (m_normalCount <= 1)
+	{
+		LoadStatistics::Scope normalScope(m_statistics, "normals");
+
+		if (!generateNormals())
+			return false;
+
+		normalScope.add(m_normals->size(), m_positionCount - 1);
+	}
+	else if (!m_normals->map())
+	{
+		return false;
+	}
+
+	{
+		LoadStatistics::Scope vertexScope(m_statistics, "build vertices");
+
+		if (!buildVertices())
+			return false;
+
+		vertexScope.add(m_vertices->size() + m_indices->size(), m_cornerCount);
+	}
+
+	// only the final geometry is needed from here on
+	m_positions.reset();
+	m_texCoords.reset();
+	m_normals.reset();
+	m_corners.reset();
+
+	m_loader.createMaterials(filename, m_loader.objMaterials());
+
+	auto loadEnd = std::chrono::steady_clock::now();
+	globjects::debug() << "Loaded " << m_indices->size() / sizeof(uint) / 3 << " triangles and " << vertexCount() << " vertices out of core in "
+		<< std::chrono::duration<double>(loadEnd - loadStart).count() << " s with a limit of " << double(memoryLimit()) / (1024.0 * 1024.0) << " MB";
+
+	return true;
+}
+
+bool OutOfCoreLoader::generateNormals()
+{
+	if (m_options.creaseAngle < 180.0f)
+		globjects::debug() << "Crease angles are not supported out of core, all faces of a position are smoothed together";
+
+	std::unique_ptr<SpillFile> normals = createSpillFile("generated-normals");
+
+	const vec3 * positions = m_positions->data<vec3>();
+	const Corner * corners = m_corners->data<Corner>();
+	const std::size_t blockSize = std::max(memoryLimit() / 4 / sizeof(vec3), std::size_t(1024));
+
+	std::vector<vec3> block;
+
+	for (std::size_t blockBegin = 0; blockBegin < m_positionCount; blockBegin += blockSize)
+	{
+		const std::size_t blockEnd = std::min(blockBegin + blockSize, m_positionCount);
+		block.assign(blockEnd - blockBegin, vec3(0.0f));
+
+		for (std::size_t c = 0; c + 2 < m_cornerCount; c += 3)
+		{
+			const uint p[3] = { corners[c].position, corners[c + 1].position, corners[c + 2].position };
+
+			if ((p[0] < blockBegin || p[0] >= blockEnd) && (p[1] < blockBegin || p[1] >= blockEnd) && (p[2] < blockBegin || p[2] >= blockEnd))
+				continue;
+
+			if (p[0] >= m_positionCount || p[1] >= m_positionCount || p[2] >= m_positionCount)
+				continue;
+
+			const vec3 faceNormal = cross(positions[p[1]] - positions[p[0]], positions[p[2]] - positions[p[0]]);
+			const float faceLength = length(faceNormal);
+
+			if (!(faceLength > 0.0f))
+				continue;
+
+			for (int k = 0; k < 3; k++)
+			{
+				if (p[k] < blockBegin || p[k] >= blockEnd)
+					continue;
+
+				float weight = 1.0f / faceLength;
+
+				if (m_options.normalWeighting == LoadOptions::NormalWeighting::Area)
+				{
+					weight = 1.0f;
+				}
+				else if (m_options.normalWeighting == LoadOptions::NormalWeighting::Angle)
+				{
+					const vec3 a = positions[p[(k + 1) % 3]] - positions[p[k]];
+					const vec3 b = positions[p[(k + 2) % 3]] - positions[p[k]];
+					const float ab = length(a) * length(b);
+					weight = ab > 0.0f ? std::acos(std::clamp(dot(a, b) / ab, -1.0f, 1.0f)) / faceLength : 0.0f;
+				}
+
+				block[p[k] - blockBegin] += faceNormal * weight;
+			}
+		}
+
+		for (auto & n : block)
+		{
+			const float l = length(n);
+			n = l > 0.0f ? n / l : vec3(0.0f);
+		}
+
+		normals->write(block.data(), block.size());
+	}
+
+	// the generated normals belong to the positions, so the corners use the position index for them
+	m_normals = std::move(normals);
+	m_generatedNormals = true;
+
+	return m_normals->map();
+}
+
+bool OutOfCoreLoader::buildVertices()
+{
+	m_vertices = createSpillFile("vertices");
+	m_indices = createSpillFile("indices");
+
+	const vec3 * positions = m_positions->data<vec3>();
+	const vec2 * texCoords = m_texCoords->data<vec2>();
+	const vec3 * normals = m_normals->data<vec3>();
+	const Corner * corners = m_corners->data<Corner>();
+
+	const auto & objGroups = m_loader.objGroups();
+	const auto & runs = m_loader.groupRuns();
+	const std::vector<uint> materialIndices = m_loader.materialIndices();
+
+	// the runs of each group in file order, found by a counting sort
+	std::vector<std::size_t> runOffsets(objGroups.size() + 1, 0);
+	std::vector<std::size_t> groupRuns(runs.size());
+
+	for (const auto & r : runs)
+		runOffsets[r.group + 1]++;
+
+	for (std::size_t i = 0; i < objGroups.size(); i++)
+		runOffsets[i + 1] += runOffsets[i];
+
+	{
+		std::vector<std::size_t> cursor(runOffsets.begin(), runOffsets.end() - 1);
+
+		for (std::size_t i = 0; i < runs.size(); i++)
+			groupRuns[cursor[runs[i].group]++] = i;
+	}
+
+	// vertices are welded within a window of triangles, a vertex is only ever used by the triangles of its window,
+	// so that the tangents can be generated window by window -- corners shared across windows are duplicated
+	const std::size_t maximumWindowVertices = std::max(memoryLimit() / 2 / windowBytesPerVertex, std::size_t(1024));
+
+	std::unordered_map<CornerKey, uint, CornerKeyHash> weldTable;
+	std::vector<Vertex> windowVertices;
+	std::vector<uint> windowIndices;
+	std::size_t vertexOffset = 0;
+	std::size_t indexCount = 0;
+
+	weldTable.reserve(maximumWindowVertices);
+
+	auto flush = [&]() {
+		if (windowIndices.empty())
+			return;
+
+		Group window;
+		window.startIndex = 0;
+		window.endIndex = uint(windowIndices.size());
+		TangentGenerator::generate(windowVertices, windowIndices, { window });
+
+		for (auto & i : windowIndices)
+			i += uint(vertexOffset);
+
+		m_vertices->write(windowVertices.data(), windowVertices.size());
+		m_indices->write(windowIndices.data(), windowIndices.size());
+
+		vertexOffset += windowVertices.size();
+		indexCount += windowIndices.size();
+		windowVertices.clear();
+		windowIndices.clear();
+		weldTable.clear();
+	};
+
+	m_minimumBounds = vec3(std::numeric_limits<float>::max());
+	m_maximumBounds = vec3(-std::numeric_limits<float>::max());
+	m_groups.clear();
+
+	for (std::size_t g = 0; g < objGroups.size(); g++)
+	{
+		Group group;
+		group.name = std::string(m_loader.groupName(objGroups[g]));
+		group.materialIndex = objGroups[g].material < materialIndices.size() ? materialIndices[objGroups[g].material] : 0;
+		group.startIndex = uint(indexCount + windowIndices.size());
+
+		vec3 minimum(std::numeric_limits<float>::max());
+		vec3 maximum(-std::numeric_limits<float>::max());
+
+		for (std::size_t r = runOffsets[g]; r < runOffsets[g + 1]; r++)
+		{
+			const std::size_t run = groupRuns[r];
+			const std::size_t runBegin = runs[run].cornerBegin;
+			const std::size_t runEnd = run + 1 < runs.size() ? runs[run + 1].cornerBegin : m_cornerCount;
+
+			// runs always hold whole triangles, since faces are triangulated as they are parsed
+			for (std::size_t c = runBegin; c + 2 < runEnd; c += 3)
+			{
+				// a triangle never straddles two windows
+				if (windowVertices.size() + 3 > maximumWindowVertices || windowIndices.size() + 3 > maximumWindowVertices * 6)
+					flush();
+
+				for (std::size_t k = c; k < c + 3; k++)
+				{
+					const Corner & corner = corners[k];
+					const CornerKey key{ corner.position < m_positionCount ? corner.position : 0, corner.texCoord < m_texCoordCount ? corner.texCoord : 0,
+						m_generatedNormals ? 0 : (corner.normal < m_normalCount ? corner.normal : 0) };
+
+					auto inserted = weldTable.emplace(key, uint(windowVertices.size()));
+
+					if (inserted.second)
+					{
+						Vertex vertex;
+						vertex.position = positions[key.position];
+						vertex.texcoord = texCoords[key.texCoord];
+						vertex.normal = m_generatedNormals ? normals[key.position] : normals[key.normal];
+						windowVertices.push_back(vertex);
+					}
+
+					minimum = min(minimum, positions[key.position]);
+					maximum = max(maximum, positions[key.position]);
+
+					windowIndices.push_back(inserted.first->second);
+				}
+			}
+		}
+
+		group.endIndex = uint(indexCount + windowIndices.size());
+
+		if (group.endIndex > group.startIndex)
+		{
+			group.centre_group = (minimum + maximum) * 0.5f;
+			group.radius_group = length(maximum - minimum) * 0.5f;
+			group.minimum_group = minimum;
+			group.maximum_group = maximum;
+			m_minimumBounds = min(m_minimumBounds, minimum);
+			m_maximumBounds = max(m_maximumBounds, maximum);
+
+			// the indices are uploaded as they are
+			group.indexOffset = std::size_t(group.startIndex) * sizeof(uint);
+			m_groups.push_back(std::move(group));
+		}
+	}
+
+	flush();
+
+	return m_vertices->map() && m_indices->map();
+}
+
+std::unique_ptr<OutOfCoreLoader::SpillFile> OutOfCoreLoader::createSpillFile(const std::string & name)
+{
+	return std::make_unique<SpillFile>(m_spillPrefix + "." + name);
+}
+
+std::size_t OutOfCoreLoader::memoryLimit() const
+{
+	return m_options.memoryLimit > 0 ? m_options.memoryLimit : defaultMemoryLimit;
+}
+
+std::size_t OutOfCoreLoader::uploadChunkSize() const
+{
+	return std::max(memoryLimit() / 8, std::size_t(1) << 16);
+}
+
+const std::vector<Group> & OutOfCoreLoader::groups() const
+{
+	return m_groups;
+}
+
+const std::vector<Material> & OutOfCoreLoader::materials() const
+{
+	return m_loader.materials();
+}
+
+vec3 OutOfCoreLoader::minimumBounds() const
+{
+	return m_minimumBounds;
+}
+
+vec3 OutOfCoreLoader::maximumBounds() const
+{
+	return m_maximumBounds;
+}
+
+const Vertex * OutOfCoreLoader::vertexData() const
+{
+	return m_vertices ? m_vertices->data<Vertex>() : nullptr;
+}
+
+std::size_t OutOfCoreLoader::vertexCount() const
+{
+	return m_vertices ? m_vertices->size() / sizeof(Vertex) : 0;
+}
+
+const uint * OutOfCoreLoader::indexData() const
+{
+	return m_indices ? m_indices->data<uint>() : nullptr;
+}
+
+std::size_t OutOfCoreLoader::indexCount() const
+{
+	return m_indices ? m_indices->size() / sizeof(uint) : 0;
+}
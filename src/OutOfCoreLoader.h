@@ -0,0 +1,121 @@
+#pragma once
+
+#include "Model.h"
+#include "ObjLoader.h"
+#include "MappedFile.h"
+
+#include <cstddef>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace minity
+{
+	// loads models which do not fit into memory: the file is parsed in windows whose attributes and corners are spilled
+	// to temporary files, vertices are welded and get their tangents in windows of triangles, and the final vertices and
+	// indices end up in temporary files again, which are mapped for uploading -- memory stays within LoadOptions::memoryLimit
+	// apart from the groups, the group runs and the pages of the mapped files, which the operating system can always drop
+	class OutOfCoreLoader
+	{
+	public:
+
+		// a temporary file which is written sequentially, then mapped for reading and removed with the object
+		class SpillFile
+		{
+		public:
+			SpillFile(const std::string & filename);
+			~SpillFile();
+
+			SpillFile(const SpillFile &) = delete;
+			SpillFile & operator=(const SpillFile &) = delete;
+
+			template <typename T> void write(const T * data, std::size_t count)
+			{
+				m_os.write(reinterpret_cast<const char*>(data), std::streamsize(count * sizeof(T)));
+				m_size += count * sizeof(T);
+			}
+
+			// finishes writing, the contents are valid until the object is destroyed
+			bool map();
+
+			template <typename T> const T * data() const
+			{
+				return reinterpret_cast<const T*>(m_file.data());
+			}
+
+			std::size_t size() const;
+			const std::string & filename() const;
+
+		private:
+			std::string m_filename;
+			std::ofstream m_os;
+			MappedFile m_file;
+			std::size_t m_size = 0;
+		};
+
+		OutOfCoreLoader(const LoadOptions & options, TextureLoader * textureLoader = nullptr, LoadStatistics * statistics = nullptr);
+		~OutOfCoreLoader();
+
+		OutOfCoreLoader(const OutOfCoreLoader &) = delete;
+		OutOfCoreLoader & operator=(const OutOfCoreLoader &) = delete;
+
+		bool load(const std::string & filename);
+
+		// the memory limit of the options, or a default for loaders created without one
+		std::size_t memoryLimit() const;
+		// bytes of the final vertices and indices to upload at once
+		std::size_t uploadChunkSize() const;
+
+		const std::vector<Group> & groups() const;
+		const std::vector<Material> & materials() const;
+		glm::vec3 minimumBounds() const;
+		glm::vec3 maximumBounds() const;
+
+		// the final geometry in mapped temporary files, the groups use 32-bit indices into the whole vertex file
+		const Vertex * vertexData() const;
+		std::size_t vertexCount() const;
+		const glm::uint * indexData() const;
+		std::size_t indexCount() const;
+
+	private:
+
+		struct Corner
+		{
+			glm::uint position;
+			glm::uint texCoord;
+			glm::uint normal;
+		};
+
+		std::unique_ptr<SpillFile> createSpillFile(const std::string & name);
+
+		// smooth normals of the positions for files without normals, built in blocks of positions which each take
+		// one pass over the corners
+		bool generateNormals();
+		bool buildVertices();
+
+		LoadOptions m_options;
+		LoadStatistics * m_statistics = nullptr;
+		ObjLoader m_loader;
+		std::string m_spillPrefix;
+
+		std::unique_ptr<SpillFile> m_positions;
+		std::unique_ptr<SpillFile> m_texCoords;
+		std::unique_ptr<SpillFile> m_normals;
+		std::unique_ptr<SpillFile> m_corners;
+		std::unique_ptr<SpillFile> m_vertices;
+		std::unique_ptr<SpillFile> m_indices;
+
+		// with the defaults at index zero
+		std::size_t m_positionCount = 1;
+		std::size_t m_texCoordCount = 1;
+		std::size_t m_normalCount = 1;
+		std::size_t m_cornerCount = 0;
+		// generated normals are stored per position and used through the position index
+		bool m_generatedNormals = false;
+
+		std::vector<Group> m_groups;
+		glm::vec3 m_minimumBounds = glm::vec3(0.0f);
+		glm::vec3 m_maximumBounds = glm::vec3(0.0f);
+	};
+}
@@ -0,0 +1,288 @@
+#include "RenderQueue.h"
+
+#include <algorithm>
+#include <tuple>
+
+using namespace minity;
+using namespace gl;
+using namespace glm;
+using namespace globjects;
+
+namespace
+{
+	const char * const samplerNames[RenderQueue::textureUnitCount] = { "diffuseTexture", "ambientTexture", "specularTexture", "objectSpaceNormals", "tangentSpaceNormals" };
+}
+
+void RenderQueue::clear()
+{
+	m_draws.clear();
+}
+
+void RenderQueue::add(uint materialIndex, const IndexRange & range, uint first, uint count, const vec3 & offset, GLuint condition)
+{
+	Draw draw;
+	draw.material = materialIndex;
+	draw.offset = offset;
+	draw.type = range.indexType();
+	draw.baseVertex = GLint(range.baseVertex);
+	draw.indexSize = range.indexSize();
+	draw.indexOffset = range.indexOffset + first * range.indexSize();
+	draw.count = GLsizei(count);
+	draw.condition = condition;
+	m_draws.push_back(draw);
+}
+
+void RenderQueue::submit(Program & program, const VertexArray & vertexArray, const std::vector<Material> & materials, bool wireframe, bool batching)
+{
+	m_statistics = Statistics();
+	m_statistics.draws = m_draws.size();
+
+	std::fill(std::begin(m_boundTextures), std::end(m_boundTextures), nullptr);
+
+	// the samplers never change their units
+	for (std::size_t unit = 0; unit < textureUnitCount; unit++)
+		program.setUniform(samplerName(unit), GLint(unit));
+
+	m_statistics.uniformChanges += textureUnitCount;
+
+	setOffset(program, vec3(0.0f), true);
+	m_shortIndices = false;
+	m_baseVertex = 0;
+	m_firstIndex = 0;
+
+	if (!batching)
+	{
+		for (const auto & draw : m_draws)
+		{
+			bindTextures(materials.at(draw.material), true);
+			setOffset(program, draw.offset, true);
+
+			m_batch.assign(1, draw);
+			drawBatch(program, vertexArray, wireframe, true);
+
+			unbindTextures();
+		}
+
+		return;
+	}
+
+	// materials with identical textures do not need any bindings between them
+	m_textureSets.clear();
+
+	for (auto & draw : m_draws)
+	{
+		const Material & material = materials.at(draw.material);
+		std::array<const Texture*, textureUnitCount> textures;
+
+		for (std::size_t unit = 0; unit < textureUnitCount; unit++)
+			textures[unit] = texture(material, unit);
+
+		draw.textureSet = m_textureSets.emplace(textures, uint(m_textureSets.size())).first->second;
+	}
+
+	// the index order within a batch keeps ranges which continue each other next to each other
+	std::sort(m_draws.begin(), m_draws.end(), [](const Draw & a, const Draw & b) {
+		return std::tie(a.textureSet, a.offset.x, a.offset.y, a.offset.z, a.condition, a.type, a.indexOffset) < std::tie(b.textureSet, b.offset.x, b.offset.y, b.offset.z, b.condition, b.type, b.indexOffset);
+	});
+
+	for (std::size_t begin = 0; begin < m_draws.size();)
+	{
+		const Draw & first = m_draws[begin];
+		std::size_t end = begin + 1;
+
+		while (end < m_draws.size() && m_draws[end].textureSet == first.textureSet && m_draws[end].offset == first.offset && m_draws[end].condition == first.condition && m_draws[end].type == first.type)
+			end++;
+
+		bindTextures(materials.at(first.material), false);
+		setOffset(program, first.offset, false);
+
+		m_batch.clear();
+
+		for (std::size_t i = begin; i < end; i++)
+		{
+			const Draw & draw = m_draws[i];
+
+			if (!m_batch.empty() && m_batch.back().baseVertex == draw.baseVertex && m_batch.back().indexOffset + std::size_t(m_batch.back().count) * draw.indexSize == draw.indexOffset)
+				m_batch.back().count += draw.count;
+			else
+				m_batch.push_back(draw);
+		}
+
+		drawBatch(program, vertexArray, wireframe, false);
+		begin = end;
+	}
+
+	unbindTextures();
+}
+
+const RenderQueue::Statistics & RenderQueue::statistics() const
+{
+	return m_statistics;
+}
+
+const Texture * RenderQueue::texture(const Material & material, std::size_t unit)
+{
+	switch (unit)
+	{
+	case 0:
+		return material.diffuseTexture.get();
+	case 1:
+		return material.ambientTexture.get();
+	case 2:
+		return material.specularTexture.get();
+	case 3:
+		return material.objectSpaceNormalTexture.get();
+	default:
+		return material.tangentSpaceNormalTexture.get();
+	}
+}
+
+const char * RenderQueue::samplerName(std::size_t unit)
+{
+	return samplerNames[unit];
+}
+
+void RenderQueue::bindTextures(const Material & material, bool force)
+{
+	for (std::size_t unit = 0; unit < textureUnitCount; unit++)
+	{
+		const Texture * t = texture(material, unit);
+
+		if (t == m_boundTextures[unit] && !force)
+		{
+			m_statistics.skippedChanges++;
+			continue;
+		}
+
+		if (t)
+		{
+			t->bindActive(GLuint(unit));
+			m_statistics.textureBinds++;
+		}
+		else if (m_boundTextures[unit])
+		{
+			m_boundTextures[unit]->unbindActive(GLuint(unit));
+			m_statistics.textureBinds++;
+		}
+
+		m_boundTextures[unit] = t;
+	}
+}
+
+void RenderQueue::unbindTextures()
+{
+	for (std::size_t unit = 0; unit < textureUnitCount; unit++)
+	{
+		if (m_boundTextures[unit])
+		{
+			m_boundTextures[unit]->unbindActive(GLuint(unit));
+			m_boundTextures[unit] = nullptr;
+			m_statistics.textureBinds++;
+		}
+	}
+}
+
+void RenderQueue::setOffset(Program & program, const vec3 & offset, bool force)
+{
+	if (offset == m_offset && !force)
+	{
+		m_statistics.skippedChanges++;
+		return;
+	}
+
+	program.setUniform("explosionVector", offset);
+	m_offset = offset;
+	m_statistics.uniformChanges++;
+}
+
+void RenderQueue::setRange(Program & program, const Draw & draw, bool force)
+{
+	const bool shortIndices = draw.type == GL_UNSIGNED_SHORT;
+
+	if (shortIndices != m_shortIndices || force)
+	{
+		program.setUniform("shortIndices", shortIndices);
+		m_shortIndices = shortIndices;
+		m_statistics.uniformChanges++;
+	}
+	else
+	{
+		m_statistics.skippedChanges++;
+	}
+
+	if (draw.baseVertex != m_baseVertex || force)
+	{
+		program.setUniform("baseVertex", draw.baseVertex);
+		m_baseVertex = draw.baseVertex;
+		m_statistics.uniformChanges++;
+	}
+	else
+	{
+		m_statistics.skippedChanges++;
+	}
+
+	// the shader numbers the corners of the triangles from the first vertex of the draw
+	const GLint firstIndex = GLint(draw.indexOffset / draw.indexSize);
+
+	if (firstIndex != m_firstIndex || force)
+	{
+		program.setUniform("firstIndex", firstIndex);
+		m_firstIndex = firstIndex;
+		m_statistics.uniformChanges++;
+	}
+	else
+	{
+		m_statistics.skippedChanges++;
+	}
+}
+
+void RenderQueue::drawBatch(Program & program, const VertexArray & vertexArray, bool wireframe, bool force)
+{
+	// all draws of a batch share their condition, a result which is not available yet draws them
+	const GLuint condition = m_batch.front().condition;
+
+	if (condition != 0)
+		glBeginConditionalRender(condition, GL_QUERY_NO_WAIT);
+
+	drawRanges(program, vertexArray, wireframe, force);
+
+	if (condition != 0)
+		glEndConditionalRender();
+}
+
+void RenderQueue::drawRanges(Program & program, const VertexArray & vertexArray, bool wireframe, bool force)
+{
+	// the wireframe fetches the indices itself, so every range needs its own draw with its index layout
+	if (wireframe)
+	{
+		for (const auto & draw : m_batch)
+		{
+			setRange(program, draw, force || m_statistics.drawCalls == 0);
+			vertexArray.drawArrays(GL_TRIANGLES, GLint(draw.indexOffset / draw.indexSize), draw.count);
+			m_statistics.drawCalls++;
+		}
+
+		return;
+	}
+
+	if (m_batch.size() == 1)
+	{
+		vertexArray.drawElementsBaseVertex(GL_TRIANGLES, m_batch.front().count, m_batch.front().type, reinterpret_cast<const void*>(m_batch.front().indexOffset), m_batch.front().baseVertex);
+		m_statistics.drawCalls++;
+		return;
+	}
+
+	m_counts.clear();
+	m_indices.clear();
+	m_baseVertices.clear();
+
+	for (const auto & draw : m_batch)
+	{
+		m_counts.push_back(draw.count);
+		m_indices.push_back(reinterpret_cast<const void*>(draw.indexOffset));
+		m_baseVertices.push_back(draw.baseVertex);
+	}
+
+	vertexArray.multiDrawElementsBaseVertex(GL_TRIANGLES, m_counts.data(), m_batch.front().type, m_indices.data(), GLsizei(m_batch.size()), m_baseVertices.data());
+	m_statistics.drawCalls++;
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include "Model.h"
+
+#include <glm/glm.hpp>
+#include <glbinding/gl/types.h>
+#include <globjects/Program.h>
+#include <globjects/Texture.h>
+#include <globjects/VertexArray.h>
+
+#include <array>
+#include <cstddef>
+#include <map>
+#include <vector>
+
+namespace minity
+{
+	// collects the draws of the model for a frame and submits them sorted by the textures of their materials, so that
+	// every texture set is bound once, skips uniforms and bindings which are already current, and merges draws with the
+	// same material and explosion offset into one multi-draw call
+	class RenderQueue
+	{
+	public:
+
+		struct Statistics
+		{
+			// index ranges added and draw calls issued for them
+			std::size_t draws = 0;
+			std::size_t drawCalls = 0;
+			std::size_t textureBinds = 0;
+			std::size_t uniformChanges = 0;
+			// bindings and uniforms which were already current and not set again
+			std::size_t skippedChanges = 0;
+		};
+
+		// the textures of the materials go to these units, with these sampler names
+		static constexpr std::size_t textureUnitCount = 5;
+
+		void clear();
+
+		// count indices starting first indices into the range, drawn with the material and moved by the offset, and only
+		// if the occlusion query of the condition passed unless it is zero, draws with different conditions are never merged
+		void add(glm::uint materialIndex, const IndexRange & range, glm::uint first, glm::uint count, const glm::vec3 & offset, gl::GLuint condition = 0);
+
+		// with batching disabled, the draws are submitted in the order they were added, each binding and unbinding
+		// its textures, which is how the model used to be drawn and serves as the baseline for the statistics
+		void submit(globjects::Program & program, const globjects::VertexArray & vertexArray, const std::vector<Material> & materials, bool wireframe, bool batching);
+
+		const Statistics & statistics() const;
+
+		// the texture of the material for the unit and the name of its sampler
+		static const globjects::Texture * texture(const Material & material, std::size_t unit);
+		static const char * samplerName(std::size_t unit);
+
+	private:
+
+		struct Draw
+		{
+			glm::uint material = 0;
+			// materials with the same textures share a texture set
+			glm::uint textureSet = 0;
+			glm::vec3 offset = glm::vec3(0.0f);
+			gl::GLenum type = gl::GL_UNSIGNED_INT;
+			gl::GLint baseVertex = 0;
+			std::size_t indexSize = sizeof(glm::uint);
+			// in bytes into the index buffer
+			std::size_t indexOffset = 0;
+			gl::GLsizei count = 0;
+			// occlusion query for conditional rendering
+			gl::GLuint condition = 0;
+		};
+
+		// binds the textures of the material to all units, units it has no texture for are unbound
+		void bindTextures(const Material & material, bool force);
+		void setOffset(globjects::Program & program, const glm::vec3 & offset, bool force);
+		void setRange(globjects::Program & program, const Draw & draw, bool force);
+		void unbindTextures();
+		void drawBatch(globjects::Program & program, const globjects::VertexArray & vertexArray, bool wireframe, bool force);
+		void drawRanges(globjects::Program & program, const globjects::VertexArray & vertexArray, bool wireframe, bool force);
+
+		std::vector<Draw> m_draws;
+
+		// merged ranges of the current batch
+		std::vector<Draw> m_batch;
+		std::vector<gl::GLsizei> m_counts;
+		std::vector<const void*> m_indices;
+		std::vector<gl::GLint> m_baseVertices;
+		std::map<std::array<const globjects::Texture*, textureUnitCount>, glm::uint> m_textureSets;
+
+		const globjects::Texture * m_boundTextures[textureUnitCount] = {};
+		glm::vec3 m_offset = glm::vec3(0.0f);
+		gl::GLint m_baseVertex = 0;
+		gl::GLint m_firstIndex = 0;
+		bool m_shortIndices = false;
+
+		Statistics m_statistics;
+	};
+}
@@ -0,0 +1,99 @@
+#include "TangentGenerator.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace glm;
+using namespace minity;
+
+namespace
+{
+	// the angle between the edges leaving a corner
+	float cornerAngle(const vec3 & corner, const vec3 & a, const vec3 & b)
+	{
+		const vec3 e1 = a - corner;
+		const vec3 e2 = b - corner;
+		const float lengths = length(e1) * length(e2);
+
+		if (!(lengths > 0.0f))
+			return 0.0f;
+
+		return std::acos(clamp(dot(e1, e2) / lengths, -1.0f, 1.0f));
+	}
+
+	// any unit vector perpendicular to the normal
+	vec3 perpendicular(const vec3 & normal)
+	{
+		const vec3 axis = std::abs(normal.x) < 0.9f ? vec3(1.0f, 0.0f, 0.0f) : vec3(0.0f, 1.0f, 0.0f);
+		return normalize(cross(normal, axis));
+	}
+}
+
+void TangentGenerator::generate(std::vector<Vertex> & vertices, const std::vector<uint> & indices, const std::vector<Group> & groups)
+{
+	std::vector<vec3> tangents(vertices.size(), vec3(0.0f));
+	std::vector<vec3> bitangents(vertices.size(), vec3(0.0f));
+
+	for (const auto & g : groups)
+	{
+		const size_t end = std::min(size_t(g.endIndex), indices.size());
+
+		for (size_t j = g.startIndex; j + 2 < end; j += 3)
+		{
+			const uint i0 = indices[j + 0];
+			const uint i1 = indices[j + 1];
+			const uint i2 = indices[j + 2];
+
+			const vec3 & p0 = vertices[i0].position;
+			const vec3 & p1 = vertices[i1].position;
+			const vec3 & p2 = vertices[i2].position;
+
+			const vec3 edge1 = p1 - p0;
+			const vec3 edge2 = p2 - p0;
+			const vec2 deltaUV1 = vertices[i1].texcoord - vertices[i0].texcoord;
+			const vec2 deltaUV2 = vertices[i2].texcoord - vertices[i0].texcoord;
+
+			// faces without a texture mapping do not define a tangent
+			const float determinant = deltaUV1.x * deltaUV2.y - deltaUV2.x * deltaUV1.y;
+
+			if (!(std::abs(determinant) > 0.0f))
+				continue;
+
+			const vec3 tangent = (edge1 * deltaUV2.y - edge2 * deltaUV1.y) / determinant;
+			const vec3 bitangent = (edge2 * deltaUV1.x - edge1 * deltaUV2.x) / determinant;
+
+			if (!std::isfinite(dot(tangent, tangent)) || !std::isfinite(dot(bitangent, bitangent)))
+				continue;
+
+			// the face tangents are normalized, so that large triangles do not dominate, but wide corners count more
+			const vec3 unitTangent = dot(tangent, tangent) > 0.0f ? normalize(tangent) : vec3(0.0f);
+			const vec3 unitBitangent = dot(bitangent, bitangent) > 0.0f ? normalize(bitangent) : vec3(0.0f);
+
+			const float angles[3] = { cornerAngle(p0, p1, p2), cornerAngle(p1, p2, p0), cornerAngle(p2, p0, p1) };
+			const uint corners[3] = { i0, i1, i2 };
+
+			for (int k = 0; k < 3; k++)
+			{
+				tangents[corners[k]] += unitTangent * angles[k];
+				bitangents[corners[k]] += unitBitangent * angles[k];
+			}
+		}
+	}
+
+	for (size_t i = 0; i < vertices.size(); i++)
+	{
+		Vertex & v = vertices[i];
+		const vec3 normal = dot(v.normal, v.normal) > 0.0f ? normalize(v.normal) : vec3(0.0f, 0.0f, 1.0f);
+
+		// Gram-Schmidt against the normal, the bitangent is rebuilt in the shader from the cross product and the sign
+		vec3 tangent = tangents[i] - normal * dot(normal, tangents[i]);
+
+		if (dot(tangent, tangent) > 1e-12f && std::isfinite(dot(tangent, tangent)))
+			tangent = normalize(tangent);
+		else
+			tangent = perpendicular(normal);
+
+		const float handedness = dot(cross(normal, tangent), bitangents[i]) < 0.0f ? -1.0f : 1.0f;
+		v.tangent = vec4(tangent, handedness);
+	}
+}
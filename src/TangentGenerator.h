@@ -0,0 +1,19 @@
+#pragma once
+
+#include "Model.h"
+
+#include <vector>
+
+namespace minity
+{
+	// per vertex tangent frames for tangent space normal mapping, in the spirit of MikkTSpace: the texture space
+	// tangents of the faces are averaged with the corner angles as weights and orthogonalized against the vertex normal
+	class TangentGenerator
+	{
+	public:
+
+		// fills the tangents of all vertices used by the triangles of the groups, the handedness of the bitangent
+		// is stored in w, vertices without texture coordinates get an arbitrary tangent perpendicular to the normal
+		static void generate(std::vector<Vertex> & vertices, const std::vector<glm::uint> & indices, const std::vector<Group> & groups);
+	};
+}
@@ -0,0 +1,143 @@
+#include "TextureCache.h"
+
+#include <filesystem>
+
+using namespace minity;
+using namespace globjects;
+
+TextureCache & TextureCache::instance()
+{
+	static TextureCache cache;
+	return cache;
+}
+
+std::string TextureCache::canonicalPath(const std::string & filename)
+{
+	std::error_code error;
+	std::filesystem::path path = std::filesystem::weakly_canonical(std::filesystem::absolute(filename, error), error);
+
+	if (error)
+		return filename;
+
+	return path.string();
+}
+
+std::shared_ptr<Texture> TextureCache::acquire(const std::string & path)
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_requests++;
+
+	auto i = m_paths.find(path);
+
+	if (i == m_paths.end())
+		return std::shared_ptr<Texture>();
+
+	std::shared_ptr<Texture> texture = i->second.lock();
+
+	if (!texture)
+	{
+		m_paths.erase(i);
+		return texture;
+	}
+
+	m_pathHits++;
+	entry(texture).references++;
+	return texture;
+}
+
+std::shared_ptr<Texture> TextureCache::acquireContent(std::uint64_t contentHash, const std::shared_ptr<Texture> & duplicate)
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+
+	auto i = m_contents.find(contentHash);
+
+	if (i == m_contents.end())
+		return std::shared_ptr<Texture>();
+
+	std::shared_ptr<Texture> texture = i->second.lock();
+
+	if (!texture)
+	{
+		m_contents.erase(i);
+		return texture;
+	}
+
+	if (texture == duplicate)
+		return texture;
+
+	// the first request for the duplicate was counted as miss by insert()
+	m_misses--;
+	m_contentHits++;
+
+	Entry & duplicateEntry = entry(duplicate);
+	entry(texture).references += duplicateEntry.references;
+	duplicateEntry.references = 0;
+
+	for (auto & p : m_paths)
+	{
+		if (p.second.lock() == duplicate)
+			p.second = texture;
+	}
+
+	return texture;
+}
+
+bool TextureCache::containsContent(std::uint64_t contentHash) const
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	auto i = m_contents.find(contentHash);
+	return i != m_contents.end() && !i->second.expired();
+}
+
+void TextureCache::insert(const std::string & path, const std::shared_ptr<Texture> & texture)
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_misses++;
+	m_paths[path] = texture;
+	entry(texture).references++;
+}
+
+void TextureCache::setContent(const std::shared_ptr<Texture> & texture, std::uint64_t contentHash, std::size_t bytes, std::size_t uncompressedBytes)
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_contents[contentHash] = texture;
+	entry(texture).bytes = bytes;
+	entry(texture).uncompressedBytes = uncompressedBytes;
+}
+
+TextureCache::Statistics TextureCache::statistics() const
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+
+	Statistics statistics;
+	statistics.requests = m_requests;
+	statistics.pathHits = m_pathHits;
+	statistics.contentHits = m_contentHits;
+	statistics.misses = m_misses;
+
+	for (auto & e : m_entries)
+	{
+		if (e.second.texture.expired())
+			continue;
+
+		statistics.textures++;
+		statistics.residentBytes += e.second.bytes;
+		statistics.uncompressedBytes += e.second.uncompressedBytes;
+
+		if (e.second.references > 1)
+			statistics.savedBytes += e.second.bytes * (e.second.references - 1);
+	}
+
+	return statistics;
+}
+
+TextureCache::Entry & TextureCache::entry(const std::shared_ptr<Texture> & texture)
+{
+	Entry & e = m_entries[texture.get()];
+
+	// a texture may reuse the address of a released one
+	if (e.texture.lock() != texture)
+		e = Entry{ texture, 0, 0 };
+
+	return e;
+}
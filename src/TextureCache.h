@@ -0,0 +1,81 @@
+#pragma once
+
+#include <globjects/Texture.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace minity
+{
+	// process-wide registry of the loaded textures, so that all materials referencing the same image share one texture,
+	// textures are found by canonical path and, once decoded, by a hash of the file content, the TextureLoader combines both
+	// with the usage of the texture,
+	// only weak references are kept, so a texture is released together with the last material using it
+	class TextureCache
+	{
+	public:
+
+		struct Statistics
+		{
+			std::size_t requests = 0;
+			std::size_t pathHits = 0;
+			std::size_t contentHits = 0;
+			std::size_t misses = 0;
+			// textures which are currently alive
+			std::size_t textures = 0;
+			// estimated size of the alive textures including their mipmaps
+			std::size_t residentBytes = 0;
+			// size the alive textures would have without block compression
+			std::size_t uncompressedBytes = 0;
+			// memory which would have been used by the duplicates that were shared instead
+			std::size_t savedBytes = 0;
+		};
+
+		static TextureCache & instance();
+
+		static std::string canonicalPath(const std::string & filename);
+
+		// returns the texture loaded for the path, or an empty pointer, and counts the request
+		std::shared_ptr<globjects::Texture> acquire(const std::string & path);
+
+		// returns a texture with the given content, which replaces the duplicate texture created for the path by insert() before
+		std::shared_ptr<globjects::Texture> acquireContent(std::uint64_t contentHash, const std::shared_ptr<globjects::Texture> & duplicate);
+		bool containsContent(std::uint64_t contentHash) const;
+
+		// registers a new texture for the path and counts the request as miss
+		void insert(const std::string & path, const std::shared_ptr<globjects::Texture> & texture);
+		// called when the image of a texture is known
+		void setContent(const std::shared_ptr<globjects::Texture> & texture, std::uint64_t contentHash, std::size_t bytes, std::size_t uncompressedBytes);
+
+		Statistics statistics() const;
+
+	private:
+
+		TextureCache() = default;
+
+		struct Entry
+		{
+			std::weak_ptr<globjects::Texture> texture;
+			std::size_t bytes = 0;
+			std::size_t uncompressedBytes = 0;
+			// number of requests which were answered with this texture
+			std::size_t references = 0;
+		};
+
+		Entry & entry(const std::shared_ptr<globjects::Texture> & texture);
+
+		mutable std::mutex m_mutex;
+		std::unordered_map< std::string, std::weak_ptr<globjects::Texture> > m_paths;
+		std::unordered_map< std::uint64_t, std::weak_ptr<globjects::Texture> > m_contents;
+		std::unordered_map< const globjects::Texture*, Entry > m_entries;
+
+		std::size_t m_requests = 0;
+		std::size_t m_pathHits = 0;
+		std::size_t m_contentHits = 0;
+		std::size_t m_misses = 0;
+	};
+}
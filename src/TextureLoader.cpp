@@ -0,0 +1,484 @@
+#include "TextureLoader.h"
+#include "TextureCache.h"
+#include "MappedFile.h"
+#include "CacheFile.h"
+#include "MipmapCache.h"
+
+#include <iostream>
+#include <chrono>
+#include <cstring>
+#include <globjects/globjects.h>
+#include <globjects/logging.h>
+
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+
+using namespace minity;
+using namespace gl;
+using namespace glm;
+using namespace globjects;
+
+TextureLoader::TextureLoader(const LoadOptions & options) : m_options(options), m_pool(options.threadCount)
+{
+	if (options.textureCompression)
+		m_formats = BlockCompressor::supportedFormats();
+
+	// the flag is global in stb_image, so it is set once before any worker decodes
+	stbi_set_flip_vertically_on_load(true);
+}
+
+TextureLoader::~TextureLoader()
+{
+
+}
+
+void TextureLoader::prefetch(const std::string & filename, Usage usage)
+{
+	const std::string path = requestPath(filename);
+	Request * request = nullptr;
+
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		auto & slot = m_requests[cacheKey(path, usage)];
+
+		if (slot)
+			return;
+
+		slot = std::make_unique<Request>();
+		slot->filename = path;
+		slot->usage = usage;
+		request = slot.get();
+	}
+
+	m_pool.submit([this, request]() {
+		Image image = decode(request->filename, request->usage, m_options, m_formats, true);
+
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			request->image = std::move(image);
+			request->decoded = true;
+			m_finished.push_back(request);
+		}
+
+		m_decoded.notify_all();
+	});
+}
+
+std::shared_ptr<Texture> TextureLoader::texture(const std::string & filename, Usage usage)
+{
+	const std::string path = requestPath(filename);
+	const std::string key = cacheKey(path, usage);
+
+	// textures of earlier loads are reused without reading the file again
+	if (auto texture = TextureCache::instance().acquire(key))
+		return texture;
+
+	prefetch(path, usage);
+
+	Request * request = nullptr;
+	bool decoded = false;
+
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		request = m_requests.at(key).get();
+		decoded = request->decoded;
+	}
+
+	if (!request->texture)
+	{
+		request->texture = createTexture(placeholder(request->usage));
+		TextureCache::instance().insert(key, request->texture);
+		m_pendingCount++;
+
+		// update() skips images which were decoded before anyone asked for their texture
+		if (decoded)
+			uploadRequest(*request);
+	}
+
+	return request->texture;
+}
+
+std::size_t TextureLoader::update()
+{
+	std::vector<Request*> finished;
+
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		finished.swap(m_finished);
+	}
+
+	std::size_t uploadCount = 0;
+
+	for (auto request : finished)
+	{
+		if (request->texture && !request->uploaded)
+		{
+			uploadRequest(*request);
+			uploadCount++;
+		}
+	}
+
+	return uploadCount;
+}
+
+bool TextureLoader::replaceDuplicates(std::vector<Material> & materials)
+{
+	if (m_replacements.empty())
+		return false;
+
+	for (auto & m : materials)
+	{
+		for (auto texture : { &m.ambientTexture, &m.diffuseTexture, &m.specularTexture, &m.shininessTexture, &m.bumpTexture, &m.objectSpaceNormalTexture, &m.tangentSpaceNormalTexture })
+		{
+			for (auto & r : m_replacements)
+			{
+				if (*texture == r.first)
+					*texture = r.second;
+			}
+		}
+	}
+
+	m_replacements.clear();
+	return true;
+}
+
+void TextureLoader::finish()
+{
+	while (m_pendingCount > 0)
+	{
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_decoded.wait(lock, [this]() { return !m_finished.empty(); });
+		}
+
+		update();
+	}
+}
+
+std::size_t TextureLoader::pendingCount() const
+{
+	return m_pendingCount;
+}
+
+std::shared_ptr<Texture> TextureLoader::load(const std::string & filename, Usage usage, const LoadOptions & options)
+{
+	TextureCache & cache = TextureCache::instance();
+	const std::string path = TextureCache::canonicalPath(filename);
+	const std::string key = cacheKey(path, usage);
+
+	if (auto texture = cache.acquire(key))
+		return texture;
+
+	const unsigned int formats = options.textureCompression ? BlockCompressor::supportedFormats() : 0;
+
+	stbi_set_flip_vertically_on_load(true);
+	Image image = decode(path, usage, options, formats, true);
+
+	std::shared_ptr<Texture> texture = createTexture(placeholder(usage));
+	cache.insert(key, texture);
+
+	if (auto shared = cache.acquireContent(contentKey(image.contentHash, usage), texture))
+		return shared;
+
+	if (!image.data && image.contentHash != 0)
+		image = decode(path, usage, options, formats);
+
+	if (!image.data)
+		return std::shared_ptr<Texture>();
+
+	std::cout << "Loaded " << filename << std::endl;
+
+	upload(*texture, image);
+	cache.setContent(texture, contentKey(image.contentHash, usage), byteSize(image), uncompressedByteSize(image));
+	return texture;
+}
+
+TextureLoader::Image TextureLoader::decode(const std::string & filename, Usage usage, const LoadOptions & options, unsigned int formats, bool skipCachedContent)
+{
+	const bool srgb = usage == Usage::Color;
+	MipmapCache mipmapCache(filename, usage, options.cacheDirectory);
+	Image image;
+
+	// the cache file knows the content hash, so the source image is not even read,
+	// it is only used if it was compressed to the format this context would choose
+	if (options.textureCache && mipmapCache.read(image, srgb) && image.format == compressedFormat(usage, image.channels, formats))
+	{
+		if (skipCachedContent && TextureCache::instance().containsContent(contentKey(image.contentHash, usage)))
+		{
+			image.levels.clear();
+			image.data = nullptr;
+			image.storage.reset();
+		}
+
+		return image;
+	}
+
+	image = Image();
+	MappedFile file;
+
+	if (!file.open(filename) || file.size() == 0)
+		return image;
+
+	image.contentHash = hashBytes(file.data(), file.size());
+
+	if (skipCachedContent && TextureCache::instance().containsContent(contentKey(image.contentHash, usage)))
+		return image;
+
+	int width, height, channels;
+	unsigned char * pixels = stbi_load_from_memory(reinterpret_cast<const unsigned char*>(file.data()), int(file.size()), &width, &height, &channels, 0);
+
+	if (!pixels)
+		return image;
+
+	image.width = width;
+	image.height = height;
+	image.channels = channels;
+	image.levels = MipmapGenerator::layout(width, height, channels);
+
+	const MipmapGenerator::Level & lastLevel = image.levels.back();
+	auto data = std::make_shared< std::vector<unsigned char> >(lastLevel.offset + lastLevel.size);
+
+	std::copy(pixels, pixels + image.levels.front().size, data->data());
+	stbi_image_free(pixels);
+
+	MipmapGenerator::generate(data->data(), image.levels, channels, srgb);
+
+	image.data = data->data();
+	image.storage = data;
+
+	const BlockCompressor::Format format = compressedFormat(usage, channels, formats);
+
+	if (format != BlockCompressor::Format::None)
+	{
+		const auto encodeStart = std::chrono::steady_clock::now();
+
+		std::vector<MipmapGenerator::Level> blockLevels = image.levels;
+		std::size_t offset = 0;
+
+		for (auto & level : blockLevels)
+		{
+			level.offset = offset;
+			level.size = BlockCompressor::compressedSize(format, level.width, level.height);
+			offset = (offset + level.size + 15) & ~std::size_t(15);
+		}
+
+		auto blocks = std::make_shared< std::vector<unsigned char> >(offset);
+
+		for (std::size_t i = 0; i < blockLevels.size(); i++)
+			BlockCompressor::compress(format, image.data + image.levels[i].offset, image.levels[i].width, image.levels[i].height, channels, blocks->data() + blockLevels[i].offset);
+
+		image.format = format;
+		image.levels = blockLevels;
+		image.data = blocks->data();
+		image.storage = blocks;
+		image.encodeSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - encodeStart).count();
+	}
+
+	if (options.textureCache && !mipmapCache.write(image, srgb))
+		globjects::debug() << "Could not write mipmap cache " << mipmapCache.cacheFilename();
+
+	return image;
+}
+
+const char * TextureLoader::name(Usage usage)
+{
+	switch (usage)
+	{
+	case Usage::Color:
+		return "color";
+
+	case Usage::Data:
+		return "data";
+
+	case Usage::ObjectSpaceNormal:
+		return "normal";
+
+	case Usage::TangentSpaceNormal:
+		return "tangent-normal";
+	}
+
+	return "unknown";
+}
+
+BlockCompressor::Format TextureLoader::compressedFormat(Usage usage, int channels, unsigned int formats)
+{
+	using Format = BlockCompressor::Format;
+
+	auto choose = [formats](Format format) {
+		return (formats & BlockCompressor::formatBit(format)) ? format : Format::None;
+	};
+
+	// two channels are enough for unit length tangent space normals
+	if (usage == Usage::TangentSpaceNormal && channels >= 2)
+		return choose(Format::BC5);
+
+	switch (channels)
+	{
+	case 1:
+		return choose(Format::BC4);
+
+	case 2:
+		return choose(Format::BC5);
+
+	case 3:
+		return choose(Format::BC1);
+
+	case 4:
+		// BC7 keeps the colors of blocks with alpha far better than BC3, which shares them with the BC1 block
+		if (choose(Format::BC7) != Format::None)
+			return Format::BC7;
+
+		return choose(Format::BC3);
+	}
+
+	return Format::None;
+}
+
+u8vec4 TextureLoader::placeholder(Usage usage)
+{
+	if (usage == Usage::ObjectSpaceNormal || usage == Usage::TangentSpaceNormal)
+		return u8vec4(128, 128, 255, 255);
+
+	return u8vec4(255, 255, 255, 255);
+}
+
+std::unique_ptr<Texture> TextureLoader::createTexture(const u8vec4 & color)
+{
+	auto texture = Texture::create(GL_TEXTURE_2D);
+	texture->setParameter(GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+	texture->setParameter(GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	texture->setParameter(GL_TEXTURE_WRAP_S, GL_REPEAT);
+	texture->setParameter(GL_TEXTURE_WRAP_T, GL_REPEAT);
+
+	// a single texel is a complete mipmap chain
+	texture->image2D(0, GL_RGBA, ivec2(1, 1), 0, GL_RGBA, GL_UNSIGNED_BYTE, &color);
+	return texture;
+}
+
+void TextureLoader::upload(Texture & texture, const Image & image)
+{
+	GLenum format = GL_RGBA;
+
+	switch (image.channels)
+	{
+	case 1:
+		format = GL_RED;
+		break;
+
+	case 2:
+		format = GL_RG;
+		break;
+
+	case 3:
+		format = GL_RGB;
+		break;
+
+	case 4:
+		format = GL_RGBA;
+		break;
+	}
+
+	// the rows of the levels are tightly packed, which is not four byte aligned for odd widths
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+	// the CPU already built the whole chain, so the GPU does not need to generate mipmaps
+	for (std::size_t i = 0; i < image.levels.size(); i++)
+	{
+		const MipmapGenerator::Level & level = image.levels[i];
+
+		if (image.format != BlockCompressor::Format::None)
+			texture.compressedImage2D(GLint(i), BlockCompressor::internalFormat(image.format), ivec2(level.width, level.height), 0, GLsizei(level.size), image.data + level.offset);
+		else
+			texture.image2D(GLint(i), format, ivec2(level.width, level.height), 0, format, GL_UNSIGNED_BYTE, image.data + level.offset);
+	}
+
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+}
+
+std::size_t TextureLoader::byteSize(const Image & image)
+{
+	std::size_t size = 0;
+
+	for (const auto & level : image.levels)
+		size += level.size;
+
+	return size;
+}
+
+std::size_t TextureLoader::uncompressedByteSize(const Image & image)
+{
+	std::size_t size = 0;
+
+	for (const auto & level : image.levels)
+		size += std::size_t(level.width) * std::size_t(level.height) * std::size_t(image.channels);
+
+	return size;
+}
+
+std::string TextureLoader::cacheKey(const std::string & path, Usage usage)
+{
+	return path + "#" + name(usage);
+}
+
+std::uint64_t TextureLoader::contentKey(std::uint64_t contentHash, Usage usage)
+{
+	const char * usageName = name(usage);
+	return hashBytes(usageName, std::strlen(usageName), contentHash);
+}
+
+std::string TextureLoader::requestPath(const std::string & filename)
+{
+	// the same file names are requested over and over by materials sharing their maps
+	auto i = m_paths.find(filename);
+
+	if (i != m_paths.end())
+		return i->second;
+
+	return m_paths.emplace(filename, TextureCache::canonicalPath(filename)).first->second;
+}
+
+void TextureLoader::uploadRequest(Request & request)
+{
+	TextureCache & cache = TextureCache::instance();
+	std::shared_ptr<Texture> shared;
+
+	// another file with the same content may have been loaded in the meantime
+	if (request.image.contentHash != 0)
+		shared = cache.acquireContent(contentKey(request.image.contentHash, request.usage), request.texture);
+
+	if (shared && shared != request.texture)
+	{
+		m_replacements.emplace_back(request.texture, shared);
+		request.texture = shared;
+	}
+	else
+	{
+		// the decoding was skipped, but the texture with the same content has been released since
+		if (!request.image.data && request.image.contentHash != 0)
+			request.image = decode(request.filename, request.usage, m_options, m_formats);
+
+		if (request.image.data)
+		{
+			std::cout << "Loaded " << request.filename << std::endl;
+
+			if (request.image.encodeSeconds > 0.0)
+			{
+				globjects::debug() << "Compressed " << request.filename << " to " << BlockCompressor::name(request.image.format) << " in " << request.image.encodeSeconds << " s ("
+					<< uncompressedByteSize(request.image) / (1024.0 * 1024.0) / request.image.encodeSeconds << " MiB/s), "
+					<< uncompressedByteSize(request.image) / 1024 << " KiB to " << byteSize(request.image) / 1024 << " KiB";
+			}
+
+			upload(*request.texture, request.image);
+			cache.setContent(request.texture, contentKey(request.image.contentHash, request.usage), byteSize(request.image), uncompressedByteSize(request.image));
+		}
+		else
+		{
+			// the placeholder stays in place, so the material still renders
+			globjects::debug() << "Could not load texture " << request.filename;
+		}
+	}
+
+	request.image = Image();
+	request.uploaded = true;
+	m_pendingCount--;
+}
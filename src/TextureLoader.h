@@ -0,0 +1,145 @@
+#pragma once
+
+#include "Model.h"
+#include "ThreadPool.h"
+#include "MipmapGenerator.h"
+#include "BlockCompressor.h"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/type_precision.hpp>
+#include <globjects/Texture.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace minity
+{
+	// decodes image files on a thread pool while the main thread continues loading,
+	// the textures handed out show a placeholder color until update() uploads the decoded image,
+	// all textures are shared through the TextureCache
+	class TextureLoader
+	{
+	public:
+
+		// decides about the placeholder and how the mipmaps are filtered
+		enum class Usage
+		{
+			// sRGB encoded colors, white until loaded
+			Color,
+			// linear values, white until loaded
+			Data,
+			// object space normals, all three components are needed
+			ObjectSpaceNormal,
+			// tangent space normals, z is reconstructed in the shader, pointing along z until loaded
+			TangentSpaceNormal
+		};
+
+		struct Image
+		{
+			int width = 0;
+			int height = 0;
+			int channels = 0;
+			std::uint64_t contentHash = 0;
+			// the levels hold blocks of this format, or tightly packed texels if it is None
+			BlockCompressor::Format format = BlockCompressor::Format::None;
+			// time spent in the block compressor, zero if the image came from the cache or is not compressed
+			double encodeSeconds = 0.0;
+			// level 0 first, data is null if the image could not be loaded
+			std::vector<MipmapGenerator::Level> levels;
+			const unsigned char * data = nullptr;
+			// owns data, either the decoded pixels or the mapped mipmap cache file
+			std::shared_ptr<void> storage;
+		};
+
+		// uses the thread count, the cache directory and the texture cache and compression settings of the options,
+		// the compressed formats are queried from the current context
+		TextureLoader(const LoadOptions & options = LoadOptions());
+		~TextureLoader();
+
+		TextureLoader(const TextureLoader &) = delete;
+		TextureLoader & operator=(const TextureLoader &) = delete;
+
+		// starts decoding the file on the pool if it is not already requested, does not need an OpenGL context
+		void prefetch(const std::string & filename, Usage usage);
+
+		// needs the OpenGL context, all requests of the same file and usage share one texture
+		std::shared_ptr<globjects::Texture> texture(const std::string & filename, Usage usage);
+
+		// uploads the images decoded since the last call, needs the OpenGL context
+		std::size_t update();
+
+		// files with different paths but identical content are only detected once they are read, so the textures
+		// handed out for them are replaced by the shared one here, returns whether any material changed
+		bool replaceDuplicates(std::vector<Material> & materials);
+
+		// blocks until all requested textures are uploaded
+		void finish();
+
+		// number of requested textures which are not uploaded yet
+		std::size_t pendingCount() const;
+
+		// loads the texture on the calling thread, also through the cache
+		static std::shared_ptr<globjects::Texture> load(const std::string & filename, Usage usage, const LoadOptions & options = LoadOptions());
+
+		// reads the image with all mipmaps from the mipmap cache, or hashes and decodes the file, builds the mipmaps
+		// and compresses them to the best of the given formats, nothing is decoded if skipCachedContent is set
+		// and the content is already in the TextureCache
+		static Image decode(const std::string & filename, Usage usage, const LoadOptions & options, unsigned int formats, bool skipCachedContent = false);
+
+		// the block compressed format for the usage and channel count, None if no suitable format is in formats
+		static BlockCompressor::Format compressedFormat(Usage usage, int channels, unsigned int formats);
+		static glm::u8vec4 placeholder(Usage usage);
+		static const char * name(Usage usage);
+		static std::unique_ptr<globjects::Texture> createTexture(const glm::u8vec4 & color);
+		static void upload(globjects::Texture & texture, const Image & image);
+		// texture memory including the mipmaps
+		static std::size_t byteSize(const Image & image);
+		// texture memory the image would need without block compression
+		static std::size_t uncompressedByteSize(const Image & image);
+
+	private:
+
+		struct Request
+		{
+			std::string filename;
+			Usage usage = Usage::Color;
+			Image image;
+			bool decoded = false;
+			bool uploaded = false;
+			std::shared_ptr<globjects::Texture> texture;
+		};
+
+		// the same file is decoded to different textures for each usage, as the usage decides about the sRGB filtering of the
+		// mipmaps and the compressed format, so requests and the TextureCache tell them apart by these keys
+		static std::string cacheKey(const std::string & path, Usage usage);
+		static std::uint64_t contentKey(std::uint64_t contentHash, Usage usage);
+
+		std::string requestPath(const std::string & filename);
+
+		void uploadRequest(Request & request);
+
+		LoadOptions m_options;
+		unsigned int m_formats = 0;
+
+		mutable std::mutex m_mutex;
+		std::condition_variable m_decoded;
+		std::unordered_map< std::string, std::unique_ptr<Request> > m_requests;
+		std::vector<Request*> m_finished;
+		std::size_t m_pendingCount = 0;
+
+		// canonical paths of the requested file names, only used on the main thread
+		std::unordered_map< std::string, std::string > m_paths;
+
+		// duplicate texture and the shared texture replacing it
+		std::vector< std::pair< std::shared_ptr<globjects::Texture>, std::shared_ptr<globjects::Texture> > > m_replacements;
+
+		// declared last, so that the workers are joined before the requests are destroyed
+		ThreadPool m_pool;
+	};
+}
@@ -0,0 +1,90 @@
+#include "ThreadPool.h"
+
+#include <algorithm>
+
+using namespace minity;
+
+ThreadPool::ThreadPool(unsigned int threadCount)
+{
+	if (threadCount == 0)
+		threadCount = hardwareThreads();
+
+	m_threads.reserve(threadCount);
+
+	for (unsigned int i = 0; i < threadCount; i++)
+		m_threads.emplace_back(&ThreadPool::work, this);
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_stopping = true;
+	}
+
+	m_condition.notify_all();
+
+	for (auto & t : m_threads)
+		t.join();
+}
+
+unsigned int ThreadPool::threadCount() const
+{
+	return unsigned(m_threads.size());
+}
+
+std::future<void> ThreadPool::submit(std::function<void()> task)
+{
+	std::packaged_task<void()> packagedTask(std::move(task));
+	std::future<void> future = packagedTask.get_future();
+
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_tasks.push(std::move(packagedTask));
+	}
+
+	m_condition.notify_one();
+	return future;
+}
+
+void ThreadPool::parallelFor(std::size_t count, const std::function<void(std::size_t)> & function)
+{
+	std::vector< std::future<void> > futures;
+	futures.reserve(count);
+
+	for (std::size_t i = 0; i < count; i++)
+		futures.push_back(submit([&function, i]() { function(i); }));
+
+	// get() rethrows exceptions from the workers, but all tasks have to be finished before returning
+	for (auto & f : futures)
+		f.wait();
+
+	for (auto & f : futures)
+		f.get();
+}
+
+unsigned int ThreadPool::hardwareThreads()
+{
+	return std::max(1u, std::thread::hardware_concurrency());
+}
+
+void ThreadPool::work()
+{
+	while (true)
+	{
+		std::packaged_task<void()> task;
+
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_condition.wait(lock, [this]() { return m_stopping || !m_tasks.empty(); });
+
+			if (m_tasks.empty())
+				return;
+
+			task = std::move(m_tasks.front());
+			m_tasks.pop();
+		}
+
+		task();
+	}
+}
\ No newline at end of file
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <vector>
+#include <queue>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <future>
+
+namespace minity
+{
+	class ThreadPool
+	{
+	public:
+		// a thread count of zero uses all hardware threads
+		ThreadPool(unsigned int threadCount = 0);
+		~ThreadPool();
+
+		ThreadPool(const ThreadPool &) = delete;
+		ThreadPool & operator=(const ThreadPool &) = delete;
+
+		unsigned int threadCount() const;
+
+		std::future<void> submit(std::function<void()> task);
+
+		// calls function(i) for all i in [0,count) on the pool and waits for completion,
+		// must not be called from one of the pool's own worker threads
+		void parallelFor(std::size_t count, const std::function<void(std::size_t)> & function);
+
+		static unsigned int hardwareThreads();
+
+	private:
+
+		void work();
+
+		std::vector<std::thread> m_threads;
+		std::queue< std::packaged_task<void()> > m_tasks;
+		std::mutex m_mutex;
+		std::condition_variable m_condition;
+		bool m_stopping = false;
+	};
+}
\ No newline at end of file
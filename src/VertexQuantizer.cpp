@@ -0,0 +1,127 @@
+#include "VertexQuantizer.h"
+
+#include <glm/gtc/packing.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+using namespace glm;
+using namespace minity;
+
+namespace
+{
+	float signNotZero(float value)
+	{
+		return value < 0.0f ? -1.0f : 1.0f;
+	}
+
+	// the octahedral coordinates in [-1,1] before quantization
+	vec2 octahedralProject(const vec3 & direction)
+	{
+		const float l1 = std::abs(direction.x) + std::abs(direction.y) + std::abs(direction.z);
+
+		if (!(l1 > 0.0f))
+			return vec2(0.0f);
+
+		vec2 p = vec2(direction.x, direction.y) / l1;
+
+		// the lower hemisphere is folded over the diagonals
+		if (direction.z < 0.0f)
+			p = vec2((1.0f - std::abs(p.y)) * signNotZero(p.x), (1.0f - std::abs(p.x)) * signNotZero(p.y));
+
+		return p;
+	}
+
+	vec3 octahedralUnproject(const vec2 & p)
+	{
+		vec3 v(p.x, p.y, 1.0f - std::abs(p.x) - std::abs(p.y));
+
+		if (v.z < 0.0f)
+		{
+			const float x = v.x;
+			v.x = (1.0f - std::abs(v.y)) * signNotZero(x);
+			v.y = (1.0f - std::abs(x)) * signNotZero(v.y);
+		}
+
+		return normalize(v);
+	}
+
+	std::int16_t snorm16(float scaled)
+	{
+		return std::int16_t(std::clamp(scaled, -32767.0f, 32767.0f));
+	}
+}
+
+std::vector<CompactVertex> VertexQuantizer::quantize(const std::vector<Vertex> & vertices, const vec3 & minimumBounds, const vec3 & maximumBounds)
+{
+	std::vector<CompactVertex> compact(vertices.size());
+
+	for (std::size_t i = 0; i < vertices.size(); i++)
+		compact[i] = quantize(vertices[i], minimumBounds, maximumBounds);
+
+	return compact;
+}
+
+CompactVertex VertexQuantizer::quantize(const Vertex & vertex, const vec3 & minimumBounds, const vec3 & maximumBounds)
+{
+	CompactVertex compact;
+
+	for (int k = 0; k < 3; k++)
+	{
+		const float extent = maximumBounds[k] - minimumBounds[k];
+		const float t = extent > 0.0f ? (vertex.position[k] - minimumBounds[k]) / extent : 0.0f;
+		compact.position[k] = std::uint16_t(std::round(std::clamp(t, 0.0f, 1.0f) * 65535.0f));
+	}
+
+	compact.position.w = vertex.tangent.w < 0.0f ? 0 : 65535;
+	compact.normal = octahedralEncode(vertex.normal);
+	compact.tangent = octahedralEncode(vec3(vertex.tangent));
+	compact.texcoord = u16vec2(packHalf1x16(vertex.texcoord.x), packHalf1x16(vertex.texcoord.y));
+
+	return compact;
+}
+
+Vertex VertexQuantizer::dequantize(const CompactVertex & vertex, const vec3 & minimumBounds, const vec3 & maximumBounds)
+{
+	Vertex v;
+
+	for (int k = 0; k < 3; k++)
+		v.position[k] = minimumBounds[k] + float(vertex.position[k]) / 65535.0f * (maximumBounds[k] - minimumBounds[k]);
+
+	v.normal = octahedralDecode(vertex.normal);
+	v.texcoord = vec2(unpackHalf1x16(vertex.texcoord.x), unpackHalf1x16(vertex.texcoord.y));
+	v.tangent = vec4(octahedralDecode(vertex.tangent), vertex.position.w == 0 ? -1.0f : 1.0f);
+
+	return v;
+}
+
+i16vec2 VertexQuantizer::octahedralEncode(const vec3 & direction)
+{
+	const vec2 p = octahedralProject(direction);
+	const vec3 unit = dot(direction, direction) > 0.0f ? normalize(direction) : vec3(0.0f, 0.0f, 1.0f);
+
+	// rounding down and up in each coordinate, the closest of the four decodes wins
+	i16vec2 best(0, 0);
+	float bestDot = -2.0f;
+
+	for (int i = 0; i < 4; i++)
+	{
+		const float x = (i & 1) ? std::floor(p.x * 32767.0f) : std::ceil(p.x * 32767.0f);
+		const float y = (i & 2) ? std::floor(p.y * 32767.0f) : std::ceil(p.y * 32767.0f);
+		const i16vec2 candidate(snorm16(x), snorm16(y));
+		const float d = dot(octahedralDecode(candidate), unit);
+
+		if (d > bestDot)
+		{
+			bestDot = d;
+			best = candidate;
+		}
+	}
+
+	return best;
+}
+
+vec3 VertexQuantizer::octahedralDecode(const i16vec2 & encoded)
+{
+	return octahedralUnproject(vec2(std::max(float(encoded.x) / 32767.0f, -1.0f), std::max(float(encoded.y) / 32767.0f, -1.0f)));
+}
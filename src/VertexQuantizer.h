@@ -0,0 +1,25 @@
+#pragma once
+
+#include "Model.h"
+
+#include <vector>
+
+namespace minity
+{
+	// converts vertices to the compact layout uploaded with LoadOptions::compactVertices and back
+	class VertexQuantizer
+	{
+	public:
+
+		// positions are quantized within the given bounds, positions outside of them are clamped
+		static std::vector<CompactVertex> quantize(const std::vector<Vertex> & vertices, const glm::vec3 & minimumBounds, const glm::vec3 & maximumBounds);
+		static CompactVertex quantize(const Vertex & vertex, const glm::vec3 & minimumBounds, const glm::vec3 & maximumBounds);
+
+		// the inverse as done in the vertex shaders, for measuring the error
+		static Vertex dequantize(const CompactVertex & vertex, const glm::vec3 & minimumBounds, const glm::vec3 & maximumBounds);
+
+		// maps a unit vector onto an octahedron unfolded into the unit square, choosing the rounding with the smallest angular error
+		static glm::i16vec2 octahedralEncode(const glm::vec3 & direction);
+		static glm::vec3 octahedralDecode(const glm::i16vec2 & encoded);
+	};
+}
@@ -83,6 +83,8 @@ void Viewer::display()
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 	glViewport(0, 0, viewportSize().x, viewportSize().y);
 
+	m_drawnTriangles = 0;
+
 	for (auto& r : m_renderers)
 	{
 		if (r->isEnabled())
@@ -464,6 +466,16 @@ float Viewer::explosion() const
 	return expl_degree;
 }
 
+std::size_t & Viewer::drawnTriangles()
+{
+	return m_drawnTriangles;
+}
+
+std::size_t Viewer::drawnTriangles() const
+{
+	return m_drawnTriangles;
+}
+
 Animation & Viewer::animation()
 {
 	return anim;
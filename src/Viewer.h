@@ -52,6 +52,10 @@ namespace minity
 		float &explosion();
 		float explosion() const;
 
+		// triangles submitted by the renderers in the current frame, after culling and with the drawn levels of detail
+		std::size_t & drawnTriangles();
+		std::size_t drawnTriangles() const;
+
 		bool& addFrame();
 		bool addFrame() const;
 
@@ -97,6 +101,7 @@ namespace minity
 		bool m_saveScreenshot = false;
 
 		float expl_degree = 0.0f;
+		std::size_t m_drawnTriangles = 0;
 
 		bool add_frame = false, rem_frame = false, m_play = false, clear_frames = false;
 
@@ -1,4 +1,6 @@
 #include <iostream>
+#include <cstdlib>
+#include <chrono>
 
 #include <glbinding/Version.h>
 #include <glbinding/Binding.h>
@@ -26,6 +28,8 @@
 #include "Viewer.h"
 #include "Interactor.h"
 #include "Renderer.h"
+#include "Benchmark.h"
+#include "TextureCache.h"
 
 using namespace gl;
 using namespace glm;
@@ -39,6 +43,74 @@ void error_callback(int errnum, const char * errmsg)
 
 int main(int argc, char *argv[])
 {
+	const auto startTime = std::chrono::steady_clock::now();
+
+	std::string fileName = "./dat/bunny.obj";
+	bool fileNameGiven = false;
+	LoadOptions loadOptions;
+	std::string benchmarkName;
+	std::string analysisFilename;
+
+	for (int i = 1; i < argc; i++)
+	{
+		const std::string argument(argv[i]);
+
+		if (argument == "--parser=stream")
+			loadOptions.parser = LoadOptions::Parser::Stream;
+		else if (argument == "--parser=mapped")
+			loadOptions.parser = LoadOptions::Parser::Mapped;
+		else if (argument == "--parser=parallel")
+			loadOptions.parser = LoadOptions::Parser::Parallel;
+		else if (argument.rfind("--threads=", 0) == 0)
+			loadOptions.threadCount = unsigned(std::strtoul(argument.c_str() + 10, nullptr, 10));
+		else if (argument == "--normals=uniform")
+			loadOptions.normalWeighting = LoadOptions::NormalWeighting::Uniform;
+		else if (argument == "--normals=area")
+			loadOptions.normalWeighting = LoadOptions::NormalWeighting::Area;
+		else if (argument == "--normals=angle")
+			loadOptions.normalWeighting = LoadOptions::NormalWeighting::Angle;
+		else if (argument.rfind("--crease-angle=", 0) == 0)
+			loadOptions.creaseAngle = std::strtof(argument.c_str() + 15, nullptr);
+		else if (argument == "--no-weld")
+			loadOptions.weldVertices = false;
+		else if (argument == "--no-optimize")
+			loadOptions.optimizeMesh = false;
+		else if (argument == "--no-lod")
+			loadOptions.levelsOfDetail = false;
+		else if (argument == "--compact-vertices")
+			loadOptions.compactVertices = true;
+		else if (argument.rfind("--memory-limit=", 0) == 0)
+			loadOptions.memoryLimit = std::size_t(std::strtoull(argument.c_str() + 15, nullptr, 10)) << 20;
+		else if (argument == "--no-cache")
+			loadOptions.meshCache = false;
+		else if (argument == "--no-texture-cache")
+			loadOptions.textureCache = false;
+		else if (argument == "--sync-textures")
+			loadOptions.asyncTextures = false;
+		else if (argument == "--no-texture-compression")
+			loadOptions.textureCompression = false;
+		else if (argument.rfind("--cache-dir=", 0) == 0)
+			loadOptions.cacheDirectory = argument.substr(12);
+		else if (argument.rfind("--benchmark=", 0) == 0)
+			benchmarkName = argument.substr(12);
+		else if (argument.rfind("--load-statistics=", 0) == 0)
+			loadOptions.statisticsFilename = argument.substr(18);
+		else if (argument.rfind("--analyze=", 0) == 0)
+			analysisFilename = argument.substr(10);
+		else
+		{
+			fileName = argument;
+			fileNameGiven = true;
+		}
+	}
+
+	// benchmarks do not need a window, so they run before any initialization
+	if (!benchmarkName.empty())
+		return Benchmark::run(benchmarkName, fileName, loadOptions) ? 0 : 1;
+
+	if (!analysisFilename.empty())
+		return Benchmark::analyze(fileName, loadOptions, analysisFilename) ? 0 : 1;
+
 	// Initialize GLFW
 	if (!glfwInit())
 		return 1;
@@ -80,11 +152,7 @@ int main(int argc, char *argv[])
 		<< "OpenGL Vendor:   " << glbinding::aux::ContextInfo::vendor() << std::endl
 		<< "OpenGL Renderer: " << glbinding::aux::ContextInfo::renderer() << std::endl;
 
-	std::string fileName = "./dat/bunny.obj";
-
-	if (argc > 1)
-		fileName = std::string(argv[1]);
-	else
+	if (!fileNameGiven)
 	{
 		const char *filterExtensions[] = { "*.obj" };
 		const char *openfileName = tinyfd_openFileDialog("Open File", "./", 1, filterExtensions, "Wavefront Files (*.obj)", 0);
@@ -94,7 +162,7 @@ int main(int argc, char *argv[])
 	}
 	
 	auto scene = std::make_unique<Scene>();
-	scene->model()->load(fileName);
+	scene->model()->load(fileName, loadOptions);
 	auto viewer = std::make_unique<Viewer>(window, scene.get());
 
 	// Scaling the model's bounding box to the canonical view volume
@@ -107,13 +175,38 @@ int main(int argc, char *argv[])
 
 	glfwSwapInterval(0);
 
+	// startup is measured up to the first presented frame and up to the frame in which the last texture is available,
+	// the time spent in the file dialog is included
+	bool firstFrame = true;
+	bool texturesPending = true;
+
 	// Main loop
 	while (!glfwWindowShouldClose(window))
 	{
 		glfwPollEvents();
+		scene->model()->updateTextures();
 		viewer->display();
 		//glFinish();
 		glfwSwapBuffers(window);
+
+		if (firstFrame)
+		{
+			globjects::debug() << "Time to first frame: " << std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count() << " s";
+			firstFrame = false;
+		}
+
+		if (texturesPending && scene->model()->pendingTextureCount() == 0)
+		{
+			globjects::debug() << "Time to all textures: " << std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count() << " s";
+
+			const TextureCache::Statistics textureStatistics = TextureCache::instance().statistics();
+			globjects::debug() << "Texture cache: " << textureStatistics.requests << " requests, "
+				<< textureStatistics.pathHits << " path hits, " << textureStatistics.contentHits << " content hits, " << textureStatistics.misses << " misses, "
+				<< textureStatistics.textures << " textures with " << textureStatistics.residentBytes / (1024.0 * 1024.0) << " MiB ("
+				<< textureStatistics.uncompressedBytes / (1024.0 * 1024.0) << " MiB uncompressed), "
+				<< textureStatistics.savedBytes / (1024.0 * 1024.0) << " MiB saved by sharing";
+			texturesPending = false;
+		}
 	}
 
 	// Destroy window